@@ -13,13 +13,14 @@ Attrcat::Attrcat(){
 	attrType = INT;
 	attrLen = 0;
 	indexNo = -1;
+	indexType = BTREE_INDEX;
 }
 
 Attrcat::Attrcat(char* pData){
 	memcpy(this, pData, sizeof(Attrcat));
 }
 
-Attrcat::Attrcat(const char* relName, const char* attrName, int offset, AttrType attrType, int attrLen, int indexNo){
+Attrcat::Attrcat(const char* relName, const char* attrName, int offset, AttrType attrType, int attrLen, int indexNo, IndexType indexType){
 	memset(this, '\0', sizeof(Attrcat));
 	strcpy(this->relName, relName);
 	strcpy(this->attrName, attrName);
@@ -27,6 +28,7 @@ Attrcat::Attrcat(const char* relName, const char* attrName, int offset, AttrType
 	this->attrType = attrType;
 	this->attrLen = attrLen;
 	this->indexNo = indexNo;
+	this->indexType = indexType;
 }
 
 Attrcat& Attrcat::operator=(char* pData){
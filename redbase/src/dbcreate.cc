@@ -64,6 +64,16 @@ int main(int argc, char *argv[])
 		PrintError(rc);
 		return rc;
 	}
+	// indexcat
+	if (rc = rmm.CreateFile(MYINDEXCAT, sizeof(Indexcat))){
+		PrintError(rc);
+		return rc;
+	}
+	// statcat
+	if (rc = rmm.CreateFile(MYSTATCAT, sizeof(Statcat))){
+		PrintError(rc);
+		return rc;
+	}
 
 	// Update relcat catalog
 	RID rid;
@@ -75,9 +85,17 @@ int main(int argc, char *argv[])
 	if (rc = relFile.InsertRec((char*)&relRelcat, rid))
 		return rc;
 	// attrcat
-	Relcat attrRelcat(MYATTRCAT, sizeof(Attrcat), 6, 0);
+	Relcat attrRelcat(MYATTRCAT, sizeof(Attrcat), 8, 0);
 	if (rc = relFile.InsertRec((char*)&attrRelcat, rid))
 		return rc;
+	// indexcat
+	Relcat indexRelcat(MYINDEXCAT, sizeof(Indexcat), 3 + MAXINDEXATTRS, 0);
+	if (rc = relFile.InsertRec((char*)&indexRelcat, rid))
+		return rc;
+	// statcat
+	Relcat statRelcat(MYSTATCAT, sizeof(Statcat), 8 + MAXDUPBUCKETS, 0);
+	if (rc = relFile.InsertRec((char*)&statRelcat, rid))
+		return rc;
 	if (rc = rmm.CloseFile(relFile))
 		return rc;
 
@@ -99,6 +117,32 @@ int main(int argc, char *argv[])
 	attributes.push_back(Attrcat(MYATTRCAT, "attrType", offsetof(struct Attrcat, attrType), INT, sizeof(Attrcat::attrType), SM_INVALID));
 	attributes.push_back(Attrcat(MYATTRCAT, "attrLen", offsetof(struct Attrcat, attrLen), INT, sizeof(Attrcat::attrLen), SM_INVALID));
 	attributes.push_back(Attrcat(MYATTRCAT, "indexNo", offsetof(struct Attrcat, indexNo), INT, sizeof(Attrcat::indexNo), SM_INVALID));
+	attributes.push_back(Attrcat(MYATTRCAT, "indexType", offsetof(struct Attrcat, indexType), INT, sizeof(Attrcat::indexType), SM_INVALID));
+	attributes.push_back(Attrcat(MYATTRCAT, "encoded", offsetof(struct Attrcat, encoded), INT, sizeof(Attrcat::encoded), SM_INVALID));
+	// indexcat, one attribute per key attribute name
+	attributes.push_back(Attrcat(MYINDEXCAT, "relName", offsetof(struct Indexcat, relName), STRING, sizeof(Indexcat::relName), SM_INVALID));
+	attributes.push_back(Attrcat(MYINDEXCAT, "indexNo", offsetof(struct Indexcat, indexNo), INT, sizeof(Indexcat::indexNo), SM_INVALID));
+	attributes.push_back(Attrcat(MYINDEXCAT, "attrCount", offsetof(struct Indexcat, attrCount), INT, sizeof(Indexcat::attrCount), SM_INVALID));
+	for (int i = 0; i < MAXINDEXATTRS; ++i){
+		char attrName[MAXNAME + 1];
+		sprintf(attrName, "attrName%d", i + 1);
+		attributes.push_back(Attrcat(MYINDEXCAT, attrName, offsetof(struct Indexcat, attrNames) + i * (MAXNAME + 1), STRING, MAXNAME + 1, SM_INVALID));
+	}
+	// statcat, one attribute per duplicate histogram bucket, named by the
+	// fewest rids its keys have
+	attributes.push_back(Attrcat(MYSTATCAT, "relName", offsetof(struct Statcat, relName), STRING, sizeof(Statcat::relName), SM_INVALID));
+	attributes.push_back(Attrcat(MYSTATCAT, "indexNo", offsetof(struct Statcat, indexNo), INT, sizeof(Statcat::indexNo), SM_INVALID));
+	attributes.push_back(Attrcat(MYSTATCAT, "height", offsetof(struct Statcat, height), INT, sizeof(Statcat::height), SM_INVALID));
+	attributes.push_back(Attrcat(MYSTATCAT, "leafPages", offsetof(struct Statcat, leafPages), INT, sizeof(Statcat::leafPages), SM_INVALID));
+	attributes.push_back(Attrcat(MYSTATCAT, "fillPercent", offsetof(struct Statcat, fillPercent), INT, sizeof(Statcat::fillPercent), SM_INVALID));
+	attributes.push_back(Attrcat(MYSTATCAT, "numRids", offsetof(struct Statcat, numRids), INT, sizeof(Statcat::numRids), SM_INVALID));
+	attributes.push_back(Attrcat(MYSTATCAT, "numKeys", offsetof(struct Statcat, numKeys), INT, sizeof(Statcat::numKeys), SM_INVALID));
+	attributes.push_back(Attrcat(MYSTATCAT, "clustering", offsetof(struct Statcat, clustering), INT, sizeof(Statcat::clustering), SM_INVALID));
+	for (int i = 0; i < MAXDUPBUCKETS; ++i){
+		char attrName[MAXNAME + 1];
+		sprintf(attrName, "dups%d", 1 << i);
+		attributes.push_back(Attrcat(MYSTATCAT, attrName, offsetof(struct Statcat, duplicates) + i * sizeof(int), INT, sizeof(int), SM_INVALID));
+	}
 	// Insert all the Attrcats into attrcat catalog
 	for (int i = 0; i < attributes.size(); ++i){
 		Attrcat attrcat = attributes.at(i);
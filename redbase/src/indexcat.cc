@@ -0,0 +1,27 @@
+#include <string>
+#include <cstring>
+#include <stdio.h>
+#include "redbase.h"
+
+using namespace std;
+
+const char* MYINDEXCAT = "indexcat";
+
+Indexcat::Indexcat(){
+	memset(this, '\0', sizeof(Indexcat));
+	indexNo = -1;
+	attrCount = 0;
+}
+
+Indexcat::Indexcat(char* pData){
+	memcpy(this, pData, sizeof(Indexcat));
+}
+
+Indexcat::Indexcat(const char* relName, int indexNo, int attrCount, const char * const attrNames[]){
+	memset(this, '\0', sizeof(Indexcat));
+	strcpy(this->relName, relName);
+	this->indexNo = indexNo;
+	this->attrCount = attrCount;
+	for (int i = 0; i < attrCount; ++i)
+		strcpy(this->attrNames[i], attrNames[i]);
+}
@@ -32,6 +32,7 @@ extern QL_Manager *pQlm;
 #define E_DUPLICATEATTR     -8
 #define E_TOOLONG           -9
 #define E_STRINGTOOLONG     -10
+#define E_INVINDEXTYPE      -11
 
 /*
  * file pointer to which error messages are printed
@@ -42,10 +43,11 @@ extern QL_Manager *pQlm;
  * local functions
  */
 static int mk_attr_infos(NODE *list, int max, AttrInfo attrInfos[]);
-static int parse_format_string(char *format_string, AttrType *type, int *len);
+static int parse_format_string(char *format_string, AttrType *type, int *len, bool *encoded);
 static int mk_rel_attrs(NODE *list, int max, RelAttr relAttrs[]);
 static void mk_rel_attr(NODE *node, RelAttr &relAttr);
 static int mk_relations(NODE *list, int max, char *relations[]);
+static int mk_attr_names(NODE *list, int max, char *attrNames[]);
 static int mk_conditions(NODE *list, int max, Condition conditions[]);
 static int mk_values(NODE *list, int max, Value values[]);
 static void mk_value(NODE *node, Value &value);
@@ -58,6 +60,7 @@ static void print_value(NODE *n);
 static void print_condition(NODE *n);
 static void print_relattrs(NODE *n);
 static void print_relations(NODE *n);
+static void print_attr_names(NODE *n);
 static void print_conditions(NODE *n);
 static void print_values(NODE *n);
 
@@ -102,15 +105,56 @@ RC interp(NODE *n)
 
       case N_CREATEINDEX:            /* for CreateIndex() */
 
-         errval = pSmm->CreateIndex(n->u.CREATEINDEX.relname,
-               n->u.CREATEINDEX.attrname);
-         break;
+         {
+            int nattrs;
+            char *attrNames[MAXINDEXATTRS];
+            IndexType indexType = BTREE_INDEX;
+
+            /* Make a list of attribute names forming the index key */
+            nattrs = mk_attr_names(n -> u.CREATEINDEX.attrlist, MAXINDEXATTRS,
+                  attrNames);
+            if(nattrs < 0){
+               print_error((char*)"create index", nattrs);
+               break;
+            }
+
+            /* A B+tree unless "using hash" or "using bitmap" is given */
+            if(n -> u.CREATEINDEX.indextype){
+               if(!strcmp(n -> u.CREATEINDEX.indextype, "hash"))
+                  indexType = HASH_INDEX;
+               else if(!strcmp(n -> u.CREATEINDEX.indextype, "bitmap"))
+                  indexType = BITMAP_INDEX;
+               else if(strcmp(n -> u.CREATEINDEX.indextype, "btree")){
+                  /* Fail the statement, but as a warning: a negative
+                     errval would end the session */
+                  print_error((char*)"create index", E_INVINDEXTYPE);
+                  errval = SM_INVALIDENUM;
+                  break;
+               }
+            }
+
+            errval = pSmm->CreateIndex(n->u.CREATEINDEX.relname, nattrs, attrNames,
+                  indexType);
+            break;
+         }
 
       case N_DROPINDEX:            /* for DropIndex() */
 
-         errval = pSmm->DropIndex(n->u.DROPINDEX.relname,
-               n->u.DROPINDEX.attrname);
-         break;
+         {
+            int nattrs;
+            char *attrNames[MAXINDEXATTRS];
+
+            /* Make a list of attribute names forming the index key */
+            nattrs = mk_attr_names(n -> u.DROPINDEX.attrlist, MAXINDEXATTRS,
+                  attrNames);
+            if(nattrs < 0){
+               print_error((char*)"drop index", nattrs);
+               break;
+            }
+
+            errval = pSmm->DropIndex(n->u.DROPINDEX.relname, nattrs, attrNames);
+            break;
+         }
 
       case N_DROPTABLE:            /* for DropTable() */
 
@@ -137,11 +181,44 @@ RC interp(NODE *n)
             errval = pSmm->Help();
          break;
 
+      case N_HELPINDEX:            /* for HelpIndex() */
+
+         errval = pSmm->HelpIndex(n->u.HELPINDEX.relname);
+         break;
+
       case N_PRINT:            /* for Print() */
 
          errval = pSmm->Print(n->u.PRINT.relname);
          break;
 
+      case N_VACUUM:            /* for Vacuum() */
+
+         errval = pSmm->Vacuum(n->u.VACUUM.relname);
+         break;
+
+      case N_REINDEX:            /* for Reindex() */
+
+         {
+            int nattrs;
+            char *attrNames[MAXINDEXATTRS];
+
+            /* Make a list of attribute names forming the index key */
+            nattrs = mk_attr_names(n -> u.REINDEX.attrlist, MAXINDEXATTRS,
+                  attrNames);
+            if(nattrs < 0){
+               print_error((char*)"reindex", nattrs);
+               break;
+            }
+
+            errval = pSmm->Reindex(n->u.REINDEX.relname, nattrs, attrNames);
+            break;
+         }
+
+      case N_ANALYZE:            /* for Analyze() */
+
+         errval = pSmm->Analyze(n->u.ANALYZE.relname);
+         break;
+
       case N_QUERY:            /* for Query() */
          {
             int       nSelAttrs = 0;
@@ -278,6 +355,7 @@ static int mk_attr_infos(NODE *list, int max, AttrInfo attrInfos[])
    int i;
    int len;
    AttrType type;
+   bool encoded;
    NODE *attr;
    RC errval;
 
@@ -295,7 +373,7 @@ static int mk_attr_infos(NODE *list, int max, AttrInfo attrInfos[])
          return E_TOOLONG;
 
       /* interpret the format string */
-      errval = parse_format_string(attr -> u.ATTRTYPE.type, &type, &len);
+      errval = parse_format_string(attr -> u.ATTRTYPE.type, &type, &len, &encoded);
       if(errval != E_OK)
          return errval;
 
@@ -303,6 +381,7 @@ static int mk_attr_infos(NODE *list, int max, AttrInfo attrInfos[])
       attrInfos[i].attrName = attr -> u.ATTRTYPE.attrname;
       attrInfos[i].attrType = type;
       attrInfos[i].attrLength = len;
+      attrInfos[i].encoded = encoded;
    }
 
    return i;
@@ -375,6 +454,30 @@ static int mk_relations(NODE *list, int max, char *relations[])
    return i;
 }
 
+/*
+ * mk_attr_names: converts a list of unqualified attribute names into an
+ * array of attribute names
+ *
+ * Returns:
+ *    the lengh of the list on success ( >= 0 )
+ *    error code otherwise
+ */
+static int mk_attr_names(NODE *list, int max, char *attrNames[])
+{
+   int i;
+
+   /* For each element of the list... */
+   for(i = 0; list != NULL; ++i, list = list -> u.LIST.next){
+      /* If the list is too long then error */
+      if(i == max)
+         return E_TOOMANY;
+
+      attrNames[i] = list -> u.LIST.curr -> u.RELATTR.attrname;
+   }
+
+   return i;
+}
+
 /*
  * mk_conditions: converts a list of conditions into an array of conditions
  *
@@ -458,19 +561,22 @@ static void mk_value(NODE *node, Value &value)
 /*
  * parse_format_string: deciphers a format string of the form: xl
  * where x is a type specification (one of `i' INTEGER, `r' REAL,
- * `s' STRING, or `c' STRING (character)) and l is a length (l is
- * optional for `i' and `r'), and stores the type in *type and the
- * length in *len.
+ * `s' STRING, `c' STRING (character), or `d' dictionary-encoded STRING)
+ * and l is a length (l is optional for `i' and `r'), and stores the
+ * type in *type, the length in *len, and whether it is encoded in
+ * *encoded.
  *
  * Returns
  *    E_OK on success
  *    error code otherwise
  */
-static int parse_format_string(char *format_string, AttrType *type, int *len)
+static int parse_format_string(char *format_string, AttrType *type, int *len, bool *encoded)
 {
    int n;
    char c;
 
+   *encoded = false;
+
    /* extract the components of the format string */
    n = sscanf(format_string, "%c%d", &c, len);
 
@@ -489,6 +595,7 @@ static int parse_format_string(char *format_string, AttrType *type, int *len)
             break;
          case 's':
          case 'c':
+         case 'd':
             return E_NOLENGTH;
          default:
             return E_INVFORMATSTRING;
@@ -516,6 +623,12 @@ static int parse_format_string(char *format_string, AttrType *type, int *len)
             if(*len < 1 || *len > MAXSTRINGLEN)
                return E_INVSTRLEN;
             break;
+         case 'd':
+            *type = STRING;
+            *encoded = true;
+            if(*len <= (int)sizeof(int) || *len > MAXSTRINGLEN)
+               return E_INVSTRLEN;
+            break;
          default:
             return E_INVFORMATSTRING;
       }
@@ -571,6 +684,9 @@ static void print_error(char *errmsg, RC errval)
       case E_STRINGTOOLONG:
          fprintf(stderr, "string attribute too long\n");
          break;
+      case E_INVINDEXTYPE:
+         fprintf(ERRFP, "index type must be btree, hash or bitmap\n");
+         break;
       default:
          fprintf(ERRFP, "unrecognized errval: %d\n", errval);
    }
@@ -586,12 +702,17 @@ static void echo_query(NODE *n)
          printf(";\n");
          break;
       case N_CREATEINDEX:            /* for CreateIndex() */
-         printf("create index %s(%s);\n", n -> u.CREATEINDEX.relname,
-               n -> u.CREATEINDEX.attrname);
+         printf("create index %s(", n -> u.CREATEINDEX.relname);
+         print_attr_names(n -> u.CREATEINDEX.attrlist);
+         printf(")");
+         if(n -> u.CREATEINDEX.indextype)
+            printf(" using %s", n -> u.CREATEINDEX.indextype);
+         printf(";\n");
          break;
       case N_DROPINDEX:            /* for DropIndex() */
-         printf("drop index %s(%s);\n", n -> u.DROPINDEX.relname,
-               n -> u.DROPINDEX.attrname);
+         printf("drop index %s(", n -> u.DROPINDEX.relname);
+         print_attr_names(n -> u.DROPINDEX.attrlist);
+         printf(");\n");
          break;
       case N_DROPTABLE:            /* for DropTable() */
          printf("drop table %s;\n", n -> u.DROPTABLE.relname);
@@ -606,9 +727,23 @@ static void echo_query(NODE *n)
             printf(" %s", n -> u.HELP.relname);
          printf(";\n");
          break;
+      case N_HELPINDEX:            /* for HelpIndex() */
+         printf("help index %s;\n", n -> u.HELPINDEX.relname);
+         break;
       case N_PRINT:            /* for Print() */
          printf("print %s;\n", n -> u.PRINT.relname);
          break;
+      case N_VACUUM:            /* for Vacuum() */
+         printf("vacuum %s;\n", n -> u.VACUUM.relname);
+         break;
+      case N_REINDEX:            /* for Reindex() */
+         printf("reindex %s(", n -> u.REINDEX.relname);
+         print_attr_names(n -> u.REINDEX.attrlist);
+         printf(");\n");
+         break;
+      case N_ANALYZE:            /* for Analyze() */
+         printf("analyze %s;\n", n -> u.ANALYZE.relname);
+         break;
       case N_SET:                                 /* for Set() */
          printf("set %s = \"%s\";\n", n->u.SET.paramName, n->u.SET.string);
          break;
@@ -755,6 +890,15 @@ static void print_relations(NODE *n)
    }
 }
 
+static void print_attr_names(NODE *n)
+{
+   for(; n != NULL; n = n -> u.LIST.next){
+      printf("%s", n->u.LIST.curr->u.RELATTR.attrname);
+      if(n -> u.LIST.next != NULL)
+         printf(", ");
+   }
+}
+
 static void print_conditions(NODE *n)
 {
    for(; n != NULL; n = n -> u.LIST.next){
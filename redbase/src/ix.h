@@ -15,6 +15,13 @@
 
 // Internal
 #define IX_NO_PAGE -1
+#define IX_DIR_SLOTS     ((int) (PF_PAGE_SIZE / sizeof(PageNum)))  // bucket pages per directory page
+#define IX_HASH_MAXDEPTH 16  // deepest directory; fuller buckets overflow
+#define IX_HASH_DIRPAGES (((1 << IX_HASH_MAXDEPTH) + IX_DIR_SLOTS - 1) / IX_DIR_SLOTS)
+#define IX_DESCENT_PAGES     4   // default internal pages kept pinned from the root down
+#define IX_MAX_DESCENT_PAGES 16
+#define IX_MAX_WRITE_LATCHES 16  // most pages an insert latches; taller trees exclude readers
+#define IX_MAX_STALE_COUNTS  64  // nodes a write recounts; more recount the whole tree
 struct IX_IndexHeader{
 	PageNum rootPage;   // CHANGES
 	int height;         // CHANGES
@@ -24,6 +31,15 @@ struct IX_IndexHeader{
 	SlotNum maxEntryIndex;
 	int internalHeaderSize;
 	int leafHeaderSize;
+	bool compressed;    // STRING nodes, see below
+	int numKeyAttrs;    // composite keys, see below; 0 otherwise
+	AttrType keyAttrTypes[MAXINDEXATTRS];
+	int keyAttrLengths[MAXINDEXATTRS];
+	IndexType indexType; // hash indexes, see below
+	int globalDepth;     // hash indexes: the directory has 2^globalDepth slots
+	PageNum dirPages[IX_HASH_DIRPAGES];
+	bool separated;     // uncompressed B+tree nodes, see below
+	int numHints;       // per separated node
 
 	IX_IndexHeader(){
 		rootPage = IX_NO_PAGE;
@@ -34,6 +50,14 @@ struct IX_IndexHeader{
 		maxEntryIndex = -1;
 		internalHeaderSize = 0;
 		leafHeaderSize = 0;
+		compressed = false;
+		numKeyAttrs = 0;
+		indexType = BTREE_INDEX;
+		globalDepth = 0;
+		for (int i = 0; i < IX_HASH_DIRPAGES; ++i)
+			dirPages[i] = IX_NO_PAGE;
+		separated = false;
+		numHints = 0;
 	}
 };
 struct IX_InternalHeader{
@@ -49,14 +73,208 @@ struct IX_LeafHeader{
 	char* bitSlots;			// CHANGES
 };
 // format: <header> {key page slot} ...
+// A key with more than one rid has a single leaf entry whose slot is
+// IX_POSTING_SLOT and whose page heads the key's posting list
+#define IX_POSTING_SLOT -2
+struct IX_PostingHeader{
+	int numRids;            // CHANGES
+	int usedBytes;          // CHANGES
+	PageNum nextPage;       // CHANGES
+	PageNum tailPage;       // CHANGES, head page only
+	PageNum lastPageNum;    // CHANGES, last rid on this page
+	SlotNum lastSlotNum;    // CHANGES
+};
+// format: <header> {varint page delta, varint slot (delta if same page)} ...
+// rids sorted, each page's first rid relative to (0, 0)
+// Compressed (STRING) nodes keep only what follows the prefix the keys of
+// the node share, found from the separators bounding the node, with
+// trailing nulls dropped.  Records are reached through a directory of
+// offsets and are rewritten whole on every change.
+// internal: numKeys prefixLen prefix ptr {offset} ... {len suffix ptr} ...
+// leaf:     numEntries nextBucketPage leftLeaf rightLeaf prefixLen prefix
+//           {offset} ... {len suffix page slot} ...
+#define IX_PREFIX_LEN_SIZE sizeof(short)
+#define IX_OFFSET_SIZE     sizeof(short)
+// Composite keys concatenate the values of several attributes, each
+// encoded so that comparing whole keys bytewise orders them by the first
+// attribute, then the next: ints and floats big endian with the sign bit
+// flipped (every bit, for negative floats), strings null padded.  Their
+// attrType is STRING, numKeyAttrs telling them from string keys, and
+// their nodes use the plain layout.
+// Separated nodes, the uncompressed B+tree layout by default, keep their
+// keys in one array, each padded to a whole number of ints, and their
+// child pointers or rids in a parallel array, so that a search reads
+// keys only.  The arrays start IX_ALIGN aligned in the buffer pool, page
+// data following PF's int page header.  numHints hints, order preserving
+// 4 byte prefixes of keys sampled evenly across the node, narrow a search
+// before it reads a key; they hold for the hintKeys keys they were taken
+// from and are ignored if the node's count differs.  Leaves have no
+// bitmap, their entries fill the first slots.  internalHeaderSize and
+// leafHeaderSize are where the first array starts.
+// internal: numKeys hintKeys {hint} ... {ptr} ... {key} ...
+// leaf:     numEntries nextBucketPage leftLeaf rightLeaf hintKeys {hint} ...
+//           {key} ... {page slot} ...
+#define IX_ALIGN      16
+#define IX_NODE_HINTS 16  // default hints per node, one cache line
+#define IX_MAX_HINTS  64
+#define IX_KEY_STRIDE(attrLength) ((int) (((attrLength) + sizeof(int) - 1) / sizeof(int) * sizeof(int)))
+#define IX_ALIGN_OFFSET(offset) ((int) (((offset) + sizeof(int) + IX_ALIGN - 1) / IX_ALIGN * IX_ALIGN - sizeof(int)))
+// Hash indexes use extendible hashing.  The directory is an array of
+// bucket page numbers indexed by the low globalDepth bits of a key's
+// hash, IX_DIR_SLOTS to a page, its pages listed in the index header
+// (rootPage is its first page); maxEntryIndex is a bucket's last slot.
+// A full bucket splits on the next hash bit, and chains overflow pages
+// only when splitting can't separate its keys.
+// directory: {bucket page} ...
+// bucket:    numEntries localDepth overflowPage {key page slot} ...
+struct IX_BucketHeader{
+	int numEntries;
+	int localDepth;         // unused in overflow pages
+	PageNum overflowPage;
+};
+
+// Bitmap indexes keep a directory of their distinct keys (rootPage is its
+// first page, maxEntryIndex its pages' last slot), each key with a chain
+// of pages holding its rids as a bitmap.  A bitmap is a sequence of
+// chunks, one per RID page in page order, each a sorted array of the
+// page's slots or a bitset of them, whichever is smaller (the array when
+// its bytes are numSlots shorts).  Chunks are whole within a page.
+// directory:   numValues nextPage {key firstPage lastPage numRids} ...
+// bitmap page: numBytes nextPage {chunk} ...
+// chunk:       page numSlots numBytes {slot} ... or bitset
+struct IX_BitmapDirHeader{
+	int numValues;
+	PageNum nextPage;
+};
+struct IX_BitmapPageHeader{
+	int numBytes;
+	PageNum nextPage;
+};
+#define IX_CHUNK_HEADER (sizeof(PageNum) + 2 * sizeof(short))
+#define IX_BITMAP_BYTES ((int) (PF_PAGE_SIZE - sizeof(IX_BitmapPageHeader)))  // chunk bytes a page holds
+#define IX_BITMAP_SLOTS ((int) ((IX_BITMAP_BYTES - IX_CHUNK_HEADER) * 8))      // rids' slots must be below
+// Entry counts live in a side file, two pages per node: node pageNum's
+// rid counts on side page 2 * pageNum + IX_COUNT_RIDS, its key counts on
+// the next.  Side page 0 holds the side pages allocated.
+// counts: total {below child} ...   (a leaf has only its total)
+#define IX_COUNT_RIDS 0
+#define IX_COUNT_KEYS 1
 // End Internal
 
+//
+// IX_Bitmap: a set of rids, compressed as in bitmap indexes, combined
+// with others of the same relation by bitwise operations
+//
+class IX_Bitmap {
+	friend class IX_IndexHandle;
+public:
+    IX_Bitmap();
+    IX_Bitmap(const IX_Bitmap &other);
+    ~IX_Bitmap();
+    IX_Bitmap& operator=(const IX_Bitmap &other);
+
+    // Add or remove a rid; slots must be below IX_BITMAP_SLOTS
+    RC Add(const RID &rid);
+    RC Remove(const RID &rid);
+    bool Contains(const RID &rid) const;
+
+    // Keep the rids also in other, add other's, or drop other's
+    void And(const IX_Bitmap &other);
+    void Or(const IX_Bitmap &other);
+    void AndNot(const IX_Bitmap &other);
+
+    // Keep the rids of universe not in this bitmap
+    void Not(const IX_Bitmap &universe);
+
+    int Count() const;
+
+    // All rids, in rid order; caller deletes rids
+    RC GetRids(RID* &rids, int &numRids) const;
+
+    void Clear();
+
+private:
+	char* data;             // chunks, as in bitmap pages
+	int size;
+	int capacity;
+
+	void Reserve(int bytes);
+	void Append(const char* chunks, int bytes);
+	bool FindChunk(PageNum page, int &offset) const;  // Offset of page's chunk, or of where it goes
+	RC SetSlot(const RID &rid, bool value);
+	void Combine(const IX_Bitmap &other, int op);
+};
+
+//
+// IX_RadixIndex: an adaptive radix tree held in memory, for transient
+// indexes on small or intermediate relations.  Keys are INT, FLOAT or
+// STRING attributes, encoded as composite keys are so that their bytes
+// order them; duplicates share a leaf.  A snapshot of the entries can be
+// kept in a PF file and loaded back
+//
+struct IX_RadixNode;
+class IX_RadixIndex {
+public:
+    IX_RadixIndex();
+    ~IX_RadixIndex();
+
+    // Empty the index, for keys of attrType and attrLength
+    RC Init(AttrType attrType, int attrLength);
+
+    RC InsertEntry(void *attribute, const RID &rid);
+    RC DeleteEntry(void *attribute, const RID &rid);
+
+    // All rids of a key, in the order inserted; none if absent.  Valid
+    // until the index next changes
+    RC GetRids(void *attribute, const RID* &rids, int &numRids) const;
+
+    // Rids of every key satisfying compOp value, in key order, NO_OP
+    // giving all; caller deletes rids
+    RC GetRange(CompOp compOp, void *value, RID* &rids, int &numRids) const;
+
+    // Write every entry to a new PF file, or replace the index's with a
+    // file's
+    RC SaveSnapshot(PF_Manager &pfm, const char *fileName) const;
+    RC LoadSnapshot(PF_Manager &pfm, const char *fileName);
+
+	bool open;
+	AttrType attrType;
+	int attrLength;
+	int numKeys;
+	int numRids;
+
+private:
+	IX_RadixNode* root;
+
+	void EncodeKey(const void* attribute, unsigned char* key) const;  // attrLength bytes
+};
+
 //
 // IX_IndexHandle: IX Index File interface
 //
+class IX_BulkLoader;
+
+// A rid found by IX_IndexHandle::ProbeKeys for key number probe
+struct IX_ProbeResult{
+	int probe;
+	RID rid;
+};
+
+// What IX_IndexHandle::GetStats finds, as stored in statcat (see redbase.h)
+struct IX_IndexStats{
+	int height;       // levels down to a leaf; 2 for hash and bitmap indexes
+	int leafPages;    // leaves, buckets or bitmap pages, overflow included
+	int fillPercent;  // average use of those pages
+	int numRids;
+	int numKeys;
+	int clustering;   // times the scan's rids move to another page
+	int duplicates[MAXDUPBUCKETS]; // keys with 2^b to 2^(b+1)-1 rids
+};
+
 class IX_IndexHandle {
 	friend class IX_Manager;
 	friend class IX_IndexScan;
+	friend class IX_TreeBuilder;
 public:
     IX_IndexHandle();
     ~IX_IndexHandle();
@@ -70,42 +288,251 @@ public:
     // Force index files to disk
     RC ForcePages();
 
+    // Encode the first numValues attribute values of a composite key;
+    // the attributes after them take their lowest (highest if high)
+    // encoding, which bounds every key starting with those values
+    RC EncodeKey(void * const values[], int numValues, bool high, char *key) const;
+
+    // Decode a composite key back into one value per key attribute
+    RC DecodeKey(const char *key, void * const values[]) const;
+
+    // Fill percent below which a node is merged with or rebalanced
+    // against a sibling after a delete; 0 keeps deletion lazy
+    RC SetMergePercent(int percent);
+
+    // Internal pages kept pinned in the buffer pool, whole levels from the
+    // root down, so descents do not re-read them; 0 pins none
+    RC SetDescentPages(int numPages);
+
+    // Look up numKeys keys of attrLength bytes each, stored one after
+    // another, in one pass down the tree in key order.  Returns (i, rid)
+    // for every rid of key i, in key order; caller deletes results
+    RC ProbeKeys(const void *keys, int numKeys,
+                 IX_ProbeResult* &results, int &numResults) const;
+
+    // Bitmap indexes: the rids of every key satisfying compOp value, NO_OP
+    // giving all the index's rids
+    RC GetBitmap(CompOp compOp, void *value, IX_Bitmap &bitmap) const;
+
+    // Smallest and largest keys, reading one path down a B+tree (or a
+    // bitmap index's directory); IX_EOF if the index is empty
+    RC GetMinKey(void *key) const;
+    RC GetMaxKey(void *key) const;
+
+    // Rids and distinct keys within a key range, a NULL bound leaving that
+    // side open.  A B+tree with entry counts reads two paths down the
+    // tree, a bitmap index its directory; other indexes scan the range
+    RC CountEntries(void *lowValue, bool lowInclusive,
+                    void *highValue, bool highInclusive,
+                    int &numRids, int &numKeys) const;
+    bool FastCounts() const;  // CountEntries does not scan
+
+    // Statistics from one pass over the index's leaf level (bucket pages
+    // or bitmap pages) and one full scan
+    RC GetStats(IX_IndexStats &stats) const;
+
 	bool open;
 	bool modified;
 	PF_FileHandle pfFileHandle;
 	IX_IndexHeader ixIndexHeader;
+	int mergePercent;
+	mutable int openScans;  // scans open on this handle, which pause rebalancing
+	int descentPages;       // most internal pages pinned from the root down
+	int numPinned;
+	PageNum pinnedPages[IX_MAX_DESCENT_PAGES];
+	bool descentStale;      // a split or merge changed the pinned levels
+	int numWriteLatches;    // pages the running insert holds latched
+	PageNum writeLatches[IX_MAX_WRITE_LATCHES];
+	bool readersExcluded;   // the running write holds the index latch exclusively
+	bool bloomOpen;         // the index has a Bloom filter, open in bloomHandle
+	PF_FileHandle bloomHandle;
+	int bloomPages;         // filter pages in use, from page 1 on
+	bool countsOpen;        // the B+tree keeps entry counts, open in countsHandle
+	PF_FileHandle countsHandle;
+	int numStaleCounts;     // nodes the running write changed the children of
+	PageNum staleCounts[IX_MAX_STALE_COUNTS];
+	int staleHeights[IX_MAX_STALE_COUNTS];
+	bool countsLost;        // more than IX_MAX_STALE_COUNTS nodes are stale
+	int ridDelta;           // rids and keys the running write added to its leaf
+	int keyDelta;
 
 	char* GetKeyPtr(char* pData, const SlotNum slotNum) const;        // Gets a pointer to a specific key's start location
 	char* GetEntryPtr(char* pData, const SlotNum slotNum) const;      // Gets a pointer to a specific entry's start location
 	bool GetSlotBitValue(char* pData, const SlotNum slotNum) const;   // Read a specific entry's bit value in page header
 	void SetSlotBitValue(char* pData, const SlotNum slotNum, bool b); // Write a specific entry's bit value in page header
 
+	// Typed binary search within a node
+	int UpperBoundKey(char* pData, int numKeys, void* attribute) const;      // First key > attribute
+	int SearchEntries(char* pData, int numEntries, void* attribute, bool upper) const; // First entry >= (> if upper) attribute
+	bool LeafIsCompact(char* pData, int numEntries) const;                    // Entries fill slots 0 .. numEntries-1
+	int CompareKey(const char* key, const void* value) const;                 // <0, 0, >0 as key <, =, > value
+
+	// Node access for all layouts
+	PageNum GetChildPage(char* pData, const SlotNum slotNum) const;          // Page pointer before key slotNum
+	void GetKey(char* pData, const SlotNum slotNum, char* key) const;         // Copies out key slotNum in full
+	const char* GetEntry(char* pData, const SlotNum slotNum, char* entry) const; // Whole entry, decoded into entry if compressed
+	char* GetEntryRid(char* pData, const SlotNum slotNum) const;              // Page and slot of an entry, in place
+
+	// Posting lists of duplicate keys
+	RC GetRids(void* attribute, RID* &rids, int &numRids) const;             // All rids of a key, sorted; caller deletes
+	RC CreatePostings(const RID &one, const RID &two, PageNum &headPage);
+	RC InsertPosting(PageNum headPage, const RID &rid);
+	RC DeletePosting(PageNum headPage, const RID &rid, bool &empty);          // Disposes the list once empty
+	RC ReadPostings(PageNum headPage, RID* &rids, int &numRids) const;        // Caller deletes rids
+
+	// Hash indexes (ix_hash.cc)
+	unsigned int HashKey(const void* attribute) const;
+	RC ReadDirectory(int firstSlot, int numSlots, PageNum* bucketPages) const;
+	RC WriteDirectory(int firstSlot, int numSlots, const PageNum* bucketPages); // Allocates directory pages as needed
+	RC ReadBucket(PageNum bucketPage, const void* attribute, char* &entries, int &numEntries, int &localDepth) const; // Chain's entries, only those matching attribute if given; caller deletes
+	RC WriteBucket(PageNum bucketPage, int localDepth, const char* entries, int numEntries); // Rewrites a chain, adding or disposing overflow pages
+	RC HashInsert(void* attribute, const RID &rid);
+	RC HashDelete(void* attribute, const RID &rid);
+	RC SplitBucket(unsigned int hash, bool &split);
+	RC BucketStats(int &numPages, int &fillTotal) const;                    // As LeafStats, for bucket pages
+
+	// Bitmap indexes (ix_bitmap.cc)
+	RC ReadBitmapValues(char* &values, int &numValues) const;                // Every directory entry; caller deletes
+	RC FindBitmapValue(const void* attribute, PageNum &dirPage, int &valueNum, // valueNum -1 if absent; roomPage is
+		PageNum &roomPage, PageNum &lastDirPage) const;                       // the first page with room, if any
+	RC AddBitmapValue(const void* attribute, PageNum roomPage, PageNum lastDirPage, PageNum &dirPage, int &valueNum);
+	RC RemoveBitmapValue(PageNum dirPage, int valueNum);
+	RC GetBitmapValue(PageNum dirPage, int valueNum, PageNum &firstPage, PageNum &lastPage, int &numRids) const;
+	RC SetBitmapValue(PageNum dirPage, int valueNum, PageNum firstPage, PageNum lastPage, int numRids);
+	RC ReadBitmapPage(PageNum pageNum, IX_Bitmap* bitmap, PageNum &nextPage, PageNum &firstRidPage) const; // bitmap may be NULL
+	RC WriteBitmapPages(PageNum pageNum, const IX_Bitmap &bitmap, PageNum &lastPage); // Adds pages after it as needed
+	RC SetBitmapLink(PageNum pageNum, PageNum nextPage);
+	RC ReadBitmap(PageNum firstPage, IX_Bitmap &bitmap) const;               // A key's whole chain
+	RC FindBitmapPage(PageNum firstPage, PageNum ridPage, PageNum &pageNum, PageNum &prevPage) const; // Page holding ridPage's chunk
+	RC BitmapInsert(void* attribute, const RID &rid);
+	RC BitmapDelete(void* attribute, const RID &rid);
+	RC BitmapCount(void *lowValue, bool lowInclusive, void *highValue, bool highInclusive, int &numRids, int &numKeys) const;
+	RC BitmapEdgeKey(bool last, void* key) const;                            // IX_EOF if empty
+	RC BitmapStats(int &numPages, int &fillTotal) const;                    // As LeafStats, for bitmap pages
+
+	// Bloom filters (ix_bloom.cc).  Optional, kept in a side PF file; a key
+	// the filter has not seen is not in the index
+	RC BloomProbe(const void* attribute, bool &mayContain) const;            // True if no filter
+	RC BloomAdd(const void* attribute);                                      // Nothing if no filter
+	RC ResetBloom(int numKeys);                                              // Clears it, sized for numKeys
+	RC FillBloom();                                                          // ResetBloom, then adds every key
+	void BloomBits(unsigned int hash, PageNum &pageNum, int* bits) const;    // A key's page and IX_BLOOM_HASHES bits
+
+	// Entry counts (ix_count.cc).  Optional, kept in a side PF file: for
+	// each node, the rids and keys below it and below each of its children.
+	// A write adds its leaf's change along its path, then recounts the
+	// nodes whose children it changed from their children's totals
+	RC PinCounts(PageNum pageNum, int which, int* &counts) const;            // which is IX_COUNT_RIDS or IX_COUNT_KEYS
+	RC UnpinCounts(PageNum pageNum, int which, bool dirty) const;
+	RC AllocateCounts(PageNum pageNum);                                      // Side pages for node pageNum, as needed
+	RC AddCounts(PageNum pageNum, int height, SlotNum child, int rids, int keys); // child -1 for a leaf
+	void StaleCounts(PageNum pageNum, int height);
+	void DropStaleCounts(PageNum pageNum);
+	RC RecountNode(PageNum pageNum, int height);                             // From its entries, or its children's totals
+	RC RecountSubtree(PageNum pageNum, int height);
+	RC FinishCounts();                                                       // Recounts the stale nodes, lowest first
+	RC RecountEntries();                                                     // The whole tree
+	RC CountBefore(void* attribute, bool inclusive, int &numRids, int &numKeys) const; // Entries < (<= if inclusive) attribute
+	RC EdgeKey(bool last, void* key) const;
+
+	// Statistics (ix_stats.cc)
+	RC LeafStats(int &numPages, int &fillTotal) const;                      // Leaves and the sum of their fill percents
+
 private:
+	RC TreeInsert(void *attribute, const RID &rid);
+	RC TreeDelete(void *attribute, const RID &rid);
+
 	// Insert helper functions
-	RC InsertEntryHelper(PageNum currPage, int height, void* attribute, const RID &rid, PageNum &newChildPage, char* &newAttribute);
+	// lowKey and highKey bound currPage's keys, NULL if unbounded
+	RC InsertEntryHelper(PageNum currPage, int height, void* attribute, const RID &rid, PageNum &newChildPage, char* &newAttribute,
+		const char* lowKey, const char* highKey);
 	// Internal insert
+	bool InternalHasRoom(char* pData, int numKeys, void* newAttribute) const;
 	RC InternalInsert(PageNum pageNum, PageNum newChildPage, void* newAttribute, SlotNum keyNum);
 	void MakeKeyCopyBack(char* pData, SlotNum insertIndex, PageNum newChildPage, void* newAttribute, char* &copyBack, int &copyBackSize, int &numKeys);
-	void WriteInternalFromKeyCopyBack(char* pData, char* copyBack, int copyBackSize, int numKeys);
+	void WriteInternalFromKeyCopyBack(char* pData, char* copyBack, int copyBackSize, int numKeys, const char* prefix = NULL, int prefixLen = -1);
 	// Leaf insert
+	bool LeafHasRoom(char* pData, int numEntries, void* attribute) const;
 	RC LeafInsert(PageNum pageNum, void* attribute, const RID &rid);
 	void MakeEntryCopyBack(char* pData, void* attribute, const RID &rid, char* &copyBack, int &copyBackSize, int &numEntries);
-	void WriteLeafFromEntryCopyBack(char* pData, char* copyBack, int copyBackSize, int numEntries);
+	void ReadEntries(char* pData, SlotNum first, int count, char* copyBack) const;
+	void WriteLeafFromEntryCopyBack(char* pData, char* copyBack, int copyBackSize, int numEntries, const char* prefix = NULL, int prefixLen = -1);
 	RC SetSiblingPointers(PageNum L1Page, PageNum L2Page, char* L1, char* L2);
+	RC UnlinkLeaf(char* pData);
 	// Bucket insert
 	bool ShouldBucket(void* attribute, char* pData);
+	// Posting insert
+	bool FindKeyInLeaf(char* pData, int numEntries, void* attribute, SlotNum &keySlot) const;
+	RC AddToPostings(PageNum pageNum, char* pData, SlotNum keySlot, const RID &rid);
 
 	// Delete helper functions
-	RC DeleteEntryHelper(PageNum currPage, int height, void* attribute, const RID &rid, PageNum &oldPage);
+	// lowKey and highKey bound currPage's keys, as for insert
+	RC DeleteEntryHelper(PageNum currPage, int height, void* attribute, const RID &rid, PageNum &oldPage,
+		const char* lowKey, const char* highKey);
 	void InternalDelete(char* pData, SlotNum deleteKeyIndex, int &numKeys);
 	RC LeafDelete(PageNum currPage, char* pData, void* attribute, const RID &rid, int &numEntries);
 
+	// Underflow handling (ix_rebalance.cc)
+	bool Underfull(char* pData, bool leaf) const;
+	RC RebalanceChild(PageNum currPage, char* pData, int childHeight, SlotNum childNum, int &numKeys,
+		const char* lowKey, const char* highKey);
+	bool RebalanceLeaves(char* pData, SlotNum leftNum, int &numKeys, char* left, char* right,
+		const char* lowKey, const char* highKey);
+	bool RebalanceInternals(char* pData, SlotNum leftNum, int &numKeys, char* left, char* right,
+		const char* lowKey, const char* highKey);
+	void ReadKeys(char* pData, int numKeys, char* copyBack) const;          // ptr {key ptr} ... in the full layout
+	bool ReplaceKey(char* pData, SlotNum keyNum, int numKeys, const char* key);
+	void RemoveKey(char* pData, SlotNum keyNum, int &numKeys);               // Drops key keyNum and the page after it
+	RC CopyEntries(IX_BulkLoader &loader);                                   // Every entry, in key order for B+trees
+
+	// Pinned upper levels (ix_descent.cc)
+	RC PinUpperLevels();
+	RC UnpinUpperLevels();
+	RC DisposeNode(PageNum pageNum);                                         // Unpins it first if pinned, marks the levels stale
+
+	// Concurrent access (ix_latch.cc).  The header page's latch guards the
+	// tree as a whole: shared for readers, update for an insert, exclusive
+	// for other writes.  An insert latches the pages it changes exclusively
+	RC LatchIndex(PF_LatchMode mode) const;
+	RC UnlatchIndex(PF_LatchMode mode) const;
+	RC LatchForWrite(PageNum pageNum);                                       // Held until ReleaseWriteLatches
+	RC ReleaseWriteLatches();
+	RC ExcludeReaders();                                                     // Upgrades an insert's index latch
+	RC ReadNode(PageNum pageNum, char* node) const;                          // Copies out an internal node, validated by page version
+	RC LatchShared(PageNum pageNum, char* &pData) const;                     // Pins and latches shared
+	RC ReleaseShared(PageNum pageNum) const;
+	RC MoveRight(PageNum &pageNum, char* &pData, void* attribute) const;     // To the latched leaf that would hold attribute, the last if NULL
+	RC ProbeSorted(const char* keyData, const int* order, int numKeys,       // ProbeKeys, given the keys' order
+		IX_ProbeResult* &results, int &numResults) const;
+
 	// Both Insert/Delete helper functions
 	void ChooseSubtree(char* pData, void* attribute, PageNum &nextPage, int &numKeys, SlotNum &keyNum);
 	RC GetLastPageInBucketChain(PageNum &currPage, char*& pData);
 	bool AttributeEqualEntry(char* one, char* two);
 	bool AttrSatisfiesCondition(void* one, CompOp compOp, void* two, AttrType attrType, int attrLength) const;
 
+	// Compressed nodes (ix_prefix.cc)
+	int KeyLength(const char* key) const;                                     // Bytes before the first null
+	int CommonPrefix(const char* one, const char* two) const;                 // 0 if either is NULL
+	void MakeSeparator(const char* left, const char* right, char* separator) const; // Shortest key > left, <= right
+	char* NodePrefix(char* pData, bool leaf, int &prefixLen) const;
+	char* CompressedRecord(char* pData, bool leaf, const SlotNum slotNum) const;
+	int CompressedBytes(char* pData, bool leaf) const;                        // Bytes in use
+	int CompressedSize(const char* copyBack, int num, bool leaf, int prefixLen) const; // Bytes copyBack would take
+	void Compress(char* pData, const char* copyBack, int num, bool leaf, const char* prefix, int prefixLen) const;
+	int CompressedSearch(char* pData, bool leaf, int num, void* attribute, bool upper) const;
+	int SplitKeys(const char* copyBack, int numKeys, const char* lowKey, const char* highKey) const;
+	int SplitEntries(const char* copyBack, int numEntries, const char* lowKey, const char* highKey, char* separator) const;
+
+	// Separated nodes (ix_layout.cc)
+	char* SeparatedKeys(char* pData, bool leaf) const;                       // The key array
+	char* SeparatedPointers(char* pData, bool leaf) const;                   // Child pages, or page and slot of entries
+	unsigned int KeyHint(const void* key) const;                             // Orders as the keys, where it differs
+	void SampleHints(char* pData, bool leaf, int num) const;
+	void HintRange(char* pData, bool leaf, int num, void* attribute, int &first, int &last) const; // Search keys [first, last)
+	void WriteSeparated(char* pData, const char* copyBack, int num, bool leaf) const; // From the full layout
+	void RemoveSeparated(char* pData, bool leaf, int num, SlotNum keyNum, SlotNum pointerNum) const;
+
 	//RC CreatePage(PF_FileHandle &fileHandle, PageNum &pageNum, char* pData);
     //RC GetPage(PF_FileHandle &fileHandle, PageNum pageNum, char* pData) const;
 };
@@ -118,54 +545,167 @@ public:
     IX_IndexScan();
     ~IX_IndexScan();
 
-    // Open index scan
+    // Open index scan; a reverse scan returns entries in decreasing order
     RC OpenScan(const IX_IndexHandle &indexHandle,
                 CompOp compOp,
                 void *value,
-                ClientHint  pinHint = NO_HINT);
+                ClientHint  pinHint = NO_HINT,
+                bool reverse = false);
+
+    // Open index range scan; a NULL bound leaves that side open
+    RC OpenScan(const IX_IndexHandle &indexHandle,
+                void *lowValue, bool lowInclusive,
+                void *highValue, bool highInclusive,
+                ClientHint  pinHint = NO_HINT,
+                bool reverse = false);
 
     // Get the next matching entry return IX_EOF if no more matching
     // entries.
     RC GetNextEntry(RID &rid);
 
+    // As above, also copying the entry's key (attrLength bytes) into key,
+    // so a caller needing only the indexed attribute skips the record
+    RC GetNextEntry(RID &rid, void *key);
+
+    // Get up to maxRids matching entries into rids, numRids of them;
+    // return IX_EOF if no more matching entries.  Each leaf stays pinned
+    // while its entries are read.
+    RC GetNextEntries(RID *rids, int maxRids, int &numRids);
+
     // Close index scan
     RC CloseScan();
 
 private:
 	const IX_IndexHandle* ixIndexHandle;
-	CompOp compOp;
-	void *value;
+	void *lowValue;
+	bool lowInclusive;
+	void *highValue;
+	bool highInclusive;
+	bool reverse;
 
 	bool open;
 	PageNum pageNum;
 	SlotNum entryNum;
 	PageNum rightLeaf;
+	PageNum chainLeaf;      // leaf heading the current bucket chain (reverse scans)
 	bool inBucket;
 	bool finished;
 	int entrySize;
 	char* lastEntry;
+	int pageVersion;        // PF version of pageNum when lastEntry was returned
+	char* currEntry;        // entry decoded from a compressed leaf
+	RID* postings;          // rids of the last returned posting list entry
+	int numPostings;
+	int nextPosting;
 
 	RC FindLeafNode(void* attribute, PageNum &resultPage) const;
 	RC FindMinLeafNode(PageNum &resultPage) const;
-	RC FindLeafNodeHelper(PageNum currPage, int currHeight, bool findMin, void* attribute, PageNum &resultPage) const;
-
+	RC FindMaxLeafNode(PageNum &resultPage) const;
+	RC FindLeafNodeHelper(PageNum currPage, int currHeight, bool findMin, bool findMax, void* attribute, PageNum &resultPage) const;
+	RC PositionInLeaf();
+	RC StartScan();                  // OpenScan's work, under the index latch
+	RC ScanEntries(RID *rids, int maxRids, int &numRids); // GetNextEntries's, likewise
+
+	// Hash index scans read a bucket chain's entries at a time
+	int hashSlot;           // next directory slot to read, past the end once read
+	char* bucketEntries;
+	int numBucketEntries;
+	int nextBucketEntry;
+	RC OpenHashScan();      // Equality or full scans only
+	RC GetNextHashEntry(RID &rid);
+
+	// Bitmap index scans read a key's rids at a time, keys in scan order
+	char* bitmapValues;     // directory entries of the keys in range
+	int numBitmapValues;
+	int nextBitmapValue;
+	RC OpenBitmapScan();
+	RC GetNextBitmapEntry(RID &rid);
+
+	RC StepEntry(PageNum currPage);  // Moves entryNum/pageNum one slot in scan order
+	RC PinPage(PageNum page, char* &pData) const;   // Latched shared, let go by ReleaseShared
+	RC Advance(char* &pData);        // StepEntry, moving the pin along with pageNum
 	RC GetNextPage(PageNum pageNum, PageNum &resultPage);
+	RC GetPrevPage(PageNum pageNum, PageNum &resultPage);
+	RC GetLastPageInChain(PageNum leafPage, PageNum &resultPage) const;
+	RC GetPageLink(PageNum page, int offset, PageNum &link) const;
 
     //RC GetPage(PF_FileHandle &fileHandle, PageNum pageNum, char* pData) const;
 
 };
 
+#define IX_FILL_PERCENT    90   // default bulk load fill of leaves and internal nodes
+#define IX_MERGE_PERCENT   40   // default fill below which deletes merge or rebalance nodes
+#define IX_SORT_RUN_PAGES  256  // pages of entries sorted in memory per run
+#define IX_MERGE_FANIN     8    // runs merged at once, each pinning a buffer page
+#define IX_BLOOM_BITS      10   // Bloom filter bits per key, for about 1% false positives
+#define IX_BLOOM_HASHES    7    // bits set per key, all in one filter page
+
+class IX_Manager;
+
+//
+// IX_BulkLoader: builds an empty index bottom-up from entries given in
+// any order.  Entries are sorted in memory-sized runs, spilled to a
+// temporary PF file and merged; the sorted entries are packed into
+// leaves left to right up to the fill factor, then each internal level
+// is built from the level below.
+//
+class IX_BulkLoader {
+public:
+    IX_BulkLoader(IX_Manager &ixm);
+    ~IX_BulkLoader();
+
+    // Start a bulk load into an open, empty index
+    RC OpenLoad(const char *fileName, int indexNo,
+                IX_IndexHandle &indexHandle,
+                int fillPercent = IX_FILL_PERCENT);
+
+    // Add an entry, in any order
+    RC InsertEntry(void *attribute, const RID &rid);
+
+    // Sort all entries and build the tree
+    RC CloseLoad();
+
+private:
+	PF_Manager* pfManager;
+	IX_IndexHandle* ixIndexHandle;
+	bool open;
+	int fillPercent;
+	int entrySize;          // key, page, slot, as stored in leaves
+
+	char* runBuffer;        // entries of the run being collected
+	int runEntries;
+	int maxRunEntries;
+
+	char sortFileName[MAXNAME + 32];
+	bool sortFileOpen;
+	PF_FileHandle sortFile; // spilled runs, each on consecutive pages
+	int numRuns;
+	int maxRuns;
+	PageNum* runPages;      // first page of each run
+	int* runLengths;        // entries in each run
+
+	RC SpillRun();          // Sort runBuffer and append it to sortFile
+	RC AddRun(PageNum firstPage, int numEntries);
+	RC DestroySortFile();
+};
+
 //
 // IX_Manager: provides IX index file management
 //
 class IX_Manager {
+	friend class IX_BulkLoader;
 public:
     IX_Manager(PF_Manager &pfm);
     ~IX_Manager();
 
     // Create a new Index
     RC CreateIndex(const char *fileName, int indexNo,
-                   AttrType attrType, int attrLength);
+                   AttrType attrType, int attrLength,
+                   IndexType indexType = BTREE_INDEX);
+
+    // Create a new composite Index, keyed on attrCount attributes in order
+    RC CreateIndex(const char *fileName, int indexNo, int attrCount,
+                   const AttrType attrTypes[], const int attrLengths[]);
 
     // Destroy and Index
     RC DestroyIndex(const char *fileName, int indexNo);
@@ -177,20 +717,75 @@ public:
     // Close an Index
     RC CloseIndex(IX_IndexHandle &indexHandle);
 
+    // Rewrite an open index compactly, bulk loading a copy beside it
+    // that replaces it once built
+    RC RebuildIndex(const char *fileName, int indexNo,
+                    IX_IndexHandle &indexHandle,
+                    int fillPercent = IX_FILL_PERCENT);
+
+    // Merge percent of the indexes opened from now on
+    RC SetMergePercent(int percent);
+
+    // Descent pages of the indexes opened from now on
+    RC SetDescentPages(int numPages);
+
+    // Node layout of the B+trees created from now on: separated key and
+    // pointer arrays with numHints search hints per node (0 for none), or
+    // keys interleaved with pointers.  STRING nodes are compressed either way
+    RC SetNodeLayout(bool separated, int numHints = IX_NODE_HINTS);
+
+    // Give an open index a Bloom filter, kept from then on, built from its
+    // entries (rebuilt if it has one); equality scans and ProbeKeys skip
+    // the keys it rules out
+    RC CreateBloomFilter(const char *fileName, int indexNo,
+                         IX_IndexHandle &indexHandle);
+
+    // Drop an open index's Bloom filter
+    RC DestroyBloomFilter(const char *fileName, int indexNo,
+                          IX_IndexHandle &indexHandle);
+
+    // Give an open B+tree entry counts, kept from then on, counted from its
+    // entries (recounted if it has them); CountEntries then reads two paths
+    // down the tree rather than scanning
+    RC CreateEntryCounts(const char *fileName, int indexNo,
+                         IX_IndexHandle &indexHandle);
+
+    // Drop an open index's entry counts
+    RC DestroyEntryCounts(const char *fileName, int indexNo,
+                          IX_IndexHandle &indexHandle);
+
 private:
 	PF_Manager* pfManager;
+	int mergePercent;
+	int descentPages;
+	bool separatedNodes;
+	int nodeHints;
+
+	RC CreateIndexFile(const char *indexName, AttrType attrType, int attrLength,
+		int numKeyAttrs = 0, const AttrType *keyAttrTypes = NULL, const int *keyAttrLengths = NULL,
+		IndexType indexType = BTREE_INDEX);
+	RC OpenIndexFile(const char *indexName, IX_IndexHandle &indexHandle);
 
 	const char* GetIndexFileName(const char *fileName, int indexNo);
 
-	int CalculateMaxKeys(int attrLength);  //Calculate max number of entries that will fit in one page
-	int CalculateMaxEntries(int attrLength);  //Calculate max number of entries that will fit in one page
+	int CalculateMaxKeys(bool compressed, bool separated, int attrLength);  //Calculate max number of entries that will fit in one page
+	int CalculateMaxEntries(bool compressed, bool separated, int attrLength);  //Calculate max number of entries that will fit in one page
+	int SeparatedHeaderSize(bool leaf);  // Where a separated node's first array starts
 
-	RC CreateEmptyRoot(PF_FileHandle &pfFileHandle, int attrLength, PageNum &resultPage);
+	RC CreateEmptyRoot(PF_FileHandle &pfFileHandle, bool compressed, bool separated, int attrLength, PageNum &resultPage);
+	RC CreateEmptyDirectory(PF_FileHandle &pfFileHandle, PageNum &resultPage);
+	RC CreateEmptyBitmapDirectory(PF_FileHandle &pfFileHandle, PageNum &resultPage);
 
 	//RC CreatePage(PF_FileHandle &fileHandle, PageNum &pageNum, char* pData);
     //RC GetPage(PF_FileHandle &fileHandle, PageNum pageNum, char* pData) const;
 };
 
+//
+// Merge intersection of two sorted rid lists, returns the number written
+// to result (which needs room for the shorter list)
+//
+int IX_IntersectRids(const RID *one, int numOne, const RID *two, int numTwo, RID *result);
+
 //
 // Print-error function
 //
@@ -201,7 +796,11 @@ void IX_PrintError(RC rc);
 #define IX_FILESCANREOPEN		 (START_IX_WARN + 2)
 #define IX_EOF					 (START_IX_WARN + 3)
 #define IX_SCANNOTFINISHED       (START_IX_WARN + 4)
-#define IX_LASTWARN		IX_SCANNOTFINISHED                  
+#define IX_NOTEMPTY              (START_IX_WARN + 5)
+#define IX_LOADOPEN              (START_IX_WARN + 6)
+#define IX_LOADNOTOPEN           (START_IX_WARN + 7)
+#define IX_SCANSOPEN             (START_IX_WARN + 8)
+#define IX_LASTWARN		IX_SCANSOPEN
 
 #define IX_INVALIDENUM           (START_IX_ERR - 0)
 #define IX_NULLINPUT			 (START_IX_ERR - 1)
@@ -211,7 +810,11 @@ void IX_PrintError(RC rc);
 #define IX_INVALIDSCANCOMBO      (START_IX_ERR - 5)
 #define IX_INVALIDNUM            (START_IX_ERR - 6)
 #define IX_TOOMANYSAME			 (START_IX_ERR - 7)
-#define IX_LASTERROR	IX_TOOMANYSAME
+#define IX_KEYATTRS              (START_IX_ERR - 8)
+#define IX_HASHSCAN              (START_IX_ERR - 9)
+#define IX_NOTBITMAP             (START_IX_ERR - 10)
+#define IX_NOTBTREE              (START_IX_ERR - 11)
+#define IX_LASTERROR	IX_NOTBTREE
 
 
 #endif
@@ -0,0 +1,936 @@
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include "ix.h"
+
+using namespace std;
+
+// Bitmap indexes (see ix.h).  A key's bitmap pages hold its chunks in RID
+// page order, so the chunk of a rid is on the last page of the chain whose
+// first chunk is at or before the rid's page.  Only a key's single page is
+// ever left empty; the key goes once its last rid does.
+
+#define IX_CHUNK_BYTES (IX_BITMAP_SLOTS / 8)   // largest bitset
+
+enum { IX_AND, IX_OR, IX_ANDNOT };
+
+static PageNum ChunkPage(const char* chunk)
+{
+	PageNum page;
+	memcpy(&page, chunk, sizeof(PageNum));
+	return page;
+}
+
+static int ChunkSlots(const char* chunk)
+{
+	short numSlots;
+	memcpy(&numSlots, chunk + sizeof(PageNum), sizeof(short));
+	return numSlots;
+}
+
+static int ChunkBytes(const char* chunk)
+{
+	short numBytes;
+	memcpy(&numBytes, chunk + sizeof(PageNum) + sizeof(short), sizeof(short));
+	return numBytes;
+}
+
+static int ChunkSize(const char* chunk)
+{
+	return IX_CHUNK_HEADER + ChunkBytes(chunk);
+}
+
+static bool ChunkIsArray(const char* chunk)
+{
+	return ChunkBytes(chunk) == ChunkSlots(chunk) * (int)sizeof(unsigned short);
+}
+
+// Expands a chunk into a bitset of IX_CHUNK_BYTES
+static void DecodeChunk(const char* chunk, unsigned char* bits)
+{
+	memset(bits, 0, IX_CHUNK_BYTES);
+	const char* ptr = chunk + IX_CHUNK_HEADER;
+	if (ChunkIsArray(chunk)){
+		for (int i = ChunkSlots(chunk); i > 0; --i, ptr += sizeof(unsigned short)){
+			unsigned short slot;
+			memcpy(&slot, ptr, sizeof(unsigned short));
+			bits[slot / 8] |= 1 << (slot % 8);
+		}
+	}
+	else
+		memcpy(bits, ptr, ChunkBytes(chunk));
+}
+
+// Writes page's chunk from a bitset, the array or the bitset up to its
+// last byte set, whichever is smaller; returns its size, 0 if no slot is set
+static int EncodeChunk(PageNum page, const unsigned char* bits, char* chunk)
+{
+	int count = 0;
+	int last = -1;
+	for (int i = 0; i < IX_CHUNK_BYTES; ++i)
+		if (bits[i]){
+			count += __builtin_popcount(bits[i]);
+			last = i;
+		}
+	if (count == 0)
+		return 0;
+
+	short numSlots = count;
+	short numBytes;
+	char* ptr = chunk + IX_CHUNK_HEADER;
+	if (count * (int)sizeof(unsigned short) <= last + 1){
+		numBytes = count * sizeof(unsigned short);
+		for (int i = 0; i <= last; ++i)
+			for (int b = 0; bits[i] >> b; ++b)
+				if ((bits[i] >> b) & 1){
+					unsigned short slot = i * 8 + b;
+					memcpy(ptr, &slot, sizeof(unsigned short));
+					ptr += sizeof(unsigned short);
+				}
+	}
+	else {
+		numBytes = last + 1;
+		memcpy(ptr, bits, numBytes);
+	}
+	memcpy(chunk, &page, sizeof(PageNum));
+	memcpy(chunk + sizeof(PageNum), &numSlots, sizeof(short));
+	memcpy(chunk + sizeof(PageNum) + sizeof(short), &numBytes, sizeof(short));
+	return IX_CHUNK_HEADER + numBytes;
+}
+
+IX_Bitmap::IX_Bitmap(): data(NULL), size(0), capacity(0)
+{}
+
+IX_Bitmap::IX_Bitmap(const IX_Bitmap &other): data(NULL), size(0), capacity(0)
+{
+	Append(other.data, other.size);
+}
+
+IX_Bitmap::~IX_Bitmap()
+{
+	delete [] data;
+}
+
+IX_Bitmap& IX_Bitmap::operator=(const IX_Bitmap &other)
+{
+	if (this != &other){
+		size = 0;
+		Append(other.data, other.size);
+	}
+	return *this;
+}
+
+void IX_Bitmap::Reserve(int bytes)
+{
+	if (bytes <= capacity)
+		return;
+	capacity = max(bytes, max(2 * capacity, 64));
+	char* grown = new char[capacity];
+	if (size > 0)
+		memcpy(grown, data, size);
+	delete [] data;
+	data = grown;
+}
+
+void IX_Bitmap::Append(const char* chunks, int bytes)
+{
+	Reserve(size + bytes);
+	if (bytes > 0)
+		memcpy(data + size, chunks, bytes);
+	size += bytes;
+}
+
+void IX_Bitmap::Clear()
+{
+	size = 0;
+}
+
+bool IX_Bitmap::FindChunk(PageNum page, int &offset) const
+{
+	for (offset = 0; offset < size; offset += ChunkSize(data + offset)){
+		PageNum chunkPage = ChunkPage(data + offset);
+		if (chunkPage >= page)
+			return chunkPage == page;
+	}
+	return false;
+}
+
+RC IX_Bitmap::SetSlot(const RID &rid, bool value)
+{
+	if (rid.pageNum < 0 || rid.slotNum < 0 || rid.slotNum >= IX_BITMAP_SLOTS){
+		PrintError(IX_INVALIDNUM);
+		return IX_INVALIDNUM;
+	}
+
+	unsigned char bits[IX_CHUNK_BYTES];
+	int offset;
+	int oldSize = 0;
+	if (FindChunk(rid.pageNum, offset)){
+		DecodeChunk(data + offset, bits);
+		oldSize = ChunkSize(data + offset);
+	}
+	else
+		memset(bits, 0, IX_CHUNK_BYTES);
+	if (value)
+		bits[rid.slotNum / 8] |= 1 << (rid.slotNum % 8);
+	else
+		bits[rid.slotNum / 8] &= ~(1 << (rid.slotNum % 8));
+
+	// Replace the chunk in place
+	char chunk[IX_CHUNK_HEADER + IX_CHUNK_BYTES];
+	int newSize = EncodeChunk(rid.pageNum, bits, chunk);
+	Reserve(size - oldSize + newSize);
+	memmove(data + offset + newSize, data + offset + oldSize, size - offset - oldSize);
+	memcpy(data + offset, chunk, newSize);
+	size += newSize - oldSize;
+	return OK_RC;
+}
+
+RC IX_Bitmap::Add(const RID &rid)
+{
+	return SetSlot(rid, true);
+}
+
+RC IX_Bitmap::Remove(const RID &rid)
+{
+	return SetSlot(rid, false);
+}
+
+bool IX_Bitmap::Contains(const RID &rid) const
+{
+	int offset;
+	if (rid.slotNum < 0 || !FindChunk(rid.pageNum, offset))
+		return false;
+	const char* chunk = data + offset;
+	const char* ptr = chunk + IX_CHUNK_HEADER;
+	if (ChunkIsArray(chunk)){
+		for (int i = ChunkSlots(chunk); i > 0; --i, ptr += sizeof(unsigned short)){
+			unsigned short slot;
+			memcpy(&slot, ptr, sizeof(unsigned short));
+			if (slot == rid.slotNum)
+				return true;
+		}
+		return false;
+	}
+	return rid.slotNum / 8 < ChunkBytes(chunk) && ((ptr[rid.slotNum / 8] >> (rid.slotNum % 8)) & 1);
+}
+
+int IX_Bitmap::Count() const
+{
+	int count = 0;
+	for (int offset = 0; offset < size; offset += ChunkSize(data + offset))
+		count += ChunkSlots(data + offset);
+	return count;
+}
+
+RC IX_Bitmap::GetRids(RID* &rids, int &numRids) const
+{
+	numRids = Count();
+	rids = new RID[numRids > 0 ? numRids : 1];
+	int n = 0;
+	unsigned char bits[IX_CHUNK_BYTES];
+	for (int offset = 0; offset < size; offset += ChunkSize(data + offset)){
+		const char* chunk = data + offset;
+		PageNum page = ChunkPage(chunk);
+		DecodeChunk(chunk, bits);
+		for (int i = 0; i < IX_CHUNK_BYTES; ++i)
+			for (int b = 0; bits[i] >> b; ++b)
+				if ((bits[i] >> b) & 1)
+					rids[n++] = RID(page, i * 8 + b);
+	}
+	return OK_RC;
+}
+
+// Merges the two chunk sequences by page; only pages in both are decoded.
+// A merged chunk may take more bytes than the two it came from, so the
+// result grows as it is written
+void IX_Bitmap::Combine(const IX_Bitmap &other, int op)
+{
+	IX_Bitmap result;
+	result.Reserve(size + other.size);
+	unsigned char bits[IX_CHUNK_BYTES];
+	unsigned char otherBits[IX_CHUNK_BYTES];
+	char chunk[IX_CHUNK_HEADER + IX_CHUNK_BYTES];
+	int i = 0, j = 0;
+	while (i < size || j < other.size){
+		const char* one = data + i;
+		const char* two = other.data + j;
+		if (j == other.size || (i < size && ChunkPage(one) < ChunkPage(two))){
+			if (op != IX_AND)
+				result.Append(one, ChunkSize(one));
+			i += ChunkSize(one);
+		}
+		else if (i == size || ChunkPage(two) < ChunkPage(one)){
+			if (op == IX_OR)
+				result.Append(two, ChunkSize(two));
+			j += ChunkSize(two);
+		}
+		else {
+			DecodeChunk(one, bits);
+			DecodeChunk(two, otherBits);
+			for (int k = 0; k < IX_CHUNK_BYTES; ++k){
+				if (op == IX_AND)
+					bits[k] &= otherBits[k];
+				else if (op == IX_OR)
+					bits[k] |= otherBits[k];
+				else
+					bits[k] &= ~otherBits[k];
+			}
+			result.Append(chunk, EncodeChunk(ChunkPage(one), bits, chunk));
+			i += ChunkSize(one);
+			j += ChunkSize(two);
+		}
+	}
+	std::swap(data, result.data);
+	std::swap(size, result.size);
+	std::swap(capacity, result.capacity);
+}
+
+void IX_Bitmap::And(const IX_Bitmap &other)
+{
+	Combine(other, IX_AND);
+}
+
+void IX_Bitmap::Or(const IX_Bitmap &other)
+{
+	Combine(other, IX_OR);
+}
+
+void IX_Bitmap::AndNot(const IX_Bitmap &other)
+{
+	Combine(other, IX_ANDNOT);
+}
+
+void IX_Bitmap::Not(const IX_Bitmap &universe)
+{
+	IX_Bitmap result(universe);
+	result.AndNot(*this);
+	*this = result;
+}
+
+static RC GetBitmapPage(const PF_FileHandle &fileHandle, PageNum pageNum, char* &pData)
+{
+	PF_PageHandle pfPageHandle;
+	RC rc = fileHandle.GetThisPage(pageNum, pfPageHandle);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	rc = pfPageHandle.GetData(pData);
+	if (rc != OK_RC){
+		fileHandle.UnpinPage(pageNum);
+		PrintError(rc);
+		return rc;
+	}
+	return OK_RC;
+}
+
+// Allocates an empty directory or bitmap page, left pinned; both start
+// with a count and the next page
+static RC NewBitmapPage(PF_FileHandle &fileHandle, PageNum &pageNum, char* &pData)
+{
+	PF_PageHandle pfPageHandle;
+	RC rc = fileHandle.AllocatePage(pfPageHandle);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	if ((rc = pfPageHandle.GetPageNum(pageNum)) ||
+		(rc = pfPageHandle.GetData(pData))){
+		PrintError(rc);
+		return rc;
+	}
+
+	IX_BitmapPageHeader header;
+	header.numBytes = 0;
+	header.nextPage = IX_NO_PAGE;
+	memcpy(pData, &header, sizeof(IX_BitmapPageHeader));
+	return OK_RC;
+}
+
+static RC ReleaseBitmapPage(const PF_FileHandle &fileHandle, PageNum pageNum, bool dirty)
+{
+	RC rc;
+	if (dirty && (rc = fileHandle.MarkDirty(pageNum))){
+		fileHandle.UnpinPage(pageNum);
+		PrintError(rc);
+		return rc;
+	}
+	rc = fileHandle.UnpinPage(pageNum);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	return OK_RC;
+}
+
+static int ValueSize(int attrLength)
+{
+	return attrLength + 2 * sizeof(PageNum) + sizeof(int);
+}
+
+RC IX_IndexHandle::ReadBitmapValues(char* &values, int &numValues) const
+{
+	int valueSize = ValueSize(ixIndexHeader.attrLength);
+	vector<char> all;
+	PageNum dirPage = ixIndexHeader.rootPage;
+	while (dirPage != IX_NO_PAGE){
+		char* pData;
+		RC rc = GetBitmapPage(pfFileHandle, dirPage, pData);
+		if (rc != OK_RC)
+			return rc;
+		IX_BitmapDirHeader header;
+		memcpy(&header, pData, sizeof(IX_BitmapDirHeader));
+		char* entries = pData + sizeof(IX_BitmapDirHeader);
+		all.insert(all.end(), entries, entries + header.numValues * valueSize);
+		if (rc = ReleaseBitmapPage(pfFileHandle, dirPage, false))
+			return rc;
+		dirPage = header.nextPage;
+	}
+	numValues = all.size() / valueSize;
+	values = new char[all.size() > 0 ? all.size() : 1];
+	if (!all.empty())
+		memcpy(values, &all[0], all.size());
+	return OK_RC;
+}
+
+RC IX_IndexHandle::FindBitmapValue(const void* attribute, PageNum &dirPage, int &valueNum,
+	PageNum &roomPage, PageNum &lastDirPage) const
+{
+	int valueSize = ValueSize(ixIndexHeader.attrLength);
+	valueNum = -1;
+	roomPage = IX_NO_PAGE;
+	PageNum pageNum = ixIndexHeader.rootPage;
+	while (pageNum != IX_NO_PAGE){
+		char* pData;
+		RC rc = GetBitmapPage(pfFileHandle, pageNum, pData);
+		if (rc != OK_RC)
+			return rc;
+		IX_BitmapDirHeader header;
+		memcpy(&header, pData, sizeof(IX_BitmapDirHeader));
+		for (int i = 0; valueNum == -1 && i < header.numValues; ++i)
+			if (CompareKey(pData + sizeof(IX_BitmapDirHeader) + i * valueSize, attribute) == 0){
+				dirPage = pageNum;
+				valueNum = i;
+			}
+		if (roomPage == IX_NO_PAGE && header.numValues <= ixIndexHeader.maxEntryIndex)
+			roomPage = pageNum;
+		if (rc = ReleaseBitmapPage(pfFileHandle, pageNum, false))
+			return rc;
+		if (valueNum != -1)
+			return OK_RC;
+		lastDirPage = pageNum;
+		pageNum = header.nextPage;
+	}
+	return OK_RC;
+}
+
+// Adds a key with a single empty bitmap page, in a new directory page if
+// none has room
+RC IX_IndexHandle::AddBitmapValue(const void* attribute, PageNum roomPage, PageNum lastDirPage,
+	PageNum &dirPage, int &valueNum)
+{
+	PageNum firstPage;
+	char* pData;
+	RC rc = NewBitmapPage(pfFileHandle, firstPage, pData);
+	if (rc != OK_RC)
+		return rc;
+	if (rc = ReleaseBitmapPage(pfFileHandle, firstPage, true))
+		return rc;
+	if (roomPage == IX_NO_PAGE){
+		if ((rc = NewBitmapPage(pfFileHandle, roomPage, pData)) ||
+			(rc = ReleaseBitmapPage(pfFileHandle, roomPage, true)) ||
+			(rc = SetBitmapLink(lastDirPage, roomPage)))
+			return rc;
+	}
+
+	if (rc = GetBitmapPage(pfFileHandle, roomPage, pData))
+		return rc;
+	IX_BitmapDirHeader header;
+	memcpy(&header, pData, sizeof(IX_BitmapDirHeader));
+	char* ptr = pData + sizeof(IX_BitmapDirHeader) + header.numValues * ValueSize(ixIndexHeader.attrLength);
+	int numRids = 0;
+	memcpy(ptr, attribute, ixIndexHeader.attrLength);
+	ptr += ixIndexHeader.attrLength;
+	memcpy(ptr, &firstPage, sizeof(PageNum));
+	memcpy(ptr + sizeof(PageNum), &firstPage, sizeof(PageNum));
+	memcpy(ptr + 2 * sizeof(PageNum), &numRids, sizeof(int));
+	dirPage = roomPage;
+	valueNum = header.numValues++;
+	memcpy(pData, &header, sizeof(IX_BitmapDirHeader));
+	return ReleaseBitmapPage(pfFileHandle, roomPage, true);
+}
+
+// The directory page's last entry takes the removed one's place
+RC IX_IndexHandle::RemoveBitmapValue(PageNum dirPage, int valueNum)
+{
+	int valueSize = ValueSize(ixIndexHeader.attrLength);
+	char* pData;
+	RC rc = GetBitmapPage(pfFileHandle, dirPage, pData);
+	if (rc != OK_RC)
+		return rc;
+	IX_BitmapDirHeader header;
+	memcpy(&header, pData, sizeof(IX_BitmapDirHeader));
+	char* entries = pData + sizeof(IX_BitmapDirHeader);
+	--header.numValues;
+	if (valueNum != header.numValues)
+		memcpy(entries + valueNum * valueSize, entries + header.numValues * valueSize, valueSize);
+	memcpy(pData, &header, sizeof(IX_BitmapDirHeader));
+	return ReleaseBitmapPage(pfFileHandle, dirPage, true);
+}
+
+RC IX_IndexHandle::GetBitmapValue(PageNum dirPage, int valueNum, PageNum &firstPage, PageNum &lastPage, int &numRids) const
+{
+	char* pData;
+	RC rc = GetBitmapPage(pfFileHandle, dirPage, pData);
+	if (rc != OK_RC)
+		return rc;
+	char* ptr = pData + sizeof(IX_BitmapDirHeader) + valueNum * ValueSize(ixIndexHeader.attrLength) + ixIndexHeader.attrLength;
+	memcpy(&firstPage, ptr, sizeof(PageNum));
+	memcpy(&lastPage, ptr + sizeof(PageNum), sizeof(PageNum));
+	memcpy(&numRids, ptr + 2 * sizeof(PageNum), sizeof(int));
+	return ReleaseBitmapPage(pfFileHandle, dirPage, false);
+}
+
+RC IX_IndexHandle::SetBitmapValue(PageNum dirPage, int valueNum, PageNum firstPage, PageNum lastPage, int numRids)
+{
+	char* pData;
+	RC rc = GetBitmapPage(pfFileHandle, dirPage, pData);
+	if (rc != OK_RC)
+		return rc;
+	char* ptr = pData + sizeof(IX_BitmapDirHeader) + valueNum * ValueSize(ixIndexHeader.attrLength) + ixIndexHeader.attrLength;
+	memcpy(ptr, &firstPage, sizeof(PageNum));
+	memcpy(ptr + sizeof(PageNum), &lastPage, sizeof(PageNum));
+	memcpy(ptr + 2 * sizeof(PageNum), &numRids, sizeof(int));
+	return ReleaseBitmapPage(pfFileHandle, dirPage, true);
+}
+
+RC IX_IndexHandle::ReadBitmapPage(PageNum pageNum, IX_Bitmap* bitmap, PageNum &nextPage, PageNum &firstRidPage) const
+{
+	char* pData;
+	RC rc = GetBitmapPage(pfFileHandle, pageNum, pData);
+	if (rc != OK_RC)
+		return rc;
+	IX_BitmapPageHeader header;
+	memcpy(&header, pData, sizeof(IX_BitmapPageHeader));
+	char* chunks = pData + sizeof(IX_BitmapPageHeader);
+	if (bitmap){
+		bitmap->Clear();
+		bitmap->Append(chunks, header.numBytes);
+	}
+	nextPage = header.nextPage;
+	firstRidPage = (header.numBytes > 0) ? ChunkPage(chunks) : IX_NO_PAGE;
+	return ReleaseBitmapPage(pfFileHandle, pageNum, false);
+}
+
+// Fills pageNum with as many whole chunks as fit, then new pages linked
+// after it with the rest; lastPage is the last page written
+RC IX_IndexHandle::WriteBitmapPages(PageNum pageNum, const IX_Bitmap &bitmap, PageNum &lastPage)
+{
+	char* pData;
+	RC rc = GetBitmapPage(pfFileHandle, pageNum, pData);
+	if (rc != OK_RC)
+		return rc;
+	IX_BitmapPageHeader header;
+	memcpy(&header, pData, sizeof(IX_BitmapPageHeader));
+	PageNum after = header.nextPage;
+
+	int offset = 0;
+	while (true){
+		int end = offset;
+		while (end < bitmap.size && end + ChunkSize(bitmap.data + end) - offset <= IX_BITMAP_BYTES)
+			end += ChunkSize(bitmap.data + end);
+		PageNum newPage = IX_NO_PAGE;
+		char* newData = NULL;
+		if (end < bitmap.size && (rc = NewBitmapPage(pfFileHandle, newPage, newData))){
+			ReleaseBitmapPage(pfFileHandle, pageNum, false);
+			return rc;
+		}
+		header.numBytes = end - offset;
+		header.nextPage = (newPage != IX_NO_PAGE) ? newPage : after;
+		memcpy(pData, &header, sizeof(IX_BitmapPageHeader));
+		memcpy(pData + sizeof(IX_BitmapPageHeader), bitmap.data + offset, end - offset);
+		if (rc = ReleaseBitmapPage(pfFileHandle, pageNum, true))
+			return rc;
+		if (newPage == IX_NO_PAGE)
+			break;
+		pageNum = newPage;
+		pData = newData;
+		offset = end;
+	}
+	lastPage = pageNum;
+	return OK_RC;
+}
+
+RC IX_IndexHandle::SetBitmapLink(PageNum pageNum, PageNum nextPage)
+{
+	char* pData;
+	RC rc = GetBitmapPage(pfFileHandle, pageNum, pData);
+	if (rc != OK_RC)
+		return rc;
+	memcpy(pData + sizeof(int), &nextPage, sizeof(PageNum));
+	return ReleaseBitmapPage(pfFileHandle, pageNum, true);
+}
+
+RC IX_IndexHandle::ReadBitmap(PageNum firstPage, IX_Bitmap &bitmap) const
+{
+	bitmap.Clear();
+	PageNum pageNum = firstPage;
+	while (pageNum != IX_NO_PAGE){
+		char* pData;
+		RC rc = GetBitmapPage(pfFileHandle, pageNum, pData);
+		if (rc != OK_RC)
+			return rc;
+		IX_BitmapPageHeader header;
+		memcpy(&header, pData, sizeof(IX_BitmapPageHeader));
+		bitmap.Append(pData + sizeof(IX_BitmapPageHeader), header.numBytes);
+		if (rc = ReleaseBitmapPage(pfFileHandle, pageNum, false))
+			return rc;
+		pageNum = header.nextPage;
+	}
+	return OK_RC;
+}
+
+RC IX_IndexHandle::FindBitmapPage(PageNum firstPage, PageNum ridPage, PageNum &pageNum, PageNum &prevPage) const
+{
+	pageNum = firstPage;
+	prevPage = IX_NO_PAGE;
+	PageNum page = firstPage;
+	PageNum prev = IX_NO_PAGE;
+	while (page != IX_NO_PAGE){
+		PageNum nextPage, firstRidPage;
+		RC rc = ReadBitmapPage(page, NULL, nextPage, firstRidPage);
+		if (rc != OK_RC)
+			return rc;
+		if (firstRidPage > ridPage)
+			break;
+		pageNum = page;
+		prevPage = prev;
+		prev = page;
+		page = nextPage;
+	}
+	return OK_RC;
+}
+
+// Rids mostly arrive in order, onto the key's last page
+RC IX_IndexHandle::BitmapInsert(void* attribute, const RID &rid)
+{
+	if (rid.pageNum < 0 || rid.slotNum < 0 || rid.slotNum >= IX_BITMAP_SLOTS){
+		PrintError(IX_INVALIDNUM);
+		return IX_INVALIDNUM;
+	}
+	PageNum dirPage, roomPage, lastDirPage;
+	int valueNum;
+	RC rc = FindBitmapValue(attribute, dirPage, valueNum, roomPage, lastDirPage);
+	if (rc != OK_RC)
+		return rc;
+	if (valueNum == -1 && (rc = AddBitmapValue(attribute, roomPage, lastDirPage, dirPage, valueNum)))
+		return rc;
+	PageNum firstPage, lastPage;
+	int numRids;
+	if (rc = GetBitmapValue(dirPage, valueNum, firstPage, lastPage, numRids))
+		return rc;
+
+	IX_Bitmap bitmap;
+	PageNum pageNum = lastPage;
+	PageNum nextPage, firstRidPage, prevPage;
+	if (rc = ReadBitmapPage(lastPage, NULL, nextPage, firstRidPage))
+		return rc;
+	if (firstRidPage > rid.pageNum && (rc = FindBitmapPage(firstPage, rid.pageNum, pageNum, prevPage)))
+		return rc;
+	if (rc = ReadBitmapPage(pageNum, &bitmap, nextPage, firstRidPage))
+		return rc;
+	if (bitmap.Contains(rid))
+		return OK_RC;
+	PageNum written;
+	if ((rc = bitmap.Add(rid)) ||
+		(rc = WriteBitmapPages(pageNum, bitmap, written)))
+		return rc;
+	if (pageNum == lastPage)
+		lastPage = written;
+	return SetBitmapValue(dirPage, valueNum, firstPage, lastPage, numRids + 1);
+}
+
+RC IX_IndexHandle::BitmapDelete(void* attribute, const RID &rid)
+{
+	PageNum dirPage, roomPage, lastDirPage;
+	int valueNum;
+	RC rc = FindBitmapValue(attribute, dirPage, valueNum, roomPage, lastDirPage);
+	if (rc != OK_RC)
+		return rc;
+	PageNum firstPage, lastPage, pageNum, prevPage, nextPage, firstRidPage;
+	int numRids;
+	IX_Bitmap bitmap;
+	if (valueNum != -1 &&
+		((rc = GetBitmapValue(dirPage, valueNum, firstPage, lastPage, numRids)) ||
+		(rc = FindBitmapPage(firstPage, rid.pageNum, pageNum, prevPage)) ||
+		(rc = ReadBitmapPage(pageNum, &bitmap, nextPage, firstRidPage))))
+		return rc;
+	if (valueNum == -1 || !bitmap.Contains(rid)){
+		PrintError(IX_ENTRYDNE);
+		return IX_ENTRYDNE;
+	}
+	if (rc = bitmap.Remove(rid))
+		return rc;
+
+	// The key goes with its last rid
+	if (numRids == 1){
+		if (rc = RemoveBitmapValue(dirPage, valueNum))
+			return rc;
+		rc = pfFileHandle.DisposePage(pageNum);
+		if (rc != OK_RC){
+			PrintError(rc);
+			return rc;
+		}
+		return OK_RC;
+	}
+
+	// An emptied page is unlinked, else rewritten; removing a rid never
+	// grows a chunk
+	if (bitmap.size == 0){
+		if (prevPage == IX_NO_PAGE)
+			firstPage = nextPage;
+		else if (rc = SetBitmapLink(prevPage, nextPage))
+			return rc;
+		if (pageNum == lastPage)
+			lastPage = prevPage;
+		rc = pfFileHandle.DisposePage(pageNum);
+		if (rc != OK_RC){
+			PrintError(rc);
+			return rc;
+		}
+	}
+	else {
+		PageNum written;
+		if (rc = WriteBitmapPages(pageNum, bitmap, written))
+			return rc;
+	}
+	return SetBitmapValue(dirPage, valueNum, firstPage, lastPage, numRids - 1);
+}
+
+RC IX_IndexHandle::GetBitmap(CompOp compOp, void *value, IX_Bitmap &bitmap) const
+{
+	if (!open){
+		PrintError(IX_FILENOTOPEN);
+		return IX_FILENOTOPEN;
+	}
+	if (ixIndexHeader.indexType != BITMAP_INDEX){
+		PrintError(IX_NOTBITMAP);
+		return IX_NOTBITMAP;
+	}
+	if (compOp != NO_OP && !value){
+		PrintError(IX_NULLINPUT);
+		return IX_NULLINPUT;
+	}
+
+	RC rc = LatchIndex(PF_SHARED);
+	if (rc != OK_RC)
+		return rc;
+	int valueSize = ValueSize(ixIndexHeader.attrLength);
+	char* values;
+	int numValues;
+	bitmap.Clear();
+	if ((rc = ReadBitmapValues(values, numValues)) == OK_RC){
+		IX_Bitmap one;
+		for (int i = 0; i < numValues && rc == OK_RC; ++i){
+			char* key = values + i * valueSize;
+			if (!AttrSatisfiesCondition(key, compOp, value, ixIndexHeader.attrType, ixIndexHeader.attrLength))
+				continue;
+			PageNum firstPage;
+			memcpy(&firstPage, key + ixIndexHeader.attrLength, sizeof(PageNum));
+			if ((rc = ReadBitmap(firstPage, one)) == OK_RC)
+				bitmap.Or(one);
+		}
+		delete [] values;
+	}
+	RC latchRC = UnlatchIndex(PF_SHARED);
+	return (rc != OK_RC) ? rc : latchRC;
+}
+
+// Every key's chain of bitmap pages
+RC IX_IndexHandle::BitmapStats(int &numPages, int &fillTotal) const
+{
+	int valueSize = ValueSize(ixIndexHeader.attrLength);
+	char* values;
+	int numValues;
+	RC rc = ReadBitmapValues(values, numValues);
+	if (rc != OK_RC)
+		return rc;
+	for (int i = 0; i < numValues && rc == OK_RC; ++i){
+		PageNum pageNum;
+		memcpy(&pageNum, values + i * valueSize + ixIndexHeader.attrLength, sizeof(PageNum));
+		while (pageNum != IX_NO_PAGE){
+			char* pData;
+			if (rc = GetBitmapPage(pfFileHandle, pageNum, pData))
+				break;
+			IX_BitmapPageHeader header;
+			memcpy(&header, pData, sizeof(IX_BitmapPageHeader));
+			if (rc = ReleaseBitmapPage(pfFileHandle, pageNum, false))
+				break;
+			++numPages;
+			fillTotal += header.numBytes * 100 / IX_BITMAP_BYTES;
+			pageNum = header.nextPage;
+		}
+	}
+	delete [] values;
+	return rc;
+}
+
+// Directory entries hold each key's rid count, so counts and the smallest
+// and largest keys need only the directory
+RC IX_IndexHandle::BitmapCount(void *lowValue, bool lowInclusive, void *highValue,
+	bool highInclusive, int &numRids, int &numKeys) const
+{
+	numRids = 0;
+	numKeys = 0;
+	RC rc = LatchIndex(PF_SHARED);
+	if (rc != OK_RC)
+		return rc;
+	int valueSize = ValueSize(ixIndexHeader.attrLength);
+	char* values;
+	int numValues;
+	if ((rc = ReadBitmapValues(values, numValues)) == OK_RC){
+		for (int i = 0; i < numValues; ++i){
+			char* key = values + i * valueSize;
+			int lowCmp = lowValue ? CompareKey(key, lowValue) : 1;
+			int highCmp = highValue ? CompareKey(key, highValue) : -1;
+			if (lowCmp < 0 || (lowCmp == 0 && !lowInclusive) ||
+				highCmp > 0 || (highCmp == 0 && !highInclusive))
+				continue;
+			int keyRids;
+			memcpy(&keyRids, key + ixIndexHeader.attrLength + 2 * sizeof(PageNum), sizeof(int));
+			numRids += keyRids;
+			++numKeys;
+		}
+		delete [] values;
+	}
+	RC latchRC = UnlatchIndex(PF_SHARED);
+	return (rc != OK_RC) ? rc : latchRC;
+}
+
+RC IX_IndexHandle::BitmapEdgeKey(bool last, void* key) const
+{
+	RC rc = LatchIndex(PF_SHARED);
+	if (rc != OK_RC)
+		return rc;
+	int valueSize = ValueSize(ixIndexHeader.attrLength);
+	char* values;
+	int numValues;
+	if ((rc = ReadBitmapValues(values, numValues)) == OK_RC){
+		char* best = NULL;
+		for (int i = 0; i < numValues; ++i){
+			char* one = values + i * valueSize;
+			int cmp = best ? CompareKey(one, best) : 0;
+			if (!best || (last ? cmp > 0 : cmp < 0))
+				best = one;
+		}
+		if (best)
+			memcpy(key, best, ixIndexHeader.attrLength);
+		else
+			rc = IX_EOF;
+		delete [] values;
+	}
+	RC latchRC = UnlatchIndex(PF_SHARED);
+	return (rc != OK_RC) ? rc : latchRC;
+}
+
+// Orders directory entries by key
+struct IX_ValueLess {
+	const IX_IndexHandle* ih;
+	const char* values;
+	int valueSize;
+	IX_ValueLess(const IX_IndexHandle* ih, const char* values, int valueSize): ih(ih), values(values), valueSize(valueSize) {}
+	bool operator()(int one, int two) const {
+		return ih->CompareKey(values + one * valueSize, values + two * valueSize) < 0;
+	}
+};
+
+// Keeps the directory entries of the keys within the bounds, in scan order
+RC IX_IndexScan::OpenBitmapScan()
+{
+	int attrLength = ixIndexHandle->ixIndexHeader.attrLength;
+	int valueSize = ValueSize(attrLength);
+	char* values;
+	int numValues;
+	RC rc = ixIndexHandle->ReadBitmapValues(values, numValues);
+	if (rc != OK_RC)
+		return rc;
+	vector<int> order;
+	for (int i = 0; i < numValues; ++i){
+		char* key = values + i * valueSize;
+		int cmp;
+		if (lowValue && ((cmp = ixIndexHandle->CompareKey(key, lowValue)) < 0 || (cmp == 0 && !lowInclusive)))
+			continue;
+		if (highValue && ((cmp = ixIndexHandle->CompareKey(key, highValue)) > 0 || (cmp == 0 && !highInclusive)))
+			continue;
+		order.push_back(i);
+	}
+	sort(order.begin(), order.end(), IX_ValueLess(ixIndexHandle, values, valueSize));
+	if (reverse)
+		std::reverse(order.begin(), order.end());
+	numBitmapValues = order.size();
+	bitmapValues = new char[numBitmapValues > 0 ? numBitmapValues * valueSize : 1];
+	for (int i = 0; i < numBitmapValues; ++i)
+		memcpy(bitmapValues + i * valueSize, values + order[i] * valueSize, valueSize);
+	delete [] values;
+	nextBitmapValue = 0;
+
+	entrySize = attrLength + sizeof(PageNum) + sizeof(SlotNum);
+	numBucketEntries = 0;
+	nextBucketEntry = 0;
+	open = true;
+	__sync_fetch_and_add(&ixIndexHandle->openScans, 1);
+	finished = false;
+	numPostings = 0;
+	nextPosting = 0;
+	lastEntry = new char[entrySize];
+	currEntry = new char[entrySize];
+	return OK_RC;
+}
+
+// Reads the next key's bitmap once the last one's rids are returned.  The
+// key is looked up again, as deletes may have moved or dropped it since
+// the scan opened
+RC IX_IndexScan::GetNextBitmapEntry(RID &rid)
+{
+	RC rc;
+	int attrLength = ixIndexHandle->ixIndexHeader.attrLength;
+	while (nextBucketEntry == numBucketEntries){
+		if (nextBitmapValue == numBitmapValues){
+			finished = true;
+			return IX_EOF;
+		}
+		char* key = bitmapValues + nextBitmapValue++ * ValueSize(attrLength);
+		PageNum dirPage, roomPage, lastDirPage, firstPage, lastPage;
+		int valueNum, numRids;
+		if (rc = ixIndexHandle->FindBitmapValue(key, dirPage, valueNum, roomPage, lastDirPage))
+			return rc;
+		if (valueNum == -1)
+			continue;
+		IX_Bitmap bitmap;
+		RID* rids;
+		if ((rc = ixIndexHandle->GetBitmapValue(dirPage, valueNum, firstPage, lastPage, numRids)) ||
+			(rc = ixIndexHandle->ReadBitmap(firstPage, bitmap)) ||
+			(rc = bitmap.GetRids(rids, numRids)))
+			return rc;
+		delete [] bucketEntries;
+		bucketEntries = new char[(numRids > 0 ? numRids : 1) * entrySize];
+		for (int i = 0; i < numRids; ++i){
+			char* entry = bucketEntries + i * entrySize;
+			const RID &one = rids[reverse ? numRids - 1 - i : i];
+			memcpy(entry, key, attrLength);
+			memcpy(entry + attrLength, &one.pageNum, sizeof(PageNum));
+			memcpy(entry + attrLength + sizeof(PageNum), &one.slotNum, sizeof(SlotNum));
+		}
+		delete [] rids;
+		numBucketEntries = numRids;
+		nextBucketEntry = 0;
+	}
+
+	const char* entry = bucketEntries + nextBucketEntry * entrySize;
+	memcpy(lastEntry, entry, entrySize);
+	memcpy(&rid.pageNum, entry + attrLength, sizeof(PageNum));
+	memcpy(&rid.slotNum, entry + attrLength + sizeof(PageNum), sizeof(SlotNum));
+	++nextBucketEntry;
+	return OK_RC;
+}
@@ -0,0 +1,194 @@
+#include <cstring>
+#include <vector>
+#include "ix.h"
+
+using namespace std;
+
+// Bloom filters.  The side file's page 0 holds the pages in use and the
+// pages allocated, {numPages allocPages}; pages 1 .. numPages hold the
+// bits.  A key's bits all fall in one page, chosen by its hash, so a probe
+// reads a single page.  Bits are only ever set, so a deleted key stays a
+// maybe until the filter is rebuilt.
+
+#define IX_BLOOM_PAGE_BITS (PF_PAGE_SIZE * 8)
+
+static unsigned int MixHash(unsigned int hash)
+{
+	hash ^= hash >> 15;
+	hash *= 0x2c1b3c6du;
+	hash ^= hash >> 12;
+	hash *= 0x297a2d39u;
+	hash ^= hash >> 15;
+	return hash;
+}
+
+// Double hashing within the page from two remixes of the key's hash
+void IX_IndexHandle::BloomBits(unsigned int hash, PageNum &pageNum, int* bits) const
+{
+	pageNum = 1 + hash % bloomPages;
+	unsigned int first = MixHash(hash);
+	unsigned int step = MixHash(first) | 1;
+	for (int i = 0; i < IX_BLOOM_HASHES; ++i)
+		bits[i] = (first + i * step) % IX_BLOOM_PAGE_BITS;
+}
+
+RC IX_IndexHandle::BloomProbe(const void* attribute, bool &mayContain) const
+{
+	mayContain = true;
+	if (!bloomOpen)
+		return OK_RC;
+
+	PageNum pageNum;
+	int bits[IX_BLOOM_HASHES];
+	BloomBits(HashKey(attribute), pageNum, bits);
+	PF_PageHandle pfPageHandle;
+	char* pData;
+	RC rc = bloomHandle.GetThisPage(pageNum, pfPageHandle);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	if (rc = pfPageHandle.GetData(pData)){
+		bloomHandle.UnpinPage(pageNum);
+		PrintError(rc);
+		return rc;
+	}
+	for (int i = 0; i < IX_BLOOM_HASHES && mayContain; ++i)
+		mayContain = (pData[bits[i] / 8] >> (bits[i] % 8)) & 1;
+	rc = bloomHandle.UnpinPage(pageNum);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	return OK_RC;
+}
+
+// Callers hold the index latch against other writers; readers may see a
+// byte before or after, either of which is right for them
+RC IX_IndexHandle::BloomAdd(const void* attribute)
+{
+	if (!bloomOpen)
+		return OK_RC;
+
+	PageNum pageNum;
+	int bits[IX_BLOOM_HASHES];
+	BloomBits(HashKey(attribute), pageNum, bits);
+	PF_PageHandle pfPageHandle;
+	char* pData;
+	RC rc = bloomHandle.GetThisPage(pageNum, pfPageHandle);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	if (rc = pfPageHandle.GetData(pData)){
+		bloomHandle.UnpinPage(pageNum);
+		PrintError(rc);
+		return rc;
+	}
+	for (int i = 0; i < IX_BLOOM_HASHES; ++i)
+		pData[bits[i] / 8] |= 1 << (bits[i] % 8);
+	if ((rc = bloomHandle.MarkDirty(pageNum)) ||
+		(rc = bloomHandle.UnpinPage(pageNum))){
+		PrintError(rc);
+		return rc;
+	}
+	return OK_RC;
+}
+
+// Pages are allocated in order and never disposed, so the pages in use
+// stay 1 .. numPages; a smaller filter leaves the pages past it for later
+RC IX_IndexHandle::ResetBloom(int numKeys)
+{
+	int numPages = (numKeys * IX_BLOOM_BITS + IX_BLOOM_PAGE_BITS - 1) / IX_BLOOM_PAGE_BITS;
+	if (numPages < 1)
+		numPages = 1;
+
+	PF_PageHandle pfPageHandle;
+	char* pData;
+	RC rc = bloomHandle.GetThisPage(0, pfPageHandle);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	if (rc = pfPageHandle.GetData(pData)){
+		bloomHandle.UnpinPage(0);
+		PrintError(rc);
+		return rc;
+	}
+	int allocPages;
+	memcpy(&allocPages, pData + sizeof(int), sizeof(int));
+	memcpy(pData, &numPages, sizeof(int));
+	if (allocPages < numPages)
+		memcpy(pData + sizeof(int), &numPages, sizeof(int));
+	if ((rc = bloomHandle.MarkDirty(0)) ||
+		(rc = bloomHandle.UnpinPage(0))){
+		PrintError(rc);
+		return rc;
+	}
+
+	for (PageNum i = 1; i <= numPages; ++i){
+		PageNum pageNum;
+		if (i > allocPages)
+			rc = bloomHandle.AllocatePage(pfPageHandle);
+		else
+			rc = bloomHandle.GetThisPage(i, pfPageHandle);
+		if (rc != OK_RC){
+			PrintError(rc);
+			return rc;
+		}
+		pfPageHandle.GetPageNum(pageNum);
+		if (rc = pfPageHandle.GetData(pData)){
+			bloomHandle.UnpinPage(pageNum);
+			PrintError(rc);
+			return rc;
+		}
+		memset(pData, 0, PF_PAGE_SIZE);
+		if ((rc = bloomHandle.MarkDirty(pageNum)) ||
+			(rc = bloomHandle.UnpinPage(pageNum))){
+			PrintError(rc);
+			return rc;
+		}
+	}
+	bloomPages = numPages;
+	return OK_RC;
+}
+
+// The keys are read with other writers kept out, then readers too while
+// the filter is cleared and refilled
+RC IX_IndexHandle::FillBloom()
+{
+	RC rc = LatchIndex(PF_UPDATE);
+	if (rc != OK_RC)
+		return rc;
+	int attrLength = ixIndexHeader.attrLength;
+	vector<char> keys;
+	RID rid;
+	char key[MAXSTRINGLEN + 1];
+	IX_IndexScan scan;
+	if ((rc = scan.OpenScan(*this, NO_OP, NULL)) == OK_RC){
+		// A key's rids come together, and it is kept once
+		while ((rc = scan.GetNextEntry(rid, key)) == OK_RC)
+			if (keys.empty() || memcmp(&keys[keys.size() - attrLength], key, attrLength) != 0)
+				keys.insert(keys.end(), key, key + attrLength);
+		if (rc == IX_EOF)
+			rc = scan.CloseScan();
+		else
+			scan.CloseScan();
+	}
+	if (rc != OK_RC){
+		UnlatchIndex(PF_UPDATE);
+		return rc;
+	}
+
+	if (rc = pfFileHandle.UpgradeLatch(0)){
+		UnlatchIndex(PF_UPDATE);
+		PrintError(rc);
+		return rc;
+	}
+	int numKeys = keys.size() / attrLength;
+	rc = ResetBloom(numKeys);
+	for (int i = 0; i < numKeys && rc == OK_RC; ++i)
+		rc = BloomAdd(&keys[i * attrLength]);
+	RC latchRC = UnlatchIndex(PF_EXCLUSIVE);
+	return (rc != OK_RC) ? rc : latchRC;
+}
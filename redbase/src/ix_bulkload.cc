@@ -0,0 +1,850 @@
+#include <cstring>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <algorithm>
+#include <iostream>
+#include "ix.h"
+
+using namespace std;
+
+// Orders keys as AttrSatisfiesCondition does
+static int CompareKeys(const char* one, const char* two, const IX_IndexHeader &header)
+{
+	if (header.numKeyAttrs > 0)
+		return memcmp(one, two, header.attrLength);
+	int cmp = 0;
+	switch(header.attrType) {
+	case INT: {
+		int o, t;
+		memcpy(&o, one, sizeof(int));
+		memcpy(&t, two, sizeof(int));
+		cmp = (o < t) ? -1 : (o > t);
+		break;
+	}
+	case FLOAT: {
+		float o, t;
+		memcpy(&o, one, sizeof(float));
+		memcpy(&t, two, sizeof(float));
+		cmp = (o < t) ? -1 : (o > t);
+		break;
+	}
+	case STRING:
+		cmp = strncmp(one, two, header.attrLength);
+		break;
+	}
+	return cmp;
+}
+
+// Orders entries {key, page, slot} by key, then RID
+static int CompareEntries(const char* one, const char* two, const IX_IndexHeader &header)
+{
+	int cmp = CompareKeys(one, two, header);
+	if (cmp != 0)
+		return cmp;
+
+	int attrLength = header.attrLength;
+	PageNum oPage, tPage;
+	SlotNum oSlot, tSlot;
+	memcpy(&oPage, one + attrLength, sizeof(PageNum));
+	memcpy(&tPage, two + attrLength, sizeof(PageNum));
+	if (oPage != tPage)
+		return (oPage < tPage) ? -1 : 1;
+	memcpy(&oSlot, one + attrLength + sizeof(PageNum), sizeof(SlotNum));
+	memcpy(&tSlot, two + attrLength + sizeof(PageNum), sizeof(SlotNum));
+	return (oSlot < tSlot) ? -1 : (oSlot > tSlot);
+}
+
+class IX_EntryLess {
+public:
+	IX_EntryLess(const char* entries, int entrySize, const IX_IndexHeader &header)
+		: entries(entries), entrySize(entrySize), header(&header) {}
+	bool operator()(int one, int two) const
+	{
+		return CompareEntries(entries + one * entrySize, entries + two * entrySize, *header) < 0;
+	}
+private:
+	const char* entries;
+	int entrySize;
+	const IX_IndexHeader* header;
+};
+
+// Sorts numEntries entries of buffer in place
+static void SortEntries(char* buffer, int numEntries, int entrySize, const IX_IndexHeader &header)
+{
+	vector<int> order(numEntries);
+	for (int i = 0; i < numEntries; ++i)
+		order[i] = i;
+	sort(order.begin(), order.end(), IX_EntryLess(buffer, entrySize, header));
+
+	vector<char> sorted(numEntries * entrySize);
+	for (int i = 0; i < numEntries; ++i)
+		memcpy(&sorted[i * entrySize], buffer + order[i] * entrySize, entrySize);
+	if (numEntries > 0)
+		memcpy(buffer, &sorted[0], numEntries * entrySize);
+}
+
+//
+// Receives sorted entries: either a run being written by an
+// intermediate merge pass, or the tree builder.
+//
+class IX_EntrySink {
+public:
+	virtual ~IX_EntrySink() {}
+	virtual RC Add(const char* entry) = 0;
+};
+
+// Writes entries to consecutive new pages of the sort file
+class IX_RunWriter : public IX_EntrySink {
+public:
+	IX_RunWriter(PF_FileHandle &fileHandle, int entrySize)
+		: fileHandle(fileHandle), entrySize(entrySize), perPage(PF_PAGE_SIZE / entrySize),
+		  firstPage(IX_NO_PAGE), numEntries(0), pData(NULL) {}
+
+	RC Add(const char* entry)
+	{
+		RC rc;
+		if (numEntries % perPage == 0){
+			if (rc = Unpin())
+				return rc;
+			PF_PageHandle pageHandle;
+			if ((rc = fileHandle.AllocatePage(pageHandle)) ||
+				(rc = pageHandle.GetPageNum(pageNum)) ||
+				(rc = pageHandle.GetData(pData))){
+				PrintError(rc);
+				return rc;
+			}
+			// A new sort file has no free pages, so a run's pages are consecutive
+			if (firstPage == IX_NO_PAGE)
+				firstPage = pageNum;
+		}
+		memcpy(pData + (numEntries % perPage) * entrySize, entry, entrySize);
+		++numEntries;
+		return OK_RC;
+	}
+
+	RC Unpin()
+	{
+		if (!pData)
+			return OK_RC;
+		pData = NULL;
+		RC rc;
+		if ((rc = fileHandle.MarkDirty(pageNum)) ||
+			(rc = fileHandle.UnpinPage(pageNum))){
+			PrintError(rc);
+			return rc;
+		}
+		return OK_RC;
+	}
+
+	PageNum FirstPage() const { return firstPage; }
+	int NumEntries() const { return numEntries; }
+
+private:
+	PF_FileHandle &fileHandle;
+	int entrySize;
+	int perPage;
+	PageNum firstPage;
+	int numEntries;
+	PageNum pageNum;
+	char* pData;
+};
+
+// Reads a spilled run back, pinning one page at a time
+class IX_RunReader {
+public:
+	IX_RunReader(): fileHandle(NULL), pData(NULL) {}
+
+	RC Open(PF_FileHandle &fh, PageNum firstPage, int numEntries, int size)
+	{
+		fileHandle = &fh;
+		pageNum = firstPage;
+		remaining = numEntries;
+		entrySize = size;
+		perPage = PF_PAGE_SIZE / entrySize;
+		pos = 0;
+		return Pin();
+	}
+
+	bool Done() const { return remaining == 0; }
+	const char* Entry() const { return pData + pos * entrySize; }
+
+	RC Next()
+	{
+		--remaining;
+		if (++pos < perPage && remaining > 0)
+			return OK_RC;
+		RC rc = Unpin();
+		if (rc != OK_RC)
+			return rc;
+		++pageNum;
+		pos = 0;
+		return Pin();
+	}
+
+	RC Unpin()
+	{
+		if (!pData)
+			return OK_RC;
+		pData = NULL;
+		RC rc = fileHandle->UnpinPage(pageNum);
+		if (rc != OK_RC){
+			PrintError(rc);
+			return rc;
+		}
+		return OK_RC;
+	}
+
+private:
+	PF_FileHandle* fileHandle;
+	PageNum pageNum;
+	int remaining;
+	int entrySize;
+	int perPage;
+	int pos;
+	char* pData;
+
+	RC Pin()
+	{
+		if (remaining == 0)
+			return OK_RC;
+		PF_PageHandle pageHandle;
+		RC rc;
+		if ((rc = fileHandle->GetThisPage(pageNum, pageHandle)) ||
+			(rc = pageHandle.GetData(pData))){
+			PrintError(rc);
+			return rc;
+		}
+		return OK_RC;
+	}
+};
+
+// Merges runs [first, first + count) into sink
+static RC MergeRuns(PF_FileHandle &fileHandle, const PageNum* runPages, const int* runLengths,
+	int first, int count, int entrySize, const IX_IndexHeader &header, IX_EntrySink &sink)
+{
+	vector<IX_RunReader> readers(count);
+	RC rc = OK_RC;
+	for (int i = 0; i < count && rc == OK_RC; ++i)
+		rc = readers[i].Open(fileHandle, runPages[first + i], runLengths[first + i], entrySize);
+
+	while (rc == OK_RC){
+		// Pick the smallest head among unfinished runs
+		int min = -1;
+		for (int i = 0; i < count; ++i){
+			if (readers[i].Done())
+				continue;
+			if (min < 0 || CompareEntries(readers[i].Entry(), readers[min].Entry(), header) < 0)
+				min = i;
+		}
+		if (min < 0)
+			break;
+		if ((rc = sink.Add(readers[min].Entry())) ||
+			(rc = readers[min].Next()))
+			break;
+	}
+
+	// Clean up
+	for (int i = 0; i < count; ++i)
+		readers[i].Unpin();
+	return rc;
+}
+
+//
+// Builds the tree from sorted entries.  Leaves are filled left to right
+// up to the fill factor, one entry per key with duplicates gathered into
+// its posting list; the key bounding each node from below and its page
+// are kept to build the next level up.  Compressed nodes are filled by
+// bytes, each under the prefix shared by the keys bounding it, so a leaf
+// is only written once the entry after it has arrived.
+//
+class IX_TreeBuilder : public IX_EntrySink {
+public:
+	IX_TreeBuilder(IX_IndexHandle &indexHandle, int fillPercent)
+		: ih(indexHandle), header(indexHandle.ixIndexHeader), fillPercent(fillPercent)
+	{
+		keyLength = header.attrLength;
+		entrySize = keyLength + sizeof(PageNum) + sizeof(SlotNum);
+		leafCapacity = header.maxEntryIndex + 1;
+		leafTarget = max(1, leafCapacity * fillPercent / 100);
+		byteTarget = PF_PAGE_SIZE * fillPercent / 100;
+		leaf.resize((leafCapacity + 2) * entrySize);
+		numEntries = 0;
+		keyBytes = 0;
+		leafPage = header.rootPage;   // Reuse the empty root leaf
+		prevLeaf = IX_NO_PAGE;
+	}
+
+	RC Add(const char* entry)
+	{
+		// A repeated key goes to the posting list of its one entry; it
+		// arrives in rid order, so the list is appended to
+		if (numEntries > 0 && SameKey(entry, &leaf[(numEntries - 1) * entrySize]))
+			return AddToPostings(&leaf[(numEntries - 1) * entrySize], entry);
+
+		RC rc = ih.BloomAdd(entry);
+		if (rc != OK_RC)
+			return rc;
+		memcpy(&leaf[numEntries * entrySize], entry, entrySize);
+		++numEntries;
+		if (header.compressed)
+			keyBytes += ih.KeyLength(entry);
+
+		// The entries before the newest one, bounded by it, fit while the
+		// newest arrives; once they don't, those before them make a leaf
+		if (numEntries > 2 && !LeafFits(numEntries - 1, false))
+			return FlushLeaf(numEntries - 2);
+		return OK_RC;
+	}
+
+	RC Finish()
+	{
+		// Unbounded above, the last entries may need one more leaf
+		RC rc;
+		if (numEntries > 1 && !LeafFits(numEntries, true) &&
+			(rc = FlushLeaf(numEntries - 1)))
+			return rc;
+		rc = WriteLeaf(leafPage, prevLeaf, IX_NO_PAGE, numEntries, NULL);
+		if (rc != OK_RC)
+			return rc;
+		AddChild(LowKey() ? LowKey() : &leaf[0], leafPage);
+
+		// Build internal levels until a single root remains
+		int height = 0;
+		int maxChildren = header.maxKeyIndex + 2;
+		int perNode = max(2, min(maxChildren, (header.maxKeyIndex + 1) * fillPercent / 100 + 1));
+		while (childPages.size() > 1){
+			vector<char> keys;
+			vector<PageNum> pages;
+			keys.swap(childKeys);
+			pages.swap(childPages);
+
+			int numChildren = pages.size();
+			vector<int> counts;
+			if (header.compressed)
+				GroupByBytes(keys, numChildren, counts);
+			else {
+				int numNodes = (numChildren + perNode - 1) / perNode;
+				for (int j = 0; j < numNodes; ++j)
+					counts.push_back(numChildren / numNodes + (j < numChildren % numNodes));
+			}
+			int first = 0;
+			for (int j = 0; j < (int)counts.size(); ++j){
+				PageNum pageNum;
+				if (rc = WriteInternal(&keys[0], &pages[0], numChildren, first, counts[j], pageNum))
+					return rc;
+				AddChild(&keys[first * keyLength], pageNum);
+				first += counts[j];
+			}
+			++height;
+		}
+
+		ih.ixIndexHeader.rootPage = childPages[0];
+		ih.ixIndexHeader.height = height;
+		ih.modified = true;
+		if ((rc = ih.UnpinUpperLevels()) || (rc = ih.PinUpperLevels()))
+			return rc;
+		return OK_RC;
+	}
+
+private:
+	IX_IndexHandle &ih;
+	const IX_IndexHeader &header;
+	int fillPercent;
+	int keyLength;
+	int entrySize;
+	int leafCapacity;
+	int leafTarget;
+	int byteTarget;             // compressed nodes
+	vector<char> leaf;          // entries of the leaf being filled
+	int numEntries;
+	int keyBytes;               // key lengths of those entries, compressed
+	vector<char> lowKey;        // key bounding the leaf below, none at first
+	PageNum leafPage;
+	PageNum prevLeaf;
+	vector<char> childKeys;     // first key of each finished node
+	vector<PageNum> childPages;
+
+	bool SameKey(const char* one, const char* two) const
+	{
+		return CompareKeys(one, two, header) == 0;
+	}
+
+	RC AddToPostings(char* last, const char* entry)
+	{
+		RID rid(const_cast<char*>(entry) + keyLength);
+		PageNum lastPage;
+		SlotNum lastSlot;
+		memcpy(&lastPage, last + keyLength, sizeof(PageNum));
+		memcpy(&lastSlot, last + keyLength + sizeof(PageNum), sizeof(SlotNum));
+		if (lastSlot == IX_POSTING_SLOT)
+			return ih.InsertPosting(lastPage, rid);
+
+		PageNum headPage;
+		RC rc = ih.CreatePostings(RID(lastPage, lastSlot), rid, headPage);
+		if (rc != OK_RC)
+			return rc;
+		lastSlot = IX_POSTING_SLOT;
+		memcpy(last + keyLength, &headPage, sizeof(PageNum));
+		memcpy(last + keyLength + sizeof(PageNum), &lastSlot, sizeof(SlotNum));
+		return OK_RC;
+	}
+
+	const char* LowKey() const
+	{
+		return lowKey.empty() ? NULL : &lowKey[0];
+	}
+
+	// The key the next level keeps between two neighbouring entries
+	void MakeSeparator(const char* left, const char* right, char* separator) const
+	{
+		if (header.compressed)
+			ih.MakeSeparator(left, right, separator);
+		else
+			memcpy(separator, right, keyLength);
+	}
+
+	// Whether the first n entries make a leaf within the fill factor, or
+	// within a page if full, bounded above by entry n if there is one
+	bool LeafFits(int n, bool full) const
+	{
+		if (!header.compressed)
+			return n <= (full ? leafCapacity : leafTarget);
+
+		char separator[MAXSTRINGLEN];
+		const char* highKey = NULL;
+		if (n < numEntries){
+			MakeSeparator(&leaf[(n - 1) * entrySize], &leaf[n * entrySize], separator);
+			highKey = separator;
+		}
+		int prefixLen = ih.CommonPrefix(LowKey(), highKey);
+		int bytes = keyBytes;
+		for (int i = n; i < numEntries; ++i)
+			bytes -= ih.KeyLength(&leaf[i * entrySize]);
+		int recordSize = IX_OFFSET_SIZE + 1 + sizeof(PageNum) + sizeof(SlotNum);
+		bytes += header.leafHeaderSize + prefixLen + n * (recordSize - prefixLen);
+		return bytes <= (full ? PF_PAGE_SIZE : byteTarget);
+	}
+
+	// Splits children into compressed nodes of up to byteTarget bytes
+	// each, with at least two children apiece
+	void GroupByBytes(const vector<char> &keys, int numChildren, vector<int> &counts) const
+	{
+		int recordSize = IX_OFFSET_SIZE + 1 + sizeof(PageNum);
+		int first = 0;
+		while (first < numChildren){
+			const char* low = first > 0 ? &keys[first * keyLength] : NULL;
+			int count = 1;
+			int bytes = 0;
+			while (first + count < numChildren){
+				int next = first + count;
+				const char* high = next + 1 < numChildren ? &keys[(next + 1) * keyLength] : NULL;
+				int prefixLen = ih.CommonPrefix(low, high);
+				int nextBytes = bytes + ih.KeyLength(&keys[next * keyLength]);
+				int size = header.internalHeaderSize + sizeof(PageNum) + prefixLen + count * (recordSize - prefixLen) + nextBytes;
+				if (count > 1 && size > byteTarget)
+					break;
+				bytes = nextBytes;
+				++count;
+			}
+			counts.push_back(count);
+			first += count;
+		}
+
+		// Narrower bounds only lengthen a prefix, so the node before can
+		// give up a child
+		if (counts.size() > 1 && counts.back() == 1){
+			--counts[counts.size() - 2];
+			++counts.back();
+		}
+	}
+
+	void AddChild(const char* key, PageNum pageNum)
+	{
+		childKeys.insert(childKeys.end(), key, key + keyLength);
+		childPages.push_back(pageNum);
+	}
+
+	RC AllocatePage(PageNum &pageNum, char* &pData)
+	{
+		PF_PageHandle pageHandle;
+		RC rc;
+		if ((rc = ih.pfFileHandle.AllocatePage(pageHandle)) ||
+			(rc = pageHandle.GetPageNum(pageNum)) ||
+			(rc = pageHandle.GetData(pData))){
+			PrintError(rc);
+			return rc;
+		}
+		return OK_RC;
+	}
+
+	// Writes the first n entries as the current leaf, keeps the rest
+	RC FlushLeaf(int n)
+	{
+		// Allocate the next leaf first so this one can point to it
+		PageNum nextPage;
+		char* pData;
+		RC rc = AllocatePage(nextPage, pData);
+		if (rc != OK_RC)
+			return rc;
+		if (rc = ih.pfFileHandle.UnpinPage(nextPage)){
+			PrintError(rc);
+			return rc;
+		}
+
+		char separator[MAXSTRINGLEN];
+		MakeSeparator(&leaf[(n - 1) * entrySize], &leaf[n * entrySize], separator);
+		if (rc = WriteLeaf(leafPage, prevLeaf, nextPage, n, separator))
+			return rc;
+		AddChild(LowKey() ? LowKey() : &leaf[0], leafPage);
+		lowKey.assign(separator, separator + keyLength);
+
+		if (header.compressed)
+			for (int i = 0; i < n; ++i)
+				keyBytes -= ih.KeyLength(&leaf[i * entrySize]);
+		memmove(&leaf[0], &leaf[n * entrySize], (numEntries - n) * entrySize);
+		numEntries -= n;
+		prevLeaf = leafPage;
+		leafPage = nextPage;
+		return OK_RC;
+	}
+
+	// highKey bounds the leaf from above, NULL for the last one
+	RC WriteLeaf(PageNum pageNum, PageNum left, PageNum right, int n, const char* highKey)
+	{
+		PF_PageHandle pageHandle;
+		char* pData;
+		RC rc;
+		if ((rc = ih.pfFileHandle.GetThisPage(pageNum, pageHandle)) ||
+			(rc = pageHandle.GetData(pData))){
+			PrintError(rc);
+			return rc;
+		}
+
+		// Header: numEntries, nextBucketPage, leftLeaf, rightLeaf, bitmap
+		PageNum noPage = IX_NO_PAGE;
+		char* ptr = pData;
+		memcpy(ptr, &n, sizeof(int));
+		ptr += sizeof(int);
+		memcpy(ptr, &noPage, sizeof(PageNum));
+		ptr += sizeof(PageNum);
+		memcpy(ptr, &left, sizeof(PageNum));
+		ptr += sizeof(PageNum);
+		memcpy(ptr, &right, sizeof(PageNum));
+		if (header.compressed)
+			ih.Compress(pData, &leaf[0], n, true, LowKey(), ih.CommonPrefix(LowKey(), highKey));
+		else
+			ih.WriteLeafFromEntryCopyBack(pData, &leaf[0], n * entrySize, n);
+
+		if ((rc = ih.pfFileHandle.MarkDirty(pageNum)) ||
+			(rc = ih.pfFileHandle.UnpinPage(pageNum))){
+			PrintError(rc);
+			return rc;
+		}
+		return OK_RC;
+	}
+
+	// Writes a node over children [first, first + count) of the level below
+	RC WriteInternal(const char* keys, const PageNum* pages, int numChildren, int first, int count, PageNum &pageNum)
+	{
+		char* pData;
+		RC rc = AllocatePage(pageNum, pData);
+		if (rc != OK_RC)
+			return rc;
+
+		// Layout: numKeys | ptr0 | key0 ptr1 | key1 ptr2 ...
+		int numKeys = count - 1;
+		vector<char> copyBack(sizeof(PageNum) + numKeys * (keyLength + sizeof(PageNum)));
+		char* ptr = &copyBack[0];
+		memcpy(ptr, &pages[first], sizeof(PageNum));
+		ptr += sizeof(PageNum);
+		for (int i = 0; i < numKeys; ++i){
+			memcpy(ptr, keys + (first + i + 1) * keyLength, keyLength);
+			memcpy(ptr + keyLength, &pages[first + i + 1], sizeof(PageNum));
+			ptr += keyLength + sizeof(PageNum);
+		}
+		const char* low = first > 0 ? keys + first * keyLength : NULL;
+		const char* high = first + count < numChildren ? keys + (first + count) * keyLength : NULL;
+		ih.WriteInternalFromKeyCopyBack(pData, &copyBack[0], copyBack.size(), numKeys,
+			low, ih.CommonPrefix(low, high));
+
+		if ((rc = ih.pfFileHandle.MarkDirty(pageNum)) ||
+			(rc = ih.pfFileHandle.UnpinPage(pageNum))){
+			PrintError(rc);
+			return rc;
+		}
+		return OK_RC;
+	}
+};
+
+IX_BulkLoader::IX_BulkLoader(IX_Manager &ixm): pfManager(ixm.pfManager), ixIndexHandle(NULL), open(false),
+	fillPercent(IX_FILL_PERCENT), entrySize(0), runBuffer(NULL), runEntries(0), maxRunEntries(0),
+	sortFileOpen(false), numRuns(0), maxRuns(0), runPages(NULL), runLengths(NULL)
+{
+	sortFileName[0] = '\0';
+}
+
+IX_BulkLoader::~IX_BulkLoader()
+{
+	// A load never closed leaves no sort file behind
+	DestroySortFile();
+	delete [] runBuffer;
+	delete [] runPages;
+	delete [] runLengths;
+}
+
+// Start a bulk load; the index must be open and hold no entries
+RC IX_BulkLoader::OpenLoad(const char *fileName, int indexNo, IX_IndexHandle &indexHandle, int fillPercent)
+{
+	if (open){
+		PrintError(IX_LOADOPEN);
+		return IX_LOADOPEN;
+	}
+	if (!fileName){
+		PrintError(IX_NULLINPUT);
+		return IX_NULLINPUT;
+	}
+	if (!indexHandle.open){
+		PrintError(IX_FILENOTOPEN);
+		return IX_FILENOTOPEN;
+	}
+
+	// Hash and bitmap indexes have no tree to build, so their entries are
+	// inserted as they come
+	if (indexHandle.ixIndexHeader.indexType != BTREE_INDEX){
+		ixIndexHandle = &indexHandle;
+		open = true;
+		return OK_RC;
+	}
+
+	// Check index is empty: a single root leaf with no entries
+	if (indexHandle.ixIndexHeader.height != 0)
+		return IX_NOTEMPTY;
+	PF_PageHandle pageHandle;
+	PageNum rootPage = indexHandle.ixIndexHeader.rootPage;
+	RC rc = indexHandle.pfFileHandle.GetThisPage(rootPage, pageHandle);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	char* pData;
+	pageHandle.GetData(pData);
+	int numEntries;
+	memcpy(&numEntries, pData, sizeof(int));
+	if (rc = indexHandle.pfFileHandle.UnpinPage(rootPage)){
+		PrintError(rc);
+		return rc;
+	}
+	if (numEntries != 0)
+		return IX_NOTEMPTY;
+
+	// Set up run buffer; the sort file is only created on the first spill
+	stringstream ss;
+	ss << fileName << "." << indexNo << ".sort";
+	strncpy(sortFileName, ss.str().c_str(), sizeof(sortFileName) - 1);
+	sortFileName[sizeof(sortFileName) - 1] = '\0';
+
+	ixIndexHandle = &indexHandle;
+	this->fillPercent = max(1, min(100, fillPercent));
+	entrySize = indexHandle.ixIndexHeader.attrLength + sizeof(PageNum) + sizeof(SlotNum);
+	maxRunEntries = IX_SORT_RUN_PAGES * (PF_PAGE_SIZE / entrySize);
+	delete [] runBuffer;
+	runBuffer = new char[maxRunEntries * entrySize];
+	runEntries = 0;
+	numRuns = 0;
+	open = true;
+	return OK_RC;
+}
+
+// Add an entry to the current run, spilling the run when full
+RC IX_BulkLoader::InsertEntry(void *attribute, const RID &rid)
+{
+	if (!open){
+		PrintError(IX_LOADNOTOPEN);
+		return IX_LOADNOTOPEN;
+	}
+	if (!attribute){
+		PrintError(IX_NULLINPUT);
+		return IX_NULLINPUT;
+	}
+	if (ixIndexHandle->ixIndexHeader.indexType != BTREE_INDEX)
+		return ixIndexHandle->InsertEntry(attribute, rid);
+	PageNum pageNum;
+	SlotNum slotNum;
+	RC rc;
+	if ((rc = rid.GetPageNum(pageNum)) ||
+		(rc = rid.GetSlotNum(slotNum)))
+		return rc;
+
+	if (runEntries == maxRunEntries){
+		if (rc = SpillRun())
+			return rc;
+	}
+
+	int attrLength = ixIndexHandle->ixIndexHeader.attrLength;
+	char* ptr = runBuffer + runEntries * entrySize;
+	memcpy(ptr, attribute, attrLength);
+	memcpy(ptr + attrLength, &pageNum, sizeof(PageNum));
+	memcpy(ptr + attrLength + sizeof(PageNum), &slotNum, sizeof(SlotNum));
+	++runEntries;
+	return OK_RC;
+}
+
+// Sort all entries and build the tree bottom-up
+RC IX_BulkLoader::CloseLoad()
+{
+	if (!open){
+		PrintError(IX_LOADNOTOPEN);
+		return IX_LOADNOTOPEN;
+	}
+	open = false;
+	RC rc;
+	if (ixIndexHandle->ixIndexHeader.indexType != BTREE_INDEX){
+		// Inserts set the filter's bits, but it was sized for the index
+		// before the load
+		if (ixIndexHandle->bloomOpen && (rc = ixIndexHandle->FillBloom()))
+			return rc;
+		rc = ixIndexHandle->ForcePages();
+		if (rc != OK_RC){
+			PrintError(rc);
+			return rc;
+		}
+		return OK_RC;
+	}
+
+	const IX_IndexHeader &header = ixIndexHandle->ixIndexHeader;
+	IX_TreeBuilder builder(*ixIndexHandle, fillPercent);
+	rc = OK_RC;
+
+	// The builder adds each key to the filter, sized for every entry
+	if (ixIndexHandle->bloomOpen){
+		int numEntries = runEntries;
+		for (int i = 0; i < numRuns; ++i)
+			numEntries += runLengths[i];
+		if (rc = ixIndexHandle->ResetBloom(numEntries))
+			return rc;
+	}
+
+	if (!sortFileOpen){
+		// Everything fit in memory
+		SortEntries(runBuffer, runEntries, entrySize, header);
+		for (int i = 0; i < runEntries && rc == OK_RC; ++i)
+			rc = builder.Add(runBuffer + i * entrySize);
+	}
+	else {
+		rc = SpillRun();
+
+		// Merge passes until one final merge suffices
+		int first = 0;
+		while (rc == OK_RC && numRuns - first > IX_MERGE_FANIN){
+			int end = numRuns;
+			for (; first < end && rc == OK_RC; first += IX_MERGE_FANIN){
+				int count = min(IX_MERGE_FANIN, end - first);
+				IX_RunWriter writer(sortFile, entrySize);
+				rc = MergeRuns(sortFile, runPages, runLengths, first, count, entrySize, header, writer);
+				RC rc2 = writer.Unpin();
+				if (rc == OK_RC)
+					rc = rc2;
+				if (rc == OK_RC)
+					rc = AddRun(writer.FirstPage(), writer.NumEntries());
+			}
+			first = end;
+		}
+		if (rc == OK_RC)
+			rc = MergeRuns(sortFile, runPages, runLengths, first, numRuns - first, entrySize, header, builder);
+	}
+
+	if (rc == OK_RC)
+		rc = builder.Finish();
+
+	// Clean up
+	RC rc2 = DestroySortFile();
+	delete [] runBuffer;
+	runBuffer = NULL;
+	runEntries = 0;
+	numRuns = 0;
+	if (rc != OK_RC)
+		return rc;
+	if (rc2 != OK_RC)
+		return rc2;
+
+	// The builder writes whole nodes, counted once it is done
+	if (ixIndexHandle->countsOpen && (rc = ixIndexHandle->RecountEntries()))
+		return rc;
+
+	rc = ixIndexHandle->ForcePages();
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	return OK_RC;
+}
+
+// Sort the run buffer and write it to the sort file as a new run
+RC IX_BulkLoader::SpillRun()
+{
+	RC rc;
+	if (!sortFileOpen){
+		// Clear a sort file left behind by an earlier failed load
+		pfManager->DestroyFile(sortFileName);
+		if ((rc = pfManager->CreateFile(sortFileName)) ||
+			(rc = pfManager->OpenFile(sortFileName, sortFile))){
+			PrintError(rc);
+			return rc;
+		}
+		sortFileOpen = true;
+	}
+	if (runEntries == 0)
+		return OK_RC;
+
+	SortEntries(runBuffer, runEntries, entrySize, ixIndexHandle->ixIndexHeader);
+	IX_RunWriter writer(sortFile, entrySize);
+	for (int i = 0; i < runEntries; ++i){
+		if (rc = writer.Add(runBuffer + i * entrySize)){
+			writer.Unpin();
+			return rc;
+		}
+	}
+	if ((rc = writer.Unpin()) ||
+		(rc = AddRun(writer.FirstPage(), writer.NumEntries())))
+		return rc;
+	runEntries = 0;
+	return OK_RC;
+}
+
+RC IX_BulkLoader::AddRun(PageNum firstPage, int numEntries)
+{
+	if (numRuns == maxRuns){
+		int newMax = (maxRuns == 0) ? IX_MERGE_FANIN : 2 * maxRuns;
+		PageNum* newPages = new PageNum[newMax];
+		int* newLengths = new int[newMax];
+		for (int i = 0; i < numRuns; ++i){
+			newPages[i] = runPages[i];
+			newLengths[i] = runLengths[i];
+		}
+		delete [] runPages;
+		delete [] runLengths;
+		runPages = newPages;
+		runLengths = newLengths;
+		maxRuns = newMax;
+	}
+	runPages[numRuns] = firstPage;
+	runLengths[numRuns] = numEntries;
+	++numRuns;
+	return OK_RC;
+}
+
+RC IX_BulkLoader::DestroySortFile()
+{
+	if (!sortFileOpen)
+		return OK_RC;
+	sortFileOpen = false;
+	RC rc;
+	if ((rc = pfManager->CloseFile(sortFile)) ||
+		(rc = pfManager->DestroyFile(sortFileName))){
+		PrintError(rc);
+		return rc;
+	}
+	return OK_RC;
+}
@@ -0,0 +1,556 @@
+#include <cstring>
+#include <vector>
+#include <set>
+#include <string>
+#include "ix.h"
+
+using namespace std;
+
+// Entry counts (see ix.h).  A write adds its leaf's change to the counts
+// on its path as the recursion unwinds; a node whose children it split,
+// merged or moved entries between is marked stale instead, and recounted
+// from its children's totals once the write is done, lowest nodes first.
+// New nodes are always stale, so only counted nodes are ever added to.
+
+// Slots of a leaf's entries: 0 .. numEntries-1 of a compact leaf, else
+// those whose bits are set
+static void LeafSlots(const IX_IndexHandle &ih, char* pData, vector<SlotNum> &slots)
+{
+	int numEntries;
+	memcpy(&numEntries, pData, sizeof(int));
+	slots.clear();
+	if (ih.LeafIsCompact(pData, numEntries)){
+		for (SlotNum i = 0; i < numEntries; ++i)
+			slots.push_back(i);
+	}
+	else {
+		for (SlotNum i = 0; i <= ih.ixIndexHeader.maxEntryIndex; ++i)
+			if (ih.GetSlotBitValue(pData, i))
+				slots.push_back(i);
+	}
+}
+
+// Rids of a leaf entry: one, or its posting list's
+static RC EntryRids(const IX_IndexHandle &ih, const char* entry, int &numRids)
+{
+	int attrLength = ih.ixIndexHeader.attrLength;
+	PageNum headPage;
+	SlotNum slotNum;
+	memcpy(&headPage, entry + attrLength, sizeof(PageNum));
+	memcpy(&slotNum, entry + attrLength + sizeof(PageNum), sizeof(SlotNum));
+	numRids = 1;
+	if (slotNum != IX_POSTING_SLOT)
+		return OK_RC;
+
+	PF_PageHandle pfPageHandle;
+	char* pData;
+	RC rc = ih.pfFileHandle.GetThisPage(headPage, pfPageHandle);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	pfPageHandle.GetData(pData);
+	IX_PostingHeader header;
+	memcpy(&header, pData, sizeof(IX_PostingHeader));
+	numRids = header.numRids;
+	rc = ih.pfFileHandle.UnpinPage(headPage);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	return OK_RC;
+}
+
+RC IX_IndexHandle::PinCounts(PageNum pageNum, int which, int* &counts) const
+{
+	PageNum sidePage = 2 * pageNum + which;
+	PF_PageHandle pfPageHandle;
+	char* pData;
+	RC rc = countsHandle.GetThisPage(sidePage, pfPageHandle);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	if (rc = pfPageHandle.GetData(pData)){
+		countsHandle.UnpinPage(sidePage);
+		PrintError(rc);
+		return rc;
+	}
+	counts = (int*)pData;
+	return OK_RC;
+}
+
+RC IX_IndexHandle::UnpinCounts(PageNum pageNum, int which, bool dirty) const
+{
+	PageNum sidePage = 2 * pageNum + which;
+	RC rc;
+	if (dirty && (rc = countsHandle.MarkDirty(sidePage))){
+		countsHandle.UnpinPage(sidePage);
+		PrintError(rc);
+		return rc;
+	}
+	rc = countsHandle.UnpinPage(sidePage);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	return OK_RC;
+}
+
+// Side pages are allocated in order and never disposed, so a node's pages
+// exist once any node numbered at least as high has been counted
+RC IX_IndexHandle::AllocateCounts(PageNum pageNum)
+{
+	PF_PageHandle pfPageHandle;
+	char* pData;
+	RC rc = countsHandle.GetThisPage(0, pfPageHandle);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	pfPageHandle.GetData(pData);
+	int numPages;
+	memcpy(&numPages, pData, sizeof(int));
+	int needed = 2 * pageNum + IX_COUNT_KEYS + 1;
+	if (numPages >= needed)
+		return UnpinCounts(0, 0, false);
+
+	while (rc == OK_RC && numPages < needed){
+		PF_PageHandle newHandle;
+		PageNum newPage;
+		char* newData;
+		if ((rc = countsHandle.AllocatePage(newHandle)) == OK_RC){
+			newHandle.GetPageNum(newPage);
+			newHandle.GetData(newData);
+			memset(newData, 0, PF_PAGE_SIZE);
+			if ((rc = countsHandle.MarkDirty(newPage)) == OK_RC)
+				rc = countsHandle.UnpinPage(newPage);
+			++numPages;
+		}
+	}
+	memcpy(pData, &numPages, sizeof(int));
+	RC unpinRC = UnpinCounts(0, 0, true);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	return unpinRC;
+}
+
+RC IX_IndexHandle::AddCounts(PageNum pageNum, int height, SlotNum child, int rids, int keys)
+{
+	if (!countsOpen || (rids == 0 && keys == 0))
+		return OK_RC;
+	for (int i = 0; i < numStaleCounts; ++i)
+		if (staleCounts[i] == pageNum)
+			return OK_RC;
+
+	int deltas[2] = { rids, keys };
+	for (int which = IX_COUNT_RIDS; which <= IX_COUNT_KEYS; ++which){
+		int* counts;
+		RC rc = PinCounts(pageNum, which, counts);
+		if (rc != OK_RC)
+			return rc;
+		counts[0] += deltas[which];
+		if (height > 0)
+			counts[1 + child] += deltas[which];
+		if (rc = UnpinCounts(pageNum, which, true))
+			return rc;
+	}
+	return OK_RC;
+}
+
+void IX_IndexHandle::StaleCounts(PageNum pageNum, int height)
+{
+	if (!countsOpen)
+		return;
+	for (int i = 0; i < numStaleCounts; ++i)
+		if (staleCounts[i] == pageNum)
+			return;
+	if (numStaleCounts == IX_MAX_STALE_COUNTS){
+		countsLost = true;
+		return;
+	}
+	staleCounts[numStaleCounts] = pageNum;
+	staleHeights[numStaleCounts] = height;
+	++numStaleCounts;
+}
+
+void IX_IndexHandle::DropStaleCounts(PageNum pageNum)
+{
+	for (int i = 0; i < numStaleCounts; ++i){
+		if (staleCounts[i] != pageNum)
+			continue;
+		--numStaleCounts;
+		staleCounts[i] = staleCounts[numStaleCounts];
+		staleHeights[i] = staleHeights[numStaleCounts];
+		return;
+	}
+}
+
+RC IX_IndexHandle::RecountNode(PageNum pageNum, int height)
+{
+	RC rc = AllocateCounts(pageNum);
+	if (rc != OK_RC)
+		return rc;
+	PF_PageHandle pfPageHandle;
+	char* pData;
+	if (rc = pfFileHandle.GetThisPage(pageNum, pfPageHandle)){
+		PrintError(rc);
+		return rc;
+	}
+	pfPageHandle.GetData(pData);
+
+	int totals[2] = { 0, 0 };
+	vector<int> below[2];
+	if (height == 0){
+		vector<SlotNum> slots;
+		LeafSlots(*this, pData, slots);
+		char entry[MAXSTRINGLEN + sizeof(PageNum) + sizeof(SlotNum)];
+		for (int i = 0; i < (int)slots.size() && rc == OK_RC; ++i){
+			int numRids;
+			if ((rc = EntryRids(*this, GetEntry(pData, slots[i], entry), numRids)) == OK_RC)
+				totals[IX_COUNT_RIDS] += numRids;
+		}
+		totals[IX_COUNT_KEYS] = slots.size();
+	}
+	else {
+		int numKeys;
+		memcpy(&numKeys, pData, sizeof(int));
+		for (SlotNum i = 0; i <= numKeys && rc == OK_RC; ++i){
+			PageNum childPage = GetChildPage(pData, i);
+			for (int which = IX_COUNT_RIDS; which <= IX_COUNT_KEYS && rc == OK_RC; ++which){
+				int* counts;
+				if ((rc = PinCounts(childPage, which, counts)) == OK_RC){
+					below[which].push_back(counts[0]);
+					totals[which] += counts[0];
+					rc = UnpinCounts(childPage, which, false);
+				}
+			}
+		}
+	}
+	RC unpinRC = pfFileHandle.UnpinPage(pageNum);
+	if (rc != OK_RC)
+		return rc;
+	if (unpinRC != OK_RC){
+		PrintError(unpinRC);
+		return unpinRC;
+	}
+
+	for (int which = IX_COUNT_RIDS; which <= IX_COUNT_KEYS; ++which){
+		int* counts;
+		if (rc = PinCounts(pageNum, which, counts))
+			return rc;
+		counts[0] = totals[which];
+		for (int i = 0; i < (int)below[which].size(); ++i)
+			counts[1 + i] = below[which][i];
+		if (rc = UnpinCounts(pageNum, which, true))
+			return rc;
+	}
+	return OK_RC;
+}
+
+RC IX_IndexHandle::RecountSubtree(PageNum pageNum, int height)
+{
+	if (height > 0){
+		char node[PF_PAGE_SIZE];
+		RC rc = ReadNode(pageNum, node);
+		if (rc != OK_RC)
+			return rc;
+		int numKeys;
+		memcpy(&numKeys, node, sizeof(int));
+		for (SlotNum i = 0; i <= numKeys; ++i)
+			if (rc = RecountSubtree(GetChildPage(node, i), height - 1))
+				return rc;
+	}
+	return RecountNode(pageNum, height);
+}
+
+RC IX_IndexHandle::FinishCounts()
+{
+	if (!countsOpen)
+		return OK_RC;
+	RC rc = OK_RC;
+	if (countsLost)
+		rc = RecountEntries();
+	else {
+		int maxHeight = 0;
+		for (int i = 0; i < numStaleCounts; ++i)
+			maxHeight = max(maxHeight, staleHeights[i]);
+		for (int height = 0; height <= maxHeight && rc == OK_RC; ++height)
+			for (int i = 0; i < numStaleCounts && rc == OK_RC; ++i)
+				if (staleHeights[i] == height)
+					rc = RecountNode(staleCounts[i], height);
+	}
+	numStaleCounts = 0;
+	countsLost = false;
+	ridDelta = 0;
+	keyDelta = 0;
+	return rc;
+}
+
+RC IX_IndexHandle::RecountEntries()
+{
+	numStaleCounts = 0;
+	countsLost = false;
+	if (!countsOpen)
+		return OK_RC;
+	return RecountSubtree(ixIndexHeader.rootPage, ixIndexHeader.height);
+}
+
+// Children left of the one holding attribute hold only smaller keys, and
+// keys are unique within leaves, so one path down finds every entry before it
+RC IX_IndexHandle::CountBefore(void* attribute, bool inclusive, int &numRids, int &numKeys) const
+{
+	numRids = 0;
+	numKeys = 0;
+	RC rc;
+	PageNum pageNum = ixIndexHeader.rootPage;
+	for (int height = ixIndexHeader.height; height > 0; --height){
+		char node[PF_PAGE_SIZE];
+		if (rc = ReadNode(pageNum, node))
+			return rc;
+		int numNodeKeys;
+		memcpy(&numNodeKeys, node, sizeof(int));
+		SlotNum keyNum = UpperBoundKey(node, numNodeKeys, attribute);
+		for (int which = IX_COUNT_RIDS; which <= IX_COUNT_KEYS; ++which){
+			int* counts;
+			if (rc = PinCounts(pageNum, which, counts))
+				return rc;
+			int sum = 0;
+			for (SlotNum i = 0; i < keyNum; ++i)
+				sum += counts[1 + i];
+			(which == IX_COUNT_RIDS ? numRids : numKeys) += sum;
+			if (rc = UnpinCounts(pageNum, which, false))
+				return rc;
+		}
+		pageNum = GetChildPage(node, keyNum);
+	}
+
+	// A leaf's rids are summed on the shorter side of attribute, reading
+	// only those entries' posting lists
+	int leafRids;
+	int* counts;
+	if (rc = PinCounts(pageNum, IX_COUNT_RIDS, counts))
+		return rc;
+	leafRids = counts[0];
+	if (rc = UnpinCounts(pageNum, IX_COUNT_RIDS, false))
+		return rc;
+	PF_PageHandle pfPageHandle;
+	char* pData;
+	if (rc = pfFileHandle.GetThisPage(pageNum, pfPageHandle)){
+		PrintError(rc);
+		return rc;
+	}
+	pfPageHandle.GetData(pData);
+	vector<SlotNum> slots;
+	LeafSlots(*this, pData, slots);
+	char entry[MAXSTRINGLEN + sizeof(PageNum) + sizeof(SlotNum)];
+	vector<bool> before(slots.size());
+	int numBefore = 0;
+	for (int i = 0; i < (int)slots.size(); ++i){
+		int cmp = CompareKey(GetEntry(pData, slots[i], entry), attribute);
+		before[i] = (cmp < 0 || (cmp == 0 && inclusive));
+		if (before[i])
+			++numBefore;
+	}
+	bool sumBefore = (2 * numBefore <= (int)slots.size());
+	int sideRids = 0;
+	rc = OK_RC;
+	for (int i = 0; i < (int)slots.size() && rc == OK_RC; ++i){
+		if (before[i] != sumBefore)
+			continue;
+		int entryRids;
+		if ((rc = EntryRids(*this, GetEntry(pData, slots[i], entry), entryRids)) == OK_RC)
+			sideRids += entryRids;
+	}
+	RC unpinRC = pfFileHandle.UnpinPage(pageNum);
+	if (rc != OK_RC)
+		return rc;
+	if (unpinRC != OK_RC){
+		PrintError(unpinRC);
+		return unpinRC;
+	}
+	numRids += sumBefore ? sideRids : leafRids - sideRids;
+	numKeys += numBefore;
+	return OK_RC;
+}
+
+bool IX_IndexHandle::FastCounts() const
+{
+	return ixIndexHeader.indexType == BITMAP_INDEX ||
+		(ixIndexHeader.indexType == BTREE_INDEX && countsOpen);
+}
+
+// Counted trees are read with writers kept out, as the counts of a path
+// change together
+RC IX_IndexHandle::CountEntries(void *lowValue, bool lowInclusive,
+	void *highValue, bool highInclusive, int &numRids, int &numKeys) const
+{
+	numRids = 0;
+	numKeys = 0;
+	if (!open){
+		PrintError(IX_FILENOTOPEN);
+		return IX_FILENOTOPEN;
+	}
+	if (ixIndexHeader.indexType == BITMAP_INDEX)
+		return BitmapCount(lowValue, lowInclusive, highValue, highInclusive, numRids, numKeys);
+
+	RC rc;
+	if (FastCounts()){
+		if (rc = LatchIndex(PF_UPDATE))
+			return rc;
+		int* counts;
+		int highCounts[2], lowCounts[2] = { 0, 0 };
+		for (int which = IX_COUNT_RIDS; which <= IX_COUNT_KEYS && !highValue; ++which){
+			if ((rc = PinCounts(ixIndexHeader.rootPage, which, counts)) == OK_RC){
+				highCounts[which] = counts[0];
+				rc = UnpinCounts(ixIndexHeader.rootPage, which, false);
+			}
+			if (rc != OK_RC){
+				UnlatchIndex(PF_UPDATE);
+				return rc;
+			}
+		}
+		rc = OK_RC;
+		if (highValue)
+			rc = CountBefore(highValue, highInclusive, highCounts[IX_COUNT_RIDS], highCounts[IX_COUNT_KEYS]);
+		if (lowValue && rc == OK_RC)
+			rc = CountBefore(lowValue, !lowInclusive, lowCounts[IX_COUNT_RIDS], lowCounts[IX_COUNT_KEYS]);
+		RC latchRC = UnlatchIndex(PF_UPDATE);
+		if (rc != OK_RC)
+			return rc;
+		numRids = max(0, highCounts[IX_COUNT_RIDS] - lowCounts[IX_COUNT_RIDS]);
+		numKeys = max(0, highCounts[IX_COUNT_KEYS] - lowCounts[IX_COUNT_KEYS]);
+		return latchRC;
+	}
+
+	// A hash index returns a key's entries together only within a scan of
+	// that key, so a full scan's keys are told apart by value
+	IX_IndexScan scan;
+	if (rc = scan.OpenScan(*this, lowValue, lowInclusive, highValue, highInclusive))
+		return rc;
+	int attrLength = ixIndexHeader.attrLength;
+	char key[MAXSTRINGLEN], lastKey[MAXSTRINGLEN];
+	set<string> hashKeys;
+	RID rid;
+	while ((rc = scan.GetNextEntry(rid, key)) == OK_RC){
+		if (ixIndexHeader.indexType == HASH_INDEX)
+			hashKeys.insert(string(key, attrLength));
+		else if (numRids == 0 || CompareKey(lastKey, key) != 0){
+			memcpy(lastKey, key, attrLength);
+			++numKeys;
+		}
+		++numRids;
+	}
+	if (ixIndexHeader.indexType == HASH_INDEX)
+		numKeys = hashKeys.size();
+	if (rc != IX_EOF){
+		scan.CloseScan();
+		return rc;
+	}
+	return scan.CloseScan();
+}
+
+// The first or last leaf on one path down; a leaf emptied by deletes sends
+// the search on along the leaves, right for the first key and left for the
+// last, latching as scans do
+RC IX_IndexHandle::EdgeKey(bool last, void* key) const
+{
+	RC rc = LatchIndex(PF_SHARED);
+	if (rc != OK_RC)
+		return rc;
+	PageNum pageNum = ixIndexHeader.rootPage;
+	for (int height = ixIndexHeader.height; height > 0 && rc == OK_RC; --height){
+		char node[PF_PAGE_SIZE];
+		if ((rc = ReadNode(pageNum, node)) == OK_RC){
+			int numKeys;
+			memcpy(&numKeys, node, sizeof(int));
+			pageNum = GetChildPage(node, last ? numKeys : 0);
+		}
+	}
+	char* pData;
+	if (rc == OK_RC && (rc = LatchShared(pageNum, pData)) == OK_RC && last)
+		rc = MoveRight(pageNum, pData, NULL);
+	if (rc != OK_RC){
+		UnlatchIndex(PF_SHARED);
+		return rc;
+	}
+
+	int attrLength = ixIndexHeader.attrLength;
+	char entry[MAXSTRINGLEN + sizeof(PageNum) + sizeof(SlotNum)];
+	vector<SlotNum> slots;
+	bool found = false;
+	while (!found){
+		LeafSlots(*this, pData, slots);
+		for (int i = 0; i < (int)slots.size(); ++i){
+			const char* one = GetEntry(pData, slots[i], entry);
+			int cmp = found ? CompareKey(one, key) : 0;
+			if (!found || (last ? cmp > 0 : cmp < 0))
+				memcpy(key, one, attrLength);
+			found = true;
+		}
+		if (found)
+			break;
+
+		PageNum nextPage;
+		int offset = last ? sizeof(int) + sizeof(PageNum) : sizeof(int) + 2 * sizeof(PageNum);
+		memcpy(&nextPage, pData + offset, sizeof(PageNum));
+		if (nextPage == IX_NO_PAGE)
+			break;
+		char* nextData;
+		if (last){
+			if ((rc = LatchShared(nextPage, nextData)) == OK_RC)
+				rc = ReleaseShared(pageNum);
+		}
+		else if ((rc = ReleaseShared(pageNum)) == OK_RC)
+			rc = LatchShared(nextPage, nextData);
+		if (rc != OK_RC){
+			UnlatchIndex(PF_SHARED);
+			return rc;
+		}
+		pageNum = nextPage;
+		pData = nextData;
+	}
+	if ((rc = ReleaseShared(pageNum)) || (rc = UnlatchIndex(PF_SHARED)))
+		return rc;
+	return found ? OK_RC : IX_EOF;
+}
+
+RC IX_IndexHandle::GetMinKey(void *key) const
+{
+	if (!open){
+		PrintError(IX_FILENOTOPEN);
+		return IX_FILENOTOPEN;
+	}
+	if (!key){
+		PrintError(IX_NULLINPUT);
+		return IX_NULLINPUT;
+	}
+	if (ixIndexHeader.indexType == HASH_INDEX){
+		PrintError(IX_NOTBTREE);
+		return IX_NOTBTREE;
+	}
+	if (ixIndexHeader.indexType == BITMAP_INDEX)
+		return BitmapEdgeKey(false, key);
+	return EdgeKey(false, key);
+}
+
+RC IX_IndexHandle::GetMaxKey(void *key) const
+{
+	if (!open){
+		PrintError(IX_FILENOTOPEN);
+		return IX_FILENOTOPEN;
+	}
+	if (!key){
+		PrintError(IX_NULLINPUT);
+		return IX_NULLINPUT;
+	}
+	if (ixIndexHeader.indexType == HASH_INDEX){
+		PrintError(IX_NOTBTREE);
+		return IX_NOTBTREE;
+	}
+	if (ixIndexHeader.indexType == BITMAP_INDEX)
+		return BitmapEdgeKey(true, key);
+	return EdgeKey(true, key);
+}
@@ -0,0 +1,106 @@
+#include <cstring>
+#include <vector>
+#include "ix.h"
+
+using namespace std;
+
+// The unpinned pages are only read back on the next descent, so a smaller
+// budget takes effect at once and a larger one once the levels are pinned
+RC IX_IndexHandle::SetDescentPages(int numPages)
+{
+	if (numPages < 0 || numPages > IX_MAX_DESCENT_PAGES){
+		PrintError(IX_INVALIDNUM);
+		return IX_INVALIDNUM;
+	}
+	descentPages = numPages;
+	if (!open)
+		return OK_RC;
+	RC rc = UnpinUpperLevels();
+	if (rc != OK_RC)
+		return rc;
+	return PinUpperLevels();
+}
+
+// Pins the root and each level below it, breadth first, while the whole
+// level fits in descentPages; a level only partly pinned would still cost
+// a read on most descents.  Leaves are never pinned.  A pool with no frame
+// left to spare just pins fewer levels
+RC IX_IndexHandle::PinUpperLevels()
+{
+	descentStale = false;
+	if (ixIndexHeader.indexType != BTREE_INDEX)
+		return OK_RC;
+
+	vector<PageNum> level(1, ixIndexHeader.rootPage);
+	for (int height = ixIndexHeader.height; height > 0; --height){
+		if (numPinned + (int)level.size() > descentPages)
+			break;
+		vector<PageNum> below;
+		int first = numPinned;
+		for (int i = 0; i < (int)level.size(); ++i){
+			char* pData;
+			PF_PageHandle pfPageHandle;
+			RC rc = pfFileHandle.GetThisPage(level[i], pfPageHandle);
+			if (rc == PF_NOBUF){
+				// Keep only the levels pinned in full
+				while (numPinned > first){
+					--numPinned;
+					if (rc = pfFileHandle.UnpinPage(pinnedPages[numPinned])){
+						PrintError(rc);
+						return rc;
+					}
+				}
+				return OK_RC;
+			}
+			if (rc != OK_RC || (rc = pfPageHandle.GetData(pData))){
+				PrintError(rc);
+				return rc;
+			}
+			pinnedPages[numPinned++] = level[i];
+			int numKeys;
+			memcpy(&numKeys, pData, sizeof(int));
+			for (SlotNum j = 0; j <= numKeys; ++j)
+				below.push_back(GetChildPage(pData, j));
+		}
+		level.swap(below);
+	}
+	return OK_RC;
+}
+
+RC IX_IndexHandle::UnpinUpperLevels()
+{
+	while (numPinned > 0){
+		--numPinned;
+		RC rc = pfFileHandle.UnpinPage(pinnedPages[numPinned]);
+		if (rc != OK_RC){
+			PrintError(rc);
+			return rc;
+		}
+	}
+	return OK_RC;
+}
+
+// Merges dispose internal nodes, which PF refuses while they are pinned.
+// Splits only add pages, so InsertEntry marks the levels stale itself
+RC IX_IndexHandle::DisposeNode(PageNum pageNum)
+{
+	RC rc;
+	for (int i = 0; i < numPinned; ++i){
+		if (pinnedPages[i] != pageNum)
+			continue;
+		if (rc = pfFileHandle.UnpinPage(pageNum)){
+			PrintError(rc);
+			return rc;
+		}
+		pinnedPages[i] = pinnedPages[--numPinned];
+		break;
+	}
+	descentStale = true;
+	DropStaleCounts(pageNum);
+	rc = pfFileHandle.DisposePage(pageNum);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	return OK_RC;
+}
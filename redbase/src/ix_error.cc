@@ -12,6 +12,10 @@ static char *IX_WarnMsg[] = {
   (char*)"file scan already opened, do not re-open",
   (char*)"end of file",
   (char*)"trying to close before scan finished",
+  (char*)"index not empty, cannot bulk load",
+  (char*)"bulk load already opened, do not re-open",
+  (char*)"bulk load not opened",
+  (char*)"scans open on index, close them before rebuilding",
 };
 
 static char *IX_ErrorMsg[] = {
@@ -23,6 +27,10 @@ static char *IX_ErrorMsg[] = {
 	(char*)"invalid scan parameters; either value null and compOp not NO_OP, or value not null and compOp NO_OP",
 	(char*)"invalid index number",
 	(char*)"too many entries with same key attribute", 
+	(char*)"invalid composite key, should have 1 to 4 attributes of at most 255 bytes in all",
+	(char*)"hash indexes only support equality scans and full scans",
+	(char*)"not a bitmap index",
+	(char*)"not a B+tree index",
 };
 
 void IX_PrintError(RC rc)
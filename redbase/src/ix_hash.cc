@@ -0,0 +1,553 @@
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include "ix.h"
+
+using namespace std;
+
+// Extendible hashing (see ix.h).  Directory slot i holds the bucket of the
+// keys whose hash has i as its low globalDepth bits; a bucket of local
+// depth d is held by every slot agreeing with it on the low d bits, the
+// first of them being the slot below 2^d.
+
+static RC GetBucketPage(const PF_FileHandle &fileHandle, PageNum pageNum, char* &pData)
+{
+	PF_PageHandle pfPageHandle;
+	RC rc = fileHandle.GetThisPage(pageNum, pfPageHandle);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	rc = pfPageHandle.GetData(pData);
+	if (rc != OK_RC){
+		fileHandle.UnpinPage(pageNum);
+		PrintError(rc);
+		return rc;
+	}
+	return OK_RC;
+}
+
+// Allocates an empty bucket page, left pinned
+static RC NewBucketPage(PF_FileHandle &fileHandle, int localDepth, PageNum &pageNum, char* &pData)
+{
+	PF_PageHandle pfPageHandle;
+	RC rc = fileHandle.AllocatePage(pfPageHandle);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	rc = pfPageHandle.GetPageNum(pageNum);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	rc = pfPageHandle.GetData(pData);
+	if (rc != OK_RC){
+		fileHandle.UnpinPage(pageNum);
+		PrintError(rc);
+		return rc;
+	}
+
+	IX_BucketHeader header;
+	header.numEntries = 0;
+	header.localDepth = localDepth;
+	header.overflowPage = IX_NO_PAGE;
+	memcpy(pData, &header, sizeof(IX_BucketHeader));
+	return OK_RC;
+}
+
+static RC ReleaseBucketPage(const PF_FileHandle &fileHandle, PageNum pageNum, bool dirty)
+{
+	RC rc;
+	if (dirty && (rc = fileHandle.MarkDirty(pageNum))){
+		fileHandle.UnpinPage(pageNum);
+		PrintError(rc);
+		return rc;
+	}
+	rc = fileHandle.UnpinPage(pageNum);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	return OK_RC;
+}
+
+// Hashes the bytes that decide key equality: a string up to its first
+// null, and 0 for a float -0
+unsigned int IX_IndexHandle::HashKey(const void* attribute) const
+{
+	const unsigned char* bytes = (const unsigned char*)attribute;
+	int length = ixIndexHeader.attrLength;
+	float zero = 0;
+	if (ixIndexHeader.attrType == FLOAT && *(const float*)attribute == 0)
+		bytes = (const unsigned char*)&zero;
+	else if (ixIndexHeader.attrType == STRING){
+		length = 0;
+		while (length < ixIndexHeader.attrLength && bytes[length])
+			++length;
+	}
+
+	// FNV-1a, then mixed so the low bits the directory uses vary with
+	// every byte
+	unsigned int hash = 2166136261u;
+	for (int i = 0; i < length; ++i){
+		hash ^= bytes[i];
+		hash *= 16777619u;
+	}
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6bu;
+	hash ^= hash >> 13;
+	hash *= 0xc2b2ae35u;
+	hash ^= hash >> 16;
+	return hash;
+}
+
+// Reads numSlots directory slots from firstSlot, a directory page at a time
+RC IX_IndexHandle::ReadDirectory(int firstSlot, int numSlots, PageNum* bucketPages) const
+{
+	int slot = firstSlot;
+	while (slot < firstSlot + numSlots){
+		PageNum dirPage = ixIndexHeader.dirPages[slot / IX_DIR_SLOTS];
+		int count = min(firstSlot + numSlots - slot, IX_DIR_SLOTS - slot % IX_DIR_SLOTS);
+		char* pData;
+		RC rc = GetBucketPage(pfFileHandle, dirPage, pData);
+		if (rc != OK_RC)
+			return rc;
+		memcpy(bucketPages + (slot - firstSlot), pData + (slot % IX_DIR_SLOTS) * sizeof(PageNum), count * sizeof(PageNum));
+		if (rc = ReleaseBucketPage(pfFileHandle, dirPage, false))
+			return rc;
+		slot += count;
+	}
+	return OK_RC;
+}
+
+// Writes numSlots directory slots from firstSlot, allocating the
+// directory pages they fall in as needed
+RC IX_IndexHandle::WriteDirectory(int firstSlot, int numSlots, const PageNum* bucketPages)
+{
+	RC rc;
+	int slot = firstSlot;
+	while (slot < firstSlot + numSlots){
+		PageNum &dirPage = ixIndexHeader.dirPages[slot / IX_DIR_SLOTS];
+		int count = min(firstSlot + numSlots - slot, IX_DIR_SLOTS - slot % IX_DIR_SLOTS);
+		char* pData;
+		if (dirPage == IX_NO_PAGE){
+			PF_PageHandle pfPageHandle;
+			if ((rc = pfFileHandle.AllocatePage(pfPageHandle)) ||
+				(rc = pfPageHandle.GetPageNum(dirPage)) ||
+				(rc = pfPageHandle.GetData(pData))){
+				PrintError(rc);
+				return rc;
+			}
+			modified = true;
+		}
+		else if (rc = GetBucketPage(pfFileHandle, dirPage, pData))
+			return rc;
+		memcpy(pData + (slot % IX_DIR_SLOTS) * sizeof(PageNum), bucketPages + (slot - firstSlot), count * sizeof(PageNum));
+		if (rc = ReleaseBucketPage(pfFileHandle, dirPage, true))
+			return rc;
+		slot += count;
+	}
+	return OK_RC;
+}
+
+// Collects the entries of a bucket and its overflow pages
+RC IX_IndexHandle::ReadBucket(PageNum bucketPage, const void* attribute, char* &entries, int &numEntries, int &localDepth) const
+{
+	int entrySize = ixIndexHeader.attrLength + sizeof(PageNum) + sizeof(SlotNum);
+	vector<char> result;
+	PageNum pageNum = bucketPage;
+	while (pageNum != IX_NO_PAGE){
+		char* pData;
+		RC rc = GetBucketPage(pfFileHandle, pageNum, pData);
+		if (rc != OK_RC)
+			return rc;
+		IX_BucketHeader header;
+		memcpy(&header, pData, sizeof(IX_BucketHeader));
+		if (pageNum == bucketPage)
+			localDepth = header.localDepth;
+		const char* entry = pData + sizeof(IX_BucketHeader);
+		for (int i = 0; i < header.numEntries; ++i, entry += entrySize)
+			if (!attribute || CompareKey(entry, attribute) == 0)
+				result.insert(result.end(), entry, entry + entrySize);
+		if (rc = ReleaseBucketPage(pfFileHandle, pageNum, false))
+			return rc;
+		pageNum = header.overflowPage;
+	}
+
+	numEntries = result.size() / entrySize;
+	entries = new char[result.size() > 0 ? result.size() : 1];
+	if (numEntries > 0)
+		memcpy(entries, &result[0], result.size());
+	return OK_RC;
+}
+
+// Rewrites a bucket's chain with the given entries, reusing its overflow
+// pages, adding more as needed and disposing those left empty
+RC IX_IndexHandle::WriteBucket(PageNum bucketPage, int localDepth, const char* entries, int numEntries)
+{
+	int entrySize = ixIndexHeader.attrLength + sizeof(PageNum) + sizeof(SlotNum);
+	int maxEntries = ixIndexHeader.maxEntryIndex + 1;
+	RC rc;
+	char* pData;
+	if (rc = GetBucketPage(pfFileHandle, bucketPage, pData))
+		return rc;
+	PageNum pageNum = bucketPage;
+	int written = 0;
+	while (true){
+		IX_BucketHeader header;
+		memcpy(&header, pData, sizeof(IX_BucketHeader));
+		if (pageNum == bucketPage)
+			header.localDepth = localDepth;
+		header.numEntries = min(numEntries - written, maxEntries);
+		memcpy(pData + sizeof(IX_BucketHeader), entries + written * entrySize, header.numEntries * entrySize);
+		written += header.numEntries;
+
+		// Chain another page if entries remain
+		PageNum nextPage = header.overflowPage;
+		char* nextData = NULL;
+		if (written < numEntries){
+			if (nextPage == IX_NO_PAGE){
+				if (rc = NewBucketPage(pfFileHandle, 0, nextPage, nextData)){
+					ReleaseBucketPage(pfFileHandle, pageNum, false);
+					return rc;
+				}
+				header.overflowPage = nextPage;
+			}
+			else if (rc = GetBucketPage(pfFileHandle, nextPage, nextData)){
+				ReleaseBucketPage(pfFileHandle, pageNum, false);
+				return rc;
+			}
+		}
+		else
+			header.overflowPage = IX_NO_PAGE;
+		memcpy(pData, &header, sizeof(IX_BucketHeader));
+		if (rc = ReleaseBucketPage(pfFileHandle, pageNum, true))
+			return rc;
+
+		if (!nextData){
+			// Dispose of the rest of the old chain
+			while (nextPage != IX_NO_PAGE){
+				if (rc = GetBucketPage(pfFileHandle, nextPage, pData))
+					return rc;
+				memcpy(&header, pData, sizeof(IX_BucketHeader));
+				if ((rc = ReleaseBucketPage(pfFileHandle, nextPage, false)) ||
+					(rc = pfFileHandle.DisposePage(nextPage)))
+					return rc;
+				nextPage = header.overflowPage;
+			}
+			return OK_RC;
+		}
+		pageNum = nextPage;
+		pData = nextData;
+	}
+}
+
+// Splits the bucket holding hash on its next bit, doubling the directory
+// if the bucket is as deep as it; split is false at IX_HASH_MAXDEPTH
+RC IX_IndexHandle::SplitBucket(unsigned int hash, bool &split)
+{
+	RC rc;
+	int globalDepth = ixIndexHeader.globalDepth;
+	int slot = hash & ((1u << globalDepth) - 1);
+	PageNum bucketPage;
+	if (rc = ReadDirectory(slot, 1, &bucketPage))
+		return rc;
+	char* entries;
+	int numEntries, localDepth;
+	if (rc = ReadBucket(bucketPage, NULL, entries, numEntries, localDepth))
+		return rc;
+	split = (localDepth < IX_HASH_MAXDEPTH);
+	if (!split){
+		delete [] entries;
+		return OK_RC;
+	}
+
+	// Double the directory, its upper half a copy of the lower
+	int numSlots = 1 << globalDepth;
+	vector<PageNum> directory(numSlots);
+	if (rc = ReadDirectory(0, numSlots, &directory[0])){
+		delete [] entries;
+		return rc;
+	}
+	if (localDepth == globalDepth){
+		directory.insert(directory.end(), directory.begin(), directory.end());
+		numSlots *= 2;
+		ixIndexHeader.globalDepth = ++globalDepth;
+		modified = true;
+	}
+
+	// Entries with the next bit set move to a new bucket
+	char* pData;
+	PageNum newPage;
+	if (rc = NewBucketPage(pfFileHandle, localDepth + 1, newPage, pData)){
+		delete [] entries;
+		return rc;
+	}
+	if (rc = ReleaseBucketPage(pfFileHandle, newPage, true)){
+		delete [] entries;
+		return rc;
+	}
+	int entrySize = ixIndexHeader.attrLength + sizeof(PageNum) + sizeof(SlotNum);
+	unsigned int bit = 1u << localDepth;
+	vector<char> stay, move;
+	for (int i = 0; i < numEntries; ++i){
+		const char* entry = entries + i * entrySize;
+		vector<char> &side = (HashKey(entry) & bit) ? move : stay;
+		side.insert(side.end(), entry, entry + entrySize);
+	}
+	delete [] entries;
+	if ((rc = WriteBucket(bucketPage, localDepth + 1, stay.empty() ? NULL : &stay[0], stay.size() / entrySize)) ||
+		(rc = WriteBucket(newPage, localDepth + 1, move.empty() ? NULL : &move[0], move.size() / entrySize)))
+		return rc;
+
+	// Point the slots with the bit set at the new bucket
+	for (int i = (slot & (bit - 1)) | bit; i < numSlots; i += bit << 1)
+		directory[i] = newPage;
+	return WriteDirectory(0, numSlots, &directory[0]);
+}
+
+// Each bucket's chain once, from the first directory slot holding it
+RC IX_IndexHandle::BucketStats(int &numPages, int &fillTotal) const
+{
+	int numSlots = 1 << ixIndexHeader.globalDepth;
+	vector<PageNum> directory(numSlots);
+	RC rc = ReadDirectory(0, numSlots, &directory[0]);
+	if (rc != OK_RC)
+		return rc;
+	vector<PageNum> seen;
+	for (int i = 0; i < numSlots; ++i){
+		if (find(seen.begin(), seen.end(), directory[i]) != seen.end())
+			continue;
+		seen.push_back(directory[i]);
+		PageNum pageNum = directory[i];
+		while (pageNum != IX_NO_PAGE){
+			char* pData;
+			if (rc = GetBucketPage(pfFileHandle, pageNum, pData))
+				return rc;
+			IX_BucketHeader header;
+			memcpy(&header, pData, sizeof(IX_BucketHeader));
+			if (rc = ReleaseBucketPage(pfFileHandle, pageNum, false))
+				return rc;
+			++numPages;
+			fillTotal += header.numEntries * 100 / (ixIndexHeader.maxEntryIndex + 1);
+			pageNum = header.overflowPage;
+		}
+	}
+	return OK_RC;
+}
+
+// Adds an entry to the first page of its bucket's chain with room.  A
+// full bucket is split until the entry's side has room, unless its keys
+// all hash alike, when an overflow page is chained instead
+RC IX_IndexHandle::HashInsert(void* attribute, const RID &rid)
+{
+	int entrySize = ixIndexHeader.attrLength + sizeof(PageNum) + sizeof(SlotNum);
+	int maxEntries = ixIndexHeader.maxEntryIndex + 1;
+	unsigned int hash = HashKey(attribute);
+	unsigned int depthMask = (1u << IX_HASH_MAXDEPTH) - 1;
+	RC rc;
+	while (true){
+		int slot = hash & ((1u << ixIndexHeader.globalDepth) - 1);
+		PageNum pageNum;
+		if (rc = ReadDirectory(slot, 1, &pageNum))
+			return rc;
+
+		// Find a page in the chain with room, noting whether a split
+		// would separate the entry from any of the keys there
+		bool separable = false;
+		PageNum lastPage = IX_NO_PAGE;
+		while (pageNum != IX_NO_PAGE){
+			char* pData;
+			if (rc = GetBucketPage(pfFileHandle, pageNum, pData))
+				return rc;
+			IX_BucketHeader header;
+			memcpy(&header, pData, sizeof(IX_BucketHeader));
+			if (header.numEntries < maxEntries){
+				char* entry = pData + sizeof(IX_BucketHeader) + header.numEntries * entrySize;
+				memcpy(entry, attribute, ixIndexHeader.attrLength);
+				memcpy(entry + ixIndexHeader.attrLength, &rid.pageNum, sizeof(PageNum));
+				memcpy(entry + ixIndexHeader.attrLength + sizeof(PageNum), &rid.slotNum, sizeof(SlotNum));
+				header.numEntries += 1;
+				memcpy(pData, &header, sizeof(IX_BucketHeader));
+				return ReleaseBucketPage(pfFileHandle, pageNum, true);
+			}
+			const char* entry = pData + sizeof(IX_BucketHeader);
+			for (int i = 0; !separable && i < header.numEntries; ++i, entry += entrySize)
+				separable = ((HashKey(entry) ^ hash) & depthMask) != 0;
+			if (rc = ReleaseBucketPage(pfFileHandle, pageNum, false))
+				return rc;
+			lastPage = pageNum;
+			pageNum = header.overflowPage;
+		}
+
+		if (separable){
+			bool split;
+			if (rc = SplitBucket(hash, split))
+				return rc;
+			if (split)
+				continue;
+		}
+
+		// Chain an overflow page holding the entry
+		char* pData;
+		PageNum newPage;
+		if (rc = NewBucketPage(pfFileHandle, 0, newPage, pData))
+			return rc;
+		IX_BucketHeader header;
+		memcpy(&header, pData, sizeof(IX_BucketHeader));
+		char* entry = pData + sizeof(IX_BucketHeader);
+		memcpy(entry, attribute, ixIndexHeader.attrLength);
+		memcpy(entry + ixIndexHeader.attrLength, &rid.pageNum, sizeof(PageNum));
+		memcpy(entry + ixIndexHeader.attrLength + sizeof(PageNum), &rid.slotNum, sizeof(SlotNum));
+		header.numEntries = 1;
+		memcpy(pData, &header, sizeof(IX_BucketHeader));
+		if (rc = ReleaseBucketPage(pfFileHandle, newPage, true))
+			return rc;
+		if (rc = GetBucketPage(pfFileHandle, lastPage, pData))
+			return rc;
+		memcpy(&header, pData, sizeof(IX_BucketHeader));
+		header.overflowPage = newPage;
+		memcpy(pData, &header, sizeof(IX_BucketHeader));
+		return ReleaseBucketPage(pfFileHandle, lastPage, true);
+	}
+}
+
+// Removes an entry, filling its slot with its page's last entry.  An
+// emptied overflow page is unlinked and disposed; buckets are not merged
+RC IX_IndexHandle::HashDelete(void* attribute, const RID &rid)
+{
+	int entrySize = ixIndexHeader.attrLength + sizeof(PageNum) + sizeof(SlotNum);
+	int slot = HashKey(attribute) & ((1u << ixIndexHeader.globalDepth) - 1);
+	PageNum pageNum;
+	RC rc = ReadDirectory(slot, 1, &pageNum);
+	if (rc != OK_RC)
+		return rc;
+
+	PageNum prevPage = IX_NO_PAGE;
+	while (pageNum != IX_NO_PAGE){
+		char* pData;
+		if (rc = GetBucketPage(pfFileHandle, pageNum, pData))
+			return rc;
+		IX_BucketHeader header;
+		memcpy(&header, pData, sizeof(IX_BucketHeader));
+		char* entries = pData + sizeof(IX_BucketHeader);
+		for (int i = 0; i < header.numEntries; ++i){
+			char* entry = entries + i * entrySize;
+			PageNum entryPage;
+			SlotNum entrySlot;
+			memcpy(&entryPage, entry + ixIndexHeader.attrLength, sizeof(PageNum));
+			memcpy(&entrySlot, entry + ixIndexHeader.attrLength + sizeof(PageNum), sizeof(SlotNum));
+			if (entryPage != rid.pageNum || entrySlot != rid.slotNum || CompareKey(entry, attribute) != 0)
+				continue;
+
+			header.numEntries -= 1;
+			memmove(entry, entries + header.numEntries * entrySize, entrySize);
+			memcpy(pData, &header, sizeof(IX_BucketHeader));
+			if (header.numEntries > 0 || prevPage == IX_NO_PAGE)
+				return ReleaseBucketPage(pfFileHandle, pageNum, true);
+
+			// Unlink the emptied overflow page
+			if (rc = ReleaseBucketPage(pfFileHandle, pageNum, false))
+				return rc;
+			PageNum nextPage = header.overflowPage;
+			if (rc = GetBucketPage(pfFileHandle, prevPage, pData))
+				return rc;
+			memcpy(&header, pData, sizeof(IX_BucketHeader));
+			header.overflowPage = nextPage;
+			memcpy(pData, &header, sizeof(IX_BucketHeader));
+			if (rc = ReleaseBucketPage(pfFileHandle, prevPage, true))
+				return rc;
+			rc = pfFileHandle.DisposePage(pageNum);
+			if (rc != OK_RC){
+				PrintError(rc);
+				return rc;
+			}
+			return OK_RC;
+		}
+		if (rc = ReleaseBucketPage(pfFileHandle, pageNum, false))
+			return rc;
+		prevPage = pageNum;
+		pageNum = header.overflowPage;
+	}
+
+	PrintError(IX_ENTRYDNE);
+	return IX_ENTRYDNE;
+}
+
+// Reads the matching entries of an equality scan's bucket up front; a
+// full scan reads its buckets as it reaches them
+RC IX_IndexScan::OpenHashScan()
+{
+	RC rc;
+	bool equality = lowValue && highValue && lowInclusive && highInclusive &&
+		ixIndexHandle->CompareKey((char*)lowValue, highValue) == 0;
+	if (!equality && (lowValue || highValue)){
+		PrintError(IX_HASHSCAN);
+		return IX_HASHSCAN;
+	}
+
+	entrySize = ixIndexHandle->ixIndexHeader.attrLength + sizeof(PageNum) + sizeof(SlotNum);
+	numBucketEntries = 0;
+	nextBucketEntry = 0;
+	hashSlot = 0;
+	if (equality){
+		int slot = ixIndexHandle->HashKey(lowValue) & ((1u << ixIndexHandle->ixIndexHeader.globalDepth) - 1);
+		PageNum bucketPage;
+		int localDepth;
+		if ((rc = ixIndexHandle->ReadDirectory(slot, 1, &bucketPage)) ||
+			(rc = ixIndexHandle->ReadBucket(bucketPage, lowValue, bucketEntries, numBucketEntries, localDepth)))
+			return rc;
+		hashSlot = 1 << IX_HASH_MAXDEPTH;
+	}
+
+	open = true;
+	__sync_fetch_and_add(&ixIndexHandle->openScans, 1);
+	finished = false;
+	numPostings = 0;
+	nextPosting = 0;
+	lastEntry = new char[entrySize];
+	currEntry = new char[entrySize];
+	return OK_RC;
+}
+
+// Returns the entries of the bucket read last, then reads the next bucket
+// of a full scan, each from the first directory slot holding it
+RC IX_IndexScan::GetNextHashEntry(RID &rid)
+{
+	RC rc;
+	int numSlots = 1 << ixIndexHandle->ixIndexHeader.globalDepth;
+	while (nextBucketEntry == numBucketEntries){
+		if (hashSlot >= numSlots){
+			finished = true;
+			return IX_EOF;
+		}
+		PageNum bucketPage;
+		if (rc = ixIndexHandle->ReadDirectory(hashSlot, 1, &bucketPage))
+			return rc;
+		char* pData;
+		if (rc = GetBucketPage(ixIndexHandle->pfFileHandle, bucketPage, pData))
+			return rc;
+		IX_BucketHeader header;
+		memcpy(&header, pData, sizeof(IX_BucketHeader));
+		if (rc = ReleaseBucketPage(ixIndexHandle->pfFileHandle, bucketPage, false))
+			return rc;
+		if (hashSlot < (1 << header.localDepth)){
+			delete [] bucketEntries;
+			bucketEntries = NULL;
+			int localDepth;
+			if (rc = ixIndexHandle->ReadBucket(bucketPage, NULL, bucketEntries, numBucketEntries, localDepth))
+				return rc;
+			nextBucketEntry = 0;
+		}
+		++hashSlot;
+	}
+
+	const char* entry = bucketEntries + nextBucketEntry * entrySize;
+	memcpy(lastEntry, entry, entrySize);
+	memcpy(&rid.pageNum, entry + ixIndexHandle->ixIndexHeader.attrLength, sizeof(PageNum));
+	memcpy(&rid.slotNum, entry + ixIndexHandle->ixIndexHeader.attrLength + sizeof(PageNum), sizeof(SlotNum));
+	++nextBucketEntry;
+	return OK_RC;
+}
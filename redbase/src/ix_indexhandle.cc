@@ -6,7 +6,104 @@
 
 using namespace std;
 
-IX_IndexHandle::IX_IndexHandle(): open(false), modified(false), pfFileHandle(PF_FileHandle()), ixIndexHeader(IX_IndexHeader()){}
+// Key orderings for node search, one per attribute type.  Each says
+// whether a stored key comes before value: key < value, or key <= value
+// when upper is set.
+class IX_IntBefore {
+public:
+	IX_IntBefore(void* value, bool upper): upper(upper) { memcpy(&v, value, sizeof(int)); }
+	bool operator()(const char* key) const
+	{
+		int k;
+		memcpy(&k, key, sizeof(int));
+		return (k < v) | (upper & (k == v));
+	}
+private:
+	int v;
+	bool upper;
+};
+
+class IX_FloatBefore {
+public:
+	IX_FloatBefore(void* value, bool upper): upper(upper) { memcpy(&v, value, sizeof(float)); }
+	bool operator()(const char* key) const
+	{
+		float k;
+		memcpy(&k, key, sizeof(float));
+		return (k < v) | (upper & (k == v));
+	}
+private:
+	float v;
+	bool upper;
+};
+
+class IX_StringBefore {
+public:
+	IX_StringBefore(void* value, bool upper, int attrLength)
+		: v((const char*)value), upper(upper), attrLength(attrLength) {}
+	bool operator()(const char* key) const
+	{
+		int cmp = strncmp(key, v, attrLength);
+		return (cmp < 0) | (upper & (cmp == 0));
+	}
+private:
+	const char* v;
+	bool upper;
+	int attrLength;
+};
+
+class IX_CompositeBefore {
+public:
+	IX_CompositeBefore(void* value, bool upper, int attrLength)
+		: v((const char*)value), upper(upper), attrLength(attrLength) {}
+	bool operator()(const char* key) const
+	{
+		int cmp = memcmp(key, v, attrLength);
+		return (cmp < 0) | (upper & (cmp == 0));
+	}
+private:
+	const char* v;
+	bool upper;
+	int attrLength;
+};
+
+// Counts the leading keys, stride bytes apart, that come before the
+// searched value.  The probe moves with a conditional select instead of
+// a branch, so the loop runs log2(n) times whatever the keys are.
+template <class Before>
+static int NodeSearch(const char* first, int stride, int n, const Before &before)
+{
+	if (n <= 0)
+		return 0;
+	const char* base = first;
+	while (n > 1){
+		int half = n / 2;
+		base = before(base + half * stride) ? base + half * stride : base;
+		n -= half;
+	}
+	return (base - first) / stride + before(base);
+}
+
+static int TypedNodeSearch(const char* first, int stride, int n, void* value, bool upper,
+	const IX_IndexHeader &header)
+{
+	if (header.numKeyAttrs > 0)
+		return NodeSearch(first, stride, n, IX_CompositeBefore(value, upper, header.attrLength));
+	switch(header.attrType) {
+	case INT:
+		return NodeSearch(first, stride, n, IX_IntBefore(value, upper));
+	case FLOAT:
+		return NodeSearch(first, stride, n, IX_FloatBefore(value, upper));
+	case STRING:
+		return NodeSearch(first, stride, n, IX_StringBefore(value, upper, header.attrLength));
+	}
+	return 0;
+}
+
+IX_IndexHandle::IX_IndexHandle(): open(false), modified(false), pfFileHandle(PF_FileHandle()), ixIndexHeader(IX_IndexHeader()),
+	mergePercent(IX_MERGE_PERCENT), openScans(0), descentPages(IX_DESCENT_PAGES), numPinned(0), descentStale(false),
+	numWriteLatches(0), readersExcluded(false), bloomOpen(false), bloomPages(0), countsOpen(false),
+	numStaleCounts(0), countsLost(false), ridDelta(0), keyDelta(0){}
 
 IX_IndexHandle::~IX_IndexHandle()
 {
@@ -39,18 +136,58 @@ RC IX_IndexHandle::InsertEntry(void *attribute, const RID &rid)
 		return rc;
 	// End check input.
 
+	// A hash insert may split buckets and grow the directory, and a bitmap
+	// insert rewrites a page its key's scans read whole, so they run alone.
+	// A tree insert only keeps out other writers; readers go on around the
+	// pages it latches
+	if (ixIndexHeader.indexType != BTREE_INDEX){
+		if (rc = LatchIndex(PF_EXCLUSIVE))
+			return rc;
+		if ((rc = BloomAdd(attribute)) == OK_RC)
+			rc = (ixIndexHeader.indexType == HASH_INDEX) ? HashInsert(attribute, rid) : BitmapInsert(attribute, rid);
+		RC latchRC = UnlatchIndex(PF_EXCLUSIVE);
+		return (rc != OK_RC) ? rc : latchRC;
+	}
+	if (rc = LatchIndex(PF_UPDATE))
+		return rc;
+	numWriteLatches = 0;
+	readersExcluded = false;
+	if (ixIndexHeader.height + 3 > IX_MAX_WRITE_LATCHES)
+		rc = ExcludeReaders();
+	if (rc == OK_RC)
+		rc = BloomAdd(attribute);
+	if (rc == OK_RC)
+		rc = TreeInsert(attribute, rid);
+	RC latchRC = ReleaseWriteLatches();
+	if (latchRC == OK_RC)
+		latchRC = UnlatchIndex(readersExcluded ? PF_EXCLUSIVE : PF_UPDATE);
+	readersExcluded = false;
+	return (rc != OK_RC) ? rc : latchRC;
+}
+
+// Inserts into the tree, holding the index latch in update mode
+RC IX_IndexHandle::TreeInsert(void *attribute, const RID &rid)
+{
 	// Recursive call
 	//cerr << "IX a" << endl;
+	numStaleCounts = 0;
+	countsLost = false;
 	PageNum newChildPage = IX_NO_PAGE;
 	char* newAttribute = new char[ixIndexHeader.attrLength];
-	rc = InsertEntryHelper(ixIndexHeader.rootPage, ixIndexHeader.height, attribute, rid, newChildPage, newAttribute);
+	RC rc = InsertEntryHelper(ixIndexHeader.rootPage, ixIndexHeader.height, attribute, rid, newChildPage, newAttribute, NULL, NULL);
 	if (rc != OK_RC){
 		delete [] newAttribute;
 		return rc;
 	}
 	//cerr << "IX b" << endl;
-	// Root node was split, need to add level to index
+	// Root node was split, need to add level to index.  Readers take the
+	// root from the header, so the root changes with none of them running
 	if (newChildPage != IX_NO_PAGE){
+		if (rc = ExcludeReaders()){
+			delete [] newAttribute;
+			return rc;
+		}
+
 		// Create new root
 		PageNum pageNum;
 		char *pData;
@@ -81,18 +218,17 @@ RC IX_IndexHandle::InsertEntry(void *attribute, const RID &rid)
 			return rc;
 		}
 
-		// Write root header info
-		char* ptr = pData;
-		int intTmp = 1;
-		memcpy(ptr, &intTmp, sizeof(int));
-
 		// Write data, key<old root> attribute<newAttribute> key<newChildPage>
-		ptr += sizeof(int);
+		int copyBackSize = 2 * sizeof(PageNum) + ixIndexHeader.attrLength;
+		char* copyBack = new char[copyBackSize];
+		char* ptr = copyBack;
 		memcpy(ptr, &ixIndexHeader.rootPage, sizeof(PageNum));
 		ptr += sizeof(PageNum);
 		memcpy(ptr, newAttribute, ixIndexHeader.attrLength);
 		ptr += ixIndexHeader.attrLength;
 		memcpy(ptr, &newChildPage, sizeof(PageNum));
+		WriteInternalFromKeyCopyBack(pData, copyBack, copyBackSize, 1, NULL, 0);
+		delete [] copyBack;
 
 		// Mark page as dirty
 		rc = pfFileHandle.MarkDirty(pageNum);
@@ -122,12 +258,18 @@ RC IX_IndexHandle::InsertEntry(void *attribute, const RID &rid)
 		modified = true;
 		ixIndexHeader.rootPage = pageNum;
 		ixIndexHeader.height += 1;
+		descentStale = true;
+		StaleCounts(pageNum, ixIndexHeader.height);
 	}
 
 	// Clean up
 	delete [] newAttribute;
 	newAttribute = NULL;
-	return OK_RC;
+
+	// A split may have changed the pinned levels
+	if (descentStale && ((rc = UnpinUpperLevels()) || (rc = PinUpperLevels())))
+		return rc;
+	return FinishCounts();
 }
 
 // Delete a new index entry
@@ -156,13 +298,36 @@ RC IX_IndexHandle::DeleteEntry(void *attribute, const RID &rid)
 		return rc;
 	// End check input
 
+	// Deletes may merge away the nodes readers are on, so they run alone
+	if (rc = LatchIndex(PF_EXCLUSIVE))
+		return rc;
+	if (ixIndexHeader.indexType == HASH_INDEX)
+		rc = HashDelete(attribute, rid);
+	else if (ixIndexHeader.indexType == BITMAP_INDEX)
+		rc = BitmapDelete(attribute, rid);
+	else
+		rc = TreeDelete(attribute, rid);
+	RC latchRC = UnlatchIndex(PF_EXCLUSIVE);
+	return (rc != OK_RC) ? rc : latchRC;
+}
+
+// Deletes from the tree, holding the index latch exclusively
+RC IX_IndexHandle::TreeDelete(void *attribute, const RID &rid)
+{
 	// Recursive delete call
+	numStaleCounts = 0;
+	countsLost = false;
+	ridDelta = 0;
+	keyDelta = 0;
 	PageNum oldPage = IX_NO_PAGE;
-	rc = DeleteEntryHelper(ixIndexHeader.rootPage, ixIndexHeader.height, attribute, rid, oldPage);
+	RC rc = DeleteEntryHelper(ixIndexHeader.rootPage, ixIndexHeader.height, attribute, rid, oldPage, NULL, NULL);
 	if (rc != OK_RC)
 		return rc;
 
-	return OK_RC;
+	// A merge may have changed the pinned levels
+	if (descentStale && ((rc = UnpinUpperLevels()) || (rc = PinUpperLevels())))
+		return rc;
+	return FinishCounts();
 }
 
 // Force index files to disk
@@ -197,6 +362,15 @@ RC IX_IndexHandle::ForcePages()
 
 		ptr += sizeof(PageNum);
 		memcpy(ptr, &ixIndexHeader.height, sizeof(int));
+
+		// A hash index's directory grows, past the fields before it
+		if (ixIndexHeader.indexType == HASH_INDEX){
+			ptr += sizeof(int) + sizeof(AttrType) + sizeof(int) + 2 * sizeof(SlotNum) + 2 * sizeof(int) + sizeof(bool) + sizeof(int);
+			ptr += MAXINDEXATTRS * (sizeof(AttrType) + sizeof(int)) + sizeof(IndexType);
+			memcpy(ptr, &ixIndexHeader.globalDepth, sizeof(int));
+			ptr += sizeof(int);
+			memcpy(ptr, ixIndexHeader.dirPages, IX_HASH_DIRPAGES * sizeof(PageNum));
+		}
 		// End write to header page.
 
 		// Mark header page as dirty
@@ -228,33 +402,256 @@ RC IX_IndexHandle::ForcePages()
 	return OK_RC;
 }
 
+// Merging under half full would only trade the node for a full one
+RC IX_IndexHandle::SetMergePercent(int percent)
+{
+	if (percent < 0 || percent > 50){
+		PrintError(IX_INVALIDNUM);
+		return IX_INVALIDNUM;
+	}
+	mergePercent = percent;
+	return OK_RC;
+}
+
+// Encode a composite key, see ix.h
+RC IX_IndexHandle::EncodeKey(void * const values[], int numValues, bool high, char *key) const
+{
+	// Check input
+	if (!values || !key){
+		PrintError(IX_NULLINPUT);
+		return IX_NULLINPUT;
+	}
+	if (ixIndexHeader.numKeyAttrs == 0 || numValues < 0 || numValues > ixIndexHeader.numKeyAttrs){
+		PrintError(IX_KEYATTRS);
+		return IX_KEYATTRS;
+	}
+	// End check input
+
+	char* ptr = key;
+	for (int i = 0; i < numValues; ++i){
+		int length = ixIndexHeader.keyAttrLengths[i];
+		unsigned int bits;
+		switch(ixIndexHeader.keyAttrTypes[i]) {
+		case INT:
+			memcpy(&bits, values[i], sizeof(int));
+			bits ^= 0x80000000u;
+			break;
+		case FLOAT:
+			memcpy(&bits, values[i], sizeof(float));
+			if (bits == 0x80000000u)
+				bits = 0; // -0 equals 0
+			bits = (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+			break;
+		case STRING:
+			// Null padded past the string's end, whatever the value held there
+			strncpy(ptr, (const char*)values[i], length);
+			ptr += length;
+			continue;
+		}
+		for (int b = 0; b < 4; ++b)
+			ptr[b] = (char)(bits >> (24 - 8 * b));
+		ptr += length;
+	}
+	memset(ptr, high ? 0xFF : 0, key + ixIndexHeader.attrLength - ptr);
+	return OK_RC;
+}
+
+RC IX_IndexHandle::DecodeKey(const char *key, void * const values[]) const
+{
+	// Check input
+	if (!key || !values){
+		PrintError(IX_NULLINPUT);
+		return IX_NULLINPUT;
+	}
+	if (ixIndexHeader.numKeyAttrs == 0){
+		PrintError(IX_KEYATTRS);
+		return IX_KEYATTRS;
+	}
+	// End check input
+
+	const char* ptr = key;
+	for (int i = 0; i < ixIndexHeader.numKeyAttrs; ++i){
+		int length = ixIndexHeader.keyAttrLengths[i];
+		if (ixIndexHeader.keyAttrTypes[i] == STRING){
+			memcpy(values[i], ptr, length);
+			ptr += length;
+			continue;
+		}
+		unsigned int bits = 0;
+		for (int b = 0; b < 4; ++b)
+			bits = (bits << 8) | (unsigned char)ptr[b];
+		if (ixIndexHeader.keyAttrTypes[i] == INT)
+			bits ^= 0x80000000u;
+		else
+			bits = (bits & 0x80000000u) ? (bits ^ 0x80000000u) : ~bits;
+		memcpy(values[i], &bits, sizeof(int));
+		ptr += length;
+	}
+	return OK_RC;
+}
+
 char* IX_IndexHandle::GetKeyPtr(char* pData, const SlotNum slotNum) const
 {
+	if (ixIndexHeader.separated)
+		return SeparatedKeys(pData, false) + slotNum * IX_KEY_STRIDE(ixIndexHeader.attrLength);
 	char* ptr = pData + ixIndexHeader.internalHeaderSize;
 	ptr += sizeof(PageNum);
 	ptr += slotNum * (ixIndexHeader.attrLength + sizeof(PageNum));
 	return ptr;
 }
+// A separated leaf's entry pointer is to its key alone
 char* IX_IndexHandle::GetEntryPtr(char* pData, const SlotNum slotNum) const
 {
+	if (ixIndexHeader.separated)
+		return SeparatedKeys(pData, true) + slotNum * IX_KEY_STRIDE(ixIndexHeader.attrLength);
 	char* ptr = pData + ixIndexHeader.leafHeaderSize;
 	ptr += slotNum * (ixIndexHeader.attrLength + sizeof(PageNum) + sizeof(SlotNum));
 	return ptr;
 }
+PageNum IX_IndexHandle::GetChildPage(char* pData, const SlotNum slotNum) const
+{
+	PageNum pageNum;
+	if (ixIndexHeader.separated)
+		memcpy(&pageNum, SeparatedPointers(pData, false) + slotNum * sizeof(PageNum), sizeof(PageNum));
+	else if (!ixIndexHeader.compressed)
+		memcpy(&pageNum, GetKeyPtr(pData, slotNum) - sizeof(PageNum), sizeof(PageNum));
+	else if (slotNum == 0){
+		int prefixLen;
+		memcpy(&pageNum, NodePrefix(pData, false, prefixLen) + prefixLen, sizeof(PageNum));
+	}
+	else {
+		char* record = CompressedRecord(pData, false, slotNum - 1);
+		memcpy(&pageNum, record + 1 + (unsigned char)record[0], sizeof(PageNum));
+	}
+	return pageNum;
+}
+void IX_IndexHandle::GetKey(char* pData, const SlotNum slotNum, char* key) const
+{
+	if (!ixIndexHeader.compressed){
+		memcpy(key, GetKeyPtr(pData, slotNum), ixIndexHeader.attrLength);
+		return;
+	}
+	int prefixLen;
+	char* prefix = NodePrefix(pData, false, prefixLen);
+	char* record = CompressedRecord(pData, false, slotNum);
+	unsigned char suffixLen = record[0];
+	memset(key, 0, ixIndexHeader.attrLength);
+	memcpy(key, prefix, prefixLen);
+	memcpy(key + prefixLen, record + 1, suffixLen);
+}
+const char* IX_IndexHandle::GetEntry(char* pData, const SlotNum slotNum, char* entry) const
+{
+	if (ixIndexHeader.separated){
+		memcpy(entry, GetEntryPtr(pData, slotNum), ixIndexHeader.attrLength);
+		memcpy(entry + ixIndexHeader.attrLength, GetEntryRid(pData, slotNum), sizeof(PageNum) + sizeof(SlotNum));
+		return entry;
+	}
+	if (!ixIndexHeader.compressed)
+		return GetEntryPtr(pData, slotNum);
+	int prefixLen;
+	char* prefix = NodePrefix(pData, true, prefixLen);
+	char* record = CompressedRecord(pData, true, slotNum);
+	unsigned char suffixLen = record[0];
+	memset(entry, 0, ixIndexHeader.attrLength);
+	memcpy(entry, prefix, prefixLen);
+	memcpy(entry + prefixLen, record + 1, suffixLen);
+	memcpy(entry + ixIndexHeader.attrLength, record + 1 + suffixLen, sizeof(PageNum) + sizeof(SlotNum));
+	return entry;
+}
+char* IX_IndexHandle::GetEntryRid(char* pData, const SlotNum slotNum) const
+{
+	if (ixIndexHeader.separated)
+		return SeparatedPointers(pData, true) + slotNum * (sizeof(PageNum) + sizeof(SlotNum));
+	if (!ixIndexHeader.compressed)
+		return GetEntryPtr(pData, slotNum) + ixIndexHeader.attrLength;
+	char* record = CompressedRecord(pData, true, slotNum);
+	return record + 1 + (unsigned char)record[0];
+}
+// A compressed or separated leaf has no bitmap, its entries fill the
+// first slots
 bool IX_IndexHandle::GetSlotBitValue(char* pData, const SlotNum slotNum) const
 {
+	if (ixIndexHeader.compressed || ixIndexHeader.separated){
+		int numEntries;
+		memcpy(&numEntries, pData, sizeof(int));
+		return slotNum < numEntries;
+	}
 	char c = *(pData + IX_BIT_START + slotNum / 8); //bits per byte
 	return c & (1 << slotNum % 8);
 }
 void IX_IndexHandle::SetSlotBitValue(char* pData, const SlotNum slotNum, bool b)
 {
+	if (ixIndexHeader.compressed || ixIndexHeader.separated)
+		return;
 	if (b)
 		pData[IX_BIT_START + slotNum / 8] |= ( 1 << slotNum % 8);
 	else
 		pData[IX_BIT_START + slotNum / 8] &= ~( 1 << slotNum % 8);
 }
 
-RC IX_IndexHandle::InsertEntryHelper(PageNum currPage, int height, void* attribute, const RID &rid, PageNum &newChildPage, char* &newAttribute)
+int IX_IndexHandle::UpperBoundKey(char* pData, int numKeys, void* attribute) const
+{
+	if (ixIndexHeader.compressed)
+		return CompressedSearch(pData, false, numKeys, attribute, true);
+	if (ixIndexHeader.separated){
+		int first, last;
+		HintRange(pData, false, numKeys, attribute, first, last);
+		return first + TypedNodeSearch(GetKeyPtr(pData, first), IX_KEY_STRIDE(ixIndexHeader.attrLength), last - first,
+			attribute, true, ixIndexHeader);
+	}
+	return TypedNodeSearch(GetKeyPtr(pData, 0), ixIndexHeader.attrLength + sizeof(PageNum), numKeys,
+		attribute, true, ixIndexHeader);
+}
+int IX_IndexHandle::SearchEntries(char* pData, int numEntries, void* attribute, bool upper) const
+{
+	if (ixIndexHeader.compressed)
+		return CompressedSearch(pData, true, numEntries, attribute, upper);
+	if (ixIndexHeader.separated){
+		int first, last;
+		HintRange(pData, true, numEntries, attribute, first, last);
+		return first + TypedNodeSearch(GetEntryPtr(pData, first), IX_KEY_STRIDE(ixIndexHeader.attrLength), last - first,
+			attribute, upper, ixIndexHeader);
+	}
+	return TypedNodeSearch(GetEntryPtr(pData, 0), ixIndexHeader.attrLength + sizeof(PageNum) + sizeof(SlotNum), numEntries,
+		attribute, upper, ixIndexHeader);
+}
+int IX_IndexHandle::CompareKey(const char* key, const void* value) const
+{
+	if (ixIndexHeader.numKeyAttrs > 0)
+		return memcmp(key, value, ixIndexHeader.attrLength);
+	switch(ixIndexHeader.attrType) {
+	case INT: {
+		int k, v;
+		memcpy(&k, key, sizeof(int));
+		memcpy(&v, value, sizeof(int));
+		return (k < v) ? -1 : (k > v);
+	}
+	case FLOAT: {
+		float k, v;
+		memcpy(&k, key, sizeof(float));
+		memcpy(&v, value, sizeof(float));
+		return (k < v) ? -1 : (k > v);
+	}
+	case STRING:
+		return strncmp(key, (const char*)value, ixIndexHeader.attrLength);
+	}
+	return 0;
+}
+bool IX_IndexHandle::LeafIsCompact(char* pData, int numEntries) const
+{
+	if (ixIndexHeader.compressed || ixIndexHeader.separated)
+		return true;
+	const unsigned char* bits = (const unsigned char*)(pData + IX_BIT_START);
+	for (int i = 0; i < numEntries / 8; ++i){
+		if (bits[i] != 0xFF)
+			return false;
+	}
+	int rest = numEntries % 8;
+	return rest == 0 || (bits[numEntries / 8] & ((1 << rest) - 1)) == (1 << rest) - 1;
+}
+
+RC IX_IndexHandle::InsertEntryHelper(PageNum currPage, int height, void* attribute, const RID &rid, PageNum &newChildPage, char* &newAttribute,
+	const char* lowKey, const char* highKey)
 {
 	// Get page data
 	char *pData;
@@ -279,8 +676,22 @@ RC IX_IndexHandle::InsertEntryHelper(PageNum currPage, int height, void* attribu
 		SlotNum insertKeyIndex;
 		ChooseSubtree(pData, attribute, nextPage, numKeys, insertKeyIndex);
 
+		// The keys on either side of the child bound its keys
+		char childLowKey[MAXSTRINGLEN];
+		char childHighKey[MAXSTRINGLEN];
+		const char* childLow = lowKey;
+		const char* childHigh = highKey;
+		if (ixIndexHeader.compressed && insertKeyIndex > 0){
+			GetKey(pData, insertKeyIndex - 1, childLowKey);
+			childLow = childLowKey;
+		}
+		if (ixIndexHeader.compressed && insertKeyIndex < numKeys){
+			GetKey(pData, insertKeyIndex, childHighKey);
+			childHigh = childHighKey;
+		}
+
 		// Recursively insert entry
-		rc = InsertEntryHelper(nextPage, height - 1, attribute, rid, newChildPage, newAttribute);
+		rc = InsertEntryHelper(nextPage, height - 1, attribute, rid, newChildPage, newAttribute, childLow, childHigh);
 		if (rc != OK_RC){
 			pfFileHandle.UnpinPage(currPage);
 			return rc;
@@ -295,12 +706,19 @@ RC IX_IndexHandle::InsertEntryHelper(PageNum currPage, int height, void* attribu
 				return rc;
 			}
 
-			return OK_RC;
+			return AddCounts(currPage, height, insertKeyIndex, ridDelta, keyDelta);
 		}
 
 		// We split child, must insert newChildEntry in N
+		StaleCounts(currPage, height);
+		rc = LatchForWrite(currPage);
+		if (rc != OK_RC){
+			pfFileHandle.UnpinPage(currPage);
+			return rc;
+		}
+
 		// If N has space... usual case
-		if (numKeys - 1 < ixIndexHeader.maxKeyIndex){
+		if (InternalHasRoom(pData, numKeys, newAttribute)){
 			rc = InternalInsert(currPage, newChildPage, newAttribute, insertKeyIndex);
 			if (rc != OK_RC){
 				pfFileHandle.UnpinPage(currPage);
@@ -353,24 +771,26 @@ RC IX_IndexHandle::InsertEntryHelper(PageNum currPage, int height, void* attribu
 			char* copyBack;
 			int copyBackSize;
 			MakeKeyCopyBack(pData, insertKeyIndex, newChildPage, newAttribute, copyBack, copyBackSize, numKeys);
-			SlotNum middleKeyIndex = numKeys / 2;
+			SlotNum middleKeyIndex = ixIndexHeader.compressed ? SplitKeys(copyBack, numKeys, lowKey, highKey) : numKeys / 2;
 			
 			// Store first half of keys in N
 			int keySize = ixIndexHeader.attrLength + sizeof(PageNum);
 			int newNumKeys = middleKeyIndex;
 			int newCopyBackSize = sizeof(PageNum) + newNumKeys * keySize;
-			WriteInternalFromKeyCopyBack(pData, copyBack, newCopyBackSize, newNumKeys);
+			char* ptr = copyBack + newCopyBackSize;
+			WriteInternalFromKeyCopyBack(pData, copyBack, newCopyBackSize, newNumKeys, lowKey, CommonPrefix(lowKey, ptr));
 
 			// Copy middle attribute, updating newChildPage and newAttribute
-			char* ptr = copyBack + newCopyBackSize;
 			memcpy(newAttribute, ptr, ixIndexHeader.attrLength);
 			newChildPage = newPage;
+			descentStale = true;
+			StaleCounts(newPage, height);
 
 			// Write rest of keys to new node N2
 			ptr += ixIndexHeader.attrLength;
 			newNumKeys = numKeys - newNumKeys - 1;
 			newCopyBackSize = sizeof(PageNum) + newNumKeys * keySize;
-			WriteInternalFromKeyCopyBack(newPData, ptr, newCopyBackSize, newNumKeys);
+			WriteInternalFromKeyCopyBack(newPData, ptr, newCopyBackSize, newNumKeys, newAttribute, CommonPrefix(newAttribute, highKey));
 
 			
 			// Mark N and N2 pages as dirty
@@ -425,9 +845,37 @@ RC IX_IndexHandle::InsertEntryHelper(PageNum currPage, int height, void* attribu
 		//cerr << "InsertEntryHelper numEntries: " << tmperInt << endl;
 		// TODO GINA HERE END
 
+		// Key already in L, add rid to its posting list
+		SlotNum keySlot;
+		if (FindKeyInLeaf(pData, numEntries, attribute, keySlot)){
+			rc = LatchForWrite(currPage);
+			if (rc == OK_RC)
+				rc = AddToPostings(currPage, pData, keySlot, rid);
+			if (rc != OK_RC){
+				pfFileHandle.UnpinPage(currPage);
+				return rc;
+			}
+
+			// Set newChildPage and newAttribute to null
+			newChildPage = IX_NO_PAGE;
+
+			pData = NULL;
+			rc = pfFileHandle.UnpinPage(currPage);
+			if (rc != OK_RC){
+				PrintError(rc);
+				return rc;
+			}
+
+			ridDelta = 1;
+			keyDelta = 0;
+			return AddCounts(currPage, height, -1, ridDelta, keyDelta);
+		}
+
 		// If L has space... usual case
-		if (numEntries - 1 < ixIndexHeader.maxEntryIndex){
-			rc = LeafInsert(currPage, attribute, rid);
+		if (LeafHasRoom(pData, numEntries, attribute)){
+			rc = LatchForWrite(currPage);
+			if (rc == OK_RC)
+				rc = LeafInsert(currPage, attribute, rid);
 			if (rc != OK_RC){
 				pfFileHandle.UnpinPage(currPage);
 				return rc;
@@ -443,7 +891,9 @@ RC IX_IndexHandle::InsertEntryHelper(PageNum currPage, int height, void* attribu
 				return rc;
 			}
 
-			return OK_RC;
+			ridDelta = 1;
+			keyDelta = 1;
+			return AddCounts(currPage, height, -1, ridDelta, keyDelta);
 		}
 		// Leaf is full, special case for bucket chaining
 		else if (ShouldBucket(attribute, pData)){
@@ -451,6 +901,16 @@ RC IX_IndexHandle::InsertEntryHelper(PageNum currPage, int height, void* attribu
 		}
 		// Once in a while, the leaf is full
 		else {
+			// Latch L and its right sibling L3, whose left link changes too;
+			// latches are taken right to left
+			PageNum L3Page;
+			memcpy(&L3Page, pData + sizeof(int) + 2 * sizeof(PageNum), sizeof(PageNum));
+			if ((L3Page != IX_NO_PAGE && (rc = LatchForWrite(L3Page))) ||
+				(rc = LatchForWrite(currPage))){
+				pfFileHandle.UnpinPage(currPage);
+				return rc;
+			}
+
 			// Split L
 			// Make L2 page, set newChildPage
 			char *newPData;
@@ -486,34 +946,46 @@ RC IX_IndexHandle::InsertEntryHelper(PageNum currPage, int height, void* attribu
 			int numEntries;
 			MakeEntryCopyBack(pData, attribute, rid, copyBack, copyBackSize, numEntries);
 
-			// Determine where to split
+			// Determine where to split; compressed leaves split by bytes,
+			// under the shortest key that tells the halves apart
 			int newNumEntries = numEntries / 2;
 			int entrySize = ixIndexHeader.attrLength + sizeof(PageNum) + sizeof(SlotNum);
-			int entryItr = newNumEntries - 1;
-			while (entryItr > -1 && AttributeEqualEntry(copyBack + newNumEntries * entrySize, copyBack + entryItr * entrySize))
-				entryItr -= 1;
-			if (entryItr == -1){
-				entryItr = newNumEntries + 1;
-				while (entryItr < numEntries && AttributeEqualEntry(copyBack + newNumEntries * entrySize, copyBack + entryItr * entrySize))
-					entryItr += 1;
+			if (ixIndexHeader.compressed)
+				newNumEntries = SplitEntries(copyBack, numEntries, lowKey, highKey, newAttribute);
+			else {
+				int entryItr = newNumEntries - 1;
+				while (entryItr > -1 && AttributeEqualEntry(copyBack + newNumEntries * entrySize, copyBack + entryItr * entrySize))
+					entryItr -= 1;
+				if (entryItr == -1){
+					entryItr = newNumEntries + 1;
+					while (entryItr < numEntries && AttributeEqualEntry(copyBack + newNumEntries * entrySize, copyBack + entryItr * entrySize))
+						entryItr += 1;
+				}
+				if (entryItr < newNumEntries)
+					newNumEntries = entryItr + 1;
+				else
+					newNumEntries = entryItr;
+
+				// Set newAttribute
+				memcpy(newAttribute, copyBack + newNumEntries * entrySize, ixIndexHeader.attrLength);
 			}
-			if (entryItr < newNumEntries)
-				newNumEntries = entryItr + 1;
-			else
-				newNumEntries = entryItr;
 
 			// Write first d entries to L
-			int newSize = (ixIndexHeader.attrLength + sizeof(PageNum) + sizeof(SlotNum)) * (newNumEntries);
-			WriteLeafFromEntryCopyBack(pData, copyBack, newSize, newNumEntries);
+			int newSize = entrySize * (newNumEntries);
+			WriteLeafFromEntryCopyBack(pData, copyBack, newSize, newNumEntries, lowKey, CommonPrefix(lowKey, newAttribute));
 
 			// Write rest of entries to new node L2
 			char* ptr = copyBack + newSize;
 			newNumEntries = numEntries - newNumEntries;
-			newSize = (ixIndexHeader.attrLength + sizeof(PageNum) + sizeof(SlotNum)) * (newNumEntries);
-			WriteLeafFromEntryCopyBack(newPData, ptr, newSize, newNumEntries);
+			newSize = entrySize * (newNumEntries);
+			WriteLeafFromEntryCopyBack(newPData, ptr, newSize, newNumEntries, newAttribute, CommonPrefix(newAttribute, highKey));
+			PageNum noBucket = IX_NO_PAGE;
+			memcpy(newPData + sizeof(int), &noBucket, sizeof(PageNum));
 
-			// Set newAttribute
-			memcpy(newAttribute, ptr, ixIndexHeader.attrLength);
+			ridDelta = 1;
+			keyDelta = 1;
+			StaleCounts(currPage, height);
+			StaleCounts(newChildPage, height);
 
 			// Set sibling pointers
 			rc = SetSiblingPointers(currPage, newChildPage, pData, newPData);
@@ -571,6 +1043,17 @@ RC IX_IndexHandle::InsertEntryHelper(PageNum currPage, int height, void* attribu
 	return OK_RC;
 }
 
+// A compressed node has room if the key's record fits in its free bytes
+bool IX_IndexHandle::InternalHasRoom(char* pData, int numKeys, void* newAttribute) const
+{
+	if (!ixIndexHeader.compressed)
+		return numKeys - 1 < ixIndexHeader.maxKeyIndex;
+	int prefixLen;
+	NodePrefix(pData, false, prefixLen);
+	int recordSize = IX_OFFSET_SIZE + 1 + KeyLength((char*)newAttribute) - prefixLen + sizeof(PageNum);
+	return CompressedBytes(pData, false) + recordSize <= PF_PAGE_SIZE;
+}
+
 // Assumes there is free space in internal
 RC IX_IndexHandle::InternalInsert(PageNum pageNum, PageNum newChildPage, void* newAttribute, SlotNum keyNum)
 {
@@ -590,6 +1073,28 @@ RC IX_IndexHandle::InternalInsert(PageNum pageNum, PageNum newChildPage, void* n
 		return rc;
 	}
 
+	// Compressed or separated node, rewrite it whole
+	if (ixIndexHeader.compressed || ixIndexHeader.separated){
+		char* copyBack;
+		int copyBackSize;
+		int numKeys;
+		MakeKeyCopyBack(pData, keyNum, newChildPage, newAttribute, copyBack, copyBackSize, numKeys);
+		WriteInternalFromKeyCopyBack(pData, copyBack, copyBackSize, numKeys);
+		delete [] copyBack;
+		rc = pfFileHandle.MarkDirty(pageNum);
+		if (rc != OK_RC){
+			pfFileHandle.UnpinPage(pageNum);
+			PrintError(rc);
+			return rc;
+		}
+		rc = pfFileHandle.UnpinPage(pageNum);
+		if (rc != OK_RC){
+			PrintError(rc);
+			return rc;
+		}
+		return OK_RC;
+	}
+
 	// Get number of keys
 	int numKeys;
 	memcpy(&numKeys, pData, sizeof(int));
@@ -650,7 +1155,8 @@ void IX_IndexHandle::MakeKeyCopyBack(char* pData, SlotNum insertIndex, PageNum n
 	char* ptr = copyBack;
 
 	// Copy over keys to copyBack
-	memcpy(ptr, pData + sizeof(int), sizeof(PageNum));
+	PageNum pageNum = GetChildPage(pData, 0);
+	memcpy(ptr, &pageNum, sizeof(PageNum));
 	ptr += sizeof(PageNum);
 	for (SlotNum i = 0; i < numKeys; ++i){
 		// Check if should insert new key first
@@ -660,7 +1166,9 @@ void IX_IndexHandle::MakeKeyCopyBack(char* pData, SlotNum insertIndex, PageNum n
 			memcpy(ptr, &newChildPage, sizeof(PageNum));
 			ptr += sizeof(PageNum);
 		}
-		memcpy(ptr, GetKeyPtr(pData, i), keySize);
+		GetKey(pData, i, ptr);
+		pageNum = GetChildPage(pData, i + 1);
+		memcpy(ptr + ixIndexHeader.attrLength, &pageNum, sizeof(PageNum));
 		ptr += keySize;
 	}
 	// Check if new key has been inserted
@@ -675,8 +1183,21 @@ void IX_IndexHandle::MakeKeyCopyBack(char* pData, SlotNum insertIndex, PageNum n
 	numKeys += 1;
 }
 
-void IX_IndexHandle::WriteInternalFromKeyCopyBack(char* pData, char* copyBack, int copyBackSize, int numKeys)
+// A compressed node is written under prefix, or its own prefix if
+// prefixLen is -1
+void IX_IndexHandle::WriteInternalFromKeyCopyBack(char* pData, char* copyBack, int copyBackSize, int numKeys, const char* prefix, int prefixLen)
 {
+	if (ixIndexHeader.compressed){
+		if (prefixLen < 0)
+			prefix = NodePrefix(pData, false, prefixLen);
+		Compress(pData, copyBack, numKeys, false, prefix, prefixLen);
+		return;
+	}
+	if (ixIndexHeader.separated){
+		WriteSeparated(pData, copyBack, numKeys, false);
+		return;
+	}
+
 	// Write copyBack back
 	char* ptr = pData + ixIndexHeader.internalHeaderSize;
 	memcpy(ptr, copyBack, copyBackSize);
@@ -686,6 +1207,16 @@ void IX_IndexHandle::WriteInternalFromKeyCopyBack(char* pData, char* copyBack, i
 	memcpy(pData, &numKeys, sizeof(int));
 }
 
+bool IX_IndexHandle::LeafHasRoom(char* pData, int numEntries, void* attribute) const
+{
+	if (!ixIndexHeader.compressed)
+		return numEntries - 1 < ixIndexHeader.maxEntryIndex;
+	int prefixLen;
+	NodePrefix(pData, true, prefixLen);
+	int recordSize = IX_OFFSET_SIZE + 1 + KeyLength((char*)attribute) - prefixLen + sizeof(PageNum) + sizeof(SlotNum);
+	return CompressedBytes(pData, true) + recordSize <= PF_PAGE_SIZE;
+}
+
 // Assume there is free space in leaf
 // Assumes leaf header is already set up
 RC IX_IndexHandle::LeafInsert(PageNum pageNum, void* attribute, const RID &rid)
@@ -772,6 +1303,21 @@ void IX_IndexHandle::MakeEntryCopyBack(char* pData, void* attribute, const RID &
 	char* ptr;
 	bool inserted = false;
 
+	// Compact leaf, binary search for the entry after the last <= attribute
+	if (LeafIsCompact(pData, numEntries - 1)){
+		int insertIndex = SearchEntries(pData, numEntries - 1, attribute, true);
+		ReadEntries(pData, 0, insertIndex, copyBackPtr);
+		copyBackPtr += insertIndex * entrySize;
+		memcpy(copyBackPtr, attribute, ixIndexHeader.attrLength);
+		copyBackPtr += ixIndexHeader.attrLength;
+		memcpy(copyBackPtr, &rid.pageNum, sizeof(PageNum));
+		copyBackPtr += sizeof(PageNum);
+		memcpy(copyBackPtr, &rid.slotNum, sizeof(SlotNum));
+		copyBackPtr += sizeof(SlotNum);
+		ReadEntries(pData, insertIndex, numEntries - 1 - insertIndex, copyBackPtr);
+		return;
+	}
+
 	// Determine where to insert new entry
 	for (SlotNum readIndex = 0; readIndex <= ixIndexHeader.maxEntryIndex; ++readIndex){
 		if (GetSlotBitValue(pData, readIndex)){
@@ -813,8 +1359,33 @@ void IX_IndexHandle::MakeEntryCopyBack(char* pData, void* attribute, const RID &
 	}
 }
 
-void IX_IndexHandle::WriteLeafFromEntryCopyBack(char* pData, char* copyBack, int copyBackSize, int numEntries)
+// Copies count entries of a compact leaf out in the full layout
+void IX_IndexHandle::ReadEntries(char* pData, SlotNum first, int count, char* copyBack) const
 {
+	int entrySize = ixIndexHeader.attrLength + sizeof(PageNum) + sizeof(SlotNum);
+	if (!ixIndexHeader.compressed && !ixIndexHeader.separated){
+		memcpy(copyBack, GetEntryPtr(pData, first), count * entrySize);
+		return;
+	}
+	for (int i = 0; i < count; ++i)
+		GetEntry(pData, first + i, copyBack + i * entrySize);
+}
+
+// A compressed leaf is written under prefix, or its own prefix if
+// prefixLen is -1
+void IX_IndexHandle::WriteLeafFromEntryCopyBack(char* pData, char* copyBack, int copyBackSize, int numEntries, const char* prefix, int prefixLen)
+{
+	if (ixIndexHeader.compressed){
+		if (prefixLen < 0)
+			prefix = NodePrefix(pData, true, prefixLen);
+		Compress(pData, copyBack, numEntries, true, prefix, prefixLen);
+		return;
+	}
+	if (ixIndexHeader.separated){
+		WriteSeparated(pData, copyBack, numEntries, true);
+		return;
+	}
+
 	// TODO GINA HERE
 	int tmperInt;
 	memcpy(&tmperInt, pData, sizeof(int));
@@ -893,7 +1464,98 @@ RC IX_IndexHandle::SetSiblingPointers(PageNum L1Page, PageNum L2Page, char* L1,
 	return OK_RC;
 }
 
+// Points an emptied leaf's siblings at each other
+RC IX_IndexHandle::UnlinkLeaf(char* pData){
+	int leftOffset = sizeof(int) + sizeof(PageNum);
+	int rightOffset = leftOffset + sizeof(PageNum);
+
+	PageNum sibling[2];
+	memcpy(&sibling[0], pData + leftOffset, sizeof(PageNum));
+	memcpy(&sibling[1], pData + rightOffset, sizeof(PageNum));
+
+	// Left sibling's right becomes our right, right sibling's left our left
+	for (int i = 0; i < 2; ++i){
+		if (sibling[i] == IX_NO_PAGE)
+			continue;
+		char *siblingPData;
+		PF_PageHandle pfPageHandle = PF_PageHandle();
+		RC rc = pfFileHandle.GetThisPage(sibling[i], pfPageHandle);
+		if (rc != OK_RC){
+			PrintError(rc);
+			return rc;
+		}
+		rc = pfPageHandle.GetData(siblingPData);
+		if (rc != OK_RC){
+			pfFileHandle.UnpinPage(sibling[i]);
+			PrintError(rc);
+			return rc;
+		}
+		memcpy(siblingPData + (i == 0 ? rightOffset : leftOffset), &sibling[1 - i], sizeof(PageNum));
+
+		// Clean up
+		siblingPData = NULL;
+		rc = pfFileHandle.MarkDirty(sibling[i]);
+		if (rc != OK_RC){
+			pfFileHandle.UnpinPage(sibling[i]);
+			PrintError(rc);
+			return rc;
+		}
+		rc = pfFileHandle.UnpinPage(sibling[i]);
+		if (rc != OK_RC){
+			PrintError(rc);
+			return rc;
+		}
+	}
+
+	return OK_RC;
+}
+
+// Finds a compact leaf's entry for attribute
+bool IX_IndexHandle::FindKeyInLeaf(char* pData, int numEntries, void* attribute, SlotNum &keySlot) const
+{
+	if (!LeafIsCompact(pData, numEntries))
+		return false;
+	keySlot = SearchEntries(pData, numEntries, attribute, false);
+	char entry[MAXSTRINGLEN + sizeof(PageNum) + sizeof(SlotNum)];
+	return keySlot < numEntries && CompareKey(GetEntry(pData, keySlot, entry), attribute) == 0;
+}
+
+// Adds rid to a key's posting list, turning a single entry into a list
+RC IX_IndexHandle::AddToPostings(PageNum pageNum, char* pData, SlotNum keySlot, const RID &rid)
+{
+	char* ptr = GetEntryRid(pData, keySlot);
+	PageNum entryPage;
+	SlotNum entrySlot;
+	memcpy(&entryPage, ptr, sizeof(PageNum));
+	memcpy(&entrySlot, ptr + sizeof(PageNum), sizeof(SlotNum));
+
+	// Already a posting list; readers hold its head page while reading it
+	RC rc;
+	if (entrySlot == IX_POSTING_SLOT){
+		if (rc = LatchForWrite(entryPage))
+			return rc;
+		return InsertPosting(entryPage, rid);
+	}
+
+	PageNum headPage;
+	rc = CreatePostings(RID(entryPage, entrySlot), rid, headPage);
+	if (rc != OK_RC)
+		return rc;
+	entrySlot = IX_POSTING_SLOT;
+	memcpy(ptr, &headPage, sizeof(PageNum));
+	memcpy(ptr + sizeof(PageNum), &entrySlot, sizeof(SlotNum));
+
+	rc = pfFileHandle.MarkDirty(pageNum);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	return OK_RC;
+}
+
 bool IX_IndexHandle::ShouldBucket(void* attribute, char* pData){
+	if (ixIndexHeader.compressed)
+		return false;
 	char* first = GetEntryPtr(pData, 0);
 	char* last = GetEntryPtr(pData, ixIndexHeader.maxEntryIndex);
 	bool equal = AttributeEqualEntry(first, last);
@@ -902,7 +1564,8 @@ bool IX_IndexHandle::ShouldBucket(void* attribute, char* pData){
 	return AttributeEqualEntry((char*)attribute, first);
 }
 
-RC IX_IndexHandle::DeleteEntryHelper(PageNum currPage, int height, void* attribute, const RID &rid, PageNum &oldPage)
+RC IX_IndexHandle::DeleteEntryHelper(PageNum currPage, int height, void* attribute, const RID &rid, PageNum &oldPage,
+	const char* lowKey, const char* highKey)
 {
 	// Get page data
 	char *pData;
@@ -928,24 +1591,63 @@ RC IX_IndexHandle::DeleteEntryHelper(PageNum currPage, int height, void* attribu
 		SlotNum deleteKeyIndex;
 		ChooseSubtree(pData, attribute, nextPage, numKeys, deleteKeyIndex);
 
+		// The keys on either side of the child bound its keys
+		char childLowKey[MAXSTRINGLEN];
+		char childHighKey[MAXSTRINGLEN];
+		const char* childLow = lowKey;
+		const char* childHigh = highKey;
+		if (ixIndexHeader.compressed && deleteKeyIndex > 0){
+			GetKey(pData, deleteKeyIndex - 1, childLowKey);
+			childLow = childLowKey;
+		}
+		if (ixIndexHeader.compressed && deleteKeyIndex < numKeys){
+			GetKey(pData, deleteKeyIndex, childHighKey);
+			childHigh = childHighKey;
+		}
+
 		// Recursive delete
-		DeleteEntryHelper(nextPage, height-1, attribute, rid, oldPage);
+		DeleteEntryHelper(nextPage, height-1, attribute, rid, oldPage, childLow, childHigh);
 
-		// Usual case, child not deleted
+		// Usual case, child not deleted, though it may have been merged
+		// into a sibling
 		if (oldPage == IX_NO_PAGE){
-			rc = pfFileHandle.UnpinPage(currPage);
+			if ((rc = AddCounts(currPage, height, deleteKeyIndex, ridDelta, keyDelta)) == OK_RC)
+				rc = RebalanceChild(currPage, pData, height - 1, deleteKeyIndex, numKeys, lowKey, highKey);
 			if (rc != OK_RC){
-				PrintError(rc);
+				pfFileHandle.UnpinPage(currPage);
 				return rc;
 			}
-			return OK_RC;
+			if (numKeys != 0 || currPage != ixIndexHeader.rootPage){
+				rc = pfFileHandle.UnpinPage(currPage);
+				if (rc != OK_RC){
+					PrintError(rc);
+					return rc;
+				}
+				return OK_RC;
+			}
 		}
 		// We discarded child node
 		else{
+			// Node's only child discarded, delete node
+			if (numKeys == 0 && currPage != ixIndexHeader.rootPage){
+				rc = pfFileHandle.UnpinPage(currPage);
+				if (rc != OK_RC){
+					PrintError(rc);
+					return rc;
+				}
+				rc = DisposeNode(currPage);
+				if (rc != OK_RC)
+					return rc;
+
+				oldPage = currPage;
+				return OK_RC;
+			}
+
 			InternalDelete(pData, deleteKeyIndex, numKeys);
+			StaleCounts(currPage, height);
 
-			// Node not empty, usual case
-			if (numKeys != 0){
+			// Node still has children, usual case
+			if (numKeys != 0 || currPage != ixIndexHeader.rootPage){
 				// Mark page as dirty
 				rc = pfFileHandle.MarkDirty(currPage);
 				if (rc != OK_RC){
@@ -965,30 +1667,24 @@ RC IX_IndexHandle::DeleteEntryHelper(PageNum currPage, int height, void* attribu
 				}
 				return OK_RC;
 			}
-			// Delete node
-			else {
-				// If deleting root
-				if (currPage == ixIndexHeader.rootPage){
-					// Set root to last existing page pointer
-					modified = true;
-					memcpy(&ixIndexHeader.rootPage, pData + ixIndexHeader.internalHeaderSize, sizeof(PageNum));
-				}
+		}
 
-				rc = pfFileHandle.UnpinPage(currPage);
-				if (rc != OK_RC){
-					PrintError(rc);
-					return rc;
-				}
-				rc = pfFileHandle.DisposePage(currPage);
-				if (rc != OK_RC){
-					PrintError(rc);
-					return rc;
-				}
+		// Root left with one child, which becomes the root
+		modified = true;
+		ixIndexHeader.rootPage = GetChildPage(pData, 0);
+		ixIndexHeader.height -= 1;
 
-				oldPage = currPage;
-				return OK_RC;
-			}
+		rc = pfFileHandle.UnpinPage(currPage);
+		if (rc != OK_RC){
+			PrintError(rc);
+			return rc;
 		}
+		rc = DisposeNode(currPage);
+		if (rc != OK_RC)
+			return rc;
+
+		oldPage = IX_NO_PAGE;
+		return OK_RC;
 	}
 	// Leaf node
 	else {
@@ -1001,8 +1697,10 @@ RC IX_IndexHandle::DeleteEntryHelper(PageNum currPage, int height, void* attribu
 			return rc;
 		}
 
-		// If leaf not empty or is root page
-		if (numEntries != 0 || currPage == ixIndexHeader.rootPage){
+		// If leaf not empty or is root page.  An emptied compressed leaf
+		// stays, as its neighbours' prefixes rely on the keys bounding it;
+		// its parent merges it into a sibling instead
+		if (numEntries != 0 || currPage == ixIndexHeader.rootPage || ixIndexHeader.compressed){
 			// Mark page as dirty
 			rc = pfFileHandle.MarkDirty(currPage);
 			if (rc != OK_RC){
@@ -1020,11 +1718,16 @@ RC IX_IndexHandle::DeleteEntryHelper(PageNum currPage, int height, void* attribu
 				PrintError(rc);
 				return rc;
 			}
-			return OK_RC;
+			return AddCounts(currPage, height, -1, ridDelta, keyDelta);
 		}
 		// Leaf now empty
 		else {
-			// Delete page
+			// Take leaf out of the sibling list, then delete page
+			rc = UnlinkLeaf(pData);
+			if (rc != OK_RC){
+				pfFileHandle.UnpinPage(currPage);
+				return rc;
+			}
 			rc = pfFileHandle.UnpinPage(currPage);
 			if (rc != OK_RC){
 				PrintError(rc);
@@ -1045,10 +1748,16 @@ RC IX_IndexHandle::DeleteEntryHelper(PageNum currPage, int height, void* attribu
 // Does not mark page dirty
 void IX_IndexHandle::InternalDelete(char* pData, SlotNum deleteKeyIndex, int &numKeys)
 {
+	if (ixIndexHeader.separated){
+		RemoveSeparated(pData, false, numKeys, deleteKeyIndex == numKeys ? numKeys - 1 : deleteKeyIndex, deleteKeyIndex);
+		numKeys -= 1;
+		return;
+	}
+
 	// Move pointer to page pointer before key
 	int keySize = ixIndexHeader.attrLength + sizeof(PageNum);
-	int totalSize =  sizeof(PageNum) + numKeys * keySize;
-	int skipOffset = sizeof(PageNum) + deleteKeyIndex * keySize - sizeof(PageNum);
+	int totalSize = ixIndexHeader.internalHeaderSize + sizeof(PageNum) + numKeys * keySize;
+	int skipOffset = ixIndexHeader.internalHeaderSize + deleteKeyIndex * keySize;
 
 	// If deleted last page pointer
 	if (deleteKeyIndex == numKeys){
@@ -1062,7 +1771,7 @@ void IX_IndexHandle::InternalDelete(char* pData, SlotNum deleteKeyIndex, int &nu
 
 	int difference = skipOffset + keySize;
 	int size = totalSize - difference;
-	memcpy(destPtr, srcPtr, size);
+	memmove(destPtr, srcPtr, size);
 
 	// Update numKeys in header
 	numKeys -= 1;
@@ -1081,10 +1790,38 @@ RC IX_IndexHandle::LeafDelete(PageNum currPage, char* pData, void* attribute, co
 	int attrLength = ixIndexHeader.attrLength;
 	RC rc;
 
+	// Compact leaf, binary search for the first entry >= attribute
+	memcpy(&numEntries, pData, sizeof(int));
+	bool compact = LeafIsCompact(pData, numEntries);
 	bool found = false;
+	char entry[MAXSTRINGLEN + sizeof(PageNum) + sizeof(SlotNum)];
+	if (compact){
+		deleteSlot = SearchEntries(pData, numEntries, attribute, false);
+		if (deleteSlot >= numEntries){
+			PrintError(IX_ENTRYDNE);
+			return IX_ENTRYDNE;
+		}
+
+		// Key has a posting list, delete from it; the entry goes with the
+		// list's last rid
+		char* ptr = (char*)GetEntry(pData, deleteSlot, entry);
+		PageNum v_page;
+		memcpy(&v_page, ptr + attrLength, sizeof(PageNum));
+		SlotNum v_slot;
+		memcpy(&v_slot, ptr + attrLength + sizeof(PageNum), sizeof(SlotNum));
+		if (v_slot == IX_POSTING_SLOT && AttributeEqualEntry((char*)attribute, ptr)){
+			rc = DeletePosting(v_page, rid, found);
+			if (rc != OK_RC)
+				return rc;
+			ridDelta = -1;
+			if (!found)
+				return OK_RC;
+		}
+	}
+
 	while (!found){
 		if(GetSlotBitValue(pData, deleteSlot)){
-			char* ptr = GetEntryPtr(pData, deleteSlot);
+			char* ptr = (char*)GetEntry(pData, deleteSlot, entry);
 
 			PageNum v_page;
 			memcpy(&v_page, ptr + attrLength, sizeof(PageNum));
@@ -1097,21 +1834,42 @@ RC IX_IndexHandle::LeafDelete(PageNum currPage, char* pData, void* attribute, co
 		// If not found, increment slot
 		if (!found){
 			deleteSlot += 1;
-			// If past last slot, increment page
-			if (deleteSlot > ixIndexHeader.maxEntryIndex){
+			// If past last slot (or past attribute's entries), not found
+			if (deleteSlot > ixIndexHeader.maxEntryIndex ||
+				(compact && (deleteSlot >= numEntries ||
+				!AttributeEqualEntry((char*)attribute, (char*)GetEntry(pData, deleteSlot, entry))))){
 				PrintError(IX_ENTRYDNE);
 				return IX_ENTRYDNE;
 			}
 		}
 	}
 
-	// Found matching entry. Delete
-	SetSlotBitValue(pData, deleteSlot, false);
+	// Found matching entry. Delete, shifting later entries left to keep
+	// a compact leaf compact
+	if (ixIndexHeader.compressed){
+		int entrySize = attrLength + sizeof(PageNum) + sizeof(SlotNum);
+		char* copyBack = new char[numEntries * entrySize];
+		ReadEntries(pData, 0, deleteSlot, copyBack);
+		ReadEntries(pData, deleteSlot + 1, numEntries - 1 - deleteSlot, copyBack + deleteSlot * entrySize);
+		WriteLeafFromEntryCopyBack(pData, copyBack, (numEntries - 1) * entrySize, numEntries - 1);
+		delete [] copyBack;
+	}
+	else if (ixIndexHeader.separated)
+		RemoveSeparated(pData, true, numEntries, deleteSlot, deleteSlot);
+	else if (compact){
+		int entrySize = attrLength + sizeof(PageNum) + sizeof(SlotNum);
+		memmove(GetEntryPtr(pData, deleteSlot), GetEntryPtr(pData, deleteSlot + 1),
+			(numEntries - 1 - deleteSlot) * entrySize);
+		SetSlotBitValue(pData, numEntries - 1, false);
+	}
+	else
+		SetSlotBitValue(pData, deleteSlot, false);
 
 	// If delete in last bucket page, done.
-	memcpy(&numEntries, pData, sizeof(int));
 	numEntries -= 1;
 	memcpy(pData, &numEntries, sizeof(int));
+	ridDelta = -1;
+	keyDelta = -1;
 
 	// TODO GINA HERE
 	memcpy(&tmperInt, pData, sizeof(int));
@@ -1129,32 +1887,12 @@ RC IX_IndexHandle::LeafDelete(PageNum currPage, char* pData, void* attribute, co
 
 void IX_IndexHandle::ChooseSubtree(char* pData, void* attribute, PageNum &nextPage, int &numKeys, SlotNum &keyNum)
 {
-	char* ptr;
-
 	// Get number of keys
 	memcpy(&numKeys, pData, sizeof(int));
 
-	// Iterate through keys until find first key greater than attribute.
-	bool greaterThan = false;
-	for (keyNum = 0; keyNum < numKeys; ++keyNum){
-		ptr = GetKeyPtr(pData, keyNum);
-
-		// Check if greater than
-		greaterThan = AttrSatisfiesCondition(attribute, LT_OP, ptr, ixIndexHeader.attrType, ixIndexHeader.attrLength);
-		
-		// Found first greaterthan key, copy preceding page pointer
-		if (greaterThan){
-			ptr -= sizeof(PageNum);
-			memcpy(&nextPage, ptr, sizeof(PageNum));
-			break;
-		}
-	}
-
-	// Did not find a greaterThan key, copy last page pointer
-	if (!greaterThan){
-		ptr += ixIndexHeader.attrLength;
-		memcpy(&nextPage, ptr, sizeof(PageNum));
-	}
+	// Find first key greater than attribute, copy preceding page pointer
+	keyNum = UpperBoundKey(pData, numKeys, attribute);
+	nextPage = GetChildPage(pData, keyNum);
 }
 
 //RC IX_IndexHandle::GetLastPageInBucketChain(PageNum &currPage, char*& pData)
@@ -1207,6 +1945,21 @@ bool IX_IndexHandle::AttrSatisfiesCondition(void* one, CompOp compOp, void* two,
 	if (compOp == NO_OP)
 		return true;
 
+	// Composite keys, typed STRING in the header, compare bytewise
+	if (attrType == STRING && ixIndexHeader.numKeyAttrs > 0){
+		int cmp = memcmp(one, two, attrLength);
+		switch(compOp) {
+		case NO_OP: return true;
+		case EQ_OP: return cmp == 0;
+		case LT_OP: return cmp < 0;
+		case GT_OP: return cmp > 0;
+		case LE_OP: return cmp <= 0;
+		case GE_OP: return cmp >= 0;
+		case NE_OP: return cmp != 0;
+		}
+		return false;
+	}
+
 	// Covert attribute and value to correct type
 	int o_i, t_i;
 	float o_f, t_f;
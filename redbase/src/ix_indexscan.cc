@@ -5,19 +5,30 @@
 
 using namespace std;
 
-IX_IndexScan::IX_IndexScan(): ixIndexHandle(NULL), compOp(NO_OP), value(NULL), open(false), pageNum(-1), entryNum(-1), rightLeaf(-1), inBucket(false), finished(false), entrySize(0), lastEntry(NULL)
+IX_IndexScan::IX_IndexScan(): ixIndexHandle(NULL), lowValue(NULL), lowInclusive(false), highValue(NULL), highInclusive(false), reverse(false), open(false), pageNum(-1), entryNum(-1), rightLeaf(-1), chainLeaf(-1), inBucket(false), finished(false), entrySize(0), lastEntry(NULL), pageVersion(0), currEntry(NULL), postings(NULL), numPostings(0), nextPosting(0), hashSlot(0), bucketEntries(NULL), numBucketEntries(0), nextBucketEntry(0), bitmapValues(NULL), numBitmapValues(0), nextBitmapValue(0)
 {}
 IX_IndexScan::~IX_IndexScan()
 {
+	if (open && ixIndexHandle)
+		__sync_fetch_and_sub(&ixIndexHandle->openScans, 1);
 	delete [] lastEntry;
 	lastEntry = NULL;
+	delete [] currEntry;
+	currEntry = NULL;
+	delete [] postings;
+	postings = NULL;
+	delete [] bucketEntries;
+	bucketEntries = NULL;
+	delete [] bitmapValues;
+	bitmapValues = NULL;
 }
 
 // Open index scan
 RC IX_IndexScan::OpenScan(const IX_IndexHandle &indexHandle,
 						  CompOp compOp,
 						  void *value,
-						  ClientHint  pinHint)
+						  ClientHint  pinHint,
+						  bool reverse)
 {
 	// Check if filescan already open
 	if (open){
@@ -40,27 +51,124 @@ RC IX_IndexScan::OpenScan(const IX_IndexHandle &indexHandle,
 	}
 	// End check input parameters
 
+	// Each operator is a range with at most one side open
+	switch(compOp) {
+	case EQ_OP:
+		return OpenScan(indexHandle, value, true, value, true, pinHint, reverse);
+	case GE_OP:
+		return OpenScan(indexHandle, value, true, NULL, false, pinHint, reverse);
+	case GT_OP:
+		return OpenScan(indexHandle, value, false, NULL, false, pinHint, reverse);
+	case LE_OP:
+		return OpenScan(indexHandle, NULL, false, value, true, pinHint, reverse);
+	case LT_OP:
+		return OpenScan(indexHandle, NULL, false, value, false, pinHint, reverse);
+	default:
+		return OpenScan(indexHandle, NULL, false, NULL, false, pinHint, reverse);
+	}
+}
+
+// Open index range scan; a NULL bound leaves that side open
+RC IX_IndexScan::OpenScan(const IX_IndexHandle &indexHandle,
+						  void *lowValue, bool lowInclusive,
+						  void *highValue, bool highInclusive,
+						  ClientHint  pinHint,
+						  bool reverse)
+{
+	// Check if filescan already open
+	if (open){
+		PrintError(IX_FILESCANREOPEN);
+		return IX_FILESCANREOPEN;
+	}
+
 	// Copy over scan params
 	ixIndexHandle = &indexHandle;
-	this->compOp = compOp;
-	this->value = value;
+	this->lowValue = lowValue;
+	this->lowInclusive = lowInclusive;
+	this->highValue = highValue;
+	this->highInclusive = highInclusive;
+	this->reverse = reverse;
+
+	// Scans hold the index latch shared during each call, so writers
+	// that exclude readers wait for them between calls
+	RC rc = ixIndexHandle->LatchIndex(PF_SHARED);
+	if (rc != OK_RC)
+		return rc;
+	rc = StartScan();
+	RC latchRC = ixIndexHandle->UnlatchIndex(PF_SHARED);
+	return (rc != OK_RC) ? rc : latchRC;
+}
 
-	// Set state
+RC IX_IndexScan::StartScan()
+{
+	// An equality scan on a key the Bloom filter rules out opens finished
 	RC rc;
-	if (compOp == NO_OP || compOp == LT_OP || compOp == LE_OP)
+	if (lowValue && highValue && lowInclusive && highInclusive &&
+		ixIndexHandle->CompareKey((char*)lowValue, highValue) == 0){
+		bool mayContain;
+		if (rc = ixIndexHandle->BloomProbe(lowValue, mayContain))
+			return rc;
+		if (!mayContain){
+			open = true;
+			__sync_fetch_and_add(&ixIndexHandle->openScans, 1);
+			finished = true;
+			numPostings = 0;
+			nextPosting = 0;
+			entrySize = ixIndexHandle->ixIndexHeader.attrLength + sizeof(PageNum) + sizeof(SlotNum);
+			lastEntry = new char[entrySize];
+			currEntry = new char[entrySize];
+			return OK_RC;
+		}
+	}
+
+	if (ixIndexHandle->ixIndexHeader.indexType == HASH_INDEX)
+		return OpenHashScan();
+	if (ixIndexHandle->ixIndexHeader.indexType == BITMAP_INDEX)
+		return OpenBitmapScan();
+
+	// Set state, starting at the leaf that would hold the first bound in
+	// scan order; a reverse scan starts at the end of its bucket chain
+	void* startValue = reverse ? highValue : lowValue;
+	if (startValue)
+		rc = FindLeafNode(startValue, pageNum);
+	else if (reverse)
+		rc = FindMaxLeafNode(pageNum);
+	else
 		rc = FindMinLeafNode(pageNum);
-	else //(compOp == EQ_OP || compOp == GE_OP || compOp == GT_OP)
-		rc = FindLeafNode(value, pageNum);
 	if (rc != OK_RC)
 		return rc;
 
+	// The descent may have read nodes from before a split moved the
+	// bound's entries right; a forward scan walks right onto them anyway
+	if (reverse){
+		char* pData;
+		if ((rc = ixIndexHandle->LatchShared(pageNum, pData)) ||
+			(rc = ixIndexHandle->MoveRight(pageNum, pData, startValue)) ||
+			(rc = ixIndexHandle->ReleaseShared(pageNum)))
+			return rc;
+	}
+	chainLeaf = pageNum;
+	if (reverse && (rc = GetLastPageInChain(chainLeaf, pageNum)))
+		return rc;
+
 	open = true;
-	entryNum = -1;
+	__sync_fetch_and_add(&ixIndexHandle->openScans, 1);
+	entryNum = reverse ? ixIndexHandle->ixIndexHeader.maxEntryIndex + 1 : -1;
 	rightLeaf = IX_NO_PAGE;
 	inBucket = false;
 	finished = false;
+	numPostings = 0;
+	nextPosting = 0;
+	pageVersion = 0;
 	entrySize = ixIndexHandle->ixIndexHeader.attrLength + sizeof(PageNum) + sizeof(SlotNum);
 	lastEntry = new char[entrySize];
+	currEntry = new char[entrySize];
+
+	// Start at the first candidate entry of the leaf
+	if (startValue || reverse){
+		if (rc = PositionInLeaf())
+			return rc;
+	}
 
 	return OK_RC;
 }
@@ -68,304 +176,232 @@ RC IX_IndexScan::OpenScan(const IX_IndexHandle &indexHandle,
 // Get the next matching entry return IX_EOF if no more matching entries.
 RC IX_IndexScan::GetNextEntry(RID &rid)
 {
-	// Check if scan finished
-	if (finished){
+	int numRids;
+	return GetNextEntries(&rid, 1, numRids);
+}
+
+// Get up to maxRids matching entries, holding each leaf pinned while its
+// entries are read; return IX_EOF if there were none left
+RC IX_IndexScan::GetNextEntries(RID *rids, int maxRids, int &numRids)
+{
+	numRids = 0;
+	if (!rids || maxRids < 1){
+		PrintError(IX_NULLINPUT);
+		return IX_NULLINPUT;
+	}
+
+	// Check if scan finished, but for the rest of its last posting list
+	if (finished && nextPosting >= numPostings){
 		//PrintError(IX_EOF);
 		return IX_EOF;
 	}
 
+	RC rc = ixIndexHandle->LatchIndex(PF_SHARED);
+	if (rc != OK_RC)
+		return rc;
+	rc = ScanEntries(rids, maxRids, numRids);
+	RC latchRC = ixIndexHandle->UnlatchIndex(PF_SHARED);
+	return (rc != OK_RC) ? rc : latchRC;
+}
+
+RC IX_IndexScan::ScanEntries(RID *rids, int maxRids, int &numRids)
+{
+	RC rc;
+	IndexType indexType = ixIndexHandle->ixIndexHeader.indexType;
+	if (indexType != BTREE_INDEX){
+		while (numRids < maxRids && (rc = (indexType == HASH_INDEX) ?
+			GetNextHashEntry(rids[numRids]) : GetNextBitmapEntry(rids[numRids])) == OK_RC)
+			++numRids;
+		if (rc != OK_RC && rc != IX_EOF)
+			return rc;
+		return (numRids > 0) ? OK_RC : IX_EOF;
+	}
+
+	// Rest of the last entry's posting list, read when the scan reached it
+	while (numRids < maxRids && nextPosting < numPostings)
+		rids[numRids++] = postings[nextPosting++];
+	if (numRids == maxRids || finished)
+		return OK_RC;
+
 	// CHANGES TO ACCOMODATE DELETES DURING INDEXSCAN
-	// Initialize page handle and page data
-	//rc = GetPage(ixIndexHandle->pfFileHandle, pageNum, pData);
 	char* pData;
-	PF_PageHandle pfPageHandle = PF_PageHandle();
-	RC rc = ixIndexHandle->pfFileHandle.GetThisPage(pageNum, pfPageHandle);
-	if (rc != OK_RC){
-		PrintError(rc);
+	if (rc = PinPage(pageNum, pData))
 		return rc;
-	}
 
-	rc = pfPageHandle.GetData(pData);
-	if (rc != OK_RC){
-		ixIndexHandle->pfFileHandle.UnpinPage(pageNum);
+	// Determine whether to increment entry iterator.  A page whose version
+	// is unchanged still holds the last returned entry at entryNum.  Else
+	// deletes may have emptied slots, or in a compact leaf shifted the
+	// entries after them down; keys are unique in a leaf, so the scan
+	// resumes at the first key past the last one returned.  A reverse scan
+	// always moves on, since deletes only shift entries it has passed
+	bool increment = false;
+	int version, numEntries;
+	if ((rc = ixIndexHandle->pfFileHandle.GetPageVersion(pageNum, version))){
+		ixIndexHandle->ReleaseShared(pageNum);
 		PrintError(rc);
 		return rc;
 	}
+	memcpy(&numEntries, pData, sizeof(int));
 
-	PageNum prevPage = pageNum;
-
-	// Determine whether to increment entry iterator
-	bool increment = false;
-	// Entry now empty
-	if (entryNum == -1 || !ixIndexHandle->GetSlotBitValue(pData, entryNum))
+	// An insert may also have split the page, moving entries already
+	// returned onto the leaves right of it; keys come in increasing order,
+	// so those up to the last one returned are passed over
+	bool resumed = !reverse && entryNum != -1 && version != pageVersion;
+	if (reverse || entryNum == -1 || version == pageVersion)
 		increment = true;
-	// Entry still filled
-	else {
-		// Read previous entry
-		char* charArrTmp = new char[entrySize];
-		memcpy(charArrTmp, ixIndexHandle->GetEntryPtr(pData, entryNum), entrySize);
-
-		// If previous entry is unchanged, need to increment entry iterator
-		if (memcmp(charArrTmp, lastEntry, entrySize) == 0)
-			increment = true;
-
-		delete [] charArrTmp;
-	}
-	if (increment){
-		// Increment entry
-		entryNum += 1;
-		// If entry now out of range
-		if (entryNum > ixIndexHandle->ixIndexHeader.maxEntryIndex){
-			entryNum = 0;
-			// Find next page
-			rc = GetNextPage(prevPage, pageNum);
-			if (rc != OK_RC){
-				ixIndexHandle->pfFileHandle.UnpinPage(prevPage);
-				return rc;
-			}			
-		}
-	}
-	// End determine whether to increment entry iterator
-
-	// If switched to new page, clean up and update pData
-	if (prevPage != pageNum){
-		// Unpin last page
-		rc = ixIndexHandle->pfFileHandle.UnpinPage(prevPage);
-		if (rc != OK_RC){
-			PrintError(rc);
-			return rc;
-		}
-		pData = NULL;
-
-		// If more entries to read...
-		if (pageNum != IX_NO_PAGE){
-			// Get new page data
-			//rc = GetPage(ixIndexHandle->pfFileHandle, pageNum, pData);
-			PF_PageHandle pfPageHandle = PF_PageHandle();
-			RC rc = ixIndexHandle->pfFileHandle.GetThisPage(pageNum, pfPageHandle);
-			if (rc != OK_RC){
-				PrintError(rc);
-				return rc;
-			}
-			rc = pfPageHandle.GetData(pData);
-			if (rc != OK_RC){
-				ixIndexHandle->pfFileHandle.UnpinPage(pageNum);
-				PrintError(rc);
-				return rc;
-			}
-		}
-		// No more entries to read, EOF
-		else {
-			finished = true;
-			//PrintError(IX_EOF);
-			return IX_EOF;
-		}
-	}
+	else if (ixIndexHandle->LeafIsCompact(pData, numEntries))
+		entryNum = ixIndexHandle->SearchEntries(pData, numEntries, lastEntry, true);
+	else if (!ixIndexHandle->GetSlotBitValue(pData, entryNum))
+		increment = true;
+	else
+		increment = (memcmp(ixIndexHandle->GetEntry(pData, entryNum, currEntry), lastEntry, entrySize) == 0);
+	if (increment && (rc = Advance(pData)))
+		return rc;
 	// END CHANGES TO ACCOMODATE DELETES DURING INDEXSCAN
-	//cerr << "scan: A" << endl;
-	// Iterate through pages and entries until find one that satisfies condition (or EOF)
-	bool found = false;
-	while (!found && !finished){
+
+	// Iterate through pages and entries, collecting those that satisfy the
+	// range, until the batch is full or the scan finishes
+	while (pData && !finished){
 		// If record exists in slot
+		bool found = false, last = false;
 		if (ixIndexHandle->GetSlotBitValue(pData, entryNum)){
-			// If no condition, found
-			if (compOp == NO_OP){
-				found = true;
-				break;
+			// Entries are in key order: skip those before the first bound in
+			// scan order, stop at the first past the other one
+			const char* ptr = ixIndexHandle->GetEntry(pData, entryNum, currEntry);
+			bool belowLow = false, aboveHigh = false;
+			if (lowValue){
+				int cmp = ixIndexHandle->CompareKey(ptr, lowValue);
+				belowLow = lowInclusive ? (cmp < 0) : (cmp <= 0);
 			}
-
-			// Read in attribute, covert attribute and value to correct type
-			char* ptr = ixIndexHandle->GetEntryPtr(pData, entryNum);
-			AttrType attrType = ixIndexHandle->ixIndexHeader.attrType;
-			int attrLength = ixIndexHandle->ixIndexHeader.attrLength;
-
-			int a_i, v_i;
-			float a_f, v_f;
-			string a_s, v_s;
-			switch(attrType) {
-			case INT:
-				memcpy(&a_i, ptr, attrLength);
-				memcpy(&v_i, value, attrLength);
-                break;
-			case FLOAT:
-				memcpy(&a_f, ptr, attrLength);
-				memcpy(&v_f, value, attrLength);
-                break;
-			case STRING:
-				char* tmp = new char[attrLength];
-				memcpy(tmp, ptr, attrLength);
-				a_s = string(tmp);
-				v_s = string((char*)value);
-				delete [] tmp;
-                break;
-			}
-
-			// Check if record fulfills condition
-			switch(compOp) {
-			case EQ_OP:
-				switch(attrType) {
-				case INT:
-					found = (a_i == v_i);
-					finished = (a_i > v_i);
-                    break;
-				case FLOAT:
-					found = (a_f == v_f);
-					finished = (a_f > v_f);
-                    break;
-				case STRING:
-					found = (a_s == v_s);
-					finished = (a_s > v_s);
-                    break;
-				}
-                break;
-			case LT_OP:
-				switch(attrType) {
-				case INT:
-					found = (a_i < v_i);
-					finished = (a_i >= v_i);
-                    break;
-				case FLOAT:
-					found = (a_f < v_f);
-					finished = (a_f >= v_f);
-                    break;
-				case STRING:
-					found = (a_s < v_s);
-					finished = (a_s >= v_s);
-                    break;
-				}
-                break;
-			case GT_OP:
-				switch(attrType) {
-				case INT:
-					found = (a_i > v_i);
-                    break;
-				case FLOAT:
-					found = (a_f > v_f);
-                    break;
-				case STRING:
-					found = (a_s > v_s);
-                    break;
-				}
-                break;
-			case LE_OP:
-				switch(attrType) {
-				case INT:
-					found = (a_i <= v_i);
-					finished = (a_i > v_i);
-                    break;
-				case FLOAT:
-					found = (a_f <= v_f);
-					finished = (a_f > v_f);
-                    break;
-				case STRING:
-					found = (a_s <= v_s);
-					finished = (a_s > v_s);
-                    break;
-				}
-                break;
-			case GE_OP:
-				switch(attrType) {
-				case INT:
-					found = (a_i >= v_i);
-                    break;
-				case FLOAT:
-					found = (a_f >= v_f);
-                    break;
-				case STRING:
-					found = (a_s >= v_s);
-                    break;
-				}
-                break;
+			if (highValue){
+				int cmp = ixIndexHandle->CompareKey(ptr, highValue);
+				aboveHigh = highInclusive ? (cmp > 0) : (cmp >= 0);
 			}
+			finished = reverse ? belowLow : aboveHigh;
+			found = !belowLow && !aboveHigh && !(resumed && ixIndexHandle->CompareKey(ptr, lastEntry) <= 0);
+
+			// Keys are unique outside bucket chains, so a leaf's entry equal
+			// to an inclusive upper bound is the last in range, and an
+			// equality scan need not read the next leaf to find its end
+			PageNum bucket;
+			memcpy(&bucket, pData + sizeof(int), sizeof(PageNum));
+			last = found && !reverse && highValue && highInclusive && !inBucket && bucket == IX_NO_PAGE &&
+				ixIndexHandle->CompareKey(ptr, highValue) == 0;
 		}
-
-		// Check if entry satisfied condition OR scan finished, break out of loop
-		if (found || finished){
+		if (finished)
 			break;
-        }
-		//cerr << "scan: B" << endl;
-		// Entry not found and scan not finished
-		// Increment entry num
-		prevPage = pageNum;
-		entryNum += 1;
-		if (entryNum > ixIndexHandle->ixIndexHeader.maxEntryIndex){
-			rc = GetNextPage(prevPage, pageNum);
-			if (rc != OK_RC){
-				ixIndexHandle->pfFileHandle.UnpinPage(prevPage);
-				return rc;
-			}
-			entryNum = 0;
-		}
-		//cerr << "scan: C" << endl;
-		// If switched to new page...clean up and update pData
-		if (prevPage != pageNum){
-			// Unpin last page
-			rc = ixIndexHandle->pfFileHandle.UnpinPage(prevPage);
-			if (rc != OK_RC){
-				PrintError(rc);
-				return rc;
-			}
-			pData = NULL;
-			//cerr << "scan: C" << endl;
-			// If more entries to read...
-			if (pageNum != IX_NO_PAGE){
-				// Get new page handle and page data
-				//rc = GetPage(ixIndexHandle->pfFileHandle, pageNum, pData);
-				PF_PageHandle pfPageHandle = PF_PageHandle();
-				RC rc = ixIndexHandle->pfFileHandle.GetThisPage(pageNum, pfPageHandle);
+
+		if (found){
+			// Matching entry was found, copy matching info to rid
+			RID &rid = rids[numRids];
+			char* ptr = ixIndexHandle->GetEntryRid(pData, entryNum);
+			memcpy(&rid.pageNum, ptr, sizeof(PageNum));
+			ptr += sizeof(PageNum);
+			memcpy(&rid.slotNum, ptr, sizeof(SlotNum));
+			++numRids;
+
+			// A posting list is read whole, so deletes while scanning it can't
+			// move the scan; returned in rid order (reversed for reverse scans)
+			if (rid.slotNum == IX_POSTING_SLOT){
+				delete [] postings;
+				postings = NULL;
+				rc = ixIndexHandle->ReadPostings(rid.pageNum, postings, numPostings);
 				if (rc != OK_RC){
-					PrintError(rc);
+					ixIndexHandle->ReleaseShared(pageNum);
 					return rc;
 				}
-				rc = pfPageHandle.GetData(pData);
-				if (rc != OK_RC){
-					ixIndexHandle->pfFileHandle.UnpinPage(pageNum);
+				if (reverse)
+					for (int i = 0; i < numPostings / 2; ++i){
+						RID tmp = postings[i];
+						postings[i] = postings[numPostings - 1 - i];
+						postings[numPostings - 1 - i] = tmp;
+					}
+				nextPosting = 0;
+				--numRids;
+				while (numRids < maxRids && nextPosting < numPostings)
+					rids[numRids++] = postings[nextPosting++];
+			}
+
+			// Stop on the entry last returned, noting the page version
+			finished = last;
+			if (numRids == maxRids){
+				memcpy(lastEntry, ixIndexHandle->GetEntry(pData, entryNum, currEntry), entrySize);
+				if ((rc = ixIndexHandle->pfFileHandle.GetPageVersion(pageNum, pageVersion))){
+					ixIndexHandle->ReleaseShared(pageNum);
 					PrintError(rc);
 					return rc;
 				}
+				return ixIndexHandle->ReleaseShared(pageNum);
 			}
-			// No more entries to read
-			else
-				finished = true;
-			//cerr << "scan: D" << endl;
+			if (finished)
+				break;
 		}
+
+		// Slots past a compact leaf's entries are empty, skip them
+		memcpy(&numEntries, pData, sizeof(int));
+		if (entryNum >= numEntries && ixIndexHandle->LeafIsCompact(pData, numEntries))
+			entryNum = reverse ? numEntries : ixIndexHandle->ixIndexHeader.maxEntryIndex;
+		if (rc = Advance(pData))
+			return rc;
 	}
-	
-	// After loop
-	// Scan finished, EOF
-	if (finished){
-		//if (prevPage == pageNum){
-		//cerr << "scan: E" << endl;
-		if (pageNum != IX_NO_PAGE){
-			rc = ixIndexHandle->pfFileHandle.UnpinPage(pageNum);
-			if (rc != OK_RC){
-				PrintError(rc);
-				return rc;
-			}
-		}
+
+	// Scan finished, EOF once the entries collected have been returned
+	finished = true;
+	if (pData && (rc = ixIndexHandle->ReleaseShared(pageNum)))
+		return rc;
+	if (numRids == 0){
 		//PrintError(IX_EOF);
 		return IX_EOF;
 	}
+	return OK_RC;
+}
 
-	// Matching entry was found, copy matching info to rid
-	char* ptr = ixIndexHandle->GetEntryPtr(pData, entryNum);
-	ptr += ixIndexHandle->ixIndexHeader.attrLength;
-	memcpy(&rid.pageNum, ptr, sizeof(PageNum));
-	ptr += sizeof(PageNum);
-	memcpy(&rid.slotNum, ptr, sizeof(SlotNum));
-
-	// Set lastEntry
-	memcpy(lastEntry, ixIndexHandle->GetEntryPtr(pData, entryNum), entrySize);
-	//cerr << "scan: F" << endl;
-	// Clean up.
-	pData = NULL;
-	ptr = NULL;
-	rc = ixIndexHandle->pfFileHandle.UnpinPage(pageNum);
+// Pins and latches a leaf or bucket page
+RC IX_IndexScan::PinPage(PageNum page, char* &pData) const
+{
+	return ixIndexHandle->LatchShared(page, pData);
+}
+
+// Steps one slot in scan order, moving the pin when the step leaves the
+// page; pData is NULL past the end of the index.  Latches are only waited
+// on leftwards, so a reverse scan latches the next page before letting go
+// of the last, and a forward scan after
+RC IX_IndexScan::Advance(char* &pData)
+{
+	PageNum prevPage = pageNum;
+	RC rc = StepEntry(prevPage);
 	if (rc != OK_RC){
-		PrintError(rc);
+		ixIndexHandle->ReleaseShared(prevPage);
 		return rc;
 	}
+	if (prevPage == pageNum)
+		return OK_RC;
 
+	char* nextData = NULL;
+	if (reverse && pageNum != IX_NO_PAGE && (rc = PinPage(pageNum, nextData))){
+		ixIndexHandle->ReleaseShared(prevPage);
+		return rc;
+	}
+	if (rc = ixIndexHandle->ReleaseShared(prevPage))
+		return rc;
+	pData = nextData;
+	if (reverse || pageNum == IX_NO_PAGE)
+		return OK_RC;
+	return PinPage(pageNum, pData);
+}
+
+// Get the next matching entry and its key; a posting list's rids all
+// return the key of the entry that held the list
+RC IX_IndexScan::GetNextEntry(RID &rid, void *key)
+{
+	if (!key){
+		PrintError(IX_NULLINPUT);
+		return IX_NULLINPUT;
+	}
+	RC rc = GetNextEntry(rid);
+	if (rc != OK_RC)
+		return rc;
+	memcpy(key, lastEntry, ixIndexHandle->ixIndexHeader.attrLength);
 	return OK_RC;
 }
 
@@ -378,23 +414,43 @@ RC IX_IndexScan::CloseScan()
 	}
 
 	// Set state
+	if (open)
+		__sync_fetch_and_sub(&ixIndexHandle->openScans, 1);
 	ixIndexHandle = NULL;
 	open = false;
 	delete [] lastEntry;
 	lastEntry = NULL;
+	delete [] currEntry;
+	currEntry = NULL;
+	delete [] postings;
+	postings = NULL;
+	numPostings = 0;
+	nextPosting = 0;
+	delete [] bucketEntries;
+	bucketEntries = NULL;
+	numBucketEntries = 0;
+	nextBucketEntry = 0;
+	delete [] bitmapValues;
+	bitmapValues = NULL;
+	numBitmapValues = 0;
+	nextBitmapValue = 0;
 
 	return OK_RC;
 }
 
 RC IX_IndexScan::FindLeafNode(void* attribute, PageNum &resultPage) const
 {
-	return FindLeafNodeHelper(ixIndexHandle->ixIndexHeader.rootPage, ixIndexHandle->ixIndexHeader.height, false, attribute, resultPage);
+	return FindLeafNodeHelper(ixIndexHandle->ixIndexHeader.rootPage, ixIndexHandle->ixIndexHeader.height, false, false, attribute, resultPage);
 }
 RC IX_IndexScan::FindMinLeafNode(PageNum &resultPage) const
 {
-	return FindLeafNodeHelper(ixIndexHandle->ixIndexHeader.rootPage, ixIndexHandle->ixIndexHeader.height, true, NULL, resultPage);
+	return FindLeafNodeHelper(ixIndexHandle->ixIndexHeader.rootPage, ixIndexHandle->ixIndexHeader.height, true, false, NULL, resultPage);
+}
+RC IX_IndexScan::FindMaxLeafNode(PageNum &resultPage) const
+{
+	return FindLeafNodeHelper(ixIndexHandle->ixIndexHeader.rootPage, ixIndexHandle->ixIndexHeader.height, false, true, NULL, resultPage);
 }
-RC IX_IndexScan::FindLeafNodeHelper(PageNum currPage, int currHeight, bool findMin, void* attribute, PageNum &resultPage) const
+RC IX_IndexScan::FindLeafNodeHelper(PageNum currPage, int currHeight, bool findMin, bool findMax, void* attribute, PageNum &resultPage) const
 {
 	// At leaf page, done.
 	if (currHeight == 0){
@@ -402,73 +458,87 @@ RC IX_IndexScan::FindLeafNodeHelper(PageNum currPage, int currHeight, bool findM
 		return OK_RC;
 	}
 
-	// At internal page
-	// Get page handle
-	char *pData;
-	//RC rc = GetPage(ixIndexHandle->pfFileHandle, currPage, pData);
-	PF_PageHandle pfPageHandle = PF_PageHandle();
-	RC rc = ixIndexHandle->pfFileHandle.GetThisPage(currPage, pfPageHandle);
-	if (rc != OK_RC){
-		PrintError(rc);
-		return rc;
-	}
-	rc = pfPageHandle.GetData(pData);
-	if (rc != OK_RC){
-		ixIndexHandle->pfFileHandle.UnpinPage(currPage);
-		PrintError(rc);
+	// At internal page, read from a copy
+	char pData[PF_PAGE_SIZE];
+	RC rc = ixIndexHandle->ReadNode(currPage, pData);
+	if (rc != OK_RC)
 		return rc;
-	}
 
-	char* ptr;
 	PageNum nextPage;
 
 	// Finding min leaf page
 	if (findMin){
 		// Choose left-most page pointer
-		ptr = pData + ixIndexHandle->ixIndexHeader.internalHeaderSize;
-		memcpy(&nextPage, ptr, sizeof(PageNum));
+		nextPage = ixIndexHandle->GetChildPage(pData, 0);
 	}
-	// Not finding min leaf page
+	// Finding max leaf page
+	else if (findMax){
+		// Choose right-most page pointer
+		int numKeys;
+		memcpy(&numKeys, pData, sizeof(int));
+		nextPage = ixIndexHandle->GetChildPage(pData, numKeys);
+	}
+	// Not finding min or max leaf page
 	else {
 		// Get number of keys
 		int numKeys;
 		memcpy(&numKeys, pData, sizeof(int));
 
-		// Iterate through keys until find first key greater than attribute.
-		bool greaterThan = false;
-		for (SlotNum keyNum = 0; keyNum < numKeys; ++keyNum){
-			// Get key pointer
-			ptr = ixIndexHandle->GetKeyPtr(pData, keyNum);
+		// Find first key greater than attribute, copy preceding page pointer
+		SlotNum keyNum = ixIndexHandle->UpperBoundKey(pData, numKeys, attribute);
+		nextPage = ixIndexHandle->GetChildPage(pData, keyNum);
+	}
 
-			// Check if key is greater than attribute
-			greaterThan = ixIndexHandle->AttrSatisfiesCondition(attribute, LT_OP, ptr, ixIndexHandle->ixIndexHeader.attrType, ixIndexHandle->ixIndexHeader.attrLength);
+	// Recursive call to next index level
+	return FindLeafNodeHelper(nextPage, currHeight - 1, findMin, findMax, attribute, resultPage);
+}
 
-			// Found first greaterthan key, copy preceding page pointer
-			if (greaterThan){
-				ptr -= sizeof(PageNum);
-				memcpy(&nextPage, ptr, sizeof(PageNum));
-				break;
-			}
-		}
+// Binary searches a compact leaf for the first entry within the first
+// bound in scan order, leaving the scan just before it
+RC IX_IndexScan::PositionInLeaf()
+{
+	char* pData;
+	RC rc = ixIndexHandle->LatchShared(pageNum, pData);
+	if (rc != OK_RC)
+		return rc;
 
-		// Did not find a greaterThan key, copy last page pointer
-		if (!greaterThan){
-			ptr = ixIndexHandle->GetKeyPtr(pData, numKeys) - sizeof(PageNum);
-			memcpy(&nextPage, ptr, sizeof(PageNum));
+	int numEntries;
+	memcpy(&numEntries, pData, sizeof(int));
+	if (ixIndexHandle->LeafIsCompact(pData, numEntries) && reverse){
+		// Entries before the end are the candidates
+		entryNum = highValue ? ixIndexHandle->SearchEntries(pData, numEntries, highValue, highInclusive) : numEntries;
+	}
+	else if (ixIndexHandle->LeafIsCompact(pData, numEntries)){
+		int first = ixIndexHandle->SearchEntries(pData, numEntries, lowValue, !lowInclusive);
+		// GetNextEntry moves past entryNum while it still holds lastEntry
+		if (first > 0){
+			entryNum = first - 1;
+			memcpy(lastEntry, ixIndexHandle->GetEntry(pData, entryNum, currEntry), entrySize);
 		}
 	}
 
-	// Clean up
-	pData = NULL;
-	ptr = NULL;
-	rc =  ixIndexHandle->pfFileHandle.UnpinPage(currPage);
-	if (rc != OK_RC){
-		PrintError(rc);
-		return rc;
-	}
+	return ixIndexHandle->ReleaseShared(pageNum);
+}
 
-	// Recursive call to next index level
-	return FindLeafNodeHelper(nextPage, currHeight - 1, findMin, attribute, resultPage);
+RC IX_IndexScan::StepEntry(PageNum currPage)
+{
+	if (!reverse){
+		entryNum += 1;
+		// If entry now out of range, find next page
+		if (entryNum > ixIndexHandle->ixIndexHeader.maxEntryIndex){
+			entryNum = 0;
+			return GetNextPage(currPage, pageNum);
+		}
+	}
+	else {
+		entryNum -= 1;
+		// If entry now out of range, find previous page
+		if (entryNum < 0){
+			entryNum = ixIndexHandle->ixIndexHeader.maxEntryIndex;
+			return GetPrevPage(currPage, pageNum);
+		}
+	}
+	return OK_RC;
 }
 
 // Assumes at a leaf or bucket node
@@ -477,18 +547,9 @@ RC IX_IndexScan::GetNextPage(PageNum pageNum, PageNum &resultPage)
 	// Get page data
 	char *pData;
 	//RC rc = GetPage(ixIndexHandle->pfFileHandle, pageNum, pData);
-	PF_PageHandle pfPageHandle = PF_PageHandle();
-	RC rc = ixIndexHandle->pfFileHandle.GetThisPage(pageNum, pfPageHandle);
-	if (rc != OK_RC){
-		PrintError(rc);
-		return rc;
-	}
-	rc = pfPageHandle.GetData(pData);
-	if (rc != OK_RC){
-		ixIndexHandle->pfFileHandle.UnpinPage(pageNum);
-		PrintError(rc);
+	RC rc = ixIndexHandle->LatchShared(pageNum, pData);
+	if (rc != OK_RC)
 		return rc;
-	}
 
 	PageNum nextPage;
 
@@ -515,12 +576,68 @@ RC IX_IndexScan::GetNextPage(PageNum pageNum, PageNum &resultPage)
 	//// Clean up.
 	pData = NULL;
 	ptr = NULL;
-	rc = ixIndexHandle->pfFileHandle.UnpinPage(pageNum);
-	if (rc != OK_RC){
-		PrintError(rc);
+	if (rc = ixIndexHandle->ReleaseShared(pageNum))
 		return rc;
-	}
 
 	resultPage = nextPage;
 	return OK_RC;
 }
+
+// Assumes at a leaf or bucket node of chainLeaf's chain.  Buckets only link
+// forward, so the page before a bucket is found from the head of the chain;
+// before the head is the end of the left leaf's chain.
+RC IX_IndexScan::GetPrevPage(PageNum pageNum, PageNum &resultPage)
+{
+	RC rc;
+	if (pageNum != chainLeaf){
+		PageNum page = chainLeaf;
+		PageNum nextPage;
+		while (true){
+			if (rc = GetPageLink(page, sizeof(int), nextPage))
+				return rc;
+			if (nextPage == pageNum || nextPage == IX_NO_PAGE)
+				break;
+			page = nextPage;
+		}
+		resultPage = page;
+		return OK_RC;
+	}
+
+	PageNum leftLeaf;
+	if (rc = GetPageLink(chainLeaf, sizeof(int) + sizeof(PageNum), leftLeaf))
+		return rc;
+	if (leftLeaf == IX_NO_PAGE){
+		resultPage = IX_NO_PAGE;
+		return OK_RC;
+	}
+	chainLeaf = leftLeaf;
+	return GetLastPageInChain(chainLeaf, resultPage);
+}
+
+RC IX_IndexScan::GetLastPageInChain(PageNum leafPage, PageNum &resultPage) const
+{
+	RC rc;
+	PageNum nextPage;
+	resultPage = leafPage;
+	while (true){
+		if (rc = GetPageLink(resultPage, sizeof(int), nextPage))
+			return rc;
+		if (nextPage == IX_NO_PAGE)
+			return OK_RC;
+		resultPage = nextPage;
+	}
+}
+
+// Reads the page number stored at offset in a leaf or bucket header
+RC IX_IndexScan::GetPageLink(PageNum page, int offset, PageNum &link) const
+{
+	char *pData;
+	RC rc = ixIndexHandle->LatchShared(page, pData);
+	if (rc != OK_RC)
+		return rc;
+
+	memcpy(&link, pData + offset, sizeof(PageNum));
+
+	pData = NULL;
+	return ixIndexHandle->ReleaseShared(page);
+}
@@ -0,0 +1,232 @@
+#include <cstring>
+#include "ix.h"
+
+using namespace std;
+
+RC IX_IndexHandle::LatchIndex(PF_LatchMode mode) const
+{
+	RC rc = pfFileHandle.LatchPage(0, mode);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	return OK_RC;
+}
+
+RC IX_IndexHandle::UnlatchIndex(PF_LatchMode mode) const
+{
+	RC rc = pfFileHandle.UnlatchPage(0, mode);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	return OK_RC;
+}
+
+// Pages are latched before they are first changed and stay latched until
+// the insert is done, so readers never see a node half written.  Latches
+// are only waited on leftwards along a level, upwards between levels and
+// from a leaf to its posting lists, by inserts and readers alike, so the
+// two cannot deadlock
+RC IX_IndexHandle::LatchForWrite(PageNum pageNum)
+{
+	if (readersExcluded)
+		return OK_RC;
+	for (int i = 0; i < numWriteLatches; ++i)
+		if (writeLatches[i] == pageNum)
+			return OK_RC;
+	// InsertEntry excludes readers up front from trees too tall for this
+	if (numWriteLatches == IX_MAX_WRITE_LATCHES){
+		PrintError(IX_INVALIDNUM);
+		return IX_INVALIDNUM;
+	}
+
+	PF_PageHandle pfPageHandle;
+	RC rc = pfFileHandle.GetThisPage(pageNum, pfPageHandle);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	rc = pfFileHandle.LatchPage(pageNum, PF_EXCLUSIVE);
+	if (rc != OK_RC){
+		pfFileHandle.UnpinPage(pageNum);
+		PrintError(rc);
+		return rc;
+	}
+	writeLatches[numWriteLatches++] = pageNum;
+	return OK_RC;
+}
+
+RC IX_IndexHandle::ReleaseWriteLatches()
+{
+	while (numWriteLatches > 0){
+		PageNum pageNum = writeLatches[--numWriteLatches];
+		RC rc;
+		if ((rc = pfFileHandle.UnlatchPage(pageNum, PF_EXCLUSIVE)) ||
+			(rc = pfFileHandle.UnpinPage(pageNum))){
+			PrintError(rc);
+			return rc;
+		}
+	}
+	return OK_RC;
+}
+
+// The page latches go first: a reader holding the index latch may be
+// waiting on one of them
+RC IX_IndexHandle::ExcludeReaders()
+{
+	if (readersExcluded)
+		return OK_RC;
+	RC rc = ReleaseWriteLatches();
+	if (rc != OK_RC)
+		return rc;
+	rc = pfFileHandle.UpgradeLatch(0);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	readersExcluded = true;
+	return OK_RC;
+}
+
+// Optimistic read: the node is copied without a latch, and kept if its
+// version was the same before and after.  Only a node latched by an
+// insert is waited on, by latching it shared
+RC IX_IndexHandle::ReadNode(PageNum pageNum, char* node) const
+{
+	char* pData;
+	PF_PageHandle pfPageHandle;
+	RC rc = pfFileHandle.GetThisPage(pageNum, pfPageHandle);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	rc = pfPageHandle.GetData(pData);
+	if (rc != OK_RC){
+		pfFileHandle.UnpinPage(pageNum);
+		PrintError(rc);
+		return rc;
+	}
+
+	while (true){
+		int before, after;
+		if ((rc = pfFileHandle.GetPageVersion(pageNum, before)) == OK_RC){
+			memcpy(node, pData, PF_PAGE_SIZE);
+			rc = pfFileHandle.GetPageVersion(pageNum, after);
+			if (rc == OK_RC && before == after)
+				break;
+		}
+		if (rc == PF_PAGELATCHED){
+			if ((rc = pfFileHandle.LatchPage(pageNum, PF_SHARED)) == OK_RC){
+				memcpy(node, pData, PF_PAGE_SIZE);
+				rc = pfFileHandle.UnlatchPage(pageNum, PF_SHARED);
+			}
+			if (rc != OK_RC){
+				pfFileHandle.UnpinPage(pageNum);
+				PrintError(rc);
+				return rc;
+			}
+			break;
+		}
+		if (rc != OK_RC){
+			pfFileHandle.UnpinPage(pageNum);
+			PrintError(rc);
+			return rc;
+		}
+	}
+
+	rc = pfFileHandle.UnpinPage(pageNum);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	return OK_RC;
+}
+
+RC IX_IndexHandle::LatchShared(PageNum pageNum, char* &pData) const
+{
+	PF_PageHandle pfPageHandle;
+	RC rc = pfFileHandle.GetThisPage(pageNum, pfPageHandle);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	if ((rc = pfPageHandle.GetData(pData)) ||
+		(rc = pfFileHandle.LatchPage(pageNum, PF_SHARED))){
+		pfFileHandle.UnpinPage(pageNum);
+		PrintError(rc);
+		return rc;
+	}
+	return OK_RC;
+}
+
+RC IX_IndexHandle::ReleaseShared(PageNum pageNum) const
+{
+	RC rc;
+	if ((rc = pfFileHandle.UnlatchPage(pageNum, PF_SHARED)) ||
+		(rc = pfFileHandle.UnpinPage(pageNum))){
+		PrintError(rc);
+		return rc;
+	}
+	return OK_RC;
+}
+
+// A descent through nodes copied before a split reaches the leaf that
+// was split, whose upper keys have moved to the leaves right of it.  The
+// key's leaf is the last one whose first key is at most the key; with no
+// key, the last leaf.  Each leaf is let go before the next is latched.
+// Holds no latch on an error
+RC IX_IndexHandle::MoveRight(PageNum &pageNum, char* &pData, void* attribute) const
+{
+	char entry[MAXSTRINGLEN + sizeof(PageNum) + sizeof(SlotNum)];
+	PageNum passed = IX_NO_PAGE;    // right leaf found to start past the key
+	while (true){
+		// Done if the key is within the leaf
+		int numEntries;
+		memcpy(&numEntries, pData, sizeof(int));
+		const char* last = NULL;
+		if (LeafIsCompact(pData, numEntries)){
+			if (numEntries > 0)
+				last = GetEntry(pData, numEntries - 1, entry);
+		}
+		else {
+			for (SlotNum j = ixIndexHeader.maxEntryIndex; !last && j >= 0; --j)
+				if (GetSlotBitValue(pData, j))
+					last = GetEntry(pData, j, entry);
+		}
+		if (attribute && last && CompareKey(last, attribute) >= 0)
+			return OK_RC;
+		PageNum rightPage;
+		memcpy(&rightPage, pData + sizeof(int) + 2 * sizeof(PageNum), sizeof(PageNum));
+		if (rightPage == IX_NO_PAGE || rightPage == passed)
+			return OK_RC;
+
+		// Or if it is before the right leaf.  A split may have put a leaf
+		// in between meanwhile, so the leaf is checked again
+		RC rc = ReleaseShared(pageNum);
+		if (rc != OK_RC)
+			return rc;
+		char* rightData;
+		if (rc = LatchShared(rightPage, rightData))
+			return rc;
+		memcpy(&numEntries, rightData, sizeof(int));
+		const char* first = NULL;
+		if (LeafIsCompact(rightData, numEntries)){
+			if (numEntries > 0)
+				first = GetEntry(rightData, 0, entry);
+		}
+		else {
+			for (SlotNum j = 0; !first && j <= ixIndexHeader.maxEntryIndex; ++j)
+				if (GetSlotBitValue(rightData, j))
+					first = GetEntry(rightData, j, entry);
+		}
+		if (attribute && (!first || CompareKey(first, attribute) > 0)){
+			if ((rc = ReleaseShared(rightPage)) || (rc = LatchShared(pageNum, pData)))
+				return rc;
+			passed = rightPage;
+			continue;
+		}
+		pageNum = rightPage;
+		pData = rightData;
+	}
+}
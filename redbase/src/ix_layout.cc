@@ -0,0 +1,152 @@
+#include <cstring>
+#include "ix.h"
+
+using namespace std;
+
+static int PointerSize(bool leaf)
+{
+	return leaf ? sizeof(PageNum) + sizeof(SlotNum) : sizeof(PageNum);
+}
+
+// hintKeys follows the node header, the hints follow it
+static int HintStart(bool leaf)
+{
+	return leaf ? IX_BIT_START : sizeof(int);
+}
+
+// The key hint j of numHints was taken from, in a node of num keys
+static int HintSlot(int j, int numHints, int num)
+{
+	return (j + 1) * num / (numHints + 1);
+}
+
+char* IX_IndexHandle::SeparatedKeys(char* pData, bool leaf) const
+{
+	if (leaf)
+		return pData + ixIndexHeader.leafHeaderSize;
+	return pData + IX_ALIGN_OFFSET(ixIndexHeader.internalHeaderSize + (ixIndexHeader.maxKeyIndex + 2) * sizeof(PageNum));
+}
+
+char* IX_IndexHandle::SeparatedPointers(char* pData, bool leaf) const
+{
+	if (!leaf)
+		return pData + ixIndexHeader.internalHeaderSize;
+	return pData + IX_ALIGN_OFFSET(ixIndexHeader.leafHeaderSize + (ixIndexHeader.maxEntryIndex + 1) * IX_KEY_STRIDE(ixIndexHeader.attrLength));
+}
+
+// The key's first 4 bytes as they order, big endian: ints and floats
+// encoded as in composite keys, strings up to their first null, composite
+// keys as they are.  Keys
+// with different hints order as them; keys with the same may not be equal
+unsigned int IX_IndexHandle::KeyHint(const void* key) const
+{
+	unsigned int hint = 0;
+	switch(ixIndexHeader.attrType) {
+	case INT:
+		memcpy(&hint, key, sizeof(int));
+		hint ^= 0x80000000u;
+		break;
+	case FLOAT:
+		memcpy(&hint, key, sizeof(float));
+		if (hint == 0x80000000u)
+			hint = 0; // -0 equals 0
+		hint = (hint & 0x80000000u) ? ~hint : (hint | 0x80000000u);
+		break;
+	default: {
+		const unsigned char* bytes = (const unsigned char*)key;
+		bool ended = false;
+		for (int b = 0; b < (int)sizeof(unsigned int); ++b){
+			unsigned char c = 0;
+			if (b < ixIndexHeader.attrLength && !ended)
+				c = bytes[b];
+			ended |= (ixIndexHeader.numKeyAttrs == 0 && c == 0);
+			hint = (hint << 8) | c;
+		}
+	}
+	}
+	return hint;
+}
+
+// Takes the hints from the node's num keys
+void IX_IndexHandle::SampleHints(char* pData, bool leaf, int num) const
+{
+	int numHints = ixIndexHeader.numHints;
+	int stride = IX_KEY_STRIDE(ixIndexHeader.attrLength);
+	char* keys = SeparatedKeys(pData, leaf);
+	char* ptr = pData + HintStart(leaf);
+	memcpy(ptr, &num, sizeof(int));
+	ptr += sizeof(int);
+	for (int j = 0; j < numHints; ++j, ptr += sizeof(unsigned int)){
+		unsigned int hint = num > 0 ? KeyHint(keys + HintSlot(j, numHints, num) * stride) : 0;
+		memcpy(ptr, &hint, sizeof(unsigned int));
+	}
+}
+
+// A key whose hint is below attribute's comes before it, one whose hint
+// is above after it, so the keys a search must read lie between the last
+// such key below and the first above.  The hints are counted rather than
+// searched, a loop without branches over one cache line
+void IX_IndexHandle::HintRange(char* pData, bool leaf, int num, void* attribute, int &first, int &last) const
+{
+	first = 0;
+	last = num;
+	int numHints = ixIndexHeader.numHints;
+	char* ptr = pData + HintStart(leaf);
+	int hintKeys;
+	memcpy(&hintKeys, ptr, sizeof(int));
+	if (numHints == 0 || num == 0 || hintKeys != num)
+		return;
+
+	unsigned int hints[IX_MAX_HINTS];
+	memcpy(hints, ptr + sizeof(int), numHints * sizeof(unsigned int));
+	unsigned int value = KeyHint(attribute);
+	int below = 0;
+	int through = 0;
+	for (int j = 0; j < numHints; ++j){
+		below += (hints[j] < value);
+		through += (hints[j] <= value);
+	}
+	if (below > 0)
+		first = HintSlot(below - 1, numHints, num) + 1;
+	if (through < numHints)
+		last = HintSlot(through, numHints, num);
+}
+
+// Writes num keys from copyBack, ptr {key ptr} ... for an internal node
+// and {key page slot} ... for a leaf, setting the count and hints
+void IX_IndexHandle::WriteSeparated(char* pData, const char* copyBack, int num, bool leaf) const
+{
+	int attrLength = ixIndexHeader.attrLength;
+	int stride = IX_KEY_STRIDE(attrLength);
+	int pointerSize = PointerSize(leaf);
+	char* keys = SeparatedKeys(pData, leaf);
+	char* pointers = SeparatedPointers(pData, leaf);
+	if (!leaf){
+		memcpy(pointers, copyBack, sizeof(PageNum));
+		copyBack += sizeof(PageNum);
+		pointers += sizeof(PageNum);
+	}
+	for (int i = 0; i < num; ++i, copyBack += attrLength + pointerSize){
+		memcpy(keys + i * stride, copyBack, attrLength);
+		memcpy(pointers + i * pointerSize, copyBack + attrLength, pointerSize);
+	}
+	memcpy(pData, &num, sizeof(int));
+	SampleHints(pData, leaf, num);
+}
+
+// Drops key keyNum and pointer pointerNum (child page or rid) from a
+// node of num keys, shifting the ones after them left
+void IX_IndexHandle::RemoveSeparated(char* pData, bool leaf, int num, SlotNum keyNum, SlotNum pointerNum) const
+{
+	int stride = IX_KEY_STRIDE(ixIndexHeader.attrLength);
+	int pointerSize = PointerSize(leaf);
+	int numPointers = leaf ? num : num + 1;
+	char* keys = SeparatedKeys(pData, leaf);
+	char* pointers = SeparatedPointers(pData, leaf);
+	memmove(keys + keyNum * stride, keys + (keyNum + 1) * stride, (num - 1 - keyNum) * stride);
+	memmove(pointers + pointerNum * pointerSize, pointers + (pointerNum + 1) * pointerSize,
+		(numPointers - 1 - pointerNum) * pointerSize);
+	--num;
+	memcpy(pData, &num, sizeof(int));
+	SampleHints(pData, leaf, num);
+}
@@ -1,12 +1,15 @@
+#include <cstdio>
 #include <cstring>
 #include <sstream>
 #include <cmath>
 #include <string>
+#include <unistd.h>
 #include "ix.h"
 
 using namespace std;
 
-IX_Manager::IX_Manager(PF_Manager &pfm): pfManager(&pfm)
+IX_Manager::IX_Manager(PF_Manager &pfm): pfManager(&pfm), mergePercent(IX_MERGE_PERCENT), descentPages(IX_DESCENT_PAGES),
+	separatedNodes(true), nodeHints(IX_NODE_HINTS)
 {}
 IX_Manager::~IX_Manager()
 {
@@ -15,7 +18,7 @@ IX_Manager::~IX_Manager()
 
 // Create a new Index
 RC IX_Manager::CreateIndex(const char *fileName, int indexNo,
-                AttrType attrType, int attrLength)
+                AttrType attrType, int attrLength, IndexType indexType)
 {
 	// Check input
 	// Check filename is not null
@@ -52,21 +55,92 @@ RC IX_Manager::CreateIndex(const char *fileName, int indexNo,
 		PrintError(IX_NUMLEN);
 		return IX_NUMLEN;
 	}
+	// Check index type is one of those allowed
+	if (indexType != BTREE_INDEX && indexType != HASH_INDEX && indexType != BITMAP_INDEX){
+		PrintError(IX_INVALIDENUM);
+		return IX_INVALIDENUM;
+	}
 	// End check input
 
 	// Create file
 	stringstream ss;
 	ss << fileName << '.' << indexNo;
 	string indexName= ss.str();
+	return CreateIndexFile(indexName.c_str(), attrType, attrLength, 0, NULL, NULL, indexType);
+}
+
+// Create a new composite Index
+RC IX_Manager::CreateIndex(const char *fileName, int indexNo, int attrCount,
+                const AttrType attrTypes[], const int attrLengths[])
+{
+	// Check input
+	// Check filename is not null
+	if (!fileName || !attrTypes || !attrLengths){
+		PrintError(IX_NULLINPUT);
+		return IX_NULLINPUT;
+	}
+
+	// Check filename does not exceed max relation name size and is not empty
+	size_t nameLen = strlen(fileName);
+	if (nameLen > MAXNAME || nameLen == 0){
+		PrintError(IX_FILENAMELEN);
+		return IX_FILENAMELEN;
+	}
+
+	// Given can assume indexNo is unique and positive.
+	if (indexNo < 0){
+		PrintError(IX_INVALIDNUM);
+		return IX_INVALIDNUM;
+	}
+
+	// Check number of key attributes
+	if (attrCount < 1 || attrCount > MAXINDEXATTRS){
+		PrintError(IX_KEYATTRS);
+		return IX_KEYATTRS;
+	}
+	// Check each attribute as a single attribute index would
+	int keyLength = 0;
+	for (int i = 0; i < attrCount; ++i){
+		if (attrTypes[i] != INT && attrTypes[i] != FLOAT && attrTypes[i] != STRING){
+			PrintError(IX_INVALIDENUM);
+			return IX_INVALIDENUM;
+		}
+		if (attrTypes[i] == STRING && (attrLengths[i] > MAXSTRINGLEN || attrLengths[i] < 1)){
+			PrintError(IX_STRLEN);
+			return IX_STRLEN;
+		}
+		if (attrTypes[i] != STRING && attrLengths[i] != 4){
+			PrintError(IX_NUMLEN);
+			return IX_NUMLEN;
+		}
+		keyLength += attrLengths[i];
+	}
+	// Check whole key is no longer than the longest string key
+	if (keyLength > MAXSTRINGLEN){
+		PrintError(IX_KEYATTRS);
+		return IX_KEYATTRS;
+	}
+	// End check input
+
+	// Create file
+	stringstream ss;
+	ss << fileName << '.' << indexNo;
+	string indexName= ss.str();
+	return CreateIndexFile(indexName.c_str(), STRING, keyLength, attrCount, attrTypes, attrLengths);
+}
 
-	RC rc = pfManager->CreateFile(indexName.c_str());
+// Creates an index file holding an empty root leaf
+RC IX_Manager::CreateIndexFile(const char *indexName, AttrType attrType, int attrLength,
+	int numKeyAttrs, const AttrType *keyAttrTypes, const int *keyAttrLengths, IndexType indexType)
+{
+	RC rc = pfManager->CreateFile(indexName);
 	if (rc != OK_RC){
 		PrintError(rc);
 		return rc;
 	}
 
 	PF_FileHandle fileHandle = PF_FileHandle();
-	rc = pfManager->OpenFile(indexName.c_str(), fileHandle);
+	rc = pfManager->OpenFile(indexName, fileHandle);
 	if (rc != OK_RC){
 		PrintError(rc);
 		return rc;
@@ -88,9 +162,22 @@ RC IX_Manager::CreateIndex(const char *fileName, int indexNo,
 		return rc;
 	}
 
-	//Create root leaf page
+	// STRING nodes are prefix compressed, hash buckets and bitmap
+	// directories are not; other B+tree nodes take the layout set
+	bool hashed = (indexType == HASH_INDEX);
+	bool bitmapped = (indexType == BITMAP_INDEX);
+	bool compressed = (attrType == STRING && numKeyAttrs == 0 && !hashed && !bitmapped);
+	bool separated = (separatedNodes && !compressed && !hashed && !bitmapped);
+	int numHints = separated ? nodeHints : 0;
+
+	//Create root leaf page, or the directory of a hash or bitmap index
 	PageNum rootPage;
-	rc = CreateEmptyRoot(fileHandle, attrLength, rootPage);
+	if (hashed)
+		rc = CreateEmptyDirectory(fileHandle, rootPage);
+	else if (bitmapped)
+		rc = CreateEmptyBitmapDirectory(fileHandle, rootPage);
+	else
+		rc = CreateEmptyRoot(fileHandle, compressed, separated, attrLength, rootPage);
 	if (rc != OK_RC){
 		fileHandle.UnpinPage(0);
 		return rc;
@@ -111,20 +198,67 @@ RC IX_Manager::CreateIndex(const char *fileName, int indexNo,
 	memcpy(ptr, &attrLength, sizeof(int)); // attrLength
 
 	ptr += sizeof(int);
-	SlotNum slotNumTmp = CalculateMaxKeys(attrLength) - 1; // 0-based
+	SlotNum slotNumTmp = CalculateMaxKeys(compressed, separated, attrLength) - 1; // 0-based
 	memcpy(ptr, &slotNumTmp, sizeof(SlotNum)); // maxKeyIndex
 
 	ptr += sizeof(SlotNum);
-	slotNumTmp = CalculateMaxEntries(attrLength) - 1; // 0-based
+	slotNumTmp = CalculateMaxEntries(compressed, separated, attrLength) - 1; // 0-based
+	if (hashed)
+		slotNumTmp = (PF_PAGE_SIZE - sizeof(IX_BucketHeader)) / (attrLength + sizeof(PageNum) + sizeof(SlotNum)) - 1;
+	else if (bitmapped)
+		slotNumTmp = (PF_PAGE_SIZE - sizeof(IX_BitmapDirHeader)) / (attrLength + 2 * sizeof(PageNum) + sizeof(int)) - 1;
 	memcpy(ptr, &slotNumTmp, sizeof(SlotNum)); // maxEntryIndex
 
 	ptr += sizeof(SlotNum);
 	intTmp = sizeof(int);
+	if (compressed)
+		intTmp += IX_PREFIX_LEN_SIZE;
+	else if (separated)
+		intTmp = SeparatedHeaderSize(false);
 	memcpy(ptr, &intTmp, sizeof(int)); // internalHeaderSize
 
 	ptr += sizeof(int);
-	intTmp = sizeof(int) + 3*sizeof(PageNum) + ceil(CalculateMaxEntries(attrLength) / 8.0);
+	intTmp = sizeof(int) + 3*sizeof(PageNum);
+	if (compressed)
+		intTmp += IX_PREFIX_LEN_SIZE;
+	else if (separated)
+		intTmp = SeparatedHeaderSize(true);
+	else
+		intTmp += ceil(CalculateMaxEntries(compressed, separated, attrLength) / 8.0);
 	memcpy(ptr, &intTmp, sizeof(int)); // leafHeaderSize
+
+	ptr += sizeof(int);
+	memcpy(ptr, &compressed, sizeof(bool)); // compressed
+
+	ptr += sizeof(bool);
+	memcpy(ptr, &numKeyAttrs, sizeof(int)); // numKeyAttrs
+
+	ptr += sizeof(int);
+	if (numKeyAttrs > 0)
+		memcpy(ptr, keyAttrTypes, numKeyAttrs * sizeof(AttrType)); // keyAttrTypes
+
+	ptr += MAXINDEXATTRS * sizeof(AttrType);
+	if (numKeyAttrs > 0)
+		memcpy(ptr, keyAttrLengths, numKeyAttrs * sizeof(int)); // keyAttrLengths
+
+	ptr += MAXINDEXATTRS * sizeof(int);
+	memcpy(ptr, &indexType, sizeof(IndexType)); // indexType
+
+	ptr += sizeof(IndexType);
+	intTmp = 0;
+	memcpy(ptr, &intTmp, sizeof(int)); // globalDepth
+
+	ptr += sizeof(int);
+	PageNum dirPages[IX_HASH_DIRPAGES];
+	for (int i = 0; i < IX_HASH_DIRPAGES; ++i)
+		dirPages[i] = (hashed && i == 0) ? rootPage : IX_NO_PAGE;
+	memcpy(ptr, dirPages, sizeof(dirPages)); // dirPages
+
+	ptr += sizeof(dirPages);
+	memcpy(ptr, &separated, sizeof(bool)); // separated
+
+	ptr += sizeof(bool);
+	memcpy(ptr, &numHints, sizeof(int)); // numHints
 	// End write info to header page.
 
 	// Mark header page as dirty.
@@ -181,6 +315,18 @@ RC IX_Manager::DestroyIndex(const char *fileName, int indexNo)
 		PrintError(rc);
 		return rc;
 	}
+	string bloomName = indexName + ".bloom";
+	if (access(bloomName.c_str(), F_OK) == 0 &&
+		(rc = pfManager->DestroyFile(bloomName.c_str()))){
+		PrintError(rc);
+		return rc;
+	}
+	string countName = indexName + ".count";
+	if (access(countName.c_str(), F_OK) == 0 &&
+		(rc = pfManager->DestroyFile(countName.c_str()))){
+		PrintError(rc);
+		return rc;
+	}
 
 	return OK_RC;
 }
@@ -208,8 +354,13 @@ RC IX_Manager::OpenIndex(const char *fileName, int indexNo,
 	stringstream ss;
 	ss << fileName << '.' << indexNo;
 	string indexName= ss.str();
+	return OpenIndexFile(indexName.c_str(), indexHandle);
+}
 
-	RC rc = pfManager->OpenFile(indexName.c_str(), indexHandle.pfFileHandle);
+// Opens an index file and reads its header into indexHandle
+RC IX_Manager::OpenIndexFile(const char *indexName, IX_IndexHandle &indexHandle)
+{
+	RC rc = pfManager->OpenFile(indexName, indexHandle.pfFileHandle);
 	if (rc != OK_RC){
 		PrintError(rc);
 		return rc;
@@ -218,6 +369,16 @@ RC IX_Manager::OpenIndex(const char *fileName, int indexNo,
 	// Initialize state
 	indexHandle.open = true;
 	indexHandle.modified = false;
+	indexHandle.mergePercent = mergePercent;
+	indexHandle.openScans = 0;
+	indexHandle.descentPages = descentPages;
+	indexHandle.numPinned = 0;
+	indexHandle.numWriteLatches = 0;
+	indexHandle.readersExcluded = false;
+	indexHandle.bloomOpen = false;
+	indexHandle.countsOpen = false;
+	indexHandle.numStaleCounts = 0;
+	indexHandle.countsLost = false;
 
 	// Get header page info
 	char *pData;
@@ -259,27 +420,103 @@ RC IX_Manager::OpenIndex(const char *fileName, int indexNo,
 
 	ptr += sizeof(int);
 	memcpy(&indexHandle.ixIndexHeader.leafHeaderSize, ptr, sizeof(int));
+
+	ptr += sizeof(int);
+	memcpy(&indexHandle.ixIndexHeader.compressed, ptr, sizeof(bool));
+
+	ptr += sizeof(bool);
+	memcpy(&indexHandle.ixIndexHeader.numKeyAttrs, ptr, sizeof(int));
+
+	ptr += sizeof(int);
+	memcpy(indexHandle.ixIndexHeader.keyAttrTypes, ptr, MAXINDEXATTRS * sizeof(AttrType));
+
+	ptr += MAXINDEXATTRS * sizeof(AttrType);
+	memcpy(indexHandle.ixIndexHeader.keyAttrLengths, ptr, MAXINDEXATTRS * sizeof(int));
+
+	ptr += MAXINDEXATTRS * sizeof(int);
+	memcpy(&indexHandle.ixIndexHeader.indexType, ptr, sizeof(IndexType));
+
+	ptr += sizeof(IndexType);
+	memcpy(&indexHandle.ixIndexHeader.globalDepth, ptr, sizeof(int));
+
+	ptr += sizeof(int);
+	memcpy(indexHandle.ixIndexHeader.dirPages, ptr, IX_HASH_DIRPAGES * sizeof(PageNum));
+
+	ptr += IX_HASH_DIRPAGES * sizeof(PageNum);
+	memcpy(&indexHandle.ixIndexHeader.separated, ptr, sizeof(bool));
+
+	ptr += sizeof(bool);
+	memcpy(&indexHandle.ixIndexHeader.numHints, ptr, sizeof(int));
 	// End copy over header data
 
-	// Clean up
+	// The header page stays pinned while the index is open, since its
+	// latch guards the tree
 	pData = NULL;
 	ptr = NULL;
-	rc = indexHandle.pfFileHandle.UnpinPage(0);
-	if (rc != OK_RC){
-		PrintError(rc);
+	if (rc = indexHandle.PinUpperLevels())
 		return rc;
-	}
 
+	// Open its Bloom filter and entry counts, if it has them
+	string bloomName = string(indexName) + ".bloom";
+	if (access(bloomName.c_str(), F_OK) == 0){
+		if (rc = pfManager->OpenFile(bloomName.c_str(), indexHandle.bloomHandle)){
+			PrintError(rc);
+			return rc;
+		}
+		if (rc = indexHandle.bloomHandle.GetThisPage(0, pfPageHandle)){
+			PrintError(rc);
+			return rc;
+		}
+		pfPageHandle.GetData(pData);
+		memcpy(&indexHandle.bloomPages, pData, sizeof(int));
+		if (rc = indexHandle.bloomHandle.UnpinPage(0)){
+			PrintError(rc);
+			return rc;
+		}
+		indexHandle.bloomOpen = true;
+	}
+	string countName = string(indexName) + ".count";
+	if (access(countName.c_str(), F_OK) == 0){
+		if (rc = pfManager->OpenFile(countName.c_str(), indexHandle.countsHandle)){
+			PrintError(rc);
+			return rc;
+		}
+		indexHandle.countsOpen = true;
+	}
 	return OK_RC;
 }
 
 // Close an Index
 RC IX_Manager::CloseIndex(IX_IndexHandle &indexHandle)
 {
-	// Flush dirty pages
-	RC rc = indexHandle.ForcePages();
+	// Flush dirty pages, which PF only drops once unpinned
+	RC rc = indexHandle.UnpinUpperLevels();
+	if (rc != OK_RC)
+		return rc;
+	rc = indexHandle.ForcePages();
 	if (rc != OK_RC)
 		return rc;
+	rc = indexHandle.pfFileHandle.UnpinPage(0);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	if (indexHandle.bloomOpen){
+		rc = pfManager->CloseFile(indexHandle.bloomHandle);
+		if (rc != OK_RC){
+			PrintError(rc);
+			return rc;
+		}
+		indexHandle.bloomOpen = false;
+	}
+	if (indexHandle.countsOpen){
+		rc = pfManager->CloseFile(indexHandle.countsHandle);
+		if (rc != OK_RC){
+			PrintError(rc);
+			return rc;
+		}
+		indexHandle.countsOpen = false;
+	}
         
 	// Close file handle.
 	rc = pfManager->CloseFile(indexHandle.pfFileHandle);
@@ -294,6 +531,306 @@ RC IX_Manager::CloseIndex(IX_IndexHandle &indexHandle)
 	return OK_RC;
 }
 
+// Rebuild an index.  Other handles keep reading the old file until they
+// close it; indexHandle is closed and reopened on the new one
+RC IX_Manager::RebuildIndex(const char *fileName, int indexNo,
+                IX_IndexHandle &indexHandle, int fillPercent)
+{
+	// Check input
+	if (!fileName){
+		PrintError(IX_NULLINPUT);
+		return IX_NULLINPUT;
+	}
+	if (!indexHandle.open){
+		PrintError(IX_FILENOTOPEN);
+		return IX_FILENOTOPEN;
+	}
+	if (indexHandle.openScans > 0){
+		PrintError(IX_SCANSOPEN);
+		return IX_SCANSOPEN;
+	}
+	// End check input
+
+	stringstream ss;
+	ss << fileName << '.' << indexNo;
+	string indexName = ss.str();
+	string newName = indexName + ".new";
+
+	// Bulk load the entries, in key order, into a new file beside the
+	// old one; a copy left by an interrupted rebuild is discarded
+	pfManager->DestroyFile(newName.c_str());
+	const IX_IndexHeader &header = indexHandle.ixIndexHeader;
+	RC rc = CreateIndexFile(newName.c_str(), header.attrType, header.attrLength,
+		header.numKeyAttrs, header.keyAttrTypes, header.keyAttrLengths, header.indexType);
+	if (rc != OK_RC)
+		return rc;
+	IX_IndexHandle newHandle;
+	if (rc = OpenIndexFile(newName.c_str(), newHandle)){
+		pfManager->DestroyFile(newName.c_str());
+		return rc;
+	}
+	IX_BulkLoader loader(*this);
+	if ((rc = loader.OpenLoad(fileName, indexNo, newHandle, fillPercent)) ||
+		(rc = indexHandle.CopyEntries(loader)) ||
+		(rc = loader.CloseLoad())){
+		CloseIndex(newHandle);
+		pfManager->DestroyFile(newName.c_str());
+		return rc;
+	}
+	if (rc = CloseIndex(newHandle))
+		return rc;
+
+	// Swap the new file in
+	int percent = indexHandle.mergePercent;
+	int pages = indexHandle.descentPages;
+	if (rc = CloseIndex(indexHandle))
+		return rc;
+	if (rename(newName.c_str(), indexName.c_str()) != 0){
+		PrintError(PF_UNIX);
+		return PF_UNIX;
+	}
+	if (rc = OpenIndexFile(indexName.c_str(), indexHandle))
+		return rc;
+	indexHandle.mergePercent = percent;
+	if (rc = indexHandle.SetDescentPages(pages))
+		return rc;
+
+	// The filter still has the keys deleted since it was built
+	if (indexHandle.bloomOpen && (rc = indexHandle.FillBloom()))
+		return rc;
+
+	// The copy's nodes are new pages
+	if (indexHandle.countsOpen && (rc = indexHandle.RecountEntries()))
+		return rc;
+
+	return OK_RC;
+}
+
+// Give an index a Bloom filter in a side file, fileName.indexNo.bloom
+RC IX_Manager::CreateBloomFilter(const char *fileName, int indexNo,
+                IX_IndexHandle &indexHandle)
+{
+	// Check input
+	if (!fileName){
+		PrintError(IX_NULLINPUT);
+		return IX_NULLINPUT;
+	}
+	if (!indexHandle.open){
+		PrintError(IX_FILENOTOPEN);
+		return IX_FILENOTOPEN;
+	}
+	// End check input
+
+	// An existing filter is just rebuilt
+	if (indexHandle.bloomOpen)
+		return indexHandle.FillBloom();
+
+	stringstream ss;
+	ss << fileName << '.' << indexNo << ".bloom";
+	string bloomName = ss.str();
+	RC rc = pfManager->CreateFile(bloomName.c_str());
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	if (rc = pfManager->OpenFile(bloomName.c_str(), indexHandle.bloomHandle)){
+		pfManager->DestroyFile(bloomName.c_str());
+		PrintError(rc);
+		return rc;
+	}
+
+	// Header page: no pages in use or allocated
+	PF_PageHandle pfPageHandle;
+	char* pData;
+	int zero = 0;
+	if ((rc = indexHandle.bloomHandle.AllocatePage(pfPageHandle)) == OK_RC){
+		pfPageHandle.GetData(pData);
+		memcpy(pData, &zero, sizeof(int));
+		memcpy(pData + sizeof(int), &zero, sizeof(int));
+		if ((rc = indexHandle.bloomHandle.MarkDirty(0)) == OK_RC)
+			rc = indexHandle.bloomHandle.UnpinPage(0);
+	}
+	if (rc != OK_RC){
+		pfManager->CloseFile(indexHandle.bloomHandle);
+		pfManager->DestroyFile(bloomName.c_str());
+		PrintError(rc);
+		return rc;
+	}
+	indexHandle.bloomOpen = true;
+
+	if (rc = indexHandle.FillBloom()){
+		DestroyBloomFilter(fileName, indexNo, indexHandle);
+		return rc;
+	}
+	return indexHandle.bloomHandle.ForcePages();
+}
+
+// Drop an index's Bloom filter and its side file
+RC IX_Manager::DestroyBloomFilter(const char *fileName, int indexNo,
+                IX_IndexHandle &indexHandle)
+{
+	// Check input
+	if (!fileName){
+		PrintError(IX_NULLINPUT);
+		return IX_NULLINPUT;
+	}
+	if (!indexHandle.open){
+		PrintError(IX_FILENOTOPEN);
+		return IX_FILENOTOPEN;
+	}
+	// End check input
+
+	RC rc;
+	if (indexHandle.bloomOpen){
+		indexHandle.bloomOpen = false;
+		if (rc = pfManager->CloseFile(indexHandle.bloomHandle)){
+			PrintError(rc);
+			return rc;
+		}
+	}
+	stringstream ss;
+	ss << fileName << '.' << indexNo << ".bloom";
+	string bloomName = ss.str();
+	if (access(bloomName.c_str(), F_OK) == 0 &&
+		(rc = pfManager->DestroyFile(bloomName.c_str()))){
+		PrintError(rc);
+		return rc;
+	}
+	return OK_RC;
+}
+
+// Give a B+tree entry counts in a side file, fileName.indexNo.count
+RC IX_Manager::CreateEntryCounts(const char *fileName, int indexNo,
+                IX_IndexHandle &indexHandle)
+{
+	// Check input
+	if (!fileName){
+		PrintError(IX_NULLINPUT);
+		return IX_NULLINPUT;
+	}
+	if (!indexHandle.open){
+		PrintError(IX_FILENOTOPEN);
+		return IX_FILENOTOPEN;
+	}
+	if (indexHandle.ixIndexHeader.indexType != BTREE_INDEX){
+		PrintError(IX_NOTBTREE);
+		return IX_NOTBTREE;
+	}
+	// End check input
+
+	RC rc;
+	if (!indexHandle.countsOpen){
+		stringstream ss;
+		ss << fileName << '.' << indexNo << ".count";
+		string countName = ss.str();
+		if (rc = pfManager->CreateFile(countName.c_str())){
+			PrintError(rc);
+			return rc;
+		}
+		if (rc = pfManager->OpenFile(countName.c_str(), indexHandle.countsHandle)){
+			pfManager->DestroyFile(countName.c_str());
+			PrintError(rc);
+			return rc;
+		}
+
+		// Header page: itself the only page allocated
+		PF_PageHandle pfPageHandle;
+		char* pData;
+		int one = 1;
+		if ((rc = indexHandle.countsHandle.AllocatePage(pfPageHandle)) == OK_RC){
+			pfPageHandle.GetData(pData);
+			memcpy(pData, &one, sizeof(int));
+			if ((rc = indexHandle.countsHandle.MarkDirty(0)) == OK_RC)
+				rc = indexHandle.countsHandle.UnpinPage(0);
+		}
+		if (rc != OK_RC){
+			pfManager->CloseFile(indexHandle.countsHandle);
+			pfManager->DestroyFile(countName.c_str());
+			PrintError(rc);
+			return rc;
+		}
+		indexHandle.countsOpen = true;
+	}
+
+	// Counted with writers kept out, as they would add to half-made counts
+	if (rc = indexHandle.LatchIndex(PF_EXCLUSIVE))
+		return rc;
+	rc = indexHandle.RecountEntries();
+	RC latchRC = indexHandle.UnlatchIndex(PF_EXCLUSIVE);
+	if (rc != OK_RC){
+		DestroyEntryCounts(fileName, indexNo, indexHandle);
+		return rc;
+	}
+	if (latchRC != OK_RC)
+		return latchRC;
+	return indexHandle.countsHandle.ForcePages();
+}
+
+// Drop an index's entry counts and their side file
+RC IX_Manager::DestroyEntryCounts(const char *fileName, int indexNo,
+                IX_IndexHandle &indexHandle)
+{
+	// Check input
+	if (!fileName){
+		PrintError(IX_NULLINPUT);
+		return IX_NULLINPUT;
+	}
+	if (!indexHandle.open){
+		PrintError(IX_FILENOTOPEN);
+		return IX_FILENOTOPEN;
+	}
+	// End check input
+
+	RC rc;
+	if (indexHandle.countsOpen){
+		indexHandle.countsOpen = false;
+		if (rc = pfManager->CloseFile(indexHandle.countsHandle)){
+			PrintError(rc);
+			return rc;
+		}
+	}
+	stringstream ss;
+	ss << fileName << '.' << indexNo << ".count";
+	string countName = ss.str();
+	if (access(countName.c_str(), F_OK) == 0 &&
+		(rc = pfManager->DestroyFile(countName.c_str()))){
+		PrintError(rc);
+		return rc;
+	}
+	return OK_RC;
+}
+
+RC IX_Manager::SetMergePercent(int percent)
+{
+	if (percent < 0 || percent > 50){
+		PrintError(IX_INVALIDNUM);
+		return IX_INVALIDNUM;
+	}
+	mergePercent = percent;
+	return OK_RC;
+}
+
+RC IX_Manager::SetDescentPages(int numPages)
+{
+	if (numPages < 0 || numPages > IX_MAX_DESCENT_PAGES){
+		PrintError(IX_INVALIDNUM);
+		return IX_INVALIDNUM;
+	}
+	descentPages = numPages;
+	return OK_RC;
+}
+
+RC IX_Manager::SetNodeLayout(bool separated, int numHints)
+{
+	if (numHints < 0 || numHints > IX_MAX_HINTS){
+		PrintError(IX_INVALIDNUM);
+		return IX_INVALIDNUM;
+	}
+	separatedNodes = separated;
+	nodeHints = numHints;
+	return OK_RC;
+}
+
 const char* IX_Manager::GetIndexFileName(const char *fileName, int indexNo)
 {
 	stringstream ss;
@@ -301,18 +838,46 @@ const char* IX_Manager::GetIndexFileName(const char *fileName, int indexNo)
 	return ss.str().c_str();
 }
 
-int IX_Manager::CalculateMaxKeys(int attrLength)
+// Compressed nodes hold a varying number of keys; the most they can
+// hold is with every suffix empty.  Separated nodes lose the padding
+// that aligns their second array
+int IX_Manager::CalculateMaxKeys(bool compressed, bool separated, int attrLength)
 {
+	if (compressed)
+		return (PF_PAGE_SIZE - sizeof(int) - IX_PREFIX_LEN_SIZE - sizeof(PageNum)) / (IX_OFFSET_SIZE + 1 + sizeof(PageNum));
+	if (separated){
+		int headerSize = SeparatedHeaderSize(false);
+		int maxKeys = (PF_PAGE_SIZE - headerSize - sizeof(PageNum)) / (IX_KEY_STRIDE(attrLength) + sizeof(PageNum));
+		while (IX_ALIGN_OFFSET(headerSize + (maxKeys + 1) * sizeof(PageNum)) + maxKeys * IX_KEY_STRIDE(attrLength) > PF_PAGE_SIZE)
+			--maxKeys;
+		return maxKeys;
+	}
 	return (PF_PAGE_SIZE - sizeof(int) - sizeof(PageNum)) / (attrLength + sizeof(PageNum));
 }
-int IX_Manager::CalculateMaxEntries(int attrLength)
+int IX_Manager::CalculateMaxEntries(bool compressed, bool separated, int attrLength)
 {
+	if (compressed)
+		return (PF_PAGE_SIZE - sizeof(int) - 3*sizeof(PageNum) - IX_PREFIX_LEN_SIZE) / (IX_OFFSET_SIZE + 1 + sizeof(PageNum) + sizeof(SlotNum));
+	if (separated){
+		int headerSize = SeparatedHeaderSize(true);
+		int ridSize = sizeof(PageNum) + sizeof(SlotNum);
+		int maxEntries = (PF_PAGE_SIZE - headerSize) / (IX_KEY_STRIDE(attrLength) + ridSize);
+		while (IX_ALIGN_OFFSET(headerSize + maxEntries * IX_KEY_STRIDE(attrLength)) + maxEntries * ridSize > PF_PAGE_SIZE)
+			--maxEntries;
+		return maxEntries;
+	}
 	return floor((PF_PAGE_SIZE - sizeof(int) - 3*sizeof(PageNum)) / (attrLength + sizeof(PageNum) + sizeof(SlotNum) + 1/8.0));
 }
+// The node header, hintKeys and the hints, aligned
+int IX_Manager::SeparatedHeaderSize(bool leaf)
+{
+	int headerSize = leaf ? sizeof(int) + 3*sizeof(PageNum) : sizeof(int);
+	return IX_ALIGN_OFFSET(headerSize + sizeof(int) + nodeHints * sizeof(unsigned int));
+}
 
-RC IX_Manager::CreateEmptyRoot(PF_FileHandle &fileHandle, int attrLength, PageNum &pageNum)
+RC IX_Manager::CreateEmptyRoot(PF_FileHandle &fileHandle, bool compressed, bool separated, int attrLength, PageNum &pageNum)
 {
-	SlotNum maxEntry = CalculateMaxEntries(attrLength);
+	SlotNum maxEntry = CalculateMaxEntries(compressed, separated, attrLength);
 
 	// Create page
 	char *pData;
@@ -351,6 +916,15 @@ RC IX_Manager::CreateEmptyRoot(PF_FileHandle &fileHandle, int attrLength, PageNu
 	memcpy(ptr, &pageNumTmp, sizeof(PageNum)); // rightLeaf
 
 	ptr += sizeof(PageNum);
+	if (compressed){
+		short prefixLen = 0;
+		memcpy(ptr, &prefixLen, IX_PREFIX_LEN_SIZE); // prefixLen
+		maxEntry = 0;
+	}
+	if (separated){
+		memcpy(ptr, &intTmp, sizeof(int)); // hintKeys
+		maxEntry = 0;
+	}
 	char charTmp = 0;
 	for (SlotNum i = 0; i < ceil(maxEntry / 8.0); ++i){ //bitSlots
 		memcpy(ptr, &charTmp, sizeof(char));
@@ -377,6 +951,82 @@ RC IX_Manager::CreateEmptyRoot(PF_FileHandle &fileHandle, int attrLength, PageNu
 	return OK_RC;
 }
 
+// A hash index starts as a one slot directory and an empty bucket
+RC IX_Manager::CreateEmptyDirectory(PF_FileHandle &fileHandle, PageNum &pageNum)
+{
+	// Create bucket page
+	PF_PageHandle pfPageHandle;
+	RC rc = fileHandle.AllocatePage(pfPageHandle);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	PageNum bucketPage;
+	char* pData;
+	if ((rc = pfPageHandle.GetPageNum(bucketPage)) ||
+		(rc = pfPageHandle.GetData(pData))){
+		PrintError(rc);
+		return rc;
+	}
+	IX_BucketHeader header;
+	header.numEntries = 0;
+	header.localDepth = 0;
+	header.overflowPage = IX_NO_PAGE;
+	memcpy(pData, &header, sizeof(IX_BucketHeader));
+	if ((rc = fileHandle.MarkDirty(bucketPage)) ||
+		(rc = fileHandle.UnpinPage(bucketPage))){
+		PrintError(rc);
+		return rc;
+	}
+
+	// Create directory page
+	rc = fileHandle.AllocatePage(pfPageHandle);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	if ((rc = pfPageHandle.GetPageNum(pageNum)) ||
+		(rc = pfPageHandle.GetData(pData))){
+		PrintError(rc);
+		return rc;
+	}
+	memcpy(pData, &bucketPage, sizeof(PageNum));
+	if ((rc = fileHandle.MarkDirty(pageNum)) ||
+		(rc = fileHandle.UnpinPage(pageNum))){
+		PrintError(rc);
+		return rc;
+	}
+
+	return OK_RC;
+}
+
+// A bitmap index starts with no keys, in a single directory page
+RC IX_Manager::CreateEmptyBitmapDirectory(PF_FileHandle &fileHandle, PageNum &pageNum)
+{
+	PF_PageHandle pfPageHandle;
+	RC rc = fileHandle.AllocatePage(pfPageHandle);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	char* pData;
+	if ((rc = pfPageHandle.GetPageNum(pageNum)) ||
+		(rc = pfPageHandle.GetData(pData))){
+		PrintError(rc);
+		return rc;
+	}
+	IX_BitmapDirHeader header;
+	header.numValues = 0;
+	header.nextPage = IX_NO_PAGE;
+	memcpy(pData, &header, sizeof(IX_BitmapDirHeader));
+	if ((rc = fileHandle.MarkDirty(pageNum)) ||
+		(rc = fileHandle.UnpinPage(pageNum))){
+		PrintError(rc);
+		return rc;
+	}
+	return OK_RC;
+}
+
 /*
 RC IX_Manager::CreatePage(PF_FileHandle fileHandle, PageNum &pageNum, char* pData){
 	PF_PageHandle pfPageHandle;
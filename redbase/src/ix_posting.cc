@@ -0,0 +1,493 @@
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include "ix.h"
+
+using namespace std;
+
+#define IX_POSTING_SPACE ((int)(PF_PAGE_SIZE - sizeof(IX_PostingHeader)))
+#define IX_MAX_RID_BYTES 10  // two 5 byte varints
+
+// Orders rids by page, then slot
+static bool RidLess(const RID &one, const RID &two)
+{
+	if (one.pageNum != two.pageNum)
+		return one.pageNum < two.pageNum;
+	return one.slotNum < two.slotNum;
+}
+
+static int PutVarint(char* out, unsigned int v)
+{
+	int n = 0;
+	while (v >= 0x80){
+		out[n++] = (char)((v & 0x7F) | 0x80);
+		v >>= 7;
+	}
+	out[n++] = (char)v;
+	return n;
+}
+
+static int GetVarint(const char* in, unsigned int &v)
+{
+	int n = 0;
+	int shift = 0;
+	v = 0;
+	while (true){
+		unsigned char c = in[n++];
+		v |= (unsigned int)(c & 0x7F) << shift;
+		if (!(c & 0x80))
+			return n;
+		shift += 7;
+	}
+}
+
+// Encodes rid relative to prev: the page delta, then the slot delta if
+// on the same page or the slot itself if not
+static int EncodeRid(char* out, const RID &prev, const RID &rid)
+{
+	unsigned int pageDelta = (unsigned int)(rid.pageNum - prev.pageNum);
+	int n = PutVarint(out, pageDelta);
+	unsigned int slot = (pageDelta == 0) ? (unsigned int)(rid.slotNum - prev.slotNum) : (unsigned int)rid.slotNum;
+	return n + PutVarint(out + n, slot);
+}
+
+static int DecodeRid(const char* in, const RID &prev, RID &rid)
+{
+	unsigned int pageDelta, slot;
+	int n = GetVarint(in, pageDelta);
+	n += GetVarint(in + n, slot);
+	rid.pageNum = prev.pageNum + (PageNum)pageDelta;
+	rid.slotNum = (pageDelta == 0) ? prev.slotNum + (SlotNum)slot : (SlotNum)slot;
+	return n;
+}
+
+// Decodes a posting page's rids onto the end of rids
+static void DecodePage(const char* pData, vector<RID> &rids)
+{
+	IX_PostingHeader header;
+	memcpy(&header, pData, sizeof(IX_PostingHeader));
+	const char* in = pData + sizeof(IX_PostingHeader);
+	RID prev(0, 0);
+	for (int i = 0; i < header.numRids; ++i){
+		RID rid;
+		in += DecodeRid(in, prev, rid);
+		rids.push_back(rid);
+		prev = rid;
+	}
+}
+
+// Bytes needed to encode rids as one page
+static int EncodedSize(const RID* rids, int numRids)
+{
+	char bytes[IX_MAX_RID_BYTES];
+	RID prev(0, 0);
+	int n = 0;
+	for (int i = 0; i < numRids; ++i){
+		n += EncodeRid(bytes, prev, rids[i]);
+		prev = rids[i];
+	}
+	return n;
+}
+
+// Rewrites a posting page's rids, keeping its links
+static void FillPage(char* pData, const RID* rids, int numRids)
+{
+	IX_PostingHeader header;
+	memcpy(&header, pData, sizeof(IX_PostingHeader));
+	char* out = pData + sizeof(IX_PostingHeader);
+	RID prev(0, 0);
+	int n = 0;
+	for (int i = 0; i < numRids; ++i){
+		n += EncodeRid(out + n, prev, rids[i]);
+		prev = rids[i];
+	}
+	header.numRids = numRids;
+	header.usedBytes = n;
+	header.lastPageNum = prev.pageNum;
+	header.lastSlotNum = prev.slotNum;
+	memcpy(pData, &header, sizeof(IX_PostingHeader));
+}
+
+static RC GetPostingPage(const PF_FileHandle &fileHandle, PageNum pageNum, char* &pData)
+{
+	PF_PageHandle pfPageHandle;
+	RC rc = fileHandle.GetThisPage(pageNum, pfPageHandle);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	rc = pfPageHandle.GetData(pData);
+	if (rc != OK_RC){
+		fileHandle.UnpinPage(pageNum);
+		PrintError(rc);
+		return rc;
+	}
+	return OK_RC;
+}
+
+// Allocates an empty, unlinked posting page, left pinned
+static RC NewPostingPage(PF_FileHandle &fileHandle, PageNum &pageNum, char* &pData)
+{
+	PF_PageHandle pfPageHandle;
+	RC rc = fileHandle.AllocatePage(pfPageHandle);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	rc = pfPageHandle.GetPageNum(pageNum);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	rc = pfPageHandle.GetData(pData);
+	if (rc != OK_RC){
+		fileHandle.UnpinPage(pageNum);
+		PrintError(rc);
+		return rc;
+	}
+
+	IX_PostingHeader header;
+	header.numRids = 0;
+	header.usedBytes = 0;
+	header.nextPage = IX_NO_PAGE;
+	header.tailPage = pageNum;
+	header.lastPageNum = 0;
+	header.lastSlotNum = 0;
+	memcpy(pData, &header, sizeof(IX_PostingHeader));
+	return OK_RC;
+}
+
+static RC ReleasePostingPage(const PF_FileHandle &fileHandle, PageNum pageNum, bool dirty)
+{
+	RC rc;
+	if (dirty && (rc = fileHandle.MarkDirty(pageNum))){
+		fileHandle.UnpinPage(pageNum);
+		PrintError(rc);
+		return rc;
+	}
+	rc = fileHandle.UnpinPage(pageNum);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	return OK_RC;
+}
+
+// Sets the head page's tail pointer
+static RC SetTailPage(PF_FileHandle &fileHandle, PageNum headPage, PageNum tailPage)
+{
+	char* pData;
+	RC rc = GetPostingPage(fileHandle, headPage, pData);
+	if (rc != OK_RC)
+		return rc;
+	IX_PostingHeader header;
+	memcpy(&header, pData, sizeof(IX_PostingHeader));
+	header.tailPage = tailPage;
+	memcpy(pData, &header, sizeof(IX_PostingHeader));
+	return ReleasePostingPage(fileHandle, headPage, true);
+}
+
+// Pins the first page of the list whose last rid is >= rid, along with
+// the page before it (IX_NO_PAGE if none); pageNum is IX_NO_PAGE if all
+// rids are smaller
+static RC FindPostingPage(const PF_FileHandle &fileHandle, PageNum headPage, const RID &rid, PageNum &prevPage, PageNum &pageNum, char* &pData)
+{
+	prevPage = IX_NO_PAGE;
+	pageNum = headPage;
+	while (pageNum != IX_NO_PAGE){
+		RC rc = GetPostingPage(fileHandle, pageNum, pData);
+		if (rc != OK_RC)
+			return rc;
+		IX_PostingHeader header;
+		memcpy(&header, pData, sizeof(IX_PostingHeader));
+		if (!RidLess(RID(header.lastPageNum, header.lastSlotNum), rid))
+			return OK_RC;
+
+		if (rc = ReleasePostingPage(fileHandle, pageNum, false))
+			return rc;
+		prevPage = pageNum;
+		pageNum = header.nextPage;
+	}
+	return OK_RC;
+}
+
+// All rids of a key, from its posting list or its single leaf entry
+RC IX_IndexHandle::GetRids(void* attribute, RID* &rids, int &numRids) const
+{
+	vector<RID> result;
+	IX_IndexScan scan;
+	RC rc = scan.OpenScan(*this, EQ_OP, attribute);
+	if (rc != OK_RC)
+		return rc;
+	RID rid;
+	while (OK_RC == (rc = scan.GetNextEntry(rid)))
+		result.push_back(rid);
+	if (rc != IX_EOF)
+		return rc;
+	if (rc = scan.CloseScan())
+		return rc;
+
+	sort(result.begin(), result.end(), RidLess);
+	numRids = result.size();
+	rids = new RID[numRids > 0 ? numRids : 1];
+	for (int i = 0; i < numRids; ++i)
+		rids[i] = result[i];
+	return OK_RC;
+}
+
+RC IX_IndexHandle::CreatePostings(const RID &one, const RID &two, PageNum &headPage)
+{
+	RID rids[2] = { one, two };
+	if (RidLess(two, one)){
+		rids[0] = two;
+		rids[1] = one;
+	}
+
+	char* pData;
+	RC rc = NewPostingPage(pfFileHandle, headPage, pData);
+	if (rc != OK_RC)
+		return rc;
+	FillPage(pData, rids, 2);
+	return ReleasePostingPage(pfFileHandle, headPage, true);
+}
+
+RC IX_IndexHandle::InsertPosting(PageNum headPage, const RID &rid)
+{
+	char* pData;
+	RC rc = GetPostingPage(pfFileHandle, headPage, pData);
+	if (rc != OK_RC)
+		return rc;
+	IX_PostingHeader header;
+	memcpy(&header, pData, sizeof(IX_PostingHeader));
+	PageNum tailPage = header.tailPage;
+	if (rc = ReleasePostingPage(pfFileHandle, headPage, false))
+		return rc;
+
+	// Usual case, rids arrive in increasing order: append to the tail page
+	if (rc = GetPostingPage(pfFileHandle, tailPage, pData))
+		return rc;
+	memcpy(&header, pData, sizeof(IX_PostingHeader));
+	RID last(header.lastPageNum, header.lastSlotNum);
+	if (!RidLess(rid, last)){
+		char bytes[IX_MAX_RID_BYTES];
+		int n = EncodeRid(bytes, last, rid);
+
+		// Room on the tail page
+		if (header.usedBytes + n <= IX_POSTING_SPACE){
+			memcpy(pData + sizeof(IX_PostingHeader) + header.usedBytes, bytes, n);
+			header.numRids += 1;
+			header.usedBytes += n;
+			header.lastPageNum = rid.pageNum;
+			header.lastSlotNum = rid.slotNum;
+			memcpy(pData, &header, sizeof(IX_PostingHeader));
+			return ReleasePostingPage(pfFileHandle, tailPage, true);
+		}
+
+		// Start a new tail page
+		PageNum newPage;
+		char* newData;
+		if (rc = NewPostingPage(pfFileHandle, newPage, newData)){
+			pfFileHandle.UnpinPage(tailPage);
+			return rc;
+		}
+		FillPage(newData, &rid, 1);
+		if (rc = ReleasePostingPage(pfFileHandle, newPage, true)){
+			pfFileHandle.UnpinPage(tailPage);
+			return rc;
+		}
+		header.nextPage = newPage;
+		memcpy(pData, &header, sizeof(IX_PostingHeader));
+		if (rc = ReleasePostingPage(pfFileHandle, tailPage, true))
+			return rc;
+		return SetTailPage(pfFileHandle, headPage, newPage);
+	}
+	if (rc = ReleasePostingPage(pfFileHandle, tailPage, false))
+		return rc;
+
+	// Otherwise insert into the page whose range holds the rid
+	PageNum prevPage, pageNum;
+	if (rc = FindPostingPage(pfFileHandle, headPage, rid, prevPage, pageNum, pData))
+		return rc;
+	memcpy(&header, pData, sizeof(IX_PostingHeader));
+	vector<RID> rids;
+	DecodePage(pData, rids);
+	rids.insert(upper_bound(rids.begin(), rids.end(), rid, RidLess), rid);
+
+	if (EncodedSize(&rids[0], rids.size()) <= IX_POSTING_SPACE){
+		FillPage(pData, &rids[0], rids.size());
+		return ReleasePostingPage(pfFileHandle, pageNum, true);
+	}
+
+	// Page is full, move its upper half to a new page after it
+	int half = rids.size() / 2;
+	PageNum newPage;
+	char* newData;
+	if (rc = NewPostingPage(pfFileHandle, newPage, newData)){
+		pfFileHandle.UnpinPage(pageNum);
+		return rc;
+	}
+	FillPage(newData, &rids[half], rids.size() - half);
+	IX_PostingHeader newHeader;
+	memcpy(&newHeader, newData, sizeof(IX_PostingHeader));
+	newHeader.nextPage = header.nextPage;
+	memcpy(newData, &newHeader, sizeof(IX_PostingHeader));
+	if (rc = ReleasePostingPage(pfFileHandle, newPage, true)){
+		pfFileHandle.UnpinPage(pageNum);
+		return rc;
+	}
+
+	FillPage(pData, &rids[0], half);
+	memcpy(&header, pData, sizeof(IX_PostingHeader));
+	header.nextPage = newPage;
+	memcpy(pData, &header, sizeof(IX_PostingHeader));
+	if (rc = ReleasePostingPage(pfFileHandle, pageNum, true))
+		return rc;
+	if (pageNum == tailPage)
+		return SetTailPage(pfFileHandle, headPage, newPage);
+	return OK_RC;
+}
+
+RC IX_IndexHandle::DeletePosting(PageNum headPage, const RID &rid, bool &empty)
+{
+	empty = false;
+
+	PageNum prevPage, pageNum;
+	char* pData;
+	RC rc = FindPostingPage(pfFileHandle, headPage, rid, prevPage, pageNum, pData);
+	if (rc != OK_RC)
+		return rc;
+	if (pageNum == IX_NO_PAGE){
+		PrintError(IX_ENTRYDNE);
+		return IX_ENTRYDNE;
+	}
+
+	IX_PostingHeader header;
+	memcpy(&header, pData, sizeof(IX_PostingHeader));
+	vector<RID> rids;
+	DecodePage(pData, rids);
+	vector<RID>::iterator it = lower_bound(rids.begin(), rids.end(), rid, RidLess);
+	if (it == rids.end() || RidLess(rid, *it)){
+		pfFileHandle.UnpinPage(pageNum);
+		PrintError(IX_ENTRYDNE);
+		return IX_ENTRYDNE;
+	}
+	rids.erase(it);
+
+	// Usual case, page still has rids; dropping one never lengthens the rest
+	if (!rids.empty()){
+		FillPage(pData, &rids[0], rids.size());
+		return ReleasePostingPage(pfFileHandle, pageNum, true);
+	}
+
+	// Emptied the head page: the next page moves into it, so the list
+	// keeps its head page, or the list is gone
+	if (pageNum == headPage){
+		PageNum nextPage = header.nextPage;
+		if (nextPage == IX_NO_PAGE){
+			if (rc = ReleasePostingPage(pfFileHandle, headPage, false))
+				return rc;
+			if (rc = pfFileHandle.DisposePage(headPage)){
+				PrintError(rc);
+				return rc;
+			}
+			empty = true;
+			return OK_RC;
+		}
+
+		char* nextData;
+		if (rc = GetPostingPage(pfFileHandle, nextPage, nextData)){
+			pfFileHandle.UnpinPage(headPage);
+			return rc;
+		}
+		memcpy(pData, nextData, PF_PAGE_SIZE);
+		IX_PostingHeader newHeader;
+		memcpy(&newHeader, pData, sizeof(IX_PostingHeader));
+		newHeader.tailPage = (header.tailPage == nextPage) ? headPage : header.tailPage;
+		memcpy(pData, &newHeader, sizeof(IX_PostingHeader));
+		if (rc = ReleasePostingPage(pfFileHandle, nextPage, false)){
+			pfFileHandle.UnpinPage(headPage);
+			return rc;
+		}
+		if (rc = ReleasePostingPage(pfFileHandle, headPage, true))
+			return rc;
+		if (rc = pfFileHandle.DisposePage(nextPage)){
+			PrintError(rc);
+			return rc;
+		}
+		return OK_RC;
+	}
+
+	// Emptied a later page: unlink it
+	if (rc = ReleasePostingPage(pfFileHandle, pageNum, false))
+		return rc;
+	char* prevData;
+	if (rc = GetPostingPage(pfFileHandle, prevPage, prevData))
+		return rc;
+	IX_PostingHeader prevHeader;
+	memcpy(&prevHeader, prevData, sizeof(IX_PostingHeader));
+	prevHeader.nextPage = header.nextPage;
+	memcpy(prevData, &prevHeader, sizeof(IX_PostingHeader));
+	if (rc = ReleasePostingPage(pfFileHandle, prevPage, true))
+		return rc;
+
+	if (header.nextPage == IX_NO_PAGE && (rc = SetTailPage(pfFileHandle, headPage, prevPage)))
+		return rc;
+	if (rc = pfFileHandle.DisposePage(pageNum)){
+		PrintError(rc);
+		return rc;
+	}
+	return OK_RC;
+}
+
+// An insert latches the head page to change any page of the list, so
+// the list is read whole under a shared latch on it
+RC IX_IndexHandle::ReadPostings(PageNum headPage, RID* &rids, int &numRids) const
+{
+	vector<RID> result;
+	char* headData;
+	RC rc = LatchShared(headPage, headData);
+	if (rc != OK_RC)
+		return rc;
+	PageNum pageNum = headPage;
+	while (pageNum != IX_NO_PAGE){
+		char* pData;
+		if (rc = GetPostingPage(pfFileHandle, pageNum, pData)){
+			ReleaseShared(headPage);
+			return rc;
+		}
+		DecodePage(pData, result);
+		IX_PostingHeader header;
+		memcpy(&header, pData, sizeof(IX_PostingHeader));
+		if (rc = ReleasePostingPage(pfFileHandle, pageNum, false)){
+			ReleaseShared(headPage);
+			return rc;
+		}
+		pageNum = header.nextPage;
+	}
+	if (rc = ReleaseShared(headPage))
+		return rc;
+
+	numRids = result.size();
+	rids = new RID[numRids > 0 ? numRids : 1];
+	for (int i = 0; i < numRids; ++i)
+		rids[i] = result[i];
+	return OK_RC;
+}
+
+int IX_IntersectRids(const RID *one, int numOne, const RID *two, int numTwo, RID *result)
+{
+	int i = 0, j = 0, n = 0;
+	while (i < numOne && j < numTwo){
+		if (RidLess(one[i], two[j]))
+			++i;
+		else if (RidLess(two[j], one[i]))
+			++j;
+		else {
+			result[n++] = one[i];
+			++i;
+			++j;
+		}
+	}
+	return n;
+}
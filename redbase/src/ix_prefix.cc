@@ -0,0 +1,219 @@
+#include <cstring>
+#include <iostream>
+#include "ix.h"
+
+using namespace std;
+
+// Compares a stored suffix of n bytes, none null, with the m bytes of
+// value that follow the node prefix, as strncmp would the whole keys
+static int CompareSuffix(const char* suffix, int n, const char* value, int m)
+{
+	int cmp = strncmp(suffix, value, n);
+	if (cmp != 0 || n >= m)
+		return cmp;
+	return value[n] == 0 ? 0 : -1;
+}
+
+static int RidSize(bool leaf)
+{
+	return leaf ? sizeof(PageNum) + sizeof(SlotNum) : sizeof(PageNum);
+}
+
+int IX_IndexHandle::KeyLength(const char* key) const
+{
+	int n = 0;
+	while (n < ixIndexHeader.attrLength && key[n])
+		++n;
+	return n;
+}
+
+int IX_IndexHandle::CommonPrefix(const char* one, const char* two) const
+{
+	if (!one || !two)
+		return 0;
+	int n = 0;
+	while (n < ixIndexHeader.attrLength && one[n] && one[n] == two[n])
+		++n;
+	return n;
+}
+
+// The first byte where right passes left, and what comes before it
+void IX_IndexHandle::MakeSeparator(const char* left, const char* right, char* separator) const
+{
+	int n = CommonPrefix(left, right) + 1;
+	if (n > KeyLength(right))
+		n = KeyLength(right);
+	memset(separator, 0, ixIndexHeader.attrLength);
+	memcpy(separator, right, n);
+}
+
+char* IX_IndexHandle::NodePrefix(char* pData, bool leaf, int &prefixLen) const
+{
+	int headerSize = leaf ? ixIndexHeader.leafHeaderSize : ixIndexHeader.internalHeaderSize;
+	short len;
+	memcpy(&len, pData + headerSize - IX_PREFIX_LEN_SIZE, IX_PREFIX_LEN_SIZE);
+	prefixLen = len;
+	return pData + headerSize;
+}
+
+char* IX_IndexHandle::CompressedRecord(char* pData, bool leaf, const SlotNum slotNum) const
+{
+	int prefixLen;
+	char* ptr = NodePrefix(pData, leaf, prefixLen) + prefixLen;
+	if (!leaf)
+		ptr += sizeof(PageNum);
+	short offset;
+	memcpy(&offset, ptr + slotNum * IX_OFFSET_SIZE, IX_OFFSET_SIZE);
+	return pData + offset;
+}
+
+// Records are written in key order, so the last one ends the node
+int IX_IndexHandle::CompressedBytes(char* pData, bool leaf) const
+{
+	int num;
+	memcpy(&num, pData, sizeof(int));
+	int prefixLen;
+	char* ptr = NodePrefix(pData, leaf, prefixLen) + prefixLen;
+	if (!leaf)
+		ptr += sizeof(PageNum);
+	if (num == 0)
+		return ptr - pData;
+	char* record = CompressedRecord(pData, leaf, num - 1);
+	return record - pData + 1 + (unsigned char)record[0] + RidSize(leaf);
+}
+
+int IX_IndexHandle::CompressedSize(const char* copyBack, int num, bool leaf, int prefixLen) const
+{
+	int size = leaf ? ixIndexHeader.leafHeaderSize : ixIndexHeader.internalHeaderSize + sizeof(PageNum);
+	size += prefixLen;
+	int stride = ixIndexHeader.attrLength + RidSize(leaf);
+	const char* key = leaf ? copyBack : copyBack + sizeof(PageNum);
+	for (int i = 0; i < num; ++i, key += stride)
+		size += IX_OFFSET_SIZE + 1 + KeyLength(key) - prefixLen + RidSize(leaf);
+	return size;
+}
+
+// Writes num keys or entries from copyBack in the full layout as a
+// compressed node; a leaf keeps its header links
+void IX_IndexHandle::Compress(char* pData, const char* copyBack, int num, bool leaf, const char* prefix, int prefixLen) const
+{
+	char page[PF_PAGE_SIZE];
+	int headerSize = leaf ? ixIndexHeader.leafHeaderSize : ixIndexHeader.internalHeaderSize;
+	int ridSize = RidSize(leaf);
+	memcpy(page, pData, headerSize);
+	memcpy(page, &num, sizeof(int));
+	short len = prefixLen;
+	memcpy(page + headerSize - IX_PREFIX_LEN_SIZE, &len, IX_PREFIX_LEN_SIZE);
+	memcpy(page + headerSize, prefix, prefixLen);
+
+	char* dir = page + headerSize + prefixLen;
+	if (!leaf){
+		memcpy(dir, copyBack, sizeof(PageNum));
+		copyBack += sizeof(PageNum);
+		dir += sizeof(PageNum);
+	}
+	char* ptr = dir + num * IX_OFFSET_SIZE;
+	for (int i = 0; i < num; ++i){
+		short offset = ptr - page;
+		memcpy(dir + i * IX_OFFSET_SIZE, &offset, IX_OFFSET_SIZE);
+		unsigned char suffixLen = KeyLength(copyBack) - prefixLen;
+		*ptr++ = suffixLen;
+		memcpy(ptr, copyBack + prefixLen, suffixLen);
+		ptr += suffixLen;
+		memcpy(ptr, copyBack + ixIndexHeader.attrLength, ridSize);
+		ptr += ridSize;
+		copyBack += ixIndexHeader.attrLength + ridSize;
+	}
+	memcpy(pData, page, ptr - page);
+}
+
+// Counts the keys before attribute, as NodeSearch does for the full layout
+int IX_IndexHandle::CompressedSearch(char* pData, bool leaf, int num, void* attribute, bool upper) const
+{
+	int prefixLen;
+	const char* prefix = NodePrefix(pData, leaf, prefixLen);
+	const char* value = (const char*)attribute;
+	int cmp = strncmp(prefix, value, prefixLen);
+	if (cmp != 0 || num <= 0)
+		return (cmp < 0) ? num : 0;
+
+	value += prefixLen;
+	int valueLen = ixIndexHeader.attrLength - prefixLen;
+	int base = 0;
+	int n = num;
+	while (n > 1){
+		int half = n / 2;
+		const char* record = CompressedRecord(pData, leaf, base + half);
+		cmp = CompareSuffix(record + 1, (unsigned char)record[0], value, valueLen);
+		base = ((cmp < 0) | (upper & (cmp == 0))) ? base + half : base;
+		n -= half;
+	}
+	const char* record = CompressedRecord(pData, leaf, base);
+	cmp = CompareSuffix(record + 1, (unsigned char)record[0], value, valueLen);
+	return base + ((cmp < 0) | (upper & (cmp == 0)));
+}
+
+// Picks the key to push up when splitting numKeys keys, the one leaving
+// the most even halves once each is compressed under its new bounds
+int IX_IndexHandle::SplitKeys(const char* copyBack, int numKeys, const char* lowKey, const char* highKey) const
+{
+	int keySize = ixIndexHeader.attrLength + sizeof(PageNum);
+	const char* keys = copyBack + sizeof(PageNum);
+	int headerSize = ixIndexHeader.internalHeaderSize + sizeof(PageNum);
+	int recordSize = IX_OFFSET_SIZE + 1 + sizeof(PageNum);
+
+	int total = 0;
+	for (int i = 0; i < numKeys; ++i)
+		total += KeyLength(keys + i * keySize);
+
+	int best = numKeys / 2;
+	int bestSize = PF_PAGE_SIZE + 1;
+	int before = 0;
+	for (int m = 0; m < numKeys; ++m){
+		const char* middle = keys + m * keySize;
+		int after = total - before - KeyLength(middle);
+		int leftPrefix = CommonPrefix(lowKey, middle);
+		int rightPrefix = CommonPrefix(middle, highKey);
+		int left = headerSize + leftPrefix + m * (recordSize - leftPrefix) + before;
+		int right = headerSize + rightPrefix + (numKeys - 1 - m) * (recordSize - rightPrefix) + after;
+		int size = left > right ? left : right;
+		if (m > 0 && m < numKeys - 1 && size < bestSize){
+			best = m;
+			bestSize = size;
+		}
+		before += KeyLength(middle);
+	}
+	return best;
+}
+
+// Picks where to split numEntries entries as SplitKeys does, and the
+// shortest separator between the halves
+int IX_IndexHandle::SplitEntries(const char* copyBack, int numEntries, const char* lowKey, const char* highKey, char* separator) const
+{
+	int entrySize = ixIndexHeader.attrLength + sizeof(PageNum) + sizeof(SlotNum);
+	int headerSize = ixIndexHeader.leafHeaderSize;
+	int recordSize = IX_OFFSET_SIZE + 1 + sizeof(PageNum) + sizeof(SlotNum);
+
+	int total = 0;
+	for (int i = 0; i < numEntries; ++i)
+		total += KeyLength(copyBack + i * entrySize);
+
+	int best = numEntries / 2;
+	int bestSize = PF_PAGE_SIZE + 1;
+	int before = KeyLength(copyBack);
+	for (int k = 1; k < numEntries; ++k){
+		MakeSeparator(copyBack + (k - 1) * entrySize, copyBack + k * entrySize, separator);
+		int leftPrefix = CommonPrefix(lowKey, separator);
+		int rightPrefix = CommonPrefix(separator, highKey);
+		int left = headerSize + leftPrefix + k * (recordSize - leftPrefix) + before;
+		int right = headerSize + rightPrefix + (numEntries - k) * (recordSize - rightPrefix) + total - before;
+		int size = left > right ? left : right;
+		if (size < bestSize){
+			best = k;
+			bestSize = size;
+		}
+		before += KeyLength(copyBack + k * entrySize);
+	}
+	MakeSeparator(copyBack + (best - 1) * entrySize, copyBack + best * entrySize, separator);
+	return best;
+}
@@ -0,0 +1,168 @@
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include "ix.h"
+
+using namespace std;
+
+// Orders probe numbers by their keys, ties by probe number
+struct IX_ProbeLess {
+	const IX_IndexHandle* ih;
+	const char* keys;
+	int attrLength;
+	IX_ProbeLess(const IX_IndexHandle* ih, const char* keys, int attrLength): ih(ih), keys(keys), attrLength(attrLength) {}
+	bool operator()(int one, int two) const {
+		int cmp = ih->CompareKey(keys + one * attrLength, keys + two * attrLength);
+		return cmp < 0 || (cmp == 0 && one < two);
+	}
+};
+
+// Each distinct key is looked up once, in key order.  The path of the
+// last descent is kept with the key bounding each of its nodes above, so
+// the next key only climbs back to the lowest node whose bound it is
+// under and descends from there; a run of keys in one leaf pins only it.
+RC IX_IndexHandle::ProbeKeys(const void *keys, int numKeys, IX_ProbeResult* &results, int &numResults) const
+{
+	results = NULL;
+	numResults = 0;
+	if (!open){
+		PrintError(IX_FILENOTOPEN);
+		return IX_FILENOTOPEN;
+	}
+	if (numKeys < 0 || (numKeys > 0 && !keys)){
+		PrintError(IX_NULLINPUT);
+		return IX_NULLINPUT;
+	}
+
+	int attrLength = ixIndexHeader.attrLength;
+	const char* keyData = (const char*)keys;
+	vector<int> order(numKeys);
+	for (int i = 0; i < numKeys; ++i)
+		order[i] = i;
+	sort(order.begin(), order.end(), IX_ProbeLess(this, keyData, attrLength));
+
+	// A tree is probed under the index latch, other indexes by GetRids
+	RC rc;
+	bool tree = (ixIndexHeader.indexType == BTREE_INDEX);
+	if (tree && (rc = LatchIndex(PF_SHARED)))
+		return rc;
+	rc = ProbeSorted(keyData, numKeys > 0 ? &order[0] : NULL, numKeys, results, numResults);
+	if (!tree)
+		return rc;
+	RC latchRC = UnlatchIndex(PF_SHARED);
+	return (rc != OK_RC) ? rc : latchRC;
+}
+
+// Inner nodes are read as validated copies, leaves under a shared latch
+RC IX_IndexHandle::ProbeSorted(const char* keyData, const int* order, int numKeys, IX_ProbeResult* &results, int &numResults) const
+{
+	// Level 0 is the root, level height the leaf
+	int attrLength = ixIndexHeader.attrLength;
+	int height = ixIndexHeader.height;
+	vector<PageNum> pathPages(height + 1, IX_NO_PAGE);
+	vector<char> pathBounds((height + 1) * attrLength);
+	vector<bool> bounded(height + 1, false);
+	pathPages[0] = ixIndexHeader.rootPage;
+	int depth = 0;          // deepest level of the path descended
+	vector<char> node(PF_PAGE_SIZE);
+
+	vector<IX_ProbeResult> found;
+	RC rc;
+	for (int i = 0; i < numKeys; ){
+		char* key = (char*)keyData + order[i] * attrLength;
+		int next = i + 1;
+		while (next < numKeys && CompareKey(keyData + order[next] * attrLength, key) == 0)
+			++next;
+
+		// A key the Bloom filter rules out has no rids, and no descent
+		bool mayContain;
+		if (rc = BloomProbe(key, mayContain))
+			return rc;
+		if (!mayContain){
+			i = next;
+			continue;
+		}
+
+		RID* rids = NULL;
+		int numRids = 0;
+		if (ixIndexHeader.indexType != BTREE_INDEX){
+			if (rc = GetRids(key, rids, numRids))
+				return rc;
+		}
+		else {
+			// Climb to the lowest node the key is still under, then descend
+			while (depth > 0 && bounded[depth] && CompareKey(&pathBounds[depth * attrLength], key) <= 0)
+				--depth;
+			for (; depth < height; ++depth){
+				char* pData = &node[0];
+				if (rc = ReadNode(pathPages[depth], pData))
+					return rc;
+				int nodeKeys;
+				memcpy(&nodeKeys, pData, sizeof(int));
+				int keyNum = UpperBoundKey(pData, nodeKeys, key);
+				pathPages[depth + 1] = GetChildPage(pData, keyNum);
+				bounded[depth + 1] = (keyNum < nodeKeys) || bounded[depth];
+				if (keyNum < nodeKeys)
+					GetKey(pData, keyNum, &pathBounds[(depth + 1) * attrLength]);
+				else if (bounded[depth])
+					memcpy(&pathBounds[(depth + 1) * attrLength], &pathBounds[depth * attrLength], attrLength);
+			}
+
+			// Find the key's entry in the leaf, or a leaf right of it that
+			// a split moved the key to since its parent was read
+			PageNum leaf = pathPages[height];
+			char* pData;
+			if ((rc = LatchShared(leaf, pData)) ||
+				(rc = MoveRight(leaf, pData, key)))
+				return rc;
+			int numEntries;
+			memcpy(&numEntries, pData, sizeof(int));
+			SlotNum keySlot = -1;
+			if (LeafIsCompact(pData, numEntries)){
+				if (!FindKeyInLeaf(pData, numEntries, key, keySlot))
+					keySlot = -1;
+			}
+			else {
+				char entry[MAXSTRINGLEN + sizeof(PageNum) + sizeof(SlotNum)];
+				for (SlotNum j = 0; keySlot == -1 && j <= ixIndexHeader.maxEntryIndex; ++j)
+					if (GetSlotBitValue(pData, j) && CompareKey(GetEntry(pData, j, entry), key) == 0)
+						keySlot = j;
+			}
+			RID rid;
+			if (keySlot != -1){
+				char* ptr = GetEntryRid(pData, keySlot);
+				memcpy(&rid.pageNum, ptr, sizeof(PageNum));
+				memcpy(&rid.slotNum, ptr + sizeof(PageNum), sizeof(SlotNum));
+			}
+			if (rc = ReleaseShared(leaf))
+				return rc;
+			if (keySlot != -1 && rid.slotNum == IX_POSTING_SLOT){
+				if (rc = ReadPostings(rid.pageNum, rids, numRids))
+					return rc;
+			}
+			else if (keySlot != -1){
+				rids = new RID[1];
+				rids[0] = rid;
+				numRids = 1;
+			}
+		}
+
+		// Every probe of the key gets its rids
+		for (int j = i; j < next; ++j)
+			for (int k = 0; k < numRids; ++k){
+				IX_ProbeResult result;
+				result.probe = order[j];
+				result.rid = rids[k];
+				found.push_back(result);
+			}
+		delete [] rids;
+		i = next;
+	}
+
+	numResults = found.size();
+	results = new IX_ProbeResult[numResults > 0 ? numResults : 1];
+	for (int i = 0; i < numResults; ++i)
+		results[i] = found[i];
+	return OK_RC;
+}
@@ -0,0 +1,828 @@
+#include <cstring>
+#include <vector>
+#include "ix.h"
+
+using namespace std;
+
+// Adaptive radix tree (see ix.h).  An inner node branches on one byte of
+// the key, after a compressed path of bytes that every key below it
+// shares, and takes one of four sizes as children come and go: 4 and 16
+// children behind sorted arrays of their bytes, 48 behind a 256 byte
+// index, and 256 indexed directly by byte.  A node left with one child
+// is merged into it.  Keys all have attrLength bytes, so none is a prefix
+// of another and each ends at a leaf holding the whole key and its rids.
+// snapshot: header page attrType attrLength numKeys numRids,
+//           then pages of numEntries {key page slot} ... in key order
+
+#define RADIX_LEAF 0
+
+struct IX_RadixNode {
+	int kind;               // RADIX_LEAF, or the most children: 4, 16, 48 or 256
+	int numChildren;
+	int prefixLen;
+	unsigned char* prefix;  // bytes every key below shares, before the branch byte
+};
+struct RadixNode4 : IX_RadixNode {
+	unsigned char keys[4];
+	IX_RadixNode* children[4];
+};
+struct RadixNode16 : IX_RadixNode {
+	unsigned char keys[16];
+	IX_RadixNode* children[16];
+};
+struct RadixNode48 : IX_RadixNode {
+	unsigned char index[256];  // 0 if no child, else its slot + 1
+	IX_RadixNode* children[48];
+};
+struct RadixNode256 : IX_RadixNode {
+	IX_RadixNode* children[256];
+};
+struct RadixLeaf : IX_RadixNode {
+	unsigned char* key;
+	vector<RID> rids;
+};
+
+static bool SameRid(const RID &one, const RID &two)
+{
+	PageNum onePage, twoPage;
+	SlotNum oneSlot, twoSlot;
+	one.GetPageNum(onePage);
+	one.GetSlotNum(oneSlot);
+	two.GetPageNum(twoPage);
+	two.GetSlotNum(twoSlot);
+	return onePage == twoPage && oneSlot == twoSlot;
+}
+
+static IX_RadixNode* NewNode(int kind)
+{
+	IX_RadixNode* node;
+	switch (kind) {
+	case 4:
+		node = new RadixNode4;
+		break;
+	case 16:
+		node = new RadixNode16;
+		break;
+	case 48:
+		node = new RadixNode48;
+		memset(((RadixNode48*)node)->index, 0, 256);
+		break;
+	default:
+		node = new RadixNode256;
+		memset(((RadixNode256*)node)->children, 0, sizeof(((RadixNode256*)node)->children));
+		break;
+	}
+	node->kind = kind;
+	node->numChildren = 0;
+	node->prefixLen = 0;
+	node->prefix = NULL;
+	return node;
+}
+
+static IX_RadixNode* NewLeaf(const unsigned char* key, int keyLen, const RID &rid)
+{
+	RadixLeaf* leaf = new RadixLeaf;
+	leaf->kind = RADIX_LEAF;
+	leaf->numChildren = 0;
+	leaf->prefixLen = 0;
+	leaf->prefix = NULL;
+	leaf->key = new unsigned char[keyLen];
+	memcpy(leaf->key, key, keyLen);
+	leaf->rids.push_back(rid);
+	return leaf;
+}
+
+// Frees node alone, not its children
+static void DeleteNode(IX_RadixNode* node)
+{
+	delete [] node->prefix;
+	switch (node->kind) {
+	case RADIX_LEAF:
+		delete [] ((RadixLeaf*)node)->key;
+		delete (RadixLeaf*)node;
+		break;
+	case 4:
+		delete (RadixNode4*)node;
+		break;
+	case 16:
+		delete (RadixNode16*)node;
+		break;
+	case 48:
+		delete (RadixNode48*)node;
+		break;
+	default:
+		delete (RadixNode256*)node;
+		break;
+	}
+}
+
+// Children in byte order, with their bytes; returns how many
+static int GetChildren(const IX_RadixNode* node, unsigned char* bytes, IX_RadixNode** children)
+{
+	int n = 0;
+	switch (node->kind) {
+	case 4:
+		memcpy(bytes, ((RadixNode4*)node)->keys, node->numChildren);
+		memcpy(children, ((RadixNode4*)node)->children, node->numChildren * sizeof(IX_RadixNode*));
+		return node->numChildren;
+	case 16:
+		memcpy(bytes, ((RadixNode16*)node)->keys, node->numChildren);
+		memcpy(children, ((RadixNode16*)node)->children, node->numChildren * sizeof(IX_RadixNode*));
+		return node->numChildren;
+	case 48:
+		for (int b = 0; b < 256; ++b)
+			if (((RadixNode48*)node)->index[b]){
+				bytes[n] = (unsigned char)b;
+				children[n++] = ((RadixNode48*)node)->children[((RadixNode48*)node)->index[b] - 1];
+			}
+		return n;
+	default:
+		for (int b = 0; b < 256; ++b)
+			if (((RadixNode256*)node)->children[b]){
+				bytes[n] = (unsigned char)b;
+				children[n++] = ((RadixNode256*)node)->children[b];
+			}
+		return n;
+	}
+}
+
+static void FreeTree(IX_RadixNode* node)
+{
+	if (!node)
+		return;
+	if (node->kind != RADIX_LEAF){
+		unsigned char bytes[256];
+		IX_RadixNode* children[256];
+		int n = GetChildren(node, bytes, children);
+		for (int i = 0; i < n; ++i)
+			FreeTree(children[i]);
+	}
+	DeleteNode(node);
+}
+
+static void SetPrefix(IX_RadixNode* node, const unsigned char* bytes, int len)
+{
+	unsigned char* prefix = NULL;
+	if (len > 0){
+		prefix = new unsigned char[len];
+		memcpy(prefix, bytes, len);
+	}
+	delete [] node->prefix;
+	node->prefix = prefix;
+	node->prefixLen = len;
+}
+
+static IX_RadixNode** FindChild(IX_RadixNode* node, unsigned char byte)
+{
+	switch (node->kind) {
+	case 4:
+		for (int i = 0; i < node->numChildren; ++i)
+			if (((RadixNode4*)node)->keys[i] == byte)
+				return &((RadixNode4*)node)->children[i];
+		return NULL;
+	case 16:
+		for (int i = 0; i < node->numChildren; ++i)
+			if (((RadixNode16*)node)->keys[i] == byte)
+				return &((RadixNode16*)node)->children[i];
+		return NULL;
+	case 48:
+		if (((RadixNode48*)node)->index[byte] == 0)
+			return NULL;
+		return &((RadixNode48*)node)->children[((RadixNode48*)node)->index[byte] - 1];
+	default:
+		if (((RadixNode256*)node)->children[byte] == NULL)
+			return NULL;
+		return &((RadixNode256*)node)->children[byte];
+	}
+}
+
+// Moves node's children into a new node of kind, which replaces it
+static void Resize(IX_RadixNode* &ref, int kind)
+{
+	IX_RadixNode* node = ref;
+	IX_RadixNode* resized = NewNode(kind);
+	resized->prefix = node->prefix;
+	resized->prefixLen = node->prefixLen;
+	node->prefix = NULL;
+
+	unsigned char bytes[256];
+	IX_RadixNode* children[256];
+	int n = GetChildren(node, bytes, children);
+	resized->numChildren = n;
+	for (int i = 0; i < n; ++i){
+		switch (kind) {
+		case 4:
+			((RadixNode4*)resized)->keys[i] = bytes[i];
+			((RadixNode4*)resized)->children[i] = children[i];
+			break;
+		case 16:
+			((RadixNode16*)resized)->keys[i] = bytes[i];
+			((RadixNode16*)resized)->children[i] = children[i];
+			break;
+		case 48:
+			((RadixNode48*)resized)->index[bytes[i]] = i + 1;
+			((RadixNode48*)resized)->children[i] = children[i];
+			break;
+		default:
+			((RadixNode256*)resized)->children[bytes[i]] = children[i];
+			break;
+		}
+	}
+	DeleteNode(node);
+	ref = resized;
+}
+
+// Adds child under byte, which node does not have, growing node if full
+static void AddChild(IX_RadixNode* &ref, unsigned char byte, IX_RadixNode* child)
+{
+	IX_RadixNode* node = ref;
+	if (node->numChildren == node->kind)
+		Resize(ref, node->kind == 4 ? 16 : (node->kind == 16 ? 48 : 256));
+	node = ref;
+
+	unsigned char* keys = NULL;
+	IX_RadixNode** children = NULL;
+	switch (node->kind) {
+	case 4:
+		keys = ((RadixNode4*)node)->keys;
+		children = ((RadixNode4*)node)->children;
+		break;
+	case 16:
+		keys = ((RadixNode16*)node)->keys;
+		children = ((RadixNode16*)node)->children;
+		break;
+	case 48:
+		((RadixNode48*)node)->children[node->numChildren] = child;
+		((RadixNode48*)node)->index[byte] = node->numChildren + 1;
+		++node->numChildren;
+		return;
+	default:
+		((RadixNode256*)node)->children[byte] = child;
+		++node->numChildren;
+		return;
+	}
+	int pos = node->numChildren;
+	while (pos > 0 && keys[pos - 1] > byte){
+		keys[pos] = keys[pos - 1];
+		children[pos] = children[pos - 1];
+		--pos;
+	}
+	keys[pos] = byte;
+	children[pos] = child;
+	++node->numChildren;
+}
+
+// Removes the child under byte, shrinking node once it would fit a
+// smaller kind, or merging it into its only child
+static void RemoveChild(IX_RadixNode* &ref, unsigned char byte)
+{
+	IX_RadixNode* node = ref;
+	switch (node->kind) {
+	case 4:
+	case 16:
+		{
+			unsigned char* keys = (node->kind == 4) ? ((RadixNode4*)node)->keys : ((RadixNode16*)node)->keys;
+			IX_RadixNode** children = (node->kind == 4) ? ((RadixNode4*)node)->children : ((RadixNode16*)node)->children;
+			int pos = 0;
+			while (keys[pos] != byte)
+				++pos;
+			for (; pos < node->numChildren - 1; ++pos){
+				keys[pos] = keys[pos + 1];
+				children[pos] = children[pos + 1];
+			}
+			--node->numChildren;
+		}
+		break;
+	case 48:
+		{
+			RadixNode48* node48 = (RadixNode48*)node;
+			int slot = node48->index[byte] - 1;
+			int last = node->numChildren - 1;
+			node48->index[byte] = 0;
+			if (slot != last){
+				node48->children[slot] = node48->children[last];
+				for (int b = 0; b < 256; ++b)
+					if (node48->index[b] == last + 1)
+						node48->index[b] = slot + 1;
+			}
+			--node->numChildren;
+		}
+		break;
+	default:
+		((RadixNode256*)node)->children[byte] = NULL;
+		--node->numChildren;
+		break;
+	}
+
+	if (node->kind == 256 && node->numChildren <= 36)
+		Resize(ref, 48);
+	else if (node->kind == 48 && node->numChildren <= 12)
+		Resize(ref, 16);
+	else if (node->kind == 16 && node->numChildren <= 3)
+		Resize(ref, 4);
+	else if (node->kind == 4 && node->numChildren == 1){
+		// The path to the child takes in this node's prefix and branch byte
+		IX_RadixNode* child = ((RadixNode4*)node)->children[0];
+		if (child->kind != RADIX_LEAF){
+			int len = node->prefixLen + 1 + child->prefixLen;
+			unsigned char* path = new unsigned char[len];
+			if (node->prefixLen > 0)
+				memcpy(path, node->prefix, node->prefixLen);
+			path[node->prefixLen] = ((RadixNode4*)node)->keys[0];
+			if (child->prefixLen > 0)
+				memcpy(path + node->prefixLen + 1, child->prefix, child->prefixLen);
+			SetPrefix(child, path, len);
+			delete [] path;
+		}
+		DeleteNode(node);
+		ref = child;
+	}
+}
+
+// Adds rid under key, below ref at depth bytes in; true if key is new
+static bool InsertKey(IX_RadixNode* &ref, const unsigned char* key, int keyLen, int depth, const RID &rid)
+{
+	IX_RadixNode* node = ref;
+	if (!node){
+		ref = NewLeaf(key, keyLen, rid);
+		return true;
+	}
+
+	if (node->kind == RADIX_LEAF){
+		RadixLeaf* leaf = (RadixLeaf*)node;
+		if (memcmp(leaf->key + depth, key + depth, keyLen - depth) == 0){
+			leaf->rids.push_back(rid);
+			return false;
+		}
+		// Branch where the two keys first differ
+		int p = depth;
+		while (leaf->key[p] == key[p])
+			++p;
+		IX_RadixNode* inner = NewNode(4);
+		SetPrefix(inner, key + depth, p - depth);
+		AddChild(inner, leaf->key[p], leaf);
+		AddChild(inner, key[p], NewLeaf(key, keyLen, rid));
+		ref = inner;
+		return true;
+	}
+
+	// Branch where the key leaves node's path
+	int p = 0;
+	while (p < node->prefixLen && node->prefix[p] == key[depth + p])
+		++p;
+	if (p < node->prefixLen){
+		IX_RadixNode* inner = NewNode(4);
+		SetPrefix(inner, node->prefix, p);
+		unsigned char branch = node->prefix[p];
+		SetPrefix(node, node->prefix + p + 1, node->prefixLen - p - 1);
+		AddChild(inner, branch, node);
+		AddChild(inner, key[depth + p], NewLeaf(key, keyLen, rid));
+		ref = inner;
+		return true;
+	}
+
+	depth += node->prefixLen;
+	IX_RadixNode** child = FindChild(node, key[depth]);
+	if (child)
+		return InsertKey(*child, key, keyLen, depth + 1, rid);
+	AddChild(ref, key[depth], NewLeaf(key, keyLen, rid));
+	return true;
+}
+
+// Removes rid from key, below ref at depth bytes in; false if it is not
+// there.  keyGone is set once the key has no rids left
+static bool DeleteKey(IX_RadixNode* &ref, const unsigned char* key, int keyLen, int depth, const RID &rid, bool &keyGone)
+{
+	IX_RadixNode* node = ref;
+	if (!node)
+		return false;
+
+	if (node->kind == RADIX_LEAF){
+		RadixLeaf* leaf = (RadixLeaf*)node;
+		if (memcmp(leaf->key, key, keyLen) != 0)
+			return false;
+		int i = 0;
+		while (i < (int)leaf->rids.size() && !SameRid(leaf->rids[i], rid))
+			++i;
+		if (i == (int)leaf->rids.size())
+			return false;
+		leaf->rids.erase(leaf->rids.begin() + i);
+		if (leaf->rids.empty()){
+			DeleteNode(leaf);
+			ref = NULL;
+			keyGone = true;
+		}
+		return true;
+	}
+
+	if (node->prefixLen > 0 && memcmp(node->prefix, key + depth, node->prefixLen) != 0)
+		return false;
+	depth += node->prefixLen;
+	unsigned char byte = key[depth];
+	IX_RadixNode** child = FindChild(node, byte);
+	if (!child || !DeleteKey(*child, key, keyLen, depth + 1, rid, keyGone))
+		return false;
+	if (*child == NULL)
+		RemoveChild(ref, byte);
+	return true;
+}
+
+// Appends the rids of the keys below node within low..high, a NULL bound
+// leaving that side open, in key order.  path holds the depth bytes
+// leading to node.  Returns false once past high
+static bool CollectRange(const IX_RadixNode* node, unsigned char* path, int depth, int keyLen,
+	const unsigned char* low, bool lowInclusive, const unsigned char* high, bool highInclusive,
+	vector<RID> &rids)
+{
+	if (node->kind == RADIX_LEAF){
+		const RadixLeaf* leaf = (const RadixLeaf*)node;
+		int lowCmp = low ? memcmp(leaf->key, low, keyLen) : 1;
+		int highCmp = high ? memcmp(leaf->key, high, keyLen) : -1;
+		if (highCmp > 0 || (highCmp == 0 && !highInclusive))
+			return false;
+		if (lowCmp > 0 || (lowCmp == 0 && lowInclusive))
+			rids.insert(rids.end(), leaf->rids.begin(), leaf->rids.end());
+		return true;
+	}
+
+	// Every key below shares path, so is below low or past high with it
+	if (node->prefixLen > 0)
+		memcpy(path + depth, node->prefix, node->prefixLen);
+	depth += node->prefixLen;
+	if (low && memcmp(path, low, depth) < 0)
+		return true;
+	if (high && memcmp(path, high, depth) > 0)
+		return false;
+
+	unsigned char bytes[256];
+	IX_RadixNode* children[256];
+	int n = GetChildren(node, bytes, children);
+	for (int i = 0; i < n; ++i){
+		path[depth] = bytes[i];
+		if (low && memcmp(path, low, depth + 1) < 0)
+			continue;
+		if (!CollectRange(children[i], path, depth + 1, keyLen, low, lowInclusive, high, highInclusive, rids))
+			return false;
+	}
+	return true;
+}
+
+// Every leaf below node, in key order
+static void CollectLeaves(const IX_RadixNode* node, vector<const RadixLeaf*> &leaves)
+{
+	if (node->kind == RADIX_LEAF){
+		leaves.push_back((const RadixLeaf*)node);
+		return;
+	}
+	unsigned char bytes[256];
+	IX_RadixNode* children[256];
+	int n = GetChildren(node, bytes, children);
+	for (int i = 0; i < n; ++i)
+		CollectLeaves(children[i], leaves);
+}
+
+IX_RadixIndex::IX_RadixIndex()
+{
+	open = false;
+	attrType = INT;
+	attrLength = 0;
+	numKeys = 0;
+	numRids = 0;
+	root = NULL;
+}
+
+IX_RadixIndex::~IX_RadixIndex()
+{
+	FreeTree(root);
+}
+
+RC IX_RadixIndex::Init(AttrType attrType, int attrLength)
+{
+	// Check input
+	if (attrType != INT && attrType != FLOAT && attrType != STRING){
+		PrintError(IX_INVALIDENUM);
+		return IX_INVALIDENUM;
+	}
+	if ((attrType == INT || attrType == FLOAT) && attrLength != 4){
+		PrintError(IX_NUMLEN);
+		return IX_NUMLEN;
+	}
+	if (attrType == STRING && (attrLength < 1 || attrLength > MAXSTRINGLEN)){
+		PrintError(IX_STRLEN);
+		return IX_STRLEN;
+	}
+	// End check input
+
+	FreeTree(root);
+	root = NULL;
+	this->attrType = attrType;
+	this->attrLength = attrLength;
+	numKeys = 0;
+	numRids = 0;
+	open = true;
+	return OK_RC;
+}
+
+// Encoded as a composite key attribute is (see IX_IndexHandle::EncodeKey)
+void IX_RadixIndex::EncodeKey(const void* attribute, unsigned char* key) const
+{
+	unsigned int bits;
+	switch (attrType) {
+	case INT:
+		memcpy(&bits, attribute, sizeof(int));
+		bits ^= 0x80000000u;
+		break;
+	case FLOAT:
+		memcpy(&bits, attribute, sizeof(float));
+		if (bits == 0x80000000u)
+			bits = 0; // -0 equals 0
+		bits = (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+		break;
+	default:
+		// Null padded past the string's end, whatever the value held there
+		strncpy((char*)key, (const char*)attribute, attrLength);
+		return;
+	}
+	for (int b = 0; b < 4; ++b)
+		key[b] = (unsigned char)(bits >> (24 - 8 * b));
+}
+
+RC IX_RadixIndex::InsertEntry(void *attribute, const RID &rid)
+{
+	if (!open){
+		PrintError(IX_FILENOTOPEN);
+		return IX_FILENOTOPEN;
+	}
+	if (!attribute){
+		PrintError(IX_NULLINPUT);
+		return IX_NULLINPUT;
+	}
+
+	unsigned char key[MAXSTRINGLEN];
+	EncodeKey(attribute, key);
+	if (InsertKey(root, key, attrLength, 0, rid))
+		++numKeys;
+	++numRids;
+	return OK_RC;
+}
+
+RC IX_RadixIndex::DeleteEntry(void *attribute, const RID &rid)
+{
+	if (!open){
+		PrintError(IX_FILENOTOPEN);
+		return IX_FILENOTOPEN;
+	}
+	if (!attribute){
+		PrintError(IX_NULLINPUT);
+		return IX_NULLINPUT;
+	}
+
+	unsigned char key[MAXSTRINGLEN];
+	EncodeKey(attribute, key);
+	bool keyGone = false;
+	if (!DeleteKey(root, key, attrLength, 0, rid, keyGone)){
+		PrintError(IX_ENTRYDNE);
+		return IX_ENTRYDNE;
+	}
+	if (keyGone)
+		--numKeys;
+	--numRids;
+	return OK_RC;
+}
+
+RC IX_RadixIndex::GetRids(void *attribute, const RID* &rids, int &numRids) const
+{
+	rids = NULL;
+	numRids = 0;
+	if (!open){
+		PrintError(IX_FILENOTOPEN);
+		return IX_FILENOTOPEN;
+	}
+	if (!attribute){
+		PrintError(IX_NULLINPUT);
+		return IX_NULLINPUT;
+	}
+
+	unsigned char key[MAXSTRINGLEN];
+	EncodeKey(attribute, key);
+	const IX_RadixNode* node = root;
+	int depth = 0;
+	while (node && node->kind != RADIX_LEAF){
+		if (node->prefixLen > 0 && memcmp(node->prefix, key + depth, node->prefixLen) != 0)
+			return OK_RC;
+		depth += node->prefixLen;
+		IX_RadixNode** child = FindChild((IX_RadixNode*)node, key[depth]);
+		if (!child)
+			return OK_RC;
+		node = *child;
+		++depth;
+	}
+	if (node && memcmp(((const RadixLeaf*)node)->key, key, attrLength) == 0){
+		rids = &((const RadixLeaf*)node)->rids[0];
+		numRids = ((const RadixLeaf*)node)->rids.size();
+	}
+	return OK_RC;
+}
+
+// Not equal is the keys below value, then those above it
+RC IX_RadixIndex::GetRange(CompOp compOp, void *value, RID* &rids, int &numRids) const
+{
+	rids = NULL;
+	numRids = 0;
+	if (!open){
+		PrintError(IX_FILENOTOPEN);
+		return IX_FILENOTOPEN;
+	}
+	if ((compOp == NO_OP) != (value == NULL)){
+		PrintError(IX_INVALIDSCANCOMBO);
+		return IX_INVALIDSCANCOMBO;
+	}
+
+	unsigned char key[MAXSTRINGLEN], path[MAXSTRINGLEN];
+	if (value)
+		EncodeKey(value, key);
+	vector<RID> found;
+	if (root){
+		switch (compOp) {
+		case EQ_OP:
+			CollectRange(root, path, 0, attrLength, key, true, key, true, found);
+			break;
+		case LT_OP:
+		case LE_OP:
+			CollectRange(root, path, 0, attrLength, NULL, false, key, compOp == LE_OP, found);
+			break;
+		case GT_OP:
+		case GE_OP:
+			CollectRange(root, path, 0, attrLength, key, compOp == GE_OP, NULL, false, found);
+			break;
+		case NE_OP:
+			CollectRange(root, path, 0, attrLength, NULL, false, key, false, found);
+			CollectRange(root, path, 0, attrLength, key, false, NULL, false, found);
+			break;
+		default:
+			CollectRange(root, path, 0, attrLength, NULL, false, NULL, false, found);
+			break;
+		}
+	}
+
+	numRids = found.size();
+	rids = new RID[numRids > 0 ? numRids : 1];
+	for (int i = 0; i < numRids; ++i)
+		rids[i] = found[i];
+	return OK_RC;
+}
+
+RC IX_RadixIndex::SaveSnapshot(PF_Manager &pfm, const char *fileName) const
+{
+	if (!open){
+		PrintError(IX_FILENOTOPEN);
+		return IX_FILENOTOPEN;
+	}
+	if (!fileName){
+		PrintError(IX_NULLINPUT);
+		return IX_NULLINPUT;
+	}
+
+	RC rc;
+	PF_FileHandle fileHandle;
+	PF_PageHandle pageHandle;
+	PageNum pageNum;
+	char* pData;
+	if ((rc = pfm.CreateFile(fileName)) ||
+		(rc = pfm.OpenFile(fileName, fileHandle))){
+		PrintError(rc);
+		return rc;
+	}
+
+	// Header page
+	if ((rc = fileHandle.AllocatePage(pageHandle)) ||
+		(rc = pageHandle.GetPageNum(pageNum)) ||
+		(rc = pageHandle.GetData(pData))){
+		PrintError(rc);
+		pfm.CloseFile(fileHandle);
+		return rc;
+	}
+	int header[4] = { attrType, attrLength, numKeys, numRids };
+	memcpy(pData, header, sizeof(header));
+	if ((rc = fileHandle.MarkDirty(pageNum)) ||
+		(rc = fileHandle.UnpinPage(pageNum))){
+		PrintError(rc);
+		pfm.CloseFile(fileHandle);
+		return rc;
+	}
+
+	// Entries, as many to a page as fit
+	vector<const RadixLeaf*> leaves;
+	if (root)
+		CollectLeaves(root, leaves);
+	int entrySize = attrLength + sizeof(PageNum) + sizeof(SlotNum);
+	int perPage = (PF_PAGE_SIZE - sizeof(int)) / entrySize;
+	int numEntries = 0;
+	bool pinned = false;
+	for (int i = 0; i < (int)leaves.size() && rc == OK_RC; ++i){
+		for (int j = 0; j < (int)leaves[i]->rids.size(); ++j){
+			if (pinned && numEntries == perPage){
+				if ((rc = fileHandle.MarkDirty(pageNum)) ||
+					(rc = fileHandle.UnpinPage(pageNum)))
+					break;
+				pinned = false;
+			}
+			if (!pinned){
+				if ((rc = fileHandle.AllocatePage(pageHandle)) ||
+					(rc = pageHandle.GetPageNum(pageNum)) ||
+					(rc = pageHandle.GetData(pData)))
+					break;
+				pinned = true;
+				numEntries = 0;
+			}
+			char* entry = pData + sizeof(int) + numEntries * entrySize;
+			PageNum ridPage;
+			SlotNum ridSlot;
+			leaves[i]->rids[j].GetPageNum(ridPage);
+			leaves[i]->rids[j].GetSlotNum(ridSlot);
+			memcpy(entry, leaves[i]->key, attrLength);
+			memcpy(entry + attrLength, &ridPage, sizeof(PageNum));
+			memcpy(entry + attrLength + sizeof(PageNum), &ridSlot, sizeof(SlotNum));
+			++numEntries;
+			memcpy(pData, &numEntries, sizeof(int));
+		}
+	}
+	if (rc == OK_RC && pinned && (rc = fileHandle.MarkDirty(pageNum)) == OK_RC)
+		rc = fileHandle.UnpinPage(pageNum);
+	else if (pinned)
+		fileHandle.UnpinPage(pageNum);
+	if (rc != OK_RC){
+		PrintError(rc);
+		pfm.CloseFile(fileHandle);
+		return rc;
+	}
+	if (rc = pfm.CloseFile(fileHandle)){
+		PrintError(rc);
+		return rc;
+	}
+	return OK_RC;
+}
+
+RC IX_RadixIndex::LoadSnapshot(PF_Manager &pfm, const char *fileName)
+{
+	if (!fileName){
+		PrintError(IX_NULLINPUT);
+		return IX_NULLINPUT;
+	}
+
+	RC rc;
+	PF_FileHandle fileHandle;
+	PF_PageHandle pageHandle;
+	PageNum pageNum;
+	char* pData;
+	if (rc = pfm.OpenFile(fileName, fileHandle)){
+		PrintError(rc);
+		return rc;
+	}
+	if ((rc = fileHandle.GetThisPage(0, pageHandle)) ||
+		(rc = pageHandle.GetData(pData))){
+		PrintError(rc);
+		pfm.CloseFile(fileHandle);
+		return rc;
+	}
+	int header[4];
+	memcpy(header, pData, sizeof(header));
+	if ((rc = fileHandle.UnpinPage(0)) ||
+		(rc = Init((AttrType)header[0], header[1]))){
+		pfm.CloseFile(fileHandle);
+		return rc;
+	}
+
+	// Entries are in key order, so a key's rids are added in the order saved
+	int entrySize = attrLength + sizeof(PageNum) + sizeof(SlotNum);
+	pageNum = 0;
+	while ((rc = fileHandle.GetNextPage(pageNum, pageHandle)) == OK_RC){
+		if ((rc = pageHandle.GetPageNum(pageNum)) ||
+			(rc = pageHandle.GetData(pData)))
+			break;
+		int numEntries;
+		memcpy(&numEntries, pData, sizeof(int));
+		for (int i = 0; i < numEntries; ++i){
+			const char* entry = pData + sizeof(int) + i * entrySize;
+			PageNum ridPage;
+			SlotNum ridSlot;
+			memcpy(&ridPage, entry + attrLength, sizeof(PageNum));
+			memcpy(&ridSlot, entry + attrLength + sizeof(PageNum), sizeof(SlotNum));
+			if (InsertKey(root, (const unsigned char*)entry, attrLength, 0, RID(ridPage, ridSlot)))
+				++numKeys;
+			++numRids;
+		}
+		if (rc = fileHandle.UnpinPage(pageNum))
+			break;
+	}
+	if (rc != PF_EOF){
+		PrintError(rc);
+		pfm.CloseFile(fileHandle);
+		return rc;
+	}
+	if (rc = pfm.CloseFile(fileHandle)){
+		PrintError(rc);
+		return rc;
+	}
+	return OK_RC;
+}
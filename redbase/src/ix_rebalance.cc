@@ -0,0 +1,402 @@
+#include <cstring>
+#include <iostream>
+#include "ix.h"
+
+using namespace std;
+
+// A node is underfull below mergePercent of its page, counted in slots for
+// the full layout and in bytes for compressed nodes
+bool IX_IndexHandle::Underfull(char* pData, bool leaf) const
+{
+	int num;
+	memcpy(&num, pData, sizeof(int));
+	if (ixIndexHeader.compressed)
+		return CompressedBytes(pData, leaf) * 100 < mergePercent * PF_PAGE_SIZE;
+	if (leaf)
+		return num * 100 < mergePercent * (ixIndexHeader.maxEntryIndex + 1);
+	return (num + 1) * 100 < mergePercent * (ixIndexHeader.maxKeyIndex + 2);
+}
+
+// Called on an internal node once a delete below it returns: if the child
+// at childNum fell below mergePercent, it is merged with the sibling to its
+// right (its left for the last child), or the two share their keys evenly
+// when they do not fit in one page.  lowKey and highKey bound the node.
+RC IX_IndexHandle::RebalanceChild(PageNum currPage, char* pData, int childHeight, SlotNum childNum, int &numKeys,
+	const char* lowKey, const char* highKey)
+{
+	// Merges move entries, so they wait while a scan could be on them
+	if (mergePercent == 0 || openScans > 0 || numKeys == 0)
+		return OK_RC;
+
+	bool leaf = (childHeight == 0);
+	PageNum childPage = GetChildPage(pData, childNum);
+	char *childPData;
+	PF_PageHandle pfPageHandle;
+	RC rc = pfFileHandle.GetThisPage(childPage, pfPageHandle);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	rc = pfPageHandle.GetData(childPData);
+	if (rc != OK_RC){
+		pfFileHandle.UnpinPage(childPage);
+		PrintError(rc);
+		return rc;
+	}
+	bool underfull = Underfull(childPData, leaf);
+	rc = pfFileHandle.UnpinPage(childPage);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	if (!underfull)
+		return OK_RC;
+
+	// Pin the pair, left then right
+	SlotNum leftNum = (childNum < numKeys) ? childNum : childNum - 1;
+	PageNum pages[2] = { GetChildPage(pData, leftNum), GetChildPage(pData, leftNum + 1) };
+	char* data[2];
+	for (int i = 0; i < 2; ++i){
+		rc = pfFileHandle.GetThisPage(pages[i], pfPageHandle);
+		if (rc == OK_RC){
+			rc = pfPageHandle.GetData(data[i]);
+			if (rc != OK_RC)
+				pfFileHandle.UnpinPage(pages[i]);
+		}
+		if (rc != OK_RC){
+			if (i == 1)
+				pfFileHandle.UnpinPage(pages[0]);
+			PrintError(rc);
+			return rc;
+		}
+	}
+
+	// The keys on either side of the pair bound both together
+	char pairLowKey[MAXSTRINGLEN];
+	char pairHighKey[MAXSTRINGLEN];
+	const char* pairLow = lowKey;
+	const char* pairHigh = highKey;
+	if (ixIndexHeader.compressed && leftNum > 0){
+		GetKey(pData, leftNum - 1, pairLowKey);
+		pairLow = pairLowKey;
+	}
+	if (ixIndexHeader.compressed && leftNum + 1 < numKeys){
+		GetKey(pData, leftNum + 1, pairHighKey);
+		pairHigh = pairHighKey;
+	}
+
+	int oldNumKeys = numKeys;
+	bool changed = leaf ? RebalanceLeaves(pData, leftNum, numKeys, data[0], data[1], pairLow, pairHigh)
+		: RebalanceInternals(pData, leftNum, numKeys, data[0], data[1], pairLow, pairHigh);
+	bool merged = (numKeys < oldNumKeys);
+	if (changed){
+		StaleCounts(currPage, childHeight + 1);
+		StaleCounts(pages[0], childHeight);
+		StaleCounts(pages[1], childHeight);
+	}
+
+	// A merged right leaf leaves the sibling list
+	if (merged && leaf)
+		rc = UnlinkLeaf(data[1]);
+	for (int i = 0; i < 2 && rc == OK_RC; ++i){
+		if (changed && !(merged && i == 1))
+			rc = pfFileHandle.MarkDirty(pages[i]);
+	}
+	if (changed && rc == OK_RC)
+		rc = pfFileHandle.MarkDirty(currPage);
+	if (rc != OK_RC){
+		pfFileHandle.UnpinPage(pages[0]);
+		pfFileHandle.UnpinPage(pages[1]);
+		PrintError(rc);
+		return rc;
+	}
+	for (int i = 0; i < 2; ++i){
+		rc = pfFileHandle.UnpinPage(pages[i]);
+		if (rc != OK_RC){
+			PrintError(rc);
+			return rc;
+		}
+	}
+	if (merged && (rc = DisposeNode(pages[1])))
+		return rc;
+
+	return OK_RC;
+}
+
+// Moves right's entries into left if they fit, else splits the two leaves'
+// entries where each half fits and updates the parent's key between them;
+// false if neither can be done
+bool IX_IndexHandle::RebalanceLeaves(char* pData, SlotNum leftNum, int &numKeys, char* left, char* right,
+	const char* lowKey, const char* highKey)
+{
+	// Bucket chains and leaves with gaps, from older files, stay as they are
+	int numLeft, numRight;
+	PageNum leftBucket, rightBucket;
+	memcpy(&numLeft, left, sizeof(int));
+	memcpy(&numRight, right, sizeof(int));
+	memcpy(&leftBucket, left + sizeof(int), sizeof(PageNum));
+	memcpy(&rightBucket, right + sizeof(int), sizeof(PageNum));
+	if (leftBucket != IX_NO_PAGE || rightBucket != IX_NO_PAGE ||
+		!LeafIsCompact(left, numLeft) || !LeafIsCompact(right, numRight))
+		return false;
+
+	int entrySize = ixIndexHeader.attrLength + sizeof(PageNum) + sizeof(SlotNum);
+	int numEntries = numLeft + numRight;
+	char* copyBack = new char[numEntries * entrySize];
+	ReadEntries(left, 0, numLeft, copyBack);
+	ReadEntries(right, 0, numRight, copyBack + numLeft * entrySize);
+
+	// Merge into left, whose prefix widens to the pair's bounds
+	int prefixLen = CommonPrefix(lowKey, highKey);
+	bool fits = ixIndexHeader.compressed ? CompressedSize(copyBack, numEntries, true, prefixLen) <= PF_PAGE_SIZE
+		: numEntries - 1 <= ixIndexHeader.maxEntryIndex;
+	if (fits){
+		WriteLeafFromEntryCopyBack(left, copyBack, numEntries * entrySize, numEntries, lowKey, prefixLen);
+		RemoveKey(pData, leftNum, numKeys);
+		delete [] copyBack;
+		return true;
+	}
+
+	// Split evenly.  Equal keys stay on one side, as descents send a key
+	// equal to the separator right
+	char separator[MAXSTRINGLEN];
+	int split = -1;
+	if (ixIndexHeader.compressed)
+		split = SplitEntries(copyBack, numEntries, lowKey, highKey, separator);
+	else {
+		int middle = numEntries / 2;
+		for (int d = 0; d <= middle && split < 0; ++d){
+			if (middle - d > 0 &&
+				CompareKey(copyBack + (middle - d - 1) * entrySize, copyBack + (middle - d) * entrySize) != 0)
+				split = middle - d;
+			else if (middle + d < numEntries &&
+				CompareKey(copyBack + (middle + d - 1) * entrySize, copyBack + (middle + d) * entrySize) != 0)
+				split = middle + d;
+		}
+		if (split > 0)
+			memcpy(separator, copyBack + split * entrySize, ixIndexHeader.attrLength);
+	}
+	if (split <= 0){
+		delete [] copyBack;
+		return false;
+	}
+	char* rightCopyBack = copyBack + split * entrySize;
+	int leftPrefix = CommonPrefix(lowKey, separator);
+	int rightPrefix = CommonPrefix(separator, highKey);
+	if (ixIndexHeader.compressed)
+		fits = CompressedSize(copyBack, split, true, leftPrefix) <= PF_PAGE_SIZE &&
+			CompressedSize(rightCopyBack, numEntries - split, true, rightPrefix) <= PF_PAGE_SIZE;
+	else
+		fits = split - 1 <= ixIndexHeader.maxEntryIndex && numEntries - split - 1 <= ixIndexHeader.maxEntryIndex;
+	if (!fits || !ReplaceKey(pData, leftNum, numKeys, separator)){
+		delete [] copyBack;
+		return false;
+	}
+	WriteLeafFromEntryCopyBack(left, copyBack, split * entrySize, split, lowKey, leftPrefix);
+	WriteLeafFromEntryCopyBack(right, rightCopyBack, (numEntries - split) * entrySize, numEntries - split, separator, rightPrefix);
+	delete [] copyBack;
+	return true;
+}
+
+// As RebalanceLeaves for two internal nodes: the parent's key between them
+// comes down between their keys, and a split sends the middle key up
+bool IX_IndexHandle::RebalanceInternals(char* pData, SlotNum leftNum, int &numKeys, char* left, char* right,
+	const char* lowKey, const char* highKey)
+{
+	int attrLength = ixIndexHeader.attrLength;
+	int keySize = attrLength + sizeof(PageNum);
+	int numLeft, numRight;
+	memcpy(&numLeft, left, sizeof(int));
+	memcpy(&numRight, right, sizeof(int));
+
+	// ptr {key ptr} ... of left, the parent's key, then right's
+	int num = numLeft + 1 + numRight;
+	int copyBackSize = sizeof(PageNum) + num * keySize;
+	char* copyBack = new char[copyBackSize];
+	ReadKeys(left, numLeft, copyBack);
+	char* ptr = copyBack + sizeof(PageNum) + numLeft * keySize;
+	GetKey(pData, leftNum, ptr);
+	ReadKeys(right, numRight, ptr + attrLength);
+
+	// Merge into left
+	int prefixLen = CommonPrefix(lowKey, highKey);
+	bool fits = ixIndexHeader.compressed ? CompressedSize(copyBack, num, false, prefixLen) <= PF_PAGE_SIZE
+		: num - 1 <= ixIndexHeader.maxKeyIndex;
+	if (fits){
+		WriteInternalFromKeyCopyBack(left, copyBack, copyBackSize, num, lowKey, prefixLen);
+		RemoveKey(pData, leftNum, numKeys);
+		delete [] copyBack;
+		return true;
+	}
+
+	// Split, the middle key replacing the parent's
+	SlotNum middle = ixIndexHeader.compressed ? SplitKeys(copyBack, num, lowKey, highKey) : num / 2;
+	char* middleKey = copyBack + sizeof(PageNum) + middle * keySize;
+	char* rightCopyBack = middleKey + attrLength;
+	int numRightKeys = num - 1 - middle;
+	int leftPrefix = CommonPrefix(lowKey, middleKey);
+	int rightPrefix = CommonPrefix(middleKey, highKey);
+	if (ixIndexHeader.compressed)
+		fits = CompressedSize(copyBack, middle, false, leftPrefix) <= PF_PAGE_SIZE &&
+			CompressedSize(rightCopyBack, numRightKeys, false, rightPrefix) <= PF_PAGE_SIZE;
+	else
+		fits = middle - 1 <= ixIndexHeader.maxKeyIndex && numRightKeys - 1 <= ixIndexHeader.maxKeyIndex;
+	if (!fits || !ReplaceKey(pData, leftNum, numKeys, middleKey)){
+		delete [] copyBack;
+		return false;
+	}
+	WriteInternalFromKeyCopyBack(left, copyBack, sizeof(PageNum) + middle * keySize, middle, lowKey, leftPrefix);
+	WriteInternalFromKeyCopyBack(right, rightCopyBack, sizeof(PageNum) + numRightKeys * keySize, numRightKeys, middleKey, rightPrefix);
+	delete [] copyBack;
+	return true;
+}
+
+// Copies an internal node out in the full layout
+void IX_IndexHandle::ReadKeys(char* pData, int numKeys, char* copyBack) const
+{
+	int keySize = ixIndexHeader.attrLength + sizeof(PageNum);
+	PageNum pageNum = GetChildPage(pData, 0);
+	memcpy(copyBack, &pageNum, sizeof(PageNum));
+	char* ptr = copyBack + sizeof(PageNum);
+	for (SlotNum i = 0; i < numKeys; ++i, ptr += keySize){
+		GetKey(pData, i, ptr);
+		pageNum = GetChildPage(pData, i + 1);
+		memcpy(ptr + ixIndexHeader.attrLength, &pageNum, sizeof(PageNum));
+	}
+}
+
+// Sets key keyNum, false if a compressed node has no room for it
+bool IX_IndexHandle::ReplaceKey(char* pData, SlotNum keyNum, int numKeys, const char* key)
+{
+	if (!ixIndexHeader.compressed){
+		memcpy(GetKeyPtr(pData, keyNum), key, ixIndexHeader.attrLength);
+		if (ixIndexHeader.separated)
+			SampleHints(pData, false, numKeys);
+		return true;
+	}
+	int keySize = ixIndexHeader.attrLength + sizeof(PageNum);
+	int copyBackSize = sizeof(PageNum) + numKeys * keySize;
+	char* copyBack = new char[copyBackSize];
+	ReadKeys(pData, numKeys, copyBack);
+	memcpy(copyBack + sizeof(PageNum) + keyNum * keySize, key, ixIndexHeader.attrLength);
+	int prefixLen;
+	NodePrefix(pData, false, prefixLen);
+	bool fits = CompressedSize(copyBack, numKeys, false, prefixLen) <= PF_PAGE_SIZE;
+	if (fits)
+		WriteInternalFromKeyCopyBack(pData, copyBack, copyBackSize, numKeys);
+	delete [] copyBack;
+	return fits;
+}
+
+// Does not mark page dirty
+void IX_IndexHandle::RemoveKey(char* pData, SlotNum keyNum, int &numKeys)
+{
+	int keySize = ixIndexHeader.attrLength + sizeof(PageNum);
+	int copyBackSize = sizeof(PageNum) + numKeys * keySize;
+	char* copyBack = new char[copyBackSize];
+	ReadKeys(pData, numKeys, copyBack);
+	char* ptr = copyBack + sizeof(PageNum) + keyNum * keySize;
+	memmove(ptr, ptr + keySize, (numKeys - 1 - keyNum) * keySize);
+	numKeys -= 1;
+	WriteInternalFromKeyCopyBack(pData, copyBack, copyBackSize - keySize, numKeys);
+	delete [] copyBack;
+}
+
+// Walks the leaves left to right, each followed by its bucket chain, and
+// adds every entry (each rid of a posting list) to loader
+RC IX_IndexHandle::CopyEntries(IX_BulkLoader &loader)
+{
+	int attrLength = ixIndexHeader.attrLength;
+	int rightOffset = sizeof(int) + 2 * sizeof(PageNum);
+	char entry[MAXSTRINGLEN + sizeof(PageNum) + sizeof(SlotNum)];
+	char *pData;
+	PF_PageHandle pfPageHandle;
+	RC rc;
+
+	// Hash and bitmap indexes have no leaves to walk, so a full scan
+	// copies them
+	if (ixIndexHeader.indexType != BTREE_INDEX){
+		IX_IndexScan scan;
+		if (rc = scan.OpenScan(*this, NO_OP, NULL))
+			return rc;
+		RID rid;
+		while ((rc = scan.GetNextEntry(rid, entry)) == OK_RC){
+			if (rc = loader.InsertEntry(entry, rid))
+				return rc;
+		}
+		if (rc != IX_EOF)
+			return rc;
+		return scan.CloseScan();
+	}
+
+	// Leftmost leaf
+	PageNum leaf = ixIndexHeader.rootPage;
+	for (int height = ixIndexHeader.height; height > 0; --height){
+		rc = pfFileHandle.GetThisPage(leaf, pfPageHandle);
+		if (rc != OK_RC){
+			PrintError(rc);
+			return rc;
+		}
+		pfPageHandle.GetData(pData);
+		PageNum child = GetChildPage(pData, 0);
+		rc = pfFileHandle.UnpinPage(leaf);
+		if (rc != OK_RC){
+			PrintError(rc);
+			return rc;
+		}
+		leaf = child;
+	}
+
+	while (leaf != IX_NO_PAGE){
+		PageNum rightLeaf = IX_NO_PAGE;
+		PageNum page = leaf;
+		while (page != IX_NO_PAGE){
+			rc = pfFileHandle.GetThisPage(page, pfPageHandle);
+			if (rc != OK_RC){
+				PrintError(rc);
+				return rc;
+			}
+			pfPageHandle.GetData(pData);
+			int numEntries;
+			memcpy(&numEntries, pData, sizeof(int));
+			bool compact = LeafIsCompact(pData, numEntries);
+			SlotNum last = compact ? numEntries - 1 : ixIndexHeader.maxEntryIndex;
+			for (SlotNum i = 0; i <= last && rc == OK_RC; ++i){
+				if (!compact && !GetSlotBitValue(pData, i))
+					continue;
+				char* ptr = (char*)GetEntry(pData, i, entry);
+				PageNum entryPage;
+				SlotNum entrySlot;
+				memcpy(&entryPage, ptr + attrLength, sizeof(PageNum));
+				memcpy(&entrySlot, ptr + attrLength + sizeof(PageNum), sizeof(SlotNum));
+				if (entrySlot != IX_POSTING_SLOT){
+					rc = loader.InsertEntry(ptr, RID(entryPage, entrySlot));
+					continue;
+				}
+				RID* rids = NULL;
+				int numRids = 0;
+				rc = ReadPostings(entryPage, rids, numRids);
+				for (int j = 0; j < numRids && rc == OK_RC; ++j)
+					rc = loader.InsertEntry(ptr, rids[j]);
+				delete [] rids;
+			}
+			if (page == leaf)
+				memcpy(&rightLeaf, pData + rightOffset, sizeof(PageNum));
+			PageNum bucket;
+			memcpy(&bucket, pData + sizeof(int), sizeof(PageNum));
+			if (rc != OK_RC){
+				pfFileHandle.UnpinPage(page);
+				return rc;
+			}
+			rc = pfFileHandle.UnpinPage(page);
+			if (rc != OK_RC){
+				PrintError(rc);
+				return rc;
+			}
+			page = bucket;
+		}
+		leaf = rightLeaf;
+	}
+
+	return OK_RC;
+}
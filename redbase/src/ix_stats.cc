@@ -0,0 +1,132 @@
+#include <cstring>
+#include <map>
+#include <string>
+#include "ix.h"
+
+using namespace std;
+
+// Index statistics (see IX_IndexStats).  The pages are walked under the
+// index latch, as EdgeKey walks leaves; rids, keys and the clustering
+// factor then come from an ordinary full scan, so they hold for the order
+// a query reads the index in.
+
+// Counts a key of numRids rids in its duplicate histogram bucket
+static void AddDuplicates(IX_IndexStats &stats, int numRids)
+{
+	int bucket = 0;
+	while (bucket < MAXDUPBUCKETS - 1 && (numRids >> (bucket + 1)) > 0)
+		++bucket;
+	++stats.duplicates[bucket];
+	++stats.numKeys;
+}
+
+// Down the leftmost path, then right along the leaves
+RC IX_IndexHandle::LeafStats(int &numPages, int &fillTotal) const
+{
+	RC rc = OK_RC;
+	PageNum pageNum = ixIndexHeader.rootPage;
+	for (int height = ixIndexHeader.height; height > 0 && rc == OK_RC; --height){
+		char node[PF_PAGE_SIZE];
+		if ((rc = ReadNode(pageNum, node)) == OK_RC)
+			pageNum = GetChildPage(node, 0);
+	}
+	char* pData;
+	if (rc != OK_RC || (rc = LatchShared(pageNum, pData)))
+		return rc;
+
+	while (true){
+		int numEntries;
+		memcpy(&numEntries, pData, sizeof(int));
+		++numPages;
+		if (ixIndexHeader.compressed)
+			fillTotal += CompressedBytes(pData, true) * 100 / PF_PAGE_SIZE;
+		else
+			fillTotal += numEntries * 100 / (ixIndexHeader.maxEntryIndex + 1);
+
+		PageNum nextPage;
+		memcpy(&nextPage, pData + sizeof(int) + 2 * sizeof(PageNum), sizeof(PageNum));
+		if (rc = ReleaseShared(pageNum))
+			return rc;
+		if (nextPage == IX_NO_PAGE)
+			break;
+		if (rc = LatchShared(nextPage, pData))
+			return rc;
+		pageNum = nextPage;
+	}
+	return OK_RC;
+}
+
+RC IX_IndexHandle::GetStats(IX_IndexStats &stats) const
+{
+	memset(&stats, 0, sizeof(IX_IndexStats));
+	if (!open){
+		PrintError(IX_FILENOTOPEN);
+		return IX_FILENOTOPEN;
+	}
+
+	// Pages and fill
+	RC rc = LatchIndex(PF_SHARED);
+	if (rc != OK_RC)
+		return rc;
+	int fillTotal = 0;
+	if (ixIndexHeader.indexType == HASH_INDEX){
+		stats.height = 2;
+		rc = BucketStats(stats.leafPages, fillTotal);
+	}
+	else if (ixIndexHeader.indexType == BITMAP_INDEX){
+		stats.height = 2;
+		rc = BitmapStats(stats.leafPages, fillTotal);
+	}
+	else {
+		stats.height = ixIndexHeader.height + 1;
+		rc = LeafStats(stats.leafPages, fillTotal);
+	}
+	RC latchRC = UnlatchIndex(PF_SHARED);
+	if (rc != OK_RC)
+		return rc;
+	if (latchRC != OK_RC)
+		return latchRC;
+	if (stats.leafPages > 0)
+		stats.fillPercent = fillTotal / stats.leafPages;
+
+	// Keys, their rids, and how often consecutive rids change page.  A
+	// B+tree or bitmap scan returns a key's rids together; a hash scan
+	// does not, so its keys are told apart by value
+	IX_IndexScan scan;
+	if (rc = scan.OpenScan(*this, NULL, true, NULL, true))
+		return rc;
+	int attrLength = ixIndexHeader.attrLength;
+	char key[MAXSTRINGLEN], lastKey[MAXSTRINGLEN];
+	map<string, int> hashKeys;
+	int keyRids = 0;
+	PageNum lastPage = IX_NO_PAGE;
+	RID rid;
+	while ((rc = scan.GetNextEntry(rid, key)) == OK_RC){
+		PageNum pageNum;
+		if (rc = rid.GetPageNum(pageNum))
+			break;
+		if (stats.numRids == 0 || pageNum != lastPage)
+			++stats.clustering;
+		lastPage = pageNum;
+		if (ixIndexHeader.indexType == HASH_INDEX)
+			++hashKeys[string(key, attrLength)];
+		else if (keyRids > 0 && CompareKey(lastKey, key) == 0)
+			++keyRids;
+		else {
+			if (keyRids > 0)
+				AddDuplicates(stats, keyRids);
+			memcpy(lastKey, key, attrLength);
+			keyRids = 1;
+		}
+		++stats.numRids;
+	}
+	if (rc != IX_EOF){
+		scan.CloseScan();
+		return rc;
+	}
+	if (keyRids > 0)
+		AddDuplicates(stats, keyRids);
+	for (map<string, int>::iterator it = hashKeys.begin(); it != hashKeys.end(); ++it)
+		AddDuplicates(stats, it->second);
+	return scan.CloseScan();
+}
@@ -18,12 +18,21 @@
 #include <iostream>
 #include <cstring>
 #include <cstdlib>
+#include <climits>
 #include <ctime>
 #include <queue>
+#include <pthread.h>
+#include <sys/time.h>
 #include "redbase.h"
 #include "pf.h"
 #include "rm.h"
 #include "ix.h"
+#ifdef PF_STATS
+#include "statistics.h"
+
+// Defined within pf_buffermgr.cc
+extern StatisticsMgr *pStatisticsMgr;
+#endif
 
 using namespace std;
 
@@ -37,6 +46,17 @@ using namespace std;
 #define MANY_ENTRIES 1000
 #define NENTRIES     5000             // Size of values array
 #define PROG_UNIT    200              // how frequently to give progress
+#define BULK_ENTRIES 100000           // entries bulk loaded, enough to spill runs
+#define BULK_DUPS    5                // entries per key when bulk loading
+#define PATHLEN      200              // length of path keys, sharing a long prefix
+#define KEEP_EVERY   50               // entries left of each run when testing merges
+#define TENANTS      10               // leading key values of the composite index
+#define READERS      4                // reader threads sharing an index
+#define LOOKUPS      20000            // lookups per reader when timing
+#define COUNT_KEYS   1000             // keys when counting, NENTRIES / COUNT_KEYS entries each
+#define RIDS_PER_PAGE 50              // rids given each page when measuring clustering
+#define LAYOUT_KEYS  30000            // keys when comparing node layouts
+#define PAD_LEN      201              // string after the int of composite keys, so nodes hold few
 // reports when adding lots of entries
 
 //
@@ -58,6 +78,26 @@ RC Test1(void);
 RC Test2(void);
 RC Test3(void);
 RC Test4(void);
+RC Test5(void);
+RC Test6(void);
+RC Test7(void);
+RC Test8(void);
+RC Test9(void);
+RC Test10(void);
+RC Test11(void);
+RC Test12(void);
+RC Test13(void);
+RC Test14(void);
+RC Test15(void);
+RC Test16(void);
+RC Test17(void);
+RC Test18(void);
+RC Test19(void);
+RC Test20(void);
+RC Test21(void);
+RC Test22(void);
+RC Test23(void);
+RC Test24(void);
 
 void PrintError(RC rc);
 void LsFiles(char *fileName);
@@ -75,13 +115,33 @@ RC PrintIndex(IX_IndexHandle &ih);
 //
 // Array of pointers to the test functions
 //
-#define NUM_TESTS       3               // number of tests
+#define NUM_TESTS       24              // number of tests
 int (*tests[])() =                      // RC doesn't work on some compilers
 {
    Test1,
    Test2,
    Test3,
-   Test4
+   Test4,
+   Test5,
+   Test6,
+   Test7,
+   Test8,
+   Test9,
+   Test10,
+   Test11,
+   Test12,
+   Test13,
+   Test14,
+   Test15,
+   Test16,
+   Test17,
+   Test18,
+   Test19,
+   Test20,
+   Test21,
+   Test22,
+   Test23,
+   Test24
 };
 
 //
@@ -485,26 +545,6 @@ RC VerifyIntIndex(IX_IndexHandle &ih, int nStart, int nEntries, int bExists)
    return (0);
 }
 
-char* GetKeyPtr(IX_IndexHeader ixIndexHeader, char* pData, const SlotNum slotNum)
-{
-	char* ptr = pData + ixIndexHeader.internalHeaderSize;
-	ptr += sizeof(PageNum);
-	ptr += slotNum * (ixIndexHeader.attrLength + sizeof(PageNum));
-	return ptr;
-}
-char* GetEntryPtr(IX_IndexHeader ixIndexHeader, char* pData, const SlotNum slotNum)
-{
-	char* ptr = pData + ixIndexHeader.leafHeaderSize;
-	ptr += slotNum * (ixIndexHeader.attrLength + sizeof(PageNum) + sizeof(SlotNum));
-	return ptr;
-}
-bool GetSlotBitValue(char* pData, const SlotNum slotNum)
-{
-	char c = *(pData + IX_BIT_START + slotNum / 8); //bits per byte
-	return c & (1 << slotNum % 8);
-}
-
-
 RC PrintIndex(IX_IndexHandle &ih){
 	queue<pair<int, PageNum> > myQueue;
 	pair<int, PageNum> tmp = make_pair(ih.ixIndexHeader.height, ih.ixIndexHeader.rootPage);
@@ -539,9 +579,9 @@ RC PrintIndex(IX_IndexHandle &ih){
 			int entrySize = ih.ixIndexHeader.attrLength +  sizeof(PageNum) + sizeof(SlotNum);
 			char* array = new char[entrySize];
 			for (SlotNum slotNum = 0; slotNum <= ih.ixIndexHeader.maxEntryIndex; ++slotNum){
-				if (GetSlotBitValue(pData, slotNum)){
-					char* ptr = GetEntryPtr(ih.ixIndexHeader, pData, slotNum);
-					memcpy(array, ptr, entrySize);
+				if (ih.GetSlotBitValue(pData, slotNum)){
+					char* ptr = array;
+					memcpy(array, ih.GetEntry(pData, slotNum, array), entrySize);
                     int attr;
                     memcpy(&attr, ptr, 4);
 					ptr += ih.ixIndexHeader.attrLength;
@@ -574,9 +614,9 @@ RC PrintIndex(IX_IndexHandle &ih){
 				}
 
 				for (SlotNum slotNum = 0; slotNum <= ih.ixIndexHeader.maxEntryIndex; ++slotNum){
-					if (GetSlotBitValue(bData, slotNum)){
-						char* ptr = GetEntryPtr(ih.ixIndexHeader, bData, slotNum);
-						memcpy(array, ptr, entrySize);
+					if (ih.GetSlotBitValue(bData, slotNum)){
+						char* ptr = array;
+						memcpy(array, ih.GetEntry(bData, slotNum, array), entrySize);
 						ptr += ih.ixIndexHeader.attrLength;
 						PageNum p;
 						SlotNum s;
@@ -605,22 +645,17 @@ RC PrintIndex(IX_IndexHandle &ih){
 			int keySize = ih.ixIndexHeader.attrLength;
 			char* array = new char[keySize];
 			for (SlotNum slotNum = 0; slotNum < numKeys; ++slotNum){
-				char* ptr = GetKeyPtr(ih.ixIndexHeader, pData, slotNum);
+				ih.GetKey(pData, slotNum, array);
 				int attr;
-				memcpy(&attr, ptr, sizeof(int));
+				memcpy(&attr, array, sizeof(int));
 				cerr << " " << attr; //Print key
 				
-				ptr -= sizeof(PageNum);
-				PageNum pageTmp;
-				memcpy(&pageTmp, ptr, sizeof(PageNum));
+				PageNum pageTmp = ih.GetChildPage(pData, slotNum);
 				tmp = make_pair(prevHeight - 1, ih.ixIndexHeader.rootPage);
 				myQueue.push(tmp);
 			}
 
-			char* ptr = GetKeyPtr(ih.ixIndexHeader, pData, numKeys);
-			ptr -= sizeof(PageNum);
-			PageNum pageTmp;
-			memcpy(&pageTmp, ptr, sizeof(PageNum));
+			PageNum pageTmp = ih.GetChildPage(pData, numKeys);
 			tmp = make_pair(prevHeight - 1, ih.ixIndexHeader.rootPage);
 			myQueue.push(tmp);
 
@@ -839,3 +874,2394 @@ RC Test4(void)
    printf("Passed Test 4\n\n");
    return (0);
 }
+
+//
+// Test 5 bulk loads an index from scrambled entries with duplicate
+// keys, then scans it and checks it still takes inserts and deletes
+//
+RC Test5(void)
+{
+   RC             rc;
+   IX_IndexHandle ih;
+   IX_BulkLoader  loader(ixm);
+   int            index=0;
+   int            nKeys = BULK_ENTRIES / BULK_DUPS;
+   int            i, value, prev;
+   RID            rid;
+   PageNum        pageNum;
+
+   printf("Test5: Bulk load an index... \n");
+
+   if ((rc = ixm.CreateIndex(FILENAME, index, INT, sizeof(int))) ||
+         (rc = ixm.OpenIndex(FILENAME, index, ih)) ||
+         (rc = loader.OpenLoad(FILENAME, index, ih)))
+      return (rc);
+
+   // Entry i gets key i*7919 mod BULK_ENTRIES, folded onto nKeys keys,
+   // and the RID (key + 1, i)
+   for (i = 0; i < BULK_ENTRIES; i++) {
+      value = (int)((i * 7919L) % BULK_ENTRIES) % nKeys;
+      if ((rc = loader.InsertEntry(&value, RID(value + 1, i))))
+         return (rc);
+   }
+   if ((rc = loader.CloseLoad()))
+      return (rc);
+   if (ih.ixIndexHeader.height == 0) {
+      printf("Bulk load error: tree has no internal nodes\n");
+      return (IX_EOF);
+   }
+
+   // A loaded index cannot be bulk loaded again
+   if ((rc = loader.OpenLoad(FILENAME, index, ih)) != IX_NOTEMPTY) {
+      printf("Bulk load error: loaded into a non-empty index\n");
+      return (rc ? rc : IX_EOF);
+   }
+
+   // Full scan returns every entry in key order
+   IX_IndexScan scan;
+   if ((rc = scan.OpenScan(ih, NO_OP, NULL)))
+      return (rc);
+   i = 0;
+   prev = 0;
+   while (!(rc = scan.GetNextEntry(rid))) {
+      if ((rc = rid.GetPageNum(pageNum)))
+         return (rc);
+      if (pageNum < prev) {
+         printf("Bulk load error: key %d after %d\n", pageNum - 1, prev - 1);
+         return (IX_EOF);
+      }
+      prev = pageNum;
+      i++;
+   }
+   if (rc != IX_EOF || (rc = scan.CloseScan()))
+      return (rc);
+   if (i != BULK_ENTRIES) {
+      printf("Bulk load error: scanned %d of %d entries\n", i, BULK_ENTRIES);
+      return (IX_EOF);
+   }
+
+   // Each key's duplicates are all found, including after an insert
+   value = nKeys / 2;
+   if ((rc = ih.InsertEntry(&value, RID(value + 1, BULK_ENTRIES))))
+      return (rc);
+   int checks[] = { 0, nKeys / 2, nKeys - 1 };
+   for (int c = 0; c < 3; c++) {
+      value = checks[c];
+      if ((rc = scan.OpenScan(ih, EQ_OP, &value)))
+         return (rc);
+      i = 0;
+      while (!(rc = scan.GetNextEntry(rid))) {
+         if ((rc = rid.GetPageNum(pageNum)))
+            return (rc);
+         if (pageNum != value + 1) {
+            printf("Bulk load error: wrong rid for key %d\n", value);
+            return (IX_EOF);
+         }
+         i++;
+      }
+      if (rc != IX_EOF || (rc = scan.CloseScan()))
+         return (rc);
+      if (i != BULK_DUPS + (value == nKeys / 2)) {
+         printf("Bulk load error: found %d entries for key %d\n", i, value);
+         return (IX_EOF);
+      }
+   }
+   value = nKeys / 2;
+   if ((rc = ih.DeleteEntry(&value, RID(value + 1, BULK_ENTRIES))) ||
+         (rc = ixm.CloseIndex(ih)))
+      return (rc);
+
+   LsFiles(FILENAME);
+
+   if ((rc = ixm.DestroyIndex(FILENAME, index)))
+      return (rc);
+
+   printf("Passed Test 5\n\n");
+   return (0);
+}
+
+//
+// Test 6 deletes half of many duplicate-key entries, then checks that
+// equality and inequality scans positioned inside leaves count the rest
+//
+RC Test6(void)
+{
+   RC             rc;
+   IX_IndexHandle ih;
+   int            index=0;
+   int            nKeys = MANY_ENTRIES / BULK_DUPS;
+   int            i, value, n;
+   RID            rid;
+
+   printf("Test6: Scans after deletes... \n");
+
+   if ((rc = ixm.CreateIndex(FILENAME, index, INT, sizeof(int))) ||
+         (rc = ixm.OpenIndex(FILENAME, index, ih)))
+      return (rc);
+
+   // Entry i has key i mod nKeys; delete the odd entries
+   for (i = 0; i < MANY_ENTRIES; i++) {
+      value = i % nKeys;
+      if ((rc = ih.InsertEntry(&value, RID(value + 1, i))))
+         return (rc);
+   }
+   for (i = 1; i < MANY_ENTRIES; i += 2) {
+      value = i % nKeys;
+      if ((rc = ih.DeleteEntry(&value, RID(value + 1, i))))
+         return (rc);
+   }
+
+   // Count what EQ, GE and GT scans on a remaining key should find
+   int key = nKeys / 2;
+   int expected[3] = { 0, 0, 0 };
+   for (i = 0; i < MANY_ENTRIES; i += 2) {
+      value = i % nKeys;
+      expected[0] += (value == key);
+      expected[1] += (value >= key);
+      expected[2] += (value > key);
+   }
+   CompOp ops[3] = { EQ_OP, GE_OP, GT_OP };
+   for (int c = 0; c < 3; c++) {
+      IX_IndexScan scan;
+      if ((rc = scan.OpenScan(ih, ops[c], &key)))
+         return (rc);
+      n = 0;
+      while (!(rc = scan.GetNextEntry(rid)))
+         n++;
+      if (rc != IX_EOF || (rc = scan.CloseScan()))
+         return (rc);
+      if (n != expected[c]) {
+         printf("Scan error: found %d entries, expected %d\n", n, expected[c]);
+         return (IX_EOF);
+      }
+   }
+
+   if ((rc = ixm.CloseIndex(ih)))
+      return (rc);
+
+   LsFiles(FILENAME);
+
+   if ((rc = ixm.DestroyIndex(FILENAME, index)))
+      return (rc);
+
+   printf("Passed Test 6\n\n");
+   return (0);
+}
+
+//
+// Test 7 checks two-sided range scans with each mix of inclusive and
+// exclusive bounds, open sides and an empty range
+//
+RC Test7(void)
+{
+   RC             rc;
+   IX_IndexHandle ih;
+   int            index=0;
+   int            i, value, n;
+   RID            rid;
+
+   printf("Test7: Range scans... \n");
+
+   if ((rc = ixm.CreateIndex(FILENAME, index, INT, sizeof(int))) ||
+         (rc = ixm.OpenIndex(FILENAME, index, ih)))
+      return (rc);
+
+   // Keys 0 .. MANY_ENTRIES-1, inserted out of order; the rid's page is the key
+   for (i = 0; i < MANY_ENTRIES; i++) {
+      value = (i * 7) % MANY_ENTRIES;
+      if ((rc = ih.InsertEntry(&value, RID(value + 1, i))))
+         return (rc);
+   }
+
+   struct { int low, high; bool hasLow, lowInc, hasHigh, highInc; } ranges[] = {
+      { 100, 200, true, true,  true, true  },
+      { 100, 200, true, false, true, false },
+      { 100, 200, true, true,  true, false },
+      { 0,   50,  false, false, true, true },
+      { 990, 0,   true, false, false, false },
+      { 300, 299, true, true,  true, true  },
+   };
+   int nRanges = sizeof(ranges) / sizeof(ranges[0]);
+   for (int r = 0; r < nRanges; r++) {
+      int lo = ranges[r].hasLow ? ranges[r].low + !ranges[r].lowInc : 0;
+      int hi = ranges[r].hasHigh ? ranges[r].high - !ranges[r].highInc : MANY_ENTRIES - 1;
+      int expected = (hi >= lo) ? hi - lo + 1 : 0;
+
+      IX_IndexScan scan;
+      if ((rc = scan.OpenScan(ih, ranges[r].hasLow ? &ranges[r].low : NULL, ranges[r].lowInc,
+                                  ranges[r].hasHigh ? &ranges[r].high : NULL, ranges[r].highInc)))
+         return (rc);
+      n = 0;
+      while (!(rc = scan.GetNextEntry(rid))) {
+         PageNum page;
+         if ((rc = rid.GetPageNum(page)))
+            return (rc);
+         // Entries come back in key order, all inside the range
+         if (page - 1 != lo + n) {
+            printf("Scan error: found key %d, expected %d\n", page - 1, lo + n);
+            return (IX_EOF);
+         }
+         n++;
+      }
+      if (rc != IX_EOF || (rc = scan.CloseScan()))
+         return (rc);
+      if (n != expected) {
+         printf("Scan error: found %d entries, expected %d\n", n, expected);
+         return (IX_EOF);
+      }
+   }
+
+   if ((rc = ixm.CloseIndex(ih)))
+      return (rc);
+
+   LsFiles(FILENAME);
+
+   if ((rc = ixm.DestroyIndex(FILENAME, index)))
+      return (rc);
+
+   printf("Passed Test 7\n\n");
+   return (0);
+}
+
+//
+// Test 8 checks reverse scans return entries in decreasing key order,
+// including after deletes have emptied and removed whole leaves
+//
+RC Test8(void)
+{
+   RC             rc;
+   IX_IndexHandle ih;
+   int            index=0;
+   int            i, value, n;
+   RID            rid;
+
+   printf("Test8: Reverse scans... \n");
+
+   if ((rc = ixm.CreateIndex(FILENAME, index, INT, sizeof(int))) ||
+         (rc = ixm.OpenIndex(FILENAME, index, ih)))
+      return (rc);
+
+   // Keys 0 .. NENTRIES-1, then delete the middle half; the rid's page is the key
+   for (i = 0; i < NENTRIES; i++) {
+      value = (i * 7) % NENTRIES;
+      if ((rc = ih.InsertEntry(&value, RID(value + 1, i))))
+         return (rc);
+   }
+   for (i = 0; i < NENTRIES; i++) {
+      value = (i * 7) % NENTRIES;
+      if (value >= NENTRIES / 4 && value < 3 * NENTRIES / 4 &&
+            (rc = ih.DeleteEntry(&value, RID(value + 1, i))))
+         return (rc);
+   }
+
+   CompOp ops[4] = { NO_OP, LT_OP, LE_OP, GE_OP };
+   int key = NENTRIES / 8;
+   for (int c = 0; c < 4; c++) {
+      int expected = 0;
+      for (value = 0; value < NENTRIES; value++) {
+         if (value >= NENTRIES / 4 && value < 3 * NENTRIES / 4)
+            continue;
+         expected += (ops[c] == NO_OP || (ops[c] == LT_OP && value < key) ||
+                      (ops[c] == LE_OP && value <= key) || (ops[c] == GE_OP && value >= key));
+      }
+
+      IX_IndexScan scan;
+      if ((rc = scan.OpenScan(ih, ops[c], ops[c] == NO_OP ? NULL : &key, NO_HINT, true)))
+         return (rc);
+      n = 0;
+      PageNum last = NENTRIES + 1;
+      while (!(rc = scan.GetNextEntry(rid))) {
+         PageNum page;
+         if ((rc = rid.GetPageNum(page)))
+            return (rc);
+         if (page >= last) {
+            printf("Scan error: key %d after key %d\n", page - 1, last - 1);
+            return (IX_EOF);
+         }
+         last = page;
+         n++;
+      }
+      if (rc != IX_EOF || (rc = scan.CloseScan()))
+         return (rc);
+      if (n != expected) {
+         printf("Scan error: found %d entries, expected %d\n", n, expected);
+         return (IX_EOF);
+      }
+   }
+
+   if ((rc = ixm.CloseIndex(ih)))
+      return (rc);
+
+   LsFiles(FILENAME);
+
+   if ((rc = ixm.DestroyIndex(FILENAME, index)))
+      return (rc);
+
+   printf("Passed Test 8\n\n");
+   return (0);
+}
+
+//
+// Test 9 fills posting lists with many rids per key, in and out of rid
+// order, then checks equality scans, deletes and rid intersection
+//
+RC Test9(void)
+{
+   RC             rc;
+   IX_IndexHandle ih;
+   int            index=0;
+   int            i, value, n;
+   RID            rid;
+
+   printf("Test9: Posting lists... \n");
+
+   if ((rc = ixm.CreateIndex(FILENAME, index, INT, sizeof(int))) ||
+         (rc = ixm.OpenIndex(FILENAME, index, ih)))
+      return (rc);
+
+   // Key 1 has rids (i/100+1, i%100) for every i, added backwards; key 2
+   // has every third of them, added forwards
+   for (i = NENTRIES - 1; i >= 0; i--) {
+      value = 1;
+      if ((rc = ih.InsertEntry(&value, RID(i / 100 + 1, i % 100))))
+         return (rc);
+   }
+   for (i = 0; i < NENTRIES; i += 3) {
+      value = 2;
+      if ((rc = ih.InsertEntry(&value, RID(i / 100 + 1, i % 100))))
+         return (rc);
+   }
+
+   // Drop the odd rids of key 1
+   for (i = 1; i < NENTRIES; i += 2) {
+      value = 1;
+      if ((rc = ih.DeleteEntry(&value, RID(i / 100 + 1, i % 100))))
+         return (rc);
+   }
+
+   IX_IndexScan scan;
+   value = 1;
+   if ((rc = scan.OpenScan(ih, EQ_OP, &value)))
+      return (rc);
+   for (n = 0; !(rc = scan.GetNextEntry(rid)); n++)
+      ;
+   if (rc != IX_EOF || (rc = scan.CloseScan()))
+      return (rc);
+   if (n != NENTRIES / 2) {
+      printf("Scan error: found %d entries, expected %d\n", n, NENTRIES / 2);
+      return (IX_EOF);
+   }
+
+   // Key 1's even rids and key 2's every third meet at every sixth
+   RID *one, *two;
+   int numOne, numTwo;
+   value = 1;
+   if ((rc = ih.GetRids(&value, one, numOne)))
+      return (rc);
+   value = 2;
+   if ((rc = ih.GetRids(&value, two, numTwo))) {
+      delete [] one;
+      return (rc);
+   }
+   RID *both = new RID[numOne < numTwo ? numOne : numTwo];
+   n = IX_IntersectRids(one, numOne, two, numTwo, both);
+   bool ok = (n == (NENTRIES + 5) / 6);
+   for (i = 0; ok && i < n; i++)
+      ok = (both[i].pageNum == (6 * i) / 100 + 1 && both[i].slotNum == (6 * i) % 100);
+   delete [] one;
+   delete [] two;
+   delete [] both;
+   if (!ok) {
+      printf("Intersection error: found %d rids, expected %d\n", n, (NENTRIES + 5) / 6);
+      return (IX_EOF);
+   }
+
+   if ((rc = ixm.CloseIndex(ih)))
+      return (rc);
+
+   LsFiles(FILENAME);
+
+   if ((rc = ixm.DestroyIndex(FILENAME, index)))
+      return (rc);
+
+   printf("Passed Test 9\n\n");
+   return (0);
+}
+
+//
+// Test 10 indexes long strings sharing a prefix, which compressed nodes
+// store once per node: the tree stays shallow, and inserts, deletes and
+// a bulk load of the same keys all scan back the same
+//
+static void PathKey(char *key, int i)
+{
+   memset(key, 0, PATHLEN);
+   sprintf(key, "/usr/local/redbase/data/relations/employees/record/%06d/%s",
+           i, (i % 3) ? "name" : "address");
+}
+
+static RC ScanPaths(IX_IndexHandle &ih, bool reverse, int &n, bool &ordered)
+{
+   RC rc;
+   RID rid;
+   IX_IndexScan scan;
+   PageNum page, prev = reverse ? NENTRIES + 1 : -1;
+   if ((rc = scan.OpenScan(ih, NO_OP, NULL, NO_HINT, reverse)))
+      return (rc);
+   ordered = true;
+   for (n = 0; !(rc = scan.GetNextEntry(rid)); n++) {
+      rid.GetPageNum(page);
+      ordered = ordered && (reverse ? page < prev : page > prev);
+      prev = page;
+   }
+   if (rc != IX_EOF || (rc = scan.CloseScan()))
+      return (rc);
+   return (0);
+}
+
+RC Test10(void)
+{
+   RC             rc;
+   IX_IndexHandle ih;
+   int            index=0;
+   int            i, n;
+   bool           ordered;
+   char           key[PATHLEN];
+   RID            rid;
+
+   printf("Test10: Prefix compressed strings... \n");
+
+   if ((rc = ixm.CreateIndex(FILENAME, index, STRING, PATHLEN)) ||
+         (rc = ixm.OpenIndex(FILENAME, index, ih)))
+      return (rc);
+
+   // Entry i has path i and rid (i, i), added in random order
+   ran(NENTRIES);
+   for (i = 0; i < NENTRIES; i++) {
+      PathKey(key, values[i]);
+      if ((rc = ih.InsertEntry(key, RID(values[i], values[i]))))
+         return (rc);
+   }
+
+   // Full width keys would need a third level
+   if (ih.ixIndexHeader.height > 1) {
+      printf("Height error: %d levels, expected at most 1\n", ih.ixIndexHeader.height);
+      return (IX_EOF);
+   }
+
+   // Drop the odd paths; every even one is found alone, in order both ways
+   for (i = 1; i < NENTRIES; i += 2) {
+      PathKey(key, i);
+      if ((rc = ih.DeleteEntry(key, RID(i, i))))
+         return (rc);
+   }
+   for (i = 0; i < NENTRIES; i += 2) {
+      IX_IndexScan scan;
+      PathKey(key, i);
+      if ((rc = scan.OpenScan(ih, EQ_OP, key)))
+         return (rc);
+      PageNum page = -1;
+      for (n = 0; !(rc = scan.GetNextEntry(rid)); n++)
+         rid.GetPageNum(page);
+      if (rc != IX_EOF || (rc = scan.CloseScan()))
+         return (rc);
+      if (n != 1 || page != i) {
+         printf("Scan error: path %d found %d times\n", i, n);
+         return (IX_EOF);
+      }
+   }
+   for (int reverse = 0; reverse < 2; reverse++) {
+      if ((rc = ScanPaths(ih, reverse, n, ordered)))
+         return (rc);
+      if (n != NENTRIES / 2 || !ordered) {
+         printf("Scan error: found %d entries, expected %d in order\n", n, NENTRIES / 2);
+         return (IX_EOF);
+      }
+   }
+
+   if ((rc = ixm.CloseIndex(ih)) ||
+         (rc = ixm.DestroyIndex(FILENAME, index)))
+      return (rc);
+
+   // Bulk loaded, the same keys fill leaves by bytes
+   IX_BulkLoader loader(ixm);
+   if ((rc = ixm.CreateIndex(FILENAME, index, STRING, PATHLEN)) ||
+         (rc = ixm.OpenIndex(FILENAME, index, ih)) ||
+         (rc = loader.OpenLoad(FILENAME, index, ih)))
+      return (rc);
+   for (i = 0; i < NENTRIES; i++) {
+      PathKey(key, values[i]);
+      if ((rc = loader.InsertEntry(key, RID(values[i], values[i]))))
+         return (rc);
+   }
+   if ((rc = loader.CloseLoad()))
+      return (rc);
+   if ((rc = ScanPaths(ih, false, n, ordered)))
+      return (rc);
+   if (n != NENTRIES || !ordered || ih.ixIndexHeader.height > 1) {
+      printf("Bulk load error: found %d entries in %d levels\n", n, ih.ixIndexHeader.height);
+      return (IX_EOF);
+   }
+
+   if ((rc = ixm.CloseIndex(ih)))
+      return (rc);
+
+   LsFiles(FILENAME);
+
+   if ((rc = ixm.DestroyIndex(FILENAME, index)))
+      return (rc);
+
+   printf("Passed Test 10\n\n");
+   return (0);
+}
+
+//
+// Test 11 deletes most entries, first merging nodes as they empty, then
+// lazily, and rebuilds the lazily emptied index; each time the tree
+// shrinks back to a single leaf and scans find what is left
+//
+static RC DeleteMost(IX_IndexHandle &ih)
+{
+   RC  rc;
+   int i;
+
+   ran(NENTRIES);
+   for (i = 0; i < NENTRIES; i++) {
+      if (values[i] % KEEP_EVERY == 0)
+         continue;
+      if ((rc = ih.DeleteEntry(&values[i], RID(values[i], values[i]))))
+         return (rc);
+   }
+   return (0);
+}
+
+static RC VerifyKept(IX_IndexHandle &ih)
+{
+   RC           rc;
+   RID          rid;
+   PageNum      page, prev = -1;
+   int          n;
+   IX_IndexScan scan;
+
+   if ((rc = scan.OpenScan(ih, NO_OP, NULL)))
+      return (rc);
+   for (n = 0; !(rc = scan.GetNextEntry(rid)); n++) {
+      rid.GetPageNum(page);
+      if (page % KEEP_EVERY != 0 || page <= prev) {
+         printf("Scan error: entry %d out of place\n", page);
+         return (IX_EOF);
+      }
+      prev = page;
+   }
+   if (rc != IX_EOF || (rc = scan.CloseScan()))
+      return (rc);
+   if (n != NENTRIES / KEEP_EVERY || ih.ixIndexHeader.height != 0) {
+      printf("Index error: %d entries in %d levels, expected %d in a single leaf\n",
+             n, ih.ixIndexHeader.height, NENTRIES / KEEP_EVERY);
+      return (IX_EOF);
+   }
+   return (0);
+}
+
+RC Test11(void)
+{
+   RC             rc;
+   IX_IndexHandle ih;
+   int            index=0;
+   int            i;
+
+   printf("Test11: Merging and rebuilding... \n");
+
+   if ((rc = ixm.CreateIndex(FILENAME, index, INT, sizeof(int))) ||
+         (rc = ixm.OpenIndex(FILENAME, index, ih)))
+      return (rc);
+   ran(NENTRIES);
+   for (i = 0; i < NENTRIES; i++) {
+      if ((rc = ih.InsertEntry(&values[i], RID(values[i], values[i]))))
+         return (rc);
+   }
+   if ((rc = DeleteMost(ih)) ||
+         (rc = VerifyKept(ih)))
+      return (rc);
+
+   // Without merging the emptied leaves stay until the rebuild, which
+   // waits for open scans
+   if ((rc = ixm.CloseIndex(ih)) ||
+         (rc = ixm.DestroyIndex(FILENAME, index)) ||
+         (rc = ixm.CreateIndex(FILENAME, index, INT, sizeof(int))) ||
+         (rc = ixm.OpenIndex(FILENAME, index, ih)) ||
+         (rc = ih.SetMergePercent(0)))
+      return (rc);
+   ran(NENTRIES);
+   for (i = 0; i < NENTRIES; i++) {
+      if ((rc = ih.InsertEntry(&values[i], RID(values[i], values[i]))))
+         return (rc);
+   }
+   if ((rc = DeleteMost(ih)))
+      return (rc);
+   if (ih.ixIndexHeader.height == 0) {
+      printf("Merge error: lazy deletes shrank the tree\n");
+      return (IX_EOF);
+   }
+
+   IX_IndexScan scan;
+   if ((rc = scan.OpenScan(ih, NO_OP, NULL)))
+      return (rc);
+   if ((rc = ixm.RebuildIndex(FILENAME, index, ih)) != IX_SCANSOPEN) {
+      printf("Rebuild error: rebuilt under an open scan\n");
+      return (IX_EOF);
+   }
+   RID rid;
+   while (!(rc = scan.GetNextEntry(rid)))
+      ;
+   if (rc != IX_EOF || (rc = scan.CloseScan()))
+      return (rc);
+
+   if ((rc = ixm.RebuildIndex(FILENAME, index, ih)) ||
+         (rc = VerifyKept(ih)))
+      return (rc);
+
+   if ((rc = ixm.CloseIndex(ih)))
+      return (rc);
+
+   LsFiles(FILENAME);
+
+   if ((rc = ixm.DestroyIndex(FILENAME, index)))
+      return (rc);
+
+   printf("Passed Test 11\n\n");
+   return (0);
+}
+
+//
+// Test 12 keys an index on (tenant, ts), an int then a float, both taking
+// negative values, and scans it by a tenant alone and by a tenant and a
+// range of ts.  Entry i has tenant i % TENANTS - TENANTS / 2, ts
+// i / TENANTS - 100 and rid (i, i), so each tenant's entries are in rid
+// order.
+//
+static RC ScanTenant(IX_IndexHandle &ih, int tenant, float *low, float *high, int &n)
+{
+   RC           rc;
+   RID          rid;
+   PageNum      page, prev = -1;
+   char         lowKey[2 * sizeof(int)], highKey[2 * sizeof(int)];
+   void         *lowValues[2] = {&tenant, low};
+   void         *highValues[2] = {&tenant, high};
+   IX_IndexScan scan;
+
+   // A missing bound ends at the tenant's lowest or highest key
+   if ((rc = ih.EncodeKey(lowValues, low ? 2 : 1, false, lowKey)) ||
+         (rc = ih.EncodeKey(highValues, high ? 2 : 1, true, highKey)) ||
+         (rc = scan.OpenScan(ih, lowKey, true, highKey, true)))
+      return (rc);
+   for (n = 0; !(rc = scan.GetNextEntry(rid)); n++) {
+      rid.GetPageNum(page);
+      int ts = page / TENANTS - 100;
+      if (page % TENANTS - TENANTS / 2 != tenant || page <= prev ||
+            (low && ts < *low) || (high && ts > *high)) {
+         printf("Scan error: entry %d out of place\n", page);
+         return (IX_EOF);
+      }
+      prev = page;
+   }
+   if (rc != IX_EOF || (rc = scan.CloseScan()))
+      return (rc);
+   return (0);
+}
+
+RC Test12(void)
+{
+   RC             rc;
+   IX_IndexHandle ih;
+   int            index=0;
+   int            i, n;
+   AttrType       types[2] = {INT, FLOAT};
+   int            lengths[2] = {sizeof(int), sizeof(float)};
+   char           key[2 * sizeof(int)];
+
+   printf("Test12: Composite keys... \n");
+
+   if ((rc = ixm.CreateIndex(FILENAME, index, 2, types, lengths)) ||
+         (rc = ixm.OpenIndex(FILENAME, index, ih)))
+      return (rc);
+   ran(NENTRIES);
+   for (i = 0; i < NENTRIES; i++) {
+      int tenant = values[i] % TENANTS - TENANTS / 2;
+      float ts = values[i] / TENANTS - 100;
+      void *keyValues[2] = {&tenant, &ts};
+      if ((rc = ih.EncodeKey(keyValues, 2, false, key)) ||
+            (rc = ih.InsertEntry(key, RID(values[i], values[i]))))
+         return (rc);
+   }
+
+   // The key attributes survive reopening
+   if ((rc = ixm.CloseIndex(ih)) ||
+         (rc = ixm.OpenIndex(FILENAME, index, ih)))
+      return (rc);
+
+   float low = -50, high = 10;
+   for (int tenant = -TENANTS / 2; tenant < TENANTS / 2; tenant++) {
+      if ((rc = ScanTenant(ih, tenant, NULL, NULL, n)))
+         return (rc);
+      if (n != NENTRIES / TENANTS) {
+         printf("Scan error: tenant %d has %d entries\n", tenant, n);
+         return (IX_EOF);
+      }
+      if ((rc = ScanTenant(ih, tenant, &low, &high, n)))
+         return (rc);
+      if (n != (int)(high - low) + 1) {
+         printf("Scan error: tenant %d has %d entries in range\n", tenant, n);
+         return (IX_EOF);
+      }
+   }
+
+   if ((rc = ixm.CloseIndex(ih)))
+      return (rc);
+
+   LsFiles(FILENAME);
+
+   if ((rc = ixm.DestroyIndex(FILENAME, index)))
+      return (rc);
+
+   printf("Passed Test 12\n\n");
+   return (0);
+}
+
+//
+// Test13 returns keys along with rids, from posting lists and composite
+// keys, as used by index only scans
+//
+RC Test13(void)
+{
+   RC             rc;
+   IX_IndexHandle ih;
+   IX_IndexScan   scan;
+   int            index=0;
+   int            i, n, value;
+   RID            rid;
+   PageNum        page;
+   AttrType       types[2] = {INT, FLOAT};
+   int            lengths[2] = {sizeof(int), sizeof(float)};
+   char           key[2 * sizeof(int)], lastKey[2 * sizeof(int)];
+
+   printf("Test13: Index only scans... \n");
+
+   // Duplicates share a posting list, and every rid returns its key
+   if ((rc = ixm.CreateIndex(FILENAME, index, INT, sizeof(int))) ||
+         (rc = ixm.OpenIndex(FILENAME, index, ih)))
+      return (rc);
+   ran(NENTRIES);
+   for (i = 0; i < NENTRIES; i++) {
+      value = values[i] % 10;
+      if ((rc = ih.InsertEntry(&value, RID(values[i], values[i]))))
+         return (rc);
+   }
+   if ((rc = scan.OpenScan(ih, NO_OP, NULL)))
+      return (rc);
+   for (n = 0; (rc = scan.GetNextEntry(rid, &value)) == OK_RC; n++) {
+      rid.GetPageNum(page);
+      if (value != page % 10) {
+         printf("Scan error: key %d returned with rid page %d\n", value, page);
+         return (IX_EOF);
+      }
+   }
+   if (rc != IX_EOF || n != NENTRIES || (rc = scan.CloseScan()))
+      return (rc == IX_EOF ? IX_EOF : rc);
+   if ((rc = ixm.CloseIndex(ih)) ||
+         (rc = ixm.DestroyIndex(FILENAME, index)))
+      return (rc);
+
+   // Composite keys decode back to their attribute values
+   if ((rc = ixm.CreateIndex(FILENAME, index, 2, types, lengths)) ||
+         (rc = ixm.OpenIndex(FILENAME, index, ih)))
+      return (rc);
+   for (i = 0; i < NENTRIES; i++) {
+      int tenant = values[i] % TENANTS - TENANTS / 2;
+      float ts = values[i] / TENANTS - 100;
+      void *keyValues[2] = {&tenant, &ts};
+      if ((rc = ih.EncodeKey(keyValues, 2, false, key)) ||
+            (rc = ih.InsertEntry(key, RID(values[i], values[i]))))
+         return (rc);
+   }
+   if ((rc = scan.OpenScan(ih, NO_OP, NULL)))
+      return (rc);
+   for (n = 0; (rc = scan.GetNextEntry(rid, key)) == OK_RC; n++) {
+      int tenant;
+      float ts;
+      void *keyValues[2] = {&tenant, &ts};
+      if ((rc = ih.DecodeKey(key, keyValues)))
+         return (rc);
+      rid.GetPageNum(page);
+      if (tenant != page % TENANTS - TENANTS / 2 || ts != page / TENANTS - 100 ||
+            (n > 0 && memcmp(lastKey, key, sizeof(key)) > 0)) {
+         printf("Scan error: key (%d, %f) returned with rid page %d\n", tenant, ts, page);
+         return (IX_EOF);
+      }
+      memcpy(lastKey, key, sizeof(key));
+   }
+   if (rc != IX_EOF || n != NENTRIES || (rc = scan.CloseScan()))
+      return (rc == IX_EOF ? IX_EOF : rc);
+
+   if ((rc = ixm.CloseIndex(ih)))
+      return (rc);
+
+   LsFiles(FILENAME);
+
+   if ((rc = ixm.DestroyIndex(FILENAME, index)))
+      return (rc);
+
+   printf("Passed Test 13\n\n");
+   return (0);
+}
+
+//
+// Test14 builds a hash index big enough to split its buckets and double
+// its directory, with one key duplicated past a bucket's capacity so it
+// chains overflow pages; equality and full scans find every entry through
+// deletes and a reopen
+//
+static RC CountHashEntries(IX_IndexHandle &ih, int *value, int &n)
+{
+   RC rc;
+   RID rid;
+   IX_IndexScan scan;
+   if ((rc = scan.OpenScan(ih, value ? EQ_OP : NO_OP, value)))
+      return (rc);
+   for (n = 0; (rc = scan.GetNextEntry(rid)) == OK_RC; n++)
+      ;
+   if (rc != IX_EOF || (rc = scan.CloseScan()))
+      return (rc);
+   return (0);
+}
+
+RC Test14(void)
+{
+   RC             rc;
+   IX_IndexHandle ih;
+   IX_IndexScan   scan;
+   int            index=0;
+   int            i, n, value;
+   int            dups = 1000;
+
+   printf("Test14: Hash indexes... \n");
+
+   if ((rc = ixm.CreateIndex(FILENAME, index, INT, sizeof(int), HASH_INDEX)) ||
+         (rc = ixm.OpenIndex(FILENAME, index, ih)))
+      return (rc);
+   ran(NENTRIES);
+   for (i = 0; i < NENTRIES; i++) {
+      if ((rc = ih.InsertEntry(&values[i], RID(values[i] + 1, values[i]))))
+         return (rc);
+   }
+   value = 7;
+   for (i = 0; i < dups; i++) {
+      if ((rc = ih.InsertEntry(&value, RID(NENTRIES + 1, i))))
+         return (rc);
+   }
+
+   // Each key finds its own entries only
+   for (i = 0; i < NENTRIES; i += 37) {
+      value = i;
+      if ((rc = CountHashEntries(ih, &value, n)))
+         return (rc);
+      if (n != (i == 7 ? dups + 1 : 1)) {
+         printf("Scan error: found %d entries for key %d\n", n, i);
+         return (IX_EOF);
+      }
+   }
+
+   // Only equality and full scans are supported
+   value = 10;
+   if (scan.OpenScan(ih, LT_OP, &value) != IX_HASHSCAN) {
+      printf("Scan error: range scan opened on a hash index\n");
+      return (IX_EOF);
+   }
+
+   // Delete the odd keys and half the duplicates
+   for (i = 1; i < NENTRIES; i += 2) {
+      if ((rc = ih.DeleteEntry(&i, RID(i + 1, i))))
+         return (rc);
+   }
+   value = 7;
+   for (i = 0; i < dups; i += 2) {
+      if ((rc = ih.DeleteEntry(&value, RID(NENTRIES + 1, i))))
+         return (rc);
+   }
+   value = 3;
+   if (ih.DeleteEntry(&value, RID(value + 1, value)) != IX_ENTRYDNE) {
+      printf("Delete error: deleted an entry twice\n");
+      return (IX_EOF);
+   }
+
+   // Reopened, the directory still finds every entry left
+   if ((rc = ixm.CloseIndex(ih)) ||
+         (rc = ixm.OpenIndex(FILENAME, index, ih)))
+      return (rc);
+   for (i = 0; i < 20; i++) {
+      value = i;
+      if ((rc = CountHashEntries(ih, &value, n)))
+         return (rc);
+      int expected = (i == 7) ? dups / 2 : (i % 2 == 0);
+      if (n != expected) {
+         printf("Scan error: found %d entries for key %d, expected %d\n", n, i, expected);
+         return (IX_EOF);
+      }
+   }
+   if ((rc = CountHashEntries(ih, NULL, n)))
+      return (rc);
+   if (n != NENTRIES / 2 + dups / 2) {
+      printf("Scan error: full scan found %d entries, expected %d\n", n, NENTRIES / 2 + dups / 2);
+      return (IX_EOF);
+   }
+
+   if ((rc = ixm.CloseIndex(ih)))
+      return (rc);
+
+   LsFiles(FILENAME);
+
+   if ((rc = ixm.DestroyIndex(FILENAME, index)))
+      return (rc);
+
+   printf("Passed Test 14\n\n");
+   return (0);
+}
+
+//
+// Test15 reads scans in batches: every batch size returns the same rids as
+// single entries do, posting lists included, and a scan deleting half of
+// each batch as it goes still returns every entry once
+//
+static RC ScanBatches(IX_IndexHandle &ih, int low, int high, int batch, RID *rids, int &n)
+{
+   RC rc;
+   IX_IndexScan scan;
+   int got;
+   if ((rc = scan.OpenScan(ih, &low, true, &high, false)))
+      return (rc);
+   for (n = 0; (rc = scan.GetNextEntries(rids + n, batch, got)) == OK_RC; n += got)
+      ;
+   if (rc != IX_EOF || (rc = scan.CloseScan()))
+      return (rc);
+   return (0);
+}
+
+RC Test15(void)
+{
+   RC             rc;
+   IX_IndexHandle ih;
+   IX_IndexScan   scan;
+   int            index=0;
+   int            i, n, value;
+   int            batches[3] = {1, 7, 1000};
+   RID            *expected = new RID[NENTRIES * 2];
+   RID            *rids = new RID[NENTRIES * 2 + 1000];
+
+   printf("Test15: Batched scans... \n");
+
+   // Each value once, and every tenth value again in a posting list
+   if ((rc = ixm.CreateIndex(FILENAME, index, INT, sizeof(int))) ||
+         (rc = ixm.OpenIndex(FILENAME, index, ih)))
+      return (rc);
+   ran(NENTRIES);
+   for (i = 0; i < NENTRIES; i++) {
+      if ((rc = ih.InsertEntry(&values[i], RID(values[i] + 1, values[i]))))
+         return (rc);
+      value = values[i] / 10 * 10;
+      if (values[i] % 10 == 1 &&
+            (rc = ih.InsertEntry(&value, RID(values[i] + 1, values[i] + NENTRIES))))
+         return (rc);
+   }
+
+   int expectedCount;
+   if ((rc = ScanBatches(ih, 100, NENTRIES - 100, 1, expected, expectedCount)))
+      return (rc);
+   if (expectedCount != (NENTRIES - 200) + (NENTRIES - 200) / 10) {
+      printf("Scan error: found %d entries\n", expectedCount);
+      return (IX_EOF);
+   }
+   for (i = 1; i < 3; i++) {
+      if ((rc = ScanBatches(ih, 100, NENTRIES - 100, batches[i], rids, n)))
+         return (rc);
+      if (n != expectedCount || memcmp(rids, expected, n * sizeof(RID)) != 0) {
+         printf("Scan error: batches of %d found %d entries, expected %d\n", batches[i], n, expectedCount);
+         return (IX_EOF);
+      }
+   }
+
+   // Delete the odd keys of each batch before reading the next
+   if ((rc = scan.OpenScan(ih, NO_OP, NULL)))
+      return (rc);
+   int total = 0;
+   while ((rc = scan.GetNextEntries(rids, 10, n)) == OK_RC) {
+      for (i = 0; i < n; i++) {
+         SlotNum slot;
+         rids[i].GetSlotNum(slot);
+         value = slot;
+         if (slot < NENTRIES && slot % 2 == 1 && (rc = ih.DeleteEntry(&value, rids[i])))
+            return (rc);
+      }
+      total += n;
+   }
+   if (rc != IX_EOF || (rc = scan.CloseScan()))
+      return (rc);
+   if (total != NENTRIES + NENTRIES / 10) {
+      printf("Scan error: deleting scan found %d entries, expected %d\n", total, NENTRIES + NENTRIES / 10);
+      return (IX_EOF);
+   }
+   if ((rc = ScanBatches(ih, 0, NENTRIES, 100, rids, n)))
+      return (rc);
+   if (n != NENTRIES / 2 + NENTRIES / 10) {
+      printf("Scan error: %d entries left, expected %d\n", n, NENTRIES / 2 + NENTRIES / 10);
+      return (IX_EOF);
+   }
+   delete [] expected;
+   delete [] rids;
+
+   if ((rc = ixm.CloseIndex(ih)))
+      return (rc);
+
+   LsFiles(FILENAME);
+
+   if ((rc = ixm.DestroyIndex(FILENAME, index)))
+      return (rc);
+
+   printf("Passed Test 15\n\n");
+   return (0);
+}
+
+//
+// Test16 probes a b-tree and a hash index with one batch of keys, unsorted,
+// repeated and missing: each probe gets exactly the rids its key has, in
+// key order
+//
+RC Test16(void)
+{
+   RC             rc;
+   IX_IndexHandle ih;
+   int            index=0;
+   int            i, j, n, t;
+   int            numProbes = 3000;
+   int            *keys = new int[numProbes];
+   int            *counts = new int[numProbes];
+   IndexType      types[2] = {BTREE_INDEX, HASH_INDEX};
+
+   printf("Test16: Batch probes... \n");
+
+   for (t = 0; t < 2; t++) {
+      // Each value once, multiples of 10 three more times in posting lists
+      if ((rc = ixm.CreateIndex(FILENAME, index, INT, sizeof(int), types[t])) ||
+            (rc = ixm.OpenIndex(FILENAME, index, ih)))
+         return (rc);
+      ran(NENTRIES);
+      for (i = 0; i < NENTRIES; i++) {
+         if ((rc = ih.InsertEntry(&values[i], RID(values[i] + 1, values[i]))))
+            return (rc);
+         for (j = 0; values[i] % 10 == 0 && j < 3; j++)
+            if ((rc = ih.InsertEntry(&values[i], RID(NENTRIES + 1 + j, values[i]))))
+               return (rc);
+      }
+
+      for (i = 0; i < numProbes; i++) {
+         keys[i] = rand() % (NENTRIES + 100) - 50;
+         counts[i] = 0;
+      }
+      IX_ProbeResult *results;
+      if ((rc = ih.ProbeKeys(keys, numProbes, results, n)))
+         return (rc);
+      for (i = 0; i < n; i++) {
+         SlotNum slot;
+         results[i].rid.GetSlotNum(slot);
+         if (slot != keys[results[i].probe] ||
+               (i > 0 && keys[results[i - 1].probe] > keys[results[i].probe])) {
+            printf("Probe error: result %d is out of order or for the wrong key\n", i);
+            return (IX_EOF);
+         }
+         counts[results[i].probe]++;
+      }
+      delete [] results;
+
+      for (i = 0; i < numProbes; i++) {
+         RID *rids;
+         int numRids;
+         if ((rc = ih.GetRids(&keys[i], rids, numRids)))
+            return (rc);
+         delete [] rids;
+         if (counts[i] != numRids) {
+            printf("Probe error: key %d got %d rids, expected %d\n", keys[i], counts[i], numRids);
+            return (IX_EOF);
+         }
+      }
+
+      if ((rc = ixm.CloseIndex(ih)))
+         return (rc);
+
+      LsFiles(FILENAME);
+
+      if ((rc = ixm.DestroyIndex(FILENAME, index)))
+         return (rc);
+   }
+   delete [] keys;
+   delete [] counts;
+
+   printf("Passed Test 16\n\n");
+   return (0);
+}
+
+//
+// Test17 keeps the root of a bulk loaded index pinned: after a full scan
+// has cycled every leaf through the buffer pool, a lookup reads only its
+// leaf.  Merging the tree down to a single leaf disposes the pinned root,
+// and inserts splitting it back up pin the new one
+//
+static RC CountEntries(IX_IndexHandle &ih, int &n)
+{
+   RC rc;
+   IX_IndexScan scan;
+   RID rid;
+   if ((rc = scan.OpenScan(ih, NO_OP, NULL)))
+      return (rc);
+   for (n = 0; (rc = scan.GetNextEntry(rid)) == OK_RC; n++)
+      ;
+   if (rc != IX_EOF || (rc = scan.CloseScan()))
+      return (rc);
+   return (0);
+}
+
+#ifdef PF_STATS
+static int PagesRead(void)
+{
+   int *n = pStatisticsMgr->Get(PF_READPAGE);
+   int reads = n ? *n : 0;
+   delete n;
+   return (reads);
+}
+#endif
+
+RC Test17(void)
+{
+   RC             rc;
+   IX_IndexHandle ih;
+   IX_BulkLoader  loader(ixm);
+   int            index=0;
+   int            i, j, n, value;
+   int            pinned[2] = {IX_DESCENT_PAGES, 0};
+   int            keep = 1000;               // one entry kept per keep, fitting a leaf
+
+   printf("Test17: Pinned upper levels... \n");
+
+   if ((rc = ixm.CreateIndex(FILENAME, index, INT, sizeof(int))) ||
+         (rc = ixm.OpenIndex(FILENAME, index, ih)) ||
+         (rc = loader.OpenLoad(FILENAME, index, ih)))
+      return (rc);
+   for (i = 0; i < BULK_ENTRIES; i++) {
+      if ((rc = loader.InsertEntry(&i, RID(i + 1, i))))
+         return (rc);
+   }
+   if ((rc = loader.CloseLoad()))
+      return (rc);
+   if (ih.ixIndexHeader.height == 0 || ih.numPinned == 0) {
+      printf("Pin error: loaded index has %d pinned pages\n", ih.numPinned);
+      return (IX_EOF);
+   }
+
+   // One leaf read per lookup pinned, the root as well unpinned
+   for (j = 0; j < 2; j++) {
+      if ((rc = ih.SetDescentPages(pinned[j])))
+         return (rc);
+      for (i = 0; i < 10; i++) {
+         if ((rc = CountEntries(ih, n)))
+            return (rc);
+         value = (i * 7919) % BULK_ENTRIES;
+         RID *rids;
+#ifdef PF_STATS
+         int reads = PagesRead();
+#endif
+         if ((rc = ih.GetRids(&value, rids, n)))
+            return (rc);
+         delete [] rids;
+         if (n != 1) {
+            printf("Lookup error: key %d found %d times\n", value, n);
+            return (IX_EOF);
+         }
+#ifdef PF_STATS
+         reads = PagesRead() - reads;
+         if (reads != (pinned[j] ? 1 : 2)) {
+            printf("Pin error: lookup read %d pages with %d pinned\n", reads, ih.numPinned);
+            return (IX_EOF);
+         }
+#endif
+      }
+   }
+   if ((rc = ih.SetDescentPages(IX_DESCENT_PAGES)))
+      return (rc);
+
+   // Merge down to a single leaf, then split back up
+   for (i = 0; i < BULK_ENTRIES; i++) {
+      if (i % keep != 0 && (rc = ih.DeleteEntry(&i, RID(i + 1, i))))
+         return (rc);
+   }
+   if (ih.ixIndexHeader.height != 0 || ih.numPinned != 0) {
+      printf("Merge error: height %d with %d pinned pages\n", ih.ixIndexHeader.height, ih.numPinned);
+      return (IX_EOF);
+   }
+   for (i = 0; i < NENTRIES; i++) {
+      value = BULK_ENTRIES + i;
+      if ((rc = ih.InsertEntry(&value, RID(value + 1, value))))
+         return (rc);
+   }
+   if (ih.ixIndexHeader.height == 0 || ih.numPinned == 0) {
+      printf("Pin error: split root not pinned\n");
+      return (IX_EOF);
+   }
+   if ((rc = CountEntries(ih, n)))
+      return (rc);
+   if (n != BULK_ENTRIES / keep + NENTRIES) {
+      printf("Scan error: found %d entries, expected %d\n", n, BULK_ENTRIES / keep + NENTRIES);
+      return (IX_EOF);
+   }
+
+   if ((rc = ixm.CloseIndex(ih)))
+      return (rc);
+
+   LsFiles(FILENAME);
+
+   if ((rc = ixm.DestroyIndex(FILENAME, index)))
+      return (rc);
+
+   printf("Passed Test 17\n\n");
+   return (0);
+}
+
+//
+// Test18 shares an index between threads.  Readers look up the even keys
+// of a bulk loaded index, one at a time, in probe batches and in short
+// range scans, while a writer inserts the odd keys between them, splitting
+// leaves and inner nodes under the readers.  Every even key must be found
+// each time, and a scan must return its keys in order, each once.  Read
+// throughput with one and with all readers is printed for comparison
+//
+struct IX_TestThread {
+   IX_IndexHandle *ih;
+   int            seed;
+   int            count;              // lookups, or the writer's inserts; 0 reads until stop
+   volatile bool  *stop;
+   RC             rc;
+};
+
+static RC CheckRids(int key, RID *rids, int n)
+{
+   PageNum pageNum;
+   SlotNum slotNum;
+   if (n != 1 || rids[0].GetPageNum(pageNum) || rids[0].GetSlotNum(slotNum) ||
+         pageNum != key + 1 || slotNum != key) {
+      printf("Lookup error: key %d found %d rids\n", key, n);
+      return (IX_EOF);
+   }
+   return (0);
+}
+
+static RC ReadEvenKeys(IX_TestThread &t, int round)
+{
+   RC  rc;
+   int key = 2 * (rand_r((unsigned int *)&t.seed) % BULK_ENTRIES);
+   RID *rids;
+   int n;
+
+   switch (round % 3) {
+   case 0:
+      if ((rc = t.ih->GetRids(&key, rids, n)))
+         return (rc);
+      rc = CheckRids(key, rids, n);
+      delete [] rids;
+      return (rc);
+   case 1: {
+      int keys[16];
+      IX_ProbeResult *results;
+      for (int i = 0; i < 16; i++)
+         keys[i] = 2 * (rand_r((unsigned int *)&t.seed) % BULK_ENTRIES);
+      if ((rc = t.ih->ProbeKeys(keys, 16, results, n)))
+         return (rc);
+      for (int i = 0; rc == 0 && i < n; i++)
+         rc = CheckRids(keys[results[i].probe], &results[i].rid, 1);
+      if (rc == 0 && n != 16) {
+         printf("Probe error: %d results for 16 keys\n", n);
+         rc = IX_EOF;
+      }
+      delete [] results;
+      return (rc);
+   }
+   default: {
+      IX_IndexScan scan;
+      RID rid;
+      int high = key + 40, value, last = key - 1, evens = 0;
+      if ((rc = scan.OpenScan(*t.ih, &key, true, &high, false)))
+         return (rc);
+      while ((rc = scan.GetNextEntry(rid, &value)) == OK_RC) {
+         if (value <= last) {
+            printf("Scan error: %d after %d\n", value, last);
+            return (IX_EOF);
+         }
+         last = value;
+         evens += (value % 2 == 0);
+      }
+      if (rc != IX_EOF || (rc = scan.CloseScan()))
+         return (rc);
+      if (evens != min(20, BULK_ENTRIES - key / 2)) {
+         printf("Scan error: %d even keys from %d\n", evens, key);
+         return (IX_EOF);
+      }
+      return (0);
+   }
+   }
+}
+
+static void *Reader(void *arg)
+{
+   IX_TestThread &t = *(IX_TestThread *)arg;
+   t.rc = 0;
+   for (int i = 0; t.rc == 0 && (t.count ? i < t.count : !*t.stop); i++)
+      t.rc = ReadEvenKeys(t, i);
+   return (NULL);
+}
+
+static void *Writer(void *arg)
+{
+   IX_TestThread &t = *(IX_TestThread *)arg;
+   t.rc = 0;
+   for (int i = 0; t.rc == 0 && i < t.count; i++) {
+      int value = 2 * ((i * 7919) % BULK_ENTRIES) + 1;
+      t.rc = t.ih->InsertEntry(&value, RID(value + 1, value));
+   }
+   *t.stop = true;
+   return (NULL);
+}
+
+// Starts threads[0 .. n-1], the first as writer if writer, and joins them
+static RC RunThreads(IX_TestThread *threads, int n, bool writer, double &seconds)
+{
+   pthread_t ids[READERS + 1];
+   timeval start, end;
+   gettimeofday(&start, NULL);
+   for (int i = 0; i < n; i++)
+      pthread_create(&ids[i], NULL, (writer && i == 0) ? Writer : Reader, &threads[i]);
+   for (int i = 0; i < n; i++)
+      pthread_join(ids[i], NULL);
+   gettimeofday(&end, NULL);
+   seconds = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+   for (int i = 0; i < n; i++)
+      if (threads[i].rc)
+         return (threads[i].rc);
+   return (0);
+}
+
+RC Test18(void)
+{
+   RC             rc;
+   IX_IndexHandle ih;
+   IX_BulkLoader  loader(ixm);
+   IX_TestThread  threads[READERS + 1];
+   volatile bool  stop = false;
+   int            index=0;
+   int            i, n, value;
+   double         seconds;
+
+   printf("Test18: Concurrent readers and writer... \n");
+
+   if ((rc = ixm.CreateIndex(FILENAME, index, INT, sizeof(int))) ||
+         (rc = ixm.OpenIndex(FILENAME, index, ih)) ||
+         (rc = loader.OpenLoad(FILENAME, index, ih)))
+      return (rc);
+   for (i = 0; i < BULK_ENTRIES; i++) {
+      value = 2 * i;
+      if ((rc = loader.InsertEntry(&value, RID(value + 1, value))))
+         return (rc);
+   }
+   if ((rc = loader.CloseLoad()))
+      return (rc);
+
+   for (i = 0; i <= READERS; i++) {
+      threads[i].ih = &ih;
+      threads[i].seed = i + 1;
+      threads[i].count = LOOKUPS;
+      threads[i].stop = &stop;
+   }
+
+   // Read throughput, one reader and then all of them
+   if ((rc = RunThreads(threads, 1, false, seconds)))
+      return (rc);
+   printf("  1 reader:  %.0f lookups/s\n", LOOKUPS / seconds);
+   if ((rc = RunThreads(threads, READERS, false, seconds)))
+      return (rc);
+   printf("  %d readers: %.0f lookups/s\n", READERS, READERS * LOOKUPS / seconds);
+
+   // Readers until the writer is done
+   threads[0].count = BULK_ENTRIES / 5;
+   for (i = 1; i <= READERS; i++)
+      threads[i].count = 0;
+   if ((rc = RunThreads(threads, READERS + 1, true, seconds)))
+      return (rc);
+   if ((rc = CountEntries(ih, n)))
+      return (rc);
+   if (n != BULK_ENTRIES + BULK_ENTRIES / 5) {
+      printf("Scan error: found %d entries, expected %d\n", n, BULK_ENTRIES + BULK_ENTRIES / 5);
+      return (IX_EOF);
+   }
+   printf("  inserted %d entries in %.2fs alongside %d readers\n", BULK_ENTRIES / 5, seconds, READERS);
+
+   if ((rc = ixm.CloseIndex(ih)))
+      return (rc);
+
+   LsFiles(FILENAME);
+
+   if ((rc = ixm.DestroyIndex(FILENAME, index)))
+      return (rc);
+
+   printf("Passed Test 18\n\n");
+   return (0);
+}
+
+#ifdef PF_STATS
+static int PagesGot(void)
+{
+   int *n = pStatisticsMgr->Get(PF_GETPAGE);
+   int gets = n ? *n : 0;
+   delete n;
+   return (gets);
+}
+#endif
+
+// Looks up nKeys odd keys from 2 * first + 1, missing from an index of
+// even keys, counting those the filter answered alone, with one page got
+static RC LookupMisses(IX_IndexHandle &ih, int first, int nKeys, int &filtered)
+{
+   RC rc;
+   RID *rids;
+   int n;
+   filtered = 0;
+   for (int i = first; i < first + nKeys; i++) {
+      int value = 2 * i + 1;
+#ifdef PF_STATS
+      int gets = PagesGot();
+#endif
+      if ((rc = ih.GetRids(&value, rids, n)))
+         return (rc);
+      delete [] rids;
+      if (n != 0) {
+         printf("Lookup error: missing key %d found %d times\n", value, n);
+         return (IX_EOF);
+      }
+#ifdef PF_STATS
+      if (PagesGot() - gets == 1)
+         filtered++;
+#else
+      filtered++;
+#endif
+   }
+   return (0);
+}
+
+RC Test19(void)
+{
+   RC             rc;
+   IX_IndexHandle ih;
+   IX_BulkLoader  loader(ixm);
+   IX_ProbeResult *results;
+   int            index=0;
+   int            i, n, value, filtered;
+   int            keys[100];
+   RID            *rids;
+
+   printf("Test19: Bloom filters... \n");
+
+   // A filter built from the index's keys, then kept by inserts
+   if ((rc = ixm.CreateIndex(FILENAME, index, INT, sizeof(int))) ||
+         (rc = ixm.OpenIndex(FILENAME, index, ih)))
+      return (rc);
+   for (i = 0; i < NENTRIES; i++) {
+      value = 2 * i;
+      if ((rc = ih.InsertEntry(&value, RID(value + 1, value))))
+         return (rc);
+   }
+   if ((rc = ixm.CreateBloomFilter(FILENAME, index, ih)))
+      return (rc);
+   for (i = 0; i < FEW_ENTRIES; i++) {
+      value = 2 * i + 1;
+      if ((rc = ih.InsertEntry(&value, RID(value + 1, value))))
+         return (rc);
+   }
+   for (i = 0; i < NENTRIES; i++) {
+      value = 2 * i;
+      if ((rc = ih.GetRids(&value, rids, n)))
+         return (rc);
+      delete [] rids;
+      if (n != 1) {
+         printf("Lookup error: key %d found %d times\n", value, n);
+         return (IX_EOF);
+      }
+   }
+   if ((rc = LookupMisses(ih, FEW_ENTRIES, NENTRIES - FEW_ENTRIES, filtered)))
+      return (rc);
+   printf("  %d of %d misses answered by the filter\n", filtered, NENTRIES - FEW_ENTRIES);
+   if (filtered < (NENTRIES - FEW_ENTRIES) * 95 / 100) {
+      printf("Filter error: too many false positives\n");
+      return (IX_EOF);
+   }
+
+   // Probes skip the keys ruled out, and the filter is kept on reopening
+   for (i = 0; i < 100; i++)
+      keys[i] = i;
+   if ((rc = ih.ProbeKeys(keys, 100, results, n)))
+      return (rc);
+   delete [] results;
+   if (n != 50 + FEW_ENTRIES) {
+      printf("Probe error: found %d rids, expected %d\n", n, 50 + FEW_ENTRIES);
+      return (IX_EOF);
+   }
+   if ((rc = ixm.CloseIndex(ih)) ||
+         (rc = ixm.OpenIndex(FILENAME, index, ih)))
+      return (rc);
+   value = 1;
+   if (!ih.bloomOpen || (rc = ih.GetRids(&value, rids, n)))
+      return (rc ? rc : IX_EOF);
+   delete [] rids;
+   if (n != 1) {
+      printf("Lookup error: key %d found %d times after reopening\n", value, n);
+      return (IX_EOF);
+   }
+   if ((rc = ixm.CloseIndex(ih)))
+      return (rc);
+   LsFiles(FILENAME);
+   if ((rc = ixm.DestroyIndex(FILENAME, index)))
+      return (rc);
+
+   // A bulk load sizes the filter for its entries
+   if ((rc = ixm.CreateIndex(FILENAME, index, INT, sizeof(int))) ||
+         (rc = ixm.OpenIndex(FILENAME, index, ih)) ||
+         (rc = ixm.CreateBloomFilter(FILENAME, index, ih)) ||
+         (rc = loader.OpenLoad(FILENAME, index, ih)))
+      return (rc);
+   for (i = 0; i < BULK_ENTRIES; i++) {
+      value = 2 * i;
+      if ((rc = loader.InsertEntry(&value, RID(value + 1, value))))
+         return (rc);
+   }
+   if ((rc = loader.CloseLoad()))
+      return (rc);
+   for (i = 0; i < BULK_ENTRIES; i += 97) {
+      value = 2 * i;
+      if ((rc = ih.GetRids(&value, rids, n)))
+         return (rc);
+      delete [] rids;
+      if (n != 1) {
+         printf("Lookup error: loaded key %d found %d times\n", value, n);
+         return (IX_EOF);
+      }
+   }
+   if ((rc = LookupMisses(ih, 0, NENTRIES, filtered)))
+      return (rc);
+   printf("  %d pages, %d of %d misses answered by the filter\n", ih.bloomPages, filtered, NENTRIES);
+   if (filtered < NENTRIES * 95 / 100) {
+      printf("Filter error: too many false positives after bulk load\n");
+      return (IX_EOF);
+   }
+
+   if ((rc = ixm.DestroyBloomFilter(FILENAME, index, ih)) ||
+         (rc = ixm.CloseIndex(ih)))
+      return (rc);
+
+   LsFiles(FILENAME);
+
+   if ((rc = ixm.DestroyIndex(FILENAME, index)))
+      return (rc);
+
+   printf("Passed Test 19\n\n");
+   return (0);
+}
+
+//
+// Test20 builds two bitmap indexes over the same rows: scans find each
+// key's rids, bitmaps combine with and, or and not, and deletes drop a key
+// once its last rid goes
+//
+static RID BitmapRid(int i)
+{
+   return (RID(i / 50 + 1, i % 50));
+}
+
+static RC CountBitmapEntries(IX_IndexHandle &ih, CompOp op, int *value, int &n)
+{
+   RC rc;
+   RID rid;
+   IX_IndexScan scan;
+   if ((rc = scan.OpenScan(ih, op, value)))
+      return (rc);
+   for (n = 0; (rc = scan.GetNextEntry(rid)) == OK_RC; n++)
+      ;
+   if (rc != IX_EOF || (rc = scan.CloseScan()))
+      return (rc);
+   return (0);
+}
+
+// Checks a bitmap holds the rows i for which want(i), in rid order
+static RC CheckBitmap(const IX_Bitmap &bitmap, bool (*want)(int), const char *what)
+{
+   RC rc;
+   RID *rids;
+   int n, expected = 0;
+   if ((rc = bitmap.GetRids(rids, n)))
+      return (rc);
+   for (int i = 0; i < NENTRIES; i++) {
+      if (!want(i))
+         continue;
+      RID rid = BitmapRid(i);
+      if (expected >= n || rids[expected].pageNum != rid.pageNum ||
+            rids[expected].slotNum != rid.slotNum || !bitmap.Contains(rid)) {
+         printf("Bitmap error: %s is missing row %d\n", what, i);
+         delete [] rids;
+         return (IX_EOF);
+      }
+      expected++;
+   }
+   delete [] rids;
+   if (n != expected || bitmap.Count() != expected) {
+      printf("Bitmap error: %s has %d rows, expected %d\n", what, n, expected);
+      return (IX_EOF);
+   }
+   return (0);
+}
+
+static bool ColourAndSize(int i) { return (i % 4 == 1 && i % 10 == 3); }
+static bool ColourOrSize(int i) { return (i % 4 == 1 || i % 10 == 3); }
+static bool NotColour(int i) { return (i % 4 != 1); }
+static bool SmallNotColour(int i) { return (i % 10 < 5 && i % 4 != 1); }
+
+RC Test20(void)
+{
+   RC             rc;
+   IX_IndexHandle colours, sizes;
+   IX_BulkLoader  loader(ixm);
+   IX_Bitmap      bitmap, other;
+   int            i, n, value;
+
+   printf("Test20: Bitmap indexes... \n");
+
+   if ((rc = ixm.CreateIndex(FILENAME, 0, INT, sizeof(int), BITMAP_INDEX)) ||
+         (rc = ixm.CreateIndex(FILENAME, 1, INT, sizeof(int), BITMAP_INDEX)) ||
+         (rc = ixm.OpenIndex(FILENAME, 0, colours)) ||
+         (rc = ixm.OpenIndex(FILENAME, 1, sizes)))
+      return (rc);
+   for (i = 0; i < NENTRIES; i++) {
+      int colour = i % 4, size = i % 10;
+      if ((rc = colours.InsertEntry(&colour, BitmapRid(i))) ||
+            (rc = sizes.InsertEntry(&size, BitmapRid(i))))
+         return (rc);
+   }
+
+   // Scans find a key's rids, a range's keys', or every key's
+   value = 1;
+   if ((rc = CountBitmapEntries(colours, EQ_OP, &value, n)))
+      return (rc);
+   if (n != NENTRIES / 4) {
+      printf("Scan error: found %d entries for key 1, expected %d\n", n, NENTRIES / 4);
+      return (IX_EOF);
+   }
+   value = 5;
+   if ((rc = CountBitmapEntries(sizes, LT_OP, &value, n)))
+      return (rc);
+   if (n != NENTRIES / 2) {
+      printf("Scan error: found %d entries below 5, expected %d\n", n, NENTRIES / 2);
+      return (IX_EOF);
+   }
+   if ((rc = CountBitmapEntries(sizes, NO_OP, NULL, n)))
+      return (rc);
+   if (n != NENTRIES) {
+      printf("Scan error: full scan found %d entries, expected %d\n", n, NENTRIES);
+      return (IX_EOF);
+   }
+
+   // Bitmaps of the two indexes combine
+   value = 1;
+   if ((rc = colours.GetBitmap(EQ_OP, &value, bitmap)))
+      return (rc);
+   value = 3;
+   if ((rc = sizes.GetBitmap(EQ_OP, &value, other)))
+      return (rc);
+   IX_Bitmap both(bitmap);
+   both.And(other);
+   if ((rc = CheckBitmap(both, ColourAndSize, "and")))
+      return (rc);
+   both = bitmap;
+   both.Or(other);
+   if ((rc = CheckBitmap(both, ColourOrSize, "or")))
+      return (rc);
+   if ((rc = colours.GetBitmap(NO_OP, NULL, both)))
+      return (rc);
+   bitmap.Not(both);
+   if ((rc = CheckBitmap(bitmap, NotColour, "not")))
+      return (rc);
+   value = 5;
+   if ((rc = sizes.GetBitmap(LT_OP, &value, other)))
+      return (rc);
+   other.And(bitmap);
+   if ((rc = CheckBitmap(other, SmallNotColour, "range and not")))
+      return (rc);
+
+   // Deleting every rid of a key drops it
+   value = 1;
+   for (i = 1; i < NENTRIES; i += 4) {
+      if ((rc = colours.DeleteEntry(&value, BitmapRid(i))))
+         return (rc);
+   }
+   if (colours.DeleteEntry(&value, BitmapRid(1)) != IX_ENTRYDNE) {
+      printf("Delete error: deleted an entry twice\n");
+      return (IX_EOF);
+   }
+   if ((rc = ixm.CloseIndex(colours)) ||
+         (rc = ixm.OpenIndex(FILENAME, 0, colours)))
+      return (rc);
+   if ((rc = CountBitmapEntries(colours, EQ_OP, &value, n)))
+      return (rc);
+   if ((rc = colours.GetBitmap(NE_OP, &value, bitmap)))
+      return (rc);
+   if (n != 0 || (rc = CheckBitmap(bitmap, NotColour, "reopened"))) {
+      printf("Delete error: %d entries left for a deleted key\n", n);
+      return (rc ? rc : IX_EOF);
+   }
+
+   if ((rc = ixm.CloseIndex(colours)) ||
+         (rc = ixm.CloseIndex(sizes)) ||
+         (rc = ixm.DestroyIndex(FILENAME, 1)))
+      return (rc);
+   if ((rc = ixm.DestroyIndex(FILENAME, 0)))
+      return (rc);
+
+   // A bulk load gives the same bitmaps
+   if ((rc = ixm.CreateIndex(FILENAME, 0, INT, sizeof(int), BITMAP_INDEX)) ||
+         (rc = ixm.OpenIndex(FILENAME, 0, colours)) ||
+         (rc = loader.OpenLoad(FILENAME, 0, colours)))
+      return (rc);
+   for (i = 0; i < NENTRIES; i++) {
+      int colour = i % 4;
+      if ((rc = loader.InsertEntry(&colour, BitmapRid(i))))
+         return (rc);
+   }
+   if ((rc = loader.CloseLoad()))
+      return (rc);
+   value = 1;
+   if ((rc = colours.GetBitmap(NE_OP, &value, bitmap)) ||
+         (rc = CheckBitmap(bitmap, NotColour, "loaded")))
+      return (rc);
+
+   if ((rc = ixm.CloseIndex(colours)))
+      return (rc);
+
+   LsFiles(FILENAME);
+
+   if ((rc = ixm.DestroyIndex(FILENAME, 0)))
+      return (rc);
+
+   printf("Passed Test 20\n\n");
+   return (0);
+}
+
+//
+// Test21 keeps entry counts in a B+tree: range counts match scans through
+// inserts with duplicates, deletes that merge nodes, reopening and a bulk
+// load, and the smallest and largest keys are found
+//
+// Rids and distinct keys a range scan finds
+static RC ScanCounts(IX_IndexHandle &ih, int *low, bool lowInclusive,
+      int *high, bool highInclusive, int &nRids, int &nKeys)
+{
+   RC rc;
+   IX_IndexScan scan;
+   RID rid;
+   int key, last = 0;
+   if ((rc = scan.OpenScan(ih, low, lowInclusive, high, highInclusive)))
+      return (rc);
+   for (nRids = nKeys = 0; (rc = scan.GetNextEntry(rid, &key)) == OK_RC; nRids++) {
+      if (nRids == 0 || key != last)
+         nKeys++;
+      last = key;
+   }
+   if (rc != IX_EOF || (rc = scan.CloseScan()))
+      return (rc);
+   return (0);
+}
+
+// Compares CountEntries with a scan, over low..high with each bound in or
+// out, then with either bound left open
+static RC CheckCounts(IX_IndexHandle &ih, int low, int high, const char *what)
+{
+   RC rc;
+   int nRids, nKeys, wantRids, wantKeys;
+   for (int i = 0; i < 6; i++) {
+      int *lowp = (i == 4) ? NULL : &low;
+      int *highp = (i == 5) ? NULL : &high;
+      bool lowInclusive = (i % 2 == 0), highInclusive = (i < 2);
+      if ((rc = ih.CountEntries(lowp, lowInclusive, highp, highInclusive, nRids, nKeys)) ||
+            (rc = ScanCounts(ih, lowp, lowInclusive, highp, highInclusive, wantRids, wantKeys)))
+         return (rc);
+      if (nRids != wantRids || nKeys != wantKeys) {
+         printf("Count error (%s): range %d of %d..%d counted %d rids and %d keys, scan found %d and %d\n",
+               what, i, low, high, nRids, nKeys, wantRids, wantKeys);
+         return (IX_EOF);
+      }
+   }
+   return (0);
+}
+
+static RC CheckEdges(IX_IndexHandle &ih, int wantMin, int wantMax, const char *what)
+{
+   RC rc;
+   int minKey, maxKey;
+   if ((rc = ih.GetMinKey(&minKey)) || (rc = ih.GetMaxKey(&maxKey)))
+      return (rc);
+   if (minKey != wantMin || maxKey != wantMax) {
+      printf("Edge error (%s): keys %d..%d, expected %d..%d\n", what, minKey, maxKey, wantMin, wantMax);
+      return (IX_EOF);
+   }
+   return (0);
+}
+
+RC Test21(void)
+{
+   RC             rc;
+   IX_IndexHandle ih;
+   IX_BulkLoader  loader(ixm);
+   int            index=0;
+   int            i, value, nRids, nKeys;
+
+   printf("Test21: Entry counts... \n");
+
+   // Counts kept from an empty index through inserts, in scattered order
+   if ((rc = ixm.CreateIndex(FILENAME, index, INT, sizeof(int))) ||
+         (rc = ixm.OpenIndex(FILENAME, index, ih)))
+      return (rc);
+   if (ih.GetMinKey(&value) != IX_EOF) {
+      printf("Edge error: an empty index has a smallest key\n");
+      return (IX_EOF);
+   }
+   if ((rc = ixm.CreateEntryCounts(FILENAME, index, ih)) || !ih.FastCounts())
+      return (rc ? rc : IX_EOF);
+   for (i = 0; i < NENTRIES; i++) {
+      value = (i * 37) % COUNT_KEYS;
+      if ((rc = ih.InsertEntry(&value, RID(i + 1, i))))
+         return (rc);
+   }
+   if ((rc = CheckEdges(ih, 0, COUNT_KEYS - 1, "inserted")) ||
+         (rc = CheckCounts(ih, 100, 600, "inserted")) ||
+         (rc = CheckCounts(ih, 0, COUNT_KEYS - 1, "inserted")) ||
+         (rc = CheckCounts(ih, 250, 250, "inserted")))
+      return (rc);
+
+   // Deletes empty the low keys and thin the rest, merging nodes
+   for (i = 0; i < NENTRIES; i++) {
+      value = (i * 37) % COUNT_KEYS;
+      if ((value < COUNT_KEYS / 2 || i % 3 == 0) && (rc = ih.DeleteEntry(&value, RID(i + 1, i))))
+         return (rc);
+   }
+   if ((rc = CheckEdges(ih, COUNT_KEYS / 2, COUNT_KEYS - 1, "deleted")) ||
+         (rc = CheckCounts(ih, 100, 700, "deleted")) ||
+         (rc = CheckCounts(ih, 600, 900, "deleted")))
+      return (rc);
+
+   // Kept on reopening
+   if ((rc = ixm.CloseIndex(ih)) ||
+         (rc = ixm.OpenIndex(FILENAME, index, ih)))
+      return (rc);
+   if (!ih.countsOpen || (rc = CheckCounts(ih, 550, 950, "reopened")))
+      return (rc ? rc : IX_EOF);
+   if ((rc = ixm.CloseIndex(ih)))
+      return (rc);
+   LsFiles(FILENAME);
+   if ((rc = ixm.DestroyIndex(FILENAME, index)))
+      return (rc);
+
+   // A bulk load is counted once built
+   if ((rc = ixm.CreateIndex(FILENAME, index, INT, sizeof(int))) ||
+         (rc = ixm.OpenIndex(FILENAME, index, ih)) ||
+         (rc = ixm.CreateEntryCounts(FILENAME, index, ih)) ||
+         (rc = loader.OpenLoad(FILENAME, index, ih)))
+      return (rc);
+   for (i = 0; i < BULK_ENTRIES; i++) {
+      value = i / BULK_DUPS;
+      if ((rc = loader.InsertEntry(&value, RID(i + 1, i))))
+         return (rc);
+   }
+   if ((rc = loader.CloseLoad()) ||
+         (rc = ih.CountEntries(NULL, false, NULL, false, nRids, nKeys)))
+      return (rc);
+   if (nRids != BULK_ENTRIES || nKeys != BULK_ENTRIES / BULK_DUPS) {
+      printf("Count error: loaded %d rids and %d keys, counted %d and %d\n",
+            BULK_ENTRIES, BULK_ENTRIES / BULK_DUPS, nRids, nKeys);
+      return (IX_EOF);
+   }
+   if ((rc = CheckEdges(ih, 0, BULK_ENTRIES / BULK_DUPS - 1, "loaded")) ||
+         (rc = CheckCounts(ih, 1234, 15678, "loaded")))
+      return (rc);
+
+   // A count reads a path down to each bound, a scan every key between
+#ifdef PF_STATS
+   int low = 1234, high = 15678, wantRids, wantKeys;
+   int countGets = PagesGot();
+   if ((rc = ih.CountEntries(&low, true, &high, true, nRids, nKeys)))
+      return (rc);
+   countGets = PagesGot() - countGets;
+   int scanGets = PagesGot();
+   if ((rc = ScanCounts(ih, &low, true, &high, true, wantRids, wantKeys)))
+      return (rc);
+   scanGets = PagesGot() - scanGets;
+   printf("  %d rids counted from %d pages, scanned from %d\n", nRids, countGets, scanGets);
+   if (countGets * 10 > scanGets) {
+      printf("Count error: a count got %d pages, a scan %d\n", countGets, scanGets);
+      return (IX_EOF);
+   }
+#endif
+
+   if ((rc = ixm.DestroyEntryCounts(FILENAME, index, ih)) ||
+         (rc = ixm.CloseIndex(ih)))
+      return (rc);
+
+   LsFiles(FILENAME);
+
+   if ((rc = ixm.DestroyIndex(FILENAME, index)))
+      return (rc);
+
+   printf("Passed Test 21\n\n");
+   return (0);
+}
+
+// Checks GetStats against what was inserted: nRids rids under nRids /
+// dups keys, all in the histogram bucket of dups, and the clustering
+// factor unless clustering is -1
+static RC CheckStats(IX_IndexHandle &ih, int nRids, int dups, int clustering, const char *what)
+{
+   RC rc;
+   IX_IndexStats stats;
+   int bucket = 0;
+   while ((dups >> (bucket + 1)) > 0)
+      bucket++;
+   if ((rc = ih.GetStats(stats)))
+      return (rc);
+   printf("  %s: height %d, %d leaf pages %d%% full, %d rids, %d keys, clustering %d\n",
+         what, stats.height, stats.leafPages, stats.fillPercent, stats.numRids,
+         stats.numKeys, stats.clustering);
+   if (stats.numRids != nRids || stats.numKeys != nRids / dups ||
+         stats.duplicates[bucket] != nRids / dups || stats.clustering < 1 ||
+         stats.clustering > nRids || (clustering != -1 && stats.clustering != clustering) ||
+         stats.leafPages < 1 || stats.fillPercent < 0 || stats.fillPercent > 100) {
+      printf("Stats error (%s): expected %d rids, %d keys in bucket %d, clustering %d\n",
+            what, nRids, nRids / dups, bucket, clustering);
+      return (IX_EOF);
+   }
+   return (0);
+}
+
+RC Test22(void)
+{
+   RC             rc;
+   IX_IndexHandle ih;
+   IX_BulkLoader  loader(ixm);
+   IX_IndexStats  stats;
+   IndexType      types[3] = {BTREE_INDEX, HASH_INDEX, BITMAP_INDEX};
+   const char     *names[3] = {"btree", "hash", "bitmap"};
+   int            index=0;
+   int            i, t, value;
+
+   printf("Test22: Index statistics... \n");
+
+   // Rids in key order: one page change per RIDS_PER_PAGE entries
+   if ((rc = ixm.CreateIndex(FILENAME, index, INT, sizeof(int))) ||
+         (rc = ixm.OpenIndex(FILENAME, index, ih)) ||
+         (rc = loader.OpenLoad(FILENAME, index, ih)))
+      return (rc);
+   for (i = 0; i < BULK_ENTRIES; i++) {
+      value = i / BULK_DUPS;
+      if ((rc = loader.InsertEntry(&value, RID(i / RIDS_PER_PAGE + 1, i % RIDS_PER_PAGE))))
+         return (rc);
+   }
+   if ((rc = loader.CloseLoad()) ||
+         (rc = CheckStats(ih, BULK_ENTRIES, BULK_DUPS, BULK_ENTRIES / RIDS_PER_PAGE, "loaded")))
+      return (rc);
+   if ((rc = ih.GetStats(stats)))
+      return (rc);
+   if (stats.height != ih.ixIndexHeader.height + 1 || stats.height < 2 || stats.fillPercent < 50) {
+      printf("Stats error: height %d for a tree of %d levels, leaves %d%% full\n",
+            stats.height, ih.ixIndexHeader.height + 1, stats.fillPercent);
+      return (IX_EOF);
+   }
+   if ((rc = ixm.CloseIndex(ih)) ||
+         (rc = ixm.DestroyIndex(FILENAME, index)))
+      return (rc);
+
+   // Keys inserted in scattered order, so a scan in key order moves page
+   // every rid; a hash scan's order is the buckets'
+   for (t = 0; t < 3; t++) {
+      if ((rc = ixm.CreateIndex(FILENAME, index, INT, sizeof(int), types[t])) ||
+            (rc = ixm.OpenIndex(FILENAME, index, ih)))
+         return (rc);
+      for (i = 0; i < NENTRIES; i++) {
+         value = (i * 37) % COUNT_KEYS;
+         if ((rc = ih.InsertEntry(&value, RID(i / RIDS_PER_PAGE + 1, i % RIDS_PER_PAGE))))
+            return (rc);
+      }
+      if ((rc = CheckStats(ih, NENTRIES, NENTRIES / COUNT_KEYS,
+            types[t] == HASH_INDEX ? -1 : NENTRIES, names[t])))
+         return (rc);
+
+      // Deleting all but one rid of each key leaves only unique keys
+      for (i = COUNT_KEYS; i < NENTRIES; i++) {
+         value = (i * 37) % COUNT_KEYS;
+         if ((rc = ih.DeleteEntry(&value, RID(i / RIDS_PER_PAGE + 1, i % RIDS_PER_PAGE))))
+            return (rc);
+      }
+      if ((rc = CheckStats(ih, COUNT_KEYS, 1, -1, names[t])) ||
+            (rc = ixm.CloseIndex(ih)) ||
+            (rc = ixm.DestroyIndex(FILENAME, index)))
+         return (rc);
+   }
+
+   LsFiles(FILENAME);
+
+   printf("Passed Test 22\n\n");
+   return (0);
+}
+
+// Number of a rid given out as RID(i / RIDS_PER_PAGE + 1, i % RIDS_PER_PAGE)
+static int RidNumber(const RID &rid)
+{
+   PageNum pageNum;
+   SlotNum slotNum;
+   rid.GetPageNum(pageNum);
+   rid.GetSlotNum(slotNum);
+   return (pageNum - 1) * RIDS_PER_PAGE + slotNum;
+}
+
+// Checks each comparison with value against the nEntries values inserted,
+// values[i] under rid number i, and that a range comes back in key order
+static RC CheckRadixRanges(IX_RadixIndex &radix, int *values, int nEntries, int value)
+{
+   RC   rc;
+   CompOp ops[7] = {NO_OP, EQ_OP, LT_OP, GT_OP, LE_OP, GE_OP, NE_OP};
+   RID  *rids;
+   int  numRids, i, o, want;
+
+   for (o = 0; o < 7; o++) {
+      if ((rc = radix.GetRange(ops[o], ops[o] == NO_OP ? NULL : &value, rids, numRids)))
+         return (rc);
+      for (want = 0, i = 0; i < nEntries; i++)
+         if (values[i] != INT_MIN &&
+               (ops[o] == NO_OP || (ops[o] == EQ_OP && values[i] == value) ||
+               (ops[o] == LT_OP && values[i] < value) || (ops[o] == GT_OP && values[i] > value) ||
+               (ops[o] == LE_OP && values[i] <= value) || (ops[o] == GE_OP && values[i] >= value) ||
+               (ops[o] == NE_OP && values[i] != value)))
+            want++;
+      for (i = 1; i < numRids && ops[o] != NE_OP; i++)
+         if (values[RidNumber(rids[i - 1])] > values[RidNumber(rids[i])])
+            break;
+      delete [] rids;
+      if (numRids != want || (ops[o] != NE_OP && i < numRids)) {
+         printf("Radix error: op %d value %d found %d rids, expected %d\n",
+               ops[o], value, numRids, want);
+         return (IX_EOF);
+      }
+   }
+   return (0);
+}
+
+RC Test23(void)
+{
+   RC             rc;
+   IX_RadixIndex  radix, loaded;
+   const RID      *found;
+   RID            *rids, *loadedRids;
+   int            *values = new int[NENTRIES];
+   int            i, value, numRids, numLoaded;
+   float          fValue, lastFloat;
+   char           sValue[STRLEN], lastString[STRLEN];
+
+   printf("Test23: Radix index... \n");
+
+   // Keys scattered about 0, each under NENTRIES / COUNT_KEYS rids
+   if ((rc = radix.Init(INT, sizeof(int))))
+      return (rc);
+   for (i = 0; i < NENTRIES; i++) {
+      values[i] = (i * 37) % COUNT_KEYS - COUNT_KEYS / 2;
+      if ((rc = radix.InsertEntry(&values[i], RID(i / RIDS_PER_PAGE + 1, i % RIDS_PER_PAGE))))
+         return (rc);
+   }
+   value = 17;
+   if ((rc = radix.GetRids(&value, found, numRids)))
+      return (rc);
+   if (radix.numKeys != COUNT_KEYS || radix.numRids != NENTRIES ||
+         numRids != NENTRIES / COUNT_KEYS || values[RidNumber(found[0])] != value) {
+      printf("Radix error: %d keys, %d rids, %d rids of %d\n",
+            radix.numKeys, radix.numRids, numRids, value);
+      return (IX_EOF);
+   }
+   for (value = -COUNT_KEYS / 2 - 1; value <= COUNT_KEYS / 2; value += 97)
+      if ((rc = CheckRadixRanges(radix, values, NENTRIES, value)))
+         return (rc);
+
+   // Deleting most keys shrinks and merges nodes
+   for (i = 0; i < NENTRIES; i++) {
+      if (i < COUNT_KEYS && values[i] % 7 == 0)
+         continue;
+      if ((rc = radix.DeleteEntry(&values[i], RID(i / RIDS_PER_PAGE + 1, i % RIDS_PER_PAGE))))
+         return (rc);
+      values[i] = INT_MIN;
+   }
+   for (value = -COUNT_KEYS / 2 - 1; value <= COUNT_KEYS / 2; value += 97)
+      if ((rc = CheckRadixRanges(radix, values, NENTRIES, value)))
+         return (rc);
+   value = 1;
+   if (radix.DeleteEntry(&value, RID(1, 1)) != IX_ENTRYDNE) {
+      printf("Radix error: deleted a missing entry\n");
+      return (IX_EOF);
+   }
+
+   // A snapshot loads back the same entries in the same order
+   if ((rc = radix.SaveSnapshot(pfm, FILENAME)) ||
+         (rc = loaded.LoadSnapshot(pfm, FILENAME)) ||
+         (rc = pfm.DestroyFile(FILENAME)) ||
+         (rc = radix.GetRange(NO_OP, NULL, rids, numRids)) ||
+         (rc = loaded.GetRange(NO_OP, NULL, loadedRids, numLoaded)))
+      return (rc);
+   for (i = 0; i < numRids && numRids == numLoaded; i++)
+      if (RidNumber(rids[i]) != RidNumber(loadedRids[i]))
+         break;
+   delete [] rids;
+   delete [] loadedRids;
+   if (loaded.numKeys != radix.numKeys || loaded.numRids != radix.numRids || i != numRids ||
+         loaded.attrType != INT) {
+      printf("Radix error: snapshot loaded %d keys, %d rids, saved %d and %d\n",
+            loaded.numKeys, loaded.numRids, radix.numKeys, radix.numRids);
+      return (IX_EOF);
+   }
+
+   // Negative floats order before positive ones
+   if ((rc = radix.Init(FLOAT, sizeof(float))))
+      return (rc);
+   for (i = 0; i < NENTRIES; i++) {
+      fValue = ((i * 37) % COUNT_KEYS - COUNT_KEYS / 2) * 0.25f;
+      if ((rc = radix.InsertEntry(&fValue, RID(i / RIDS_PER_PAGE + 1, i % RIDS_PER_PAGE))))
+         return (rc);
+   }
+   fValue = 0.0f;
+   if ((rc = radix.GetRange(LT_OP, &fValue, rids, numRids)))
+      return (rc);
+   for (lastFloat = -COUNT_KEYS, i = 0; i < numRids; i++) {
+      value = RidNumber(rids[i]);
+      fValue = ((value * 37) % COUNT_KEYS - COUNT_KEYS / 2) * 0.25f;
+      if (fValue < lastFloat || fValue >= 0.0f)
+         break;
+      lastFloat = fValue;
+   }
+   delete [] rids;
+   if (i != numRids || numRids != NENTRIES / 2) {
+      printf("Radix error: %d floats below 0, expected %d in order\n", numRids, NENTRIES / 2);
+      return (IX_EOF);
+   }
+
+   // Strings of different lengths, ordered as strcmp orders them
+   if ((rc = radix.Init(STRING, STRLEN)))
+      return (rc);
+   for (i = 0; i < NENTRIES; i++) {
+      memset(sValue, ' ', STRLEN);
+      sprintf(sValue, "key%d", (i * 37) % COUNT_KEYS);
+      if ((rc = radix.InsertEntry(sValue, RID(i / RIDS_PER_PAGE + 1, i % RIDS_PER_PAGE))))
+         return (rc);
+   }
+   strcpy(sValue, "key5");
+   if ((rc = radix.GetRange(GE_OP, sValue, rids, numRids)))
+      return (rc);
+   for (strcpy(lastString, "key5"), i = 0; i < numRids; i++) {
+      sprintf(sValue, "key%d", (RidNumber(rids[i]) * 37) % COUNT_KEYS);
+      if (strcmp(sValue, lastString) < 0)
+         break;
+      strcpy(lastString, sValue);
+   }
+   delete [] rids;
+   if (i != numRids || radix.numKeys != COUNT_KEYS || numRids != 555 * NENTRIES / COUNT_KEYS) {
+      printf("Radix error: %d strings from key5 of %d keys, expected %d in order\n",
+            numRids, radix.numKeys, 555 * NENTRIES / COUNT_KEYS);
+      return (IX_EOF);
+   }
+
+   delete [] values;
+
+   printf("Passed Test 23\n\n");
+   return (0);
+}
+
+// Scans for each comparison with value, checking the rids found against
+// the nEntries values inserted (values[i] under rid number i, INT_MIN
+// once deleted) and that they come in key order.  Composite keys are the
+// value followed by pad
+static RC CheckLayoutScans(IX_IndexHandle &ih, int *values, int nEntries, int value, char *pad)
+{
+   RC           rc;
+   CompOp       ops[6] = {NO_OP, EQ_OP, LT_OP, GT_OP, LE_OP, GE_OP};
+   IX_IndexScan scan;
+   RID          rid;
+   char         key[MAXSTRINGLEN];
+   void         *keyValues[2] = {&value, pad};
+   int          numRids, last, i, o, want;
+
+   if (pad && (rc = ih.EncodeKey(keyValues, 2, false, key)))
+      return (rc);
+   for (o = 0; o < 6; o++) {
+      if ((rc = scan.OpenScan(ih, ops[o], ops[o] == NO_OP ? NULL : pad ? (void *)key : (void *)&value)))
+         return (rc);
+      for (numRids = 0, last = INT_MIN; (rc = scan.GetNextEntry(rid)) == 0; numRids++) {
+         i = RidNumber(rid);
+         if (i >= nEntries || values[i] == INT_MIN || values[i] < last)
+            break;
+         last = values[i];
+      }
+      if (rc == 0) {
+         printf("Layout error: op %d value %d found rid %d out of order\n", ops[o], value, i);
+         return (IX_EOF);
+      }
+      if (rc != IX_EOF)
+         return (rc);
+      if ((rc = scan.CloseScan()))
+         return (rc);
+      for (want = 0, i = 0; i < nEntries; i++)
+         if (values[i] != INT_MIN &&
+               (ops[o] == NO_OP || (ops[o] == EQ_OP && values[i] == value) ||
+               (ops[o] == LT_OP && values[i] < value) || (ops[o] == GT_OP && values[i] > value) ||
+               (ops[o] == LE_OP && values[i] <= value) || (ops[o] == GE_OP && values[i] >= value)))
+            want++;
+      if (numRids != want) {
+         printf("Layout error: op %d value %d found %d rids, expected %d\n",
+               ops[o], value, numRids, want);
+         return (IX_EOF);
+      }
+   }
+   return (0);
+}
+
+RC Test24(void)
+{
+   RC             rc;
+   IX_IndexHandle ih;
+   PF_PageHandle  ph;
+   char           *pData;
+   char           pad[PAD_LEN];
+   char           key[MAXSTRINGLEN];
+   AttrType       keyTypes[2] = {INT, STRING};
+   int            keyLengths[2] = {sizeof(int), PAD_LEN};
+   void           *keyValues[2];
+   int            *values = new int[LAYOUT_KEYS];
+   int            index=0;
+   int            i, c, l, value, nEntries;
+   const char     *names[3] = {"interleaved", "separated", "separated with hints"};
+
+   printf("Test24: Node layouts... \n");
+
+   // Int keys, then long composite keys giving nodes of about twenty,
+   // in each layout
+   memset(pad, 0, PAD_LEN);
+   strcpy(pad, "pad");
+   keyValues[0] = &value;
+   keyValues[1] = pad;
+   for (c = 0; c < 2; c++) {
+      nEntries = c ? LAYOUT_KEYS / 10 : LAYOUT_KEYS;
+      for (l = 0; l < 3; l++) {
+         printf("  %s %s keys\n", names[l], c ? "composite" : "int");
+         if ((rc = ixm.SetNodeLayout(l > 0, l == 2 ? IX_NODE_HINTS : 0)))
+            return (rc);
+         if (c)
+            rc = ixm.CreateIndex(FILENAME, index, 2, keyTypes, keyLengths);
+         else
+            rc = ixm.CreateIndex(FILENAME, index, INT, sizeof(int));
+         if (rc || (rc = ixm.OpenIndex(FILENAME, index, ih)))
+            return (rc);
+         if (ih.ixIndexHeader.separated != (l > 0) ||
+               ih.ixIndexHeader.numHints != (l == 2 ? IX_NODE_HINTS : 0)) {
+            printf("Layout error: %s index created otherwise\n", names[l]);
+            return (IX_EOF);
+         }
+
+         // Unique keys about 0, inserted in scattered order
+         for (i = 0; i < nEntries; i++) {
+            values[i] = value = (int)((i * 7919L) % nEntries) - nEntries / 2;
+            if ((c && (rc = ih.EncodeKey(keyValues, 2, false, key))) ||
+                  (rc = ih.InsertEntry(c ? (void *)key : (void *)&value,
+                        RID(i / RIDS_PER_PAGE + 1, i % RIDS_PER_PAGE))))
+               return (rc);
+         }
+         for (value = -nEntries / 2 - 1; value <= nEntries / 2; value += nEntries / 7)
+            if ((rc = CheckLayoutScans(ih, values, nEntries, value, c ? pad : NULL)))
+               return (rc);
+
+         // Deleting two keys in three merges nodes
+         for (i = 0; i < nEntries; i++) {
+            if (i % 3 == 0)
+               continue;
+            value = values[i];
+            if ((c && (rc = ih.EncodeKey(keyValues, 2, false, key))) ||
+                  (rc = ih.DeleteEntry(c ? (void *)key : (void *)&value,
+                        RID(i / RIDS_PER_PAGE + 1, i % RIDS_PER_PAGE))))
+               return (rc);
+            values[i] = INT_MIN;
+         }
+         for (value = -nEntries / 2 - 1; value <= nEntries / 2; value += nEntries / 7)
+            if ((rc = CheckLayoutScans(ih, values, nEntries, value, c ? pad : NULL)))
+               return (rc);
+
+         // Separated keys start aligned in the buffer pool
+         if ((rc = ih.pfFileHandle.GetThisPage(ih.ixIndexHeader.rootPage, ph)) ||
+               (rc = ph.GetData(pData)))
+            return (rc);
+         char *keys = ih.ixIndexHeader.height > 0 ? ih.GetKeyPtr(pData, 0) : ih.GetEntryPtr(pData, 0);
+         if ((rc = ih.pfFileHandle.UnpinPage(ih.ixIndexHeader.rootPage)))
+            return (rc);
+         if (l > 0 && (size_t)keys % IX_ALIGN != 0) {
+            printf("Layout error: root keys at %p, not %d byte aligned\n", (void *)keys, IX_ALIGN);
+            return (IX_EOF);
+         }
+         if ((rc = ixm.CloseIndex(ih)) ||
+               (rc = ixm.DestroyIndex(FILENAME, index)))
+            return (rc);
+
+         // A bulk load of those left
+         IX_BulkLoader loader(ixm);
+         if (c)
+            rc = ixm.CreateIndex(FILENAME, index, 2, keyTypes, keyLengths);
+         else
+            rc = ixm.CreateIndex(FILENAME, index, INT, sizeof(int));
+         if (rc || (rc = ixm.OpenIndex(FILENAME, index, ih)) ||
+               (rc = loader.OpenLoad(FILENAME, index, ih)))
+            return (rc);
+         for (i = 0; i < nEntries; i++) {
+            if ((value = values[i]) == INT_MIN)
+               continue;
+            if ((c && (rc = ih.EncodeKey(keyValues, 2, false, key))) ||
+                  (rc = loader.InsertEntry(c ? (void *)key : (void *)&value,
+                        RID(i / RIDS_PER_PAGE + 1, i % RIDS_PER_PAGE))))
+               return (rc);
+         }
+         if ((rc = loader.CloseLoad()))
+            return (rc);
+         for (value = -nEntries / 2 - 1; value <= nEntries / 2; value += nEntries / 7)
+            if ((rc = CheckLayoutScans(ih, values, nEntries, value, c ? pad : NULL)))
+               return (rc);
+         if ((rc = ixm.CloseIndex(ih)) ||
+               (rc = ixm.DestroyIndex(FILENAME, index)))
+            return (rc);
+      }
+   }
+   if ((rc = ixm.SetNodeLayout(true)))
+      return (rc);
+
+   LsFiles(FILENAME);
+
+   delete [] values;
+
+   printf("Passed Test 24\n\n");
+   return (0);
+}
@@ -39,26 +39,6 @@ using namespace std;
 
 
 // GINA START
-char* GetKeyPtr(IX_IndexHeader ixIndexHeader, char* pData, const SlotNum slotNum)
-{
-	char* ptr = pData + ixIndexHeader.internalHeaderSize;
-	ptr += sizeof(PageNum);
-	ptr += slotNum * (ixIndexHeader.attrLength + sizeof(PageNum));
-	return ptr;
-}
-char* GetEntryPtr(IX_IndexHeader ixIndexHeader, char* pData, const SlotNum slotNum)
-{
-	char* ptr = pData + ixIndexHeader.leafHeaderSize;
-	ptr += slotNum * (ixIndexHeader.attrLength + sizeof(PageNum) + sizeof(SlotNum));
-	return ptr;
-}
-bool GetSlotBitValue(char* pData, const SlotNum slotNum)
-{
-	char c = *(pData + IX_BIT_START + slotNum / 8); //bits per byte
-	return c & (1 << slotNum % 8);
-}
-
-
 RC PrintIndex(IX_IndexHandle &ih){
 	queue<pair<int, PageNum> > myQueue;
 	pair<int, PageNum> tmp = make_pair(ih.ixIndexHeader.height, ih.ixIndexHeader.rootPage);
@@ -94,9 +74,9 @@ RC PrintIndex(IX_IndexHandle &ih){
 			int entrySize = ih.ixIndexHeader.attrLength +  sizeof(PageNum) + sizeof(SlotNum);
 			char* array = new char[entrySize];
 			for (SlotNum slotNum = 0; slotNum <= ih.ixIndexHeader.maxEntryIndex; ++slotNum){
-				if (GetSlotBitValue(pData, slotNum)){
-					char* ptr = GetEntryPtr(ih.ixIndexHeader, pData, slotNum);
-					memcpy(array, ptr, entrySize);
+				if (ih.GetSlotBitValue(pData, slotNum)){
+					char* ptr = array;
+					memcpy(array, ih.GetEntry(pData, slotNum, array), entrySize);
                     int attr;
                     memcpy(&attr, ptr, 4);
 					ptr += ih.ixIndexHeader.attrLength;
@@ -130,9 +110,9 @@ RC PrintIndex(IX_IndexHandle &ih){
 				}
 
 				for (SlotNum slotNum = 0; slotNum <= ih.ixIndexHeader.maxEntryIndex; ++slotNum){
-					if (GetSlotBitValue(bData, slotNum)){
-						char* ptr = GetEntryPtr(ih.ixIndexHeader, bData, slotNum);
-						memcpy(array, ptr, entrySize);
+					if (ih.GetSlotBitValue(bData, slotNum)){
+						char* ptr = array;
+						memcpy(array, ih.GetEntry(bData, slotNum, array), entrySize);
 						ptr += ih.ixIndexHeader.attrLength;
 						PageNum p;
 						SlotNum s;
@@ -162,22 +142,17 @@ RC PrintIndex(IX_IndexHandle &ih){
 			int keySize = ih.ixIndexHeader.attrLength;
 			char* array = new char[keySize];
 			for (SlotNum slotNum = 0; slotNum < numKeys; ++slotNum){
-				char* ptr = GetKeyPtr(ih.ixIndexHeader, pData, slotNum);
+				ih.GetKey(pData, slotNum, array);
 				int attr;
-				memcpy(&attr, ptr, sizeof(int));
+				memcpy(&attr, array, sizeof(int));
 				cerr << " " << attr; //Print key
 				
-				ptr -= sizeof(PageNum);
-				PageNum pageTmp;
-				memcpy(&pageTmp, ptr, sizeof(PageNum));
+				PageNum pageTmp = ih.GetChildPage(pData, slotNum);
 				tmp = make_pair(prevHeight - 1, ih.ixIndexHeader.rootPage);
 				myQueue.push(tmp);
 			}
 
-			char* ptr = GetKeyPtr(ih.ixIndexHeader, pData, numKeys);
-			ptr -= sizeof(PageNum);
-			PageNum pageTmp;
-			memcpy(&pageTmp, ptr, sizeof(PageNum));
+			PageNum pageTmp = ih.GetChildPage(pData, numKeys);
 			tmp = make_pair(prevHeight - 1, ih.ixIndexHeader.rootPage);
 			myQueue.push(tmp);
 
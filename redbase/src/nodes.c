@@ -95,12 +95,13 @@ NODE *create_table_node(char *relname, NODE *attrlist)
  * create_index_node: allocates, initializes, and returns a pointer to a new
  * create index node having the indicated values.
  */
-NODE *create_index_node(char *relname, char *attrname)
+NODE *create_index_node(char *relname, NODE *attrlist, char *indextype)
 {
     NODE *n = newnode(N_CREATEINDEX);
 
     n -> u.CREATEINDEX.relname = relname;
-    n -> u.CREATEINDEX.attrname = attrname;
+    n -> u.CREATEINDEX.attrlist = attrlist;
+    n -> u.CREATEINDEX.indextype = indextype;
     return n;
 }
 
@@ -108,12 +109,12 @@ NODE *create_index_node(char *relname, char *attrname)
  * drop_index_node: allocates, initializes, and returns a pointer to a new
  * drop index node having the indicated values.
  */
-NODE *drop_index_node(char *relname, char *attrname)
+NODE *drop_index_node(char *relname, NODE *attrlist)
 {
     NODE *n = newnode(N_DROPINDEX);
 
     n -> u.DROPINDEX.relname = relname;
-    n -> u.DROPINDEX.attrname = attrname;
+    n -> u.DROPINDEX.attrlist = attrlist;
     return n;
 }
 
@@ -167,6 +168,18 @@ NODE *help_node(char *relname)
     return n;
 }
 
+/*
+ * help_index_node: allocates, initializes, and returns a pointer to a new
+ * help index node having the indicated values.
+ */
+NODE *help_index_node(char *relname)
+{
+    NODE *n = newnode(N_HELPINDEX);
+
+    n -> u.HELPINDEX.relname = relname;
+    return n;
+}
+
 /*
  * print_node: allocates, initializes, and returns a pointer to a new
  * print node having the indicated values.
@@ -179,6 +192,43 @@ NODE *print_node(char *relname)
     return n;
 }
 
+/*
+ * vacuum_node: allocates, initializes, and returns a pointer to a new
+ * vacuum node having the indicated values.
+ */
+NODE *vacuum_node(char *relname)
+{
+    NODE *n = newnode(N_VACUUM);
+
+    n -> u.VACUUM.relname = relname;
+    return n;
+}
+
+/*
+ * reindex_node: allocates, initializes, and returns a pointer to a new
+ * reindex node having the indicated values.
+ */
+NODE *reindex_node(char *relname, NODE *attrlist)
+{
+    NODE *n = newnode(N_REINDEX);
+
+    n -> u.REINDEX.relname = relname;
+    n -> u.REINDEX.attrlist = attrlist;
+    return n;
+}
+
+/*
+ * analyze_node: allocates, initializes, and returns a pointer to a new
+ * analyze node having the indicated values.
+ */
+NODE *analyze_node(char *relname)
+{
+    NODE *n = newnode(N_ANALYZE);
+
+    n -> u.ANALYZE.relname = relname;
+    return n;
+}
+
 /*
  * query_node: allocates, initializes, and returns a pointer to a new
  * query node having the indicated values.
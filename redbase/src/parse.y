@@ -110,6 +110,10 @@ QL_Manager *pQlm;          // QL component manager
       RW_QUERY_PLAN
       RW_ON
       RW_OFF
+      RW_VACUUM
+      RW_REINDEX
+      RW_USING
+      RW_ANALYZE
 
 %token   <ival>   T_INT
 
@@ -122,6 +126,7 @@ QL_Manager *pQlm;          // QL component manager
 %type   <cval>   op
 
 %type   <sval>   opt_relname
+      opt_index_type
 
 %type   <n>   command
       ddl
@@ -135,6 +140,9 @@ QL_Manager *pQlm;          // QL component manager
       set
       help
       print
+      vacuum
+      reindex
+      analyze
       exit
       query
       insert
@@ -143,6 +151,7 @@ QL_Manager *pQlm;          // QL component manager
       non_mt_attrtype_list
       attrtype
       non_mt_relattr_list
+      non_mt_attrname_list
       non_mt_select_clause
       relattr
       non_mt_relation_list
@@ -222,6 +231,9 @@ utility
    | set
    | help
    | print
+   | vacuum
+   | reindex
+   | analyze
    | buffer
    | statistics 
    | queryplans 
@@ -297,9 +309,9 @@ createtable
    ;
 
 createindex
-   : RW_CREATE RW_INDEX T_STRING '(' T_STRING ')'
+   : RW_CREATE RW_INDEX T_STRING '(' non_mt_attrname_list ')' opt_index_type
    {
-      $$ = create_index_node($3, $5);
+      $$ = create_index_node($3, $5, $7);
    }
    ;
 
@@ -311,7 +323,7 @@ droptable
    ;
 
 dropindex
-   : RW_DROP RW_INDEX T_STRING '(' T_STRING ')'
+   : RW_DROP RW_INDEX T_STRING '(' non_mt_attrname_list ')'
    {
       $$ = drop_index_node($3, $5);
    }
@@ -337,6 +349,10 @@ help
    {
       $$ = help_node($2);
    }
+   | RW_HELP RW_INDEX T_STRING
+   {
+      $$ = help_index_node($3);
+   }
    ;
 
 print
@@ -346,6 +362,27 @@ print
    }
    ;
 
+vacuum
+   : RW_VACUUM T_STRING
+   {
+      $$ = vacuum_node($2);
+   }
+   ;
+
+reindex
+   : RW_REINDEX T_STRING '(' non_mt_attrname_list ')'
+   {
+      $$ = reindex_node($2, $4);
+   }
+   ;
+
+analyze
+   : RW_ANALYZE T_STRING
+   {
+      $$ = analyze_node($2);
+   }
+   ;
+
 exit
    : RW_EXIT
    {
@@ -419,6 +456,17 @@ non_mt_relattr_list
    }
    ;
 
+non_mt_attrname_list
+   : T_STRING ',' non_mt_attrname_list
+   {
+      $$ = prepend(relattr_node(NULL, $1), $3);
+   }
+   | T_STRING
+   {
+      $$ = list_node(relattr_node(NULL, $1));
+   }
+   ;
+
 relattr
    : T_STRING '.' T_STRING
    {
@@ -525,6 +573,17 @@ opt_relname
    }
    ;
 
+opt_index_type
+   : RW_USING T_STRING
+   {
+      $$ = $2;
+   }
+   | nothing
+   {
+      $$ = NULL;
+   }
+   ;
+
 op
    : T_LT
    {
@@ -51,7 +51,11 @@ typedef enum{
     N_LOAD,
     N_SET,
     N_HELP,
+    N_HELPINDEX,
     N_PRINT,
+    N_VACUUM,
+    N_REINDEX,
+    N_ANALYZE,
     N_QUERY,
     N_INSERT,
     N_DELETE,
@@ -83,13 +87,14 @@ typedef struct node{
       /* create index node */
       struct{
          char *relname;
-         char *attrname;
+         struct node *attrlist;
+         char *indextype;
       } CREATEINDEX;
 
       /* drop index node */
       struct{
          char *relname;
-         char *attrname;
+         struct node *attrlist;
       } DROPINDEX;
 
       /* drop table node */
@@ -114,11 +119,32 @@ typedef struct node{
          char *relname;
       } HELP;
 
+      /* help index node */
+      struct{
+         char *relname;
+      } HELPINDEX;
+
       /* print node */
       struct{
          char *relname;
       } PRINT;
 
+      /* vacuum node */
+      struct{
+         char *relname;
+      } VACUUM;
+
+      /* reindex node */
+      struct{
+         char *relname;
+         struct node *attrlist;
+      } REINDEX;
+
+      /* analyze node */
+      struct{
+         char *relname;
+      } ANALYZE;
+
       /* QL component nodes */
       /* query node */
       struct{
@@ -201,13 +227,17 @@ typedef struct node{
  */
 NODE *newnode(NODEKIND kind);
 NODE *create_table_node(char *relname, NODE *attrlist);
-NODE *create_index_node(char *relname, char *attrname);
-NODE *drop_index_node(char *relname, char *attrname);
+NODE *create_index_node(char *relname, NODE *attrlist, char *indextype);
+NODE *drop_index_node(char *relname, NODE *attrlist);
 NODE *drop_table_node(char *relname);
 NODE *load_node(char *relname, char *filename);
 NODE *set_node(char *paramName, char *string);
 NODE *help_node(char *relname);
+NODE *help_index_node(char *relname);
 NODE *print_node(char *relname);
+NODE *vacuum_node(char *relname);
+NODE *reindex_node(char *relname, NODE *attrlist);
+NODE *analyze_node(char *relname);
 NODE *query_node(NODE *relattrlist, NODE *rellist, NODE *conditionlist);
 NODE *insert_node(char *relname, NODE *valuelist);
 NODE *delete_node(char *relname, NODE *conditionlist);
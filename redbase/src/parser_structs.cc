@@ -11,6 +11,7 @@ AttrInfo::AttrInfo(){
 	attrName = NULL;
 	attrType = INT;
 	attrLength = 4;
+	encoded = false;
 }
 AttrInfo::AttrInfo(const AttrInfo& other){
 	attrName = new char[MAXNAME+1];
@@ -19,6 +20,7 @@ AttrInfo::AttrInfo(const AttrInfo& other){
 	strcpy(attrName, other.attrName);
 	attrType = other.attrType;
 	attrLength = other.attrLength;
+	encoded = other.encoded;
 }
 AttrInfo::~AttrInfo(){
 	if (del && attrName)
@@ -36,6 +38,7 @@ AttrInfo& AttrInfo::operator=(const AttrInfo& other){
 		strcpy(attrName, other.attrName);
 		attrType = other.attrType;
 		attrLength = other.attrLength;
+		encoded = other.encoded;
 	}
 	return *this;
 }
@@ -47,6 +50,7 @@ AttrInfo::AttrInfo(Attrcat attrcat){
 
 	attrType = attrcat.attrType;
 	attrLength = attrcat.attrLen;
+	encoded = false;
 }
 
 
@@ -169,6 +173,7 @@ Condition& Condition::operator=(const Condition& other){
 	bRhsIsAttr = other.bRhsIsAttr;
 	rhsAttr = other.rhsAttr;
 	rhsValue = other.rhsValue;
+	return *this;
 }
 bool Condition::operator==(const Condition &other) const{
 	if (!(lhsAttr == other.lhsAttr && op == other.op && bRhsIsAttr == other.bRhsIsAttr))
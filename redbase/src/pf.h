@@ -12,6 +12,7 @@
 //       a particular file.  Allows students to use main memory chunks
 //       that are associated with (and limited by) the buffer.
 // 2005: Added GetLastPage and GetPrevPage for rocking
+//       Page latches let several threads share the pages of a file.
 
 #ifndef PF_H
 #define PF_H
@@ -54,6 +55,12 @@ private:
    char *pPageData;                               // pointer to page data
 };
 
+//
+// PF_LatchMode: page latch modes.  Shared latches go together and with one
+// update latch; an exclusive latch goes with no other
+//
+enum PF_LatchMode { PF_SHARED, PF_UPDATE, PF_EXCLUSIVE };
+
 //
 // PF_FileHdr: Header structure for files
 //
@@ -93,8 +100,16 @@ public:
    RC AllocatePage(PF_PageHandle &pageHandle);    // Allocate a new page
    RC DisposePage (PageNum pageNum);              // Dispose of a page
    RC MarkDirty   (PageNum pageNum) const;        // Mark page as dirty
+   RC GetPageVersion(PageNum pageNum, int &version) const; // Changes when
+                                                  // a pinned page does
    RC UnpinPage   (PageNum pageNum) const;        // Unpin the page
 
+   // Latch a pinned page, waiting for latches it conflicts with
+   RC LatchPage   (PageNum pageNum, PF_LatchMode mode) const;
+   RC UnlatchPage (PageNum pageNum, PF_LatchMode mode) const;
+   // Turn the update latch the caller holds into an exclusive one
+   RC UpgradeLatch(PageNum pageNum) const;
+
    // Flush pages from buffer pool.  Will write dirty pages to disk.
    RC FlushPages  () const;
 
@@ -172,7 +187,8 @@ void PF_PrintError(RC rc);
 #define PF_PAGEUNPINNED    (START_PF_WARN + 6) // page already unpinned
 #define PF_EOF             (START_PF_WARN + 7) // end of file
 #define PF_TOOSMALL        (START_PF_WARN + 8) // Resize buffer too small
-#define PF_LASTWARN        PF_TOOSMALL
+#define PF_PAGELATCHED     (START_PF_WARN + 9) // page latched exclusively
+#define PF_LASTWARN        PF_PAGELATCHED
 
 #define PF_NOMEM           (START_PF_ERR - 0)  // no memory
 #define PF_NOBUF           (START_PF_ERR - 1)  // no buffer space
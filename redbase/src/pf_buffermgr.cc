@@ -13,6 +13,8 @@
 //       pf_test2.cc for a demo.
 // 1998: The statistics manager is now instantiated in this file and is
 //       created and destroyed by the buffer manager.
+//       Calls are serialized by a mutex, and pinned pages can be latched,
+//       so several threads may share the buffer.
 //
 
 #include <cstdio>
@@ -32,6 +34,21 @@ using namespace std;
 StatisticsMgr *pStatisticsMgr;
 #endif
 
+//
+// PF_BufferLock
+//
+// Desc: Holds the buffer manager's mutex for the length of a call.  The
+//       mutex is recursive, since some calls make others.
+//
+class PF_BufferLock {
+public:
+   PF_BufferLock (pthread_mutex_t &_mutex) : mutex(_mutex)
+      { pthread_mutex_lock(&mutex); }
+   ~PF_BufferLock() { pthread_mutex_unlock(&mutex); }
+private:
+   pthread_mutex_t &mutex;
+};
+
 #ifdef PF_LOG
 
 //
@@ -100,6 +117,14 @@ PF_BufferMgr::PF_BufferMgr(int _numPages) : hashTable(PF_HASH_TBL_SIZE)
    // Initialize local variables
    this->numPages = _numPages;
    pageSize = PF_PAGE_SIZE + sizeof(PF_PageHdr);
+   lastVersion = 0;
+
+   pthread_mutexattr_t attr;
+   pthread_mutexattr_init(&attr);
+   pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+   pthread_mutex_init(&mutex, &attr);
+   pthread_mutexattr_destroy(&attr);
+   pthread_cond_init(&latchCond, NULL);
 
 #ifdef PF_STATS
    // Initialize the global variable for the statistics manager
@@ -151,6 +176,9 @@ PF_BufferMgr::~PF_BufferMgr()
 
    delete [] bufTable;
 
+   pthread_cond_destroy(&latchCond);
+   pthread_mutex_destroy(&mutex);
+
 #ifdef PF_STATS
    // Destroy the global statistics manager
    delete pStatisticsMgr;
@@ -179,6 +207,7 @@ PF_BufferMgr::~PF_BufferMgr()
 RC PF_BufferMgr::GetPage(int fd, PageNum pageNum, char **ppBuffer,
       int bMultiplePins)
 {
+   PF_BufferLock lock(mutex);
    RC  rc;     // return code
    int slot;   // buffer slot where page is located
 
@@ -267,6 +296,7 @@ RC PF_BufferMgr::GetPage(int fd, PageNum pageNum, char **ppBuffer,
 //
 RC PF_BufferMgr::AllocatePage(int fd, PageNum pageNum, char **ppBuffer)
 {
+   PF_BufferLock lock(mutex);
    RC  rc;     // return code
    int slot;   // buffer slot where page is located
 
@@ -319,6 +349,7 @@ RC PF_BufferMgr::AllocatePage(int fd, PageNum pageNum, char **ppBuffer)
 //
 RC PF_BufferMgr::MarkDirty(int fd, PageNum pageNum)
 {
+   PF_BufferLock lock(mutex);
    RC  rc;       // return code
    int slot;     // buffer slot where page is located
 
@@ -341,6 +372,7 @@ RC PF_BufferMgr::MarkDirty(int fd, PageNum pageNum)
 
    // Mark this page dirty
    bufTable[slot].bDirty = TRUE;
+   bufTable[slot].version = ++lastVersion;
 
    // Make this page the most recently used page
    if ((rc = Unlink(slot)) ||
@@ -351,6 +383,157 @@ RC PF_BufferMgr::MarkDirty(int fd, PageNum pageNum)
    return (0);
 }
 
+//
+// GetPageVersion
+//
+// Desc: Return the version stamp of a pinned page.  The stamp changes
+//       whenever the page is marked dirty or read into the buffer, so a
+//       caller that finds it unchanged knows the page is too.
+// In:   fd - OS file descriptor of the file associated with the page
+//       pageNum - number of the page
+// Out:  version - the page's stamp
+// Ret:  PF return code
+//
+RC PF_BufferMgr::GetPageVersion(int fd, PageNum pageNum, int &version)
+{
+   PF_BufferLock lock(mutex);
+   RC  rc;       // return code
+   int slot;     // buffer slot where page is located
+
+   // The page must be found and pinned in the buffer
+   if ((rc = hashTable.Find(fd, pageNum, slot))){
+      if ((rc == PF_HASHNOTFOUND))
+         return (PF_PAGENOTINBUF);
+      else
+         return (rc);              // unexpected error
+   }
+
+   if (bufTable[slot].pinCount == 0)
+      return (PF_PAGEUNPINNED);
+
+   // The page may be mid-change while latched exclusively
+   version = bufTable[slot].version;
+   if (bufTable[slot].exclusive)
+      return (PF_PAGELATCHED);
+
+   // Return ok
+   return (0);
+}
+
+//
+// LatchPage
+//
+// Desc: Latch a pinned page, waiting until no latch held on it conflicts.
+//       Shared latches go together and with one update latch; exclusive
+//       latches go with no other.  A shared latch also waits while an
+//       update latch is being upgraded, so a stream of readers cannot
+//       starve it.  Exclusive latches restamp the page version as they
+//       come and go, so a reader copying the page unlatched can tell it
+//       was not changed meanwhile.
+// In:   fd - OS file descriptor of the file associated with the page
+//       pageNum - number of the page
+//       mode - latch mode
+// Ret:  PF return code
+//
+RC PF_BufferMgr::LatchPage(int fd, PageNum pageNum, PF_LatchMode mode)
+{
+   PF_BufferLock lock(mutex);
+   RC  rc;       // return code
+   int slot;     // buffer slot where page is located
+
+   if ((rc = FindPinned(fd, pageNum, slot)))
+      return (rc);
+
+   while (bufTable[slot].exclusive ||
+         (mode == PF_SHARED && bufTable[slot].upgrading) ||
+         (mode != PF_SHARED && bufTable[slot].update) ||
+         (mode == PF_EXCLUSIVE && bufTable[slot].shared > 0))
+      pthread_cond_wait(&latchCond, &mutex);
+
+   switch (mode) {
+   case PF_SHARED:
+      bufTable[slot].shared++;
+      break;
+   case PF_UPDATE:
+      bufTable[slot].update = TRUE;
+      break;
+   case PF_EXCLUSIVE:
+      bufTable[slot].exclusive = TRUE;
+      bufTable[slot].version = ++lastVersion;
+      break;
+   }
+
+   // Return ok
+   return (0);
+}
+
+//
+// UnlatchPage
+//
+// Desc: Release a latch taken by LatchPage, waking any waiting on it.
+// In:   fd - OS file descriptor of the file associated with the page
+//       pageNum - number of the page
+//       mode - mode it was latched in
+// Ret:  PF return code
+//
+RC PF_BufferMgr::UnlatchPage(int fd, PageNum pageNum, PF_LatchMode mode)
+{
+   PF_BufferLock lock(mutex);
+   RC  rc;       // return code
+   int slot;     // buffer slot where page is located
+
+   if ((rc = FindPinned(fd, pageNum, slot)))
+      return (rc);
+
+   switch (mode) {
+   case PF_SHARED:
+      bufTable[slot].shared--;
+      break;
+   case PF_UPDATE:
+      bufTable[slot].update = FALSE;
+      break;
+   case PF_EXCLUSIVE:
+      bufTable[slot].exclusive = FALSE;
+      bufTable[slot].version = ++lastVersion;
+      break;
+   }
+   pthread_cond_broadcast(&latchCond);
+
+   // Return ok
+   return (0);
+}
+
+//
+// UpgradeLatch
+//
+// Desc: Turn the update latch the caller holds on a page into an exclusive
+//       latch, once the shared latches held have been released.  Unlatch
+//       it as exclusive afterwards.
+// In:   fd - OS file descriptor of the file associated with the page
+//       pageNum - number of the page
+// Ret:  PF return code
+//
+RC PF_BufferMgr::UpgradeLatch(int fd, PageNum pageNum)
+{
+   PF_BufferLock lock(mutex);
+   RC  rc;       // return code
+   int slot;     // buffer slot where page is located
+
+   if ((rc = FindPinned(fd, pageNum, slot)))
+      return (rc);
+
+   bufTable[slot].upgrading = TRUE;
+   while (bufTable[slot].shared > 0)
+      pthread_cond_wait(&latchCond, &mutex);
+   bufTable[slot].upgrading = FALSE;
+   bufTable[slot].update = FALSE;
+   bufTable[slot].exclusive = TRUE;
+   bufTable[slot].version = ++lastVersion;
+
+   // Return ok
+   return (0);
+}
+
 //
 // UnpinPage
 //
@@ -361,6 +544,7 @@ RC PF_BufferMgr::MarkDirty(int fd, PageNum pageNum)
 //
 RC PF_BufferMgr::UnpinPage(int fd, PageNum pageNum)
 {
+   PF_BufferLock lock(mutex);
    RC  rc;       // return code
    int slot;     // buffer slot where page is located
 
@@ -405,6 +589,7 @@ RC PF_BufferMgr::UnpinPage(int fd, PageNum pageNum)
 //
 RC PF_BufferMgr::FlushPages(int fd)
 {
+   PF_BufferLock lock(mutex);
    RC rc, rcWarn = 0;  // return codes
 
 #ifdef PF_LOG
@@ -476,6 +661,7 @@ RC PF_BufferMgr::FlushPages(int fd)
 //
 RC PF_BufferMgr::ForcePages(int fd, PageNum pageNum)
 {
+   PF_BufferLock lock(mutex);
    RC rc;  // return codes
 
 #ifdef PF_LOG
@@ -528,6 +714,7 @@ WriteLog(psMessage);
 //
 RC PF_BufferMgr::PrintBuffer()
 {
+   PF_BufferLock lock(mutex);
    cout << "Buffer contains " << numPages << " pages of size "
       << pageSize <<".\n";
    cout << "Contents in order from most recently used to "
@@ -567,6 +754,7 @@ RC PF_BufferMgr::PrintBuffer()
 //       is called.
 RC PF_BufferMgr::ClearBuffer()
 {
+   PF_BufferLock lock(mutex);
    RC rc;
 
    int slot, next;
@@ -601,6 +789,7 @@ RC PF_BufferMgr::ClearBuffer()
 //
 RC PF_BufferMgr::ResizeBuffer(int iNewSize)
 {
+   PF_BufferLock lock(mutex);
    int i;
    RC rc;
 
@@ -910,6 +1099,38 @@ RC PF_BufferMgr::InitPageDesc(int fd, PageNum pageNum, int slot)
    bufTable[slot].pageNum  = pageNum;
    bufTable[slot].bDirty   = FALSE;
    bufTable[slot].pinCount = 1;
+   bufTable[slot].version  = ++lastVersion;
+   bufTable[slot].shared    = 0;
+   bufTable[slot].update    = FALSE;
+   bufTable[slot].exclusive = FALSE;
+   bufTable[slot].upgrading = FALSE;
+
+   // Return ok
+   return (0);
+}
+
+//
+// FindPinned
+//
+// Desc: Internal.  Find the slot of a page pinned in the buffer
+// In:   fd - file descriptor
+//       pageNum - page number
+// Out:  slot - the page's slot
+// Ret:  PF return code
+//
+RC PF_BufferMgr::FindPinned(int fd, PageNum pageNum, int &slot)
+{
+   RC rc;        // return code
+
+   if ((rc = hashTable.Find(fd, pageNum, slot))){
+      if ((rc == PF_HASHNOTFOUND))
+         return (PF_PAGENOTINBUF);
+      else
+         return (rc);              // unexpected error
+   }
+
+   if (bufTable[slot].pinCount == 0)
+      return (PF_PAGEUNPINNED);
 
    // Return ok
    return (0);
@@ -944,6 +1165,7 @@ RC PF_BufferMgr::GetBlockSize(int &length) const
 //
 RC PF_BufferMgr::AllocateBlock(char *&buffer)
 {
+   PF_BufferLock lock(mutex);
    RC rc = OK_RC;
 
    // Get an empty slot from the buffer pool
@@ -977,5 +1199,6 @@ RC PF_BufferMgr::AllocateBlock(char *&buffer)
 //
 RC PF_BufferMgr::DisposeBlock(char* buffer)
 {
+   PF_BufferLock lock(mutex);
    return UnpinPage(MEMORY_FD, buffer - (char*)0);
 }
@@ -15,6 +15,7 @@
 #ifndef PF_BUFFERMGR_H
 #define PF_BUFFERMGR_H
 
+#include <pthread.h>
 #include "pf_internal.h"
 #include "pf_hashtable.h"
 
@@ -39,6 +40,12 @@ struct PF_BufPageDesc {
     short int  pinCount;    // pin count
     PageNum    pageNum;     // page number for this page
     int        fd;          // OS file descriptor of this page
+    int        version;     // restamped whenever read in or marked dirty
+                            // and as exclusive latches come and go
+    short int  shared;      // shared latches held
+    bool       update;      // update latch held
+    bool       exclusive;   // exclusive latch held
+    bool       upgrading;   // update latch waiting to turn exclusive
 };
 
 //
@@ -58,7 +65,15 @@ public:
     RC  AllocatePage (int fd, PageNum pageNum, char **ppBuffer);
 
     RC  MarkDirty    (int fd, PageNum pageNum);  // Mark page dirty
+    // Stamp that changes whenever the page is marked dirty or reread
+    RC  GetPageVersion(int fd, PageNum pageNum, int &version);
     RC  UnpinPage    (int fd, PageNum pageNum);  // Unpin page from the buffer
+
+    // Latch a pinned page, waiting until no latch held conflicts
+    RC  LatchPage    (int fd, PageNum pageNum, PF_LatchMode mode);
+    RC  UnlatchPage  (int fd, PageNum pageNum, PF_LatchMode mode);
+    // Turn an update latch exclusive once the shared latches are gone
+    RC  UpgradeLatch (int fd, PageNum pageNum);
     RC  FlushPages   (int fd);                   // Flush pages for file
 
     // Force a page to the disk, but do not remove from the buffer pool
@@ -101,6 +116,9 @@ private:
     // Init the page desc entry
     RC  InitPageDesc (int fd, PageNum pageNum, int slot);
 
+    // Find the slot of a pinned page
+    RC  FindPinned   (int fd, PageNum pageNum, int &slot);
+
     PF_BufPageDesc *bufTable;                     // info on buffer pages
     PF_HashTable   hashTable;                     // Hash table object
     int            numPages;                      // # of pages in the buffer
@@ -108,6 +126,10 @@ private:
     int            first;                         // MRU page slot
     int            last;                          // LRU page slot
     int            free;                          // head of free list
+    int            lastVersion;                   // last page version stamped
+
+    pthread_mutex_t mutex;                        // guards everything above
+    pthread_cond_t  latchCond;                    // signalled as latches go
 };
 
 #endif
@@ -25,6 +25,7 @@ static char *PF_WarnMsg[] = {
   (char*)"page already unpinned",
   (char*)"end of file",
   (char*)"attempting to resize the buffer too small",
+  (char*)"page is latched exclusively",
   (char*)"invalid filename"
 };
 
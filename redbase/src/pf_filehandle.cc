@@ -387,6 +387,30 @@ RC PF_FileHandle::MarkDirty(PageNum pageNum) const
    return (pBufferMgr->MarkDirty(unixfd, pageNum));
 }
 
+//
+// GetPageVersion
+//
+// Desc: Get the version stamp of a pinned page, which changes whenever
+//       the page is marked dirty or reread from the file, or latched
+//       exclusively.  Returns PF_PAGELATCHED while it is.
+//       The file handle must refer to an open file.
+// In:   pageNum - number of the page
+// Out:  version - the page's stamp
+// Ret:  PF return code
+//
+RC PF_FileHandle::GetPageVersion(PageNum pageNum, int &version) const
+{
+   // File must be open
+   if (!bFileOpen)
+      return (PF_CLOSEDFILE);
+
+   // Validate page number
+   if (!IsValidPageNum(pageNum))
+      return (PF_INVALIDPAGE);
+
+   return (pBufferMgr->GetPageVersion(unixfd, pageNum, version));
+}
+
 //
 // UnpinPage
 //
@@ -412,6 +436,74 @@ RC PF_FileHandle::UnpinPage(PageNum pageNum) const
    return (pBufferMgr->UnpinPage(unixfd, pageNum));
 }
 
+//
+// LatchPage
+//
+// Desc: Latch a pinned page, waiting until the latches other threads hold
+//       on it allow.  Shared latches go together and with one update
+//       latch; an exclusive latch goes with no other.
+//       The file handle must refer to an open file.
+// In:   pageNum - number of the page
+//       mode - latch mode
+// Ret:  PF return code
+//
+RC PF_FileHandle::LatchPage(PageNum pageNum, PF_LatchMode mode) const
+{
+   // File must be open
+   if (!bFileOpen)
+      return (PF_CLOSEDFILE);
+
+   // Validate page number
+   if (!IsValidPageNum(pageNum))
+      return (PF_INVALIDPAGE);
+
+   return (pBufferMgr->LatchPage(unixfd, pageNum, mode));
+}
+
+//
+// UnlatchPage
+//
+// Desc: Release a latch taken with LatchPage, before unpinning the page.
+//       The file handle must refer to an open file.
+// In:   pageNum - number of the page
+//       mode - mode it was latched in
+// Ret:  PF return code
+//
+RC PF_FileHandle::UnlatchPage(PageNum pageNum, PF_LatchMode mode) const
+{
+   // File must be open
+   if (!bFileOpen)
+      return (PF_CLOSEDFILE);
+
+   // Validate page number
+   if (!IsValidPageNum(pageNum))
+      return (PF_INVALIDPAGE);
+
+   return (pBufferMgr->UnlatchPage(unixfd, pageNum, mode));
+}
+
+//
+// UpgradeLatch
+//
+// Desc: Turn the update latch held on a page exclusive, waiting for its
+//       shared latches to be released.
+//       The file handle must refer to an open file.
+// In:   pageNum - number of the page
+// Ret:  PF return code
+//
+RC PF_FileHandle::UpgradeLatch(PageNum pageNum) const
+{
+   // File must be open
+   if (!bFileOpen)
+      return (PF_CLOSEDFILE);
+
+   // Validate page number
+   if (!IsValidPageNum(pageNum))
+      return (PF_INVALIDPAGE);
+
+   return (pBufferMgr->UpgradeLatch(unixfd, pageNum));
+}
+
 //
 // FlushPages
 //
@@ -20,6 +20,12 @@
 #define QL_FILE "Full Table Scan"
 #define QL_INDEX "Index Scan" 
 #define QL_INDEXES "Index Scans"
+#define QL_COMPOSITE "Composite Index Scan"
+#define QL_BITMAP "Bitmap Index Scans"
+#define QL_RADIX "Transient Radix Index"
+
+#define QL_FETCH_BATCH 256 // RIDs fetched per RM_FileHandle::GetRecs call in index scans
+#define QL_RADIX_MAX_ROWS 65536 // most rows a join builds a transient radix index over
 
 #define QL_JOIN "Join"
 #define QL_CROSS "X"
@@ -74,6 +80,8 @@ public:
 
 	RC rc; // set optionally
 	char execution[MAXNAME+1];
+	Indexcat composite; // index scanned by QL_COMPOSITE
+	bool indexOnly; // index scan rows are made from index keys, not records
 	int cost; //set during query plan building
 	int numTuples; //set during query plan building
 
@@ -84,6 +92,10 @@ private:
 
 protected:
 	// Constructor
+	int RankCompositeIndexes(const char *relName);
+	int EstimateRows(const Condition &cond, const Attrcat &attrcat);
+	bool CoveredByIndex();
+	bool FitsRadixIndex(Node &node);
 	void SetRelations();
 	void SetRids();
 	void SetOutAttrs();
@@ -191,6 +203,8 @@ private:
 
 	// Helper functions
 	bool isRelation(const Node &node);
+	RC OpenCompositeIndexes(const char *relName, Node &node,        // keys read from
+	                        SM_CompositeIndex* &indexes, int &numIndexes); // node's output
 	RC DropOutput(Node &node);
 	void RecursiveDelete(Node* node);
 };
@@ -405,6 +405,13 @@ RC QL_Manager::Delete(const char *relName,
 			indexes.push_back(pair<Attrcat, IX_IndexHandle>(qPlan.root->outAttrs[i], indexHandle));
 		}
 	}
+	SM_CompositeIndex* composites;
+	int numComposites;
+	if (rc = OpenCompositeIndexes(relName, *qPlan.root, composites, numComposites)){
+		if (!isRelation(*qPlan.root))
+			smm->DropTable(qPlan.root->output);
+		return rc;
+	}
 	// Start Printer
 	vector<DataAttrInfo> dataAttrs; 
 	for (int i = 0; i < qPlan.root->numOutAttrs; ++i){
@@ -465,6 +472,14 @@ RC QL_Manager::Delete(const char *relName,
 				return rc;
 			}
 		}
+		for (int k = 0; k < numComposites; ++k){
+			if ((rc = composites[k].MakeKey(pData)) ||
+				(rc = composites[k].indexHandle.DeleteEntry(composites[k].key, rid))){
+				if (!isRelation(*qPlan.root))
+					smm->DropTable(qPlan.root->output);
+				return rc;
+			}
+		}
 		// Print 
 		printer.Print(cout, pData);
 	}
@@ -501,6 +516,11 @@ RC QL_Manager::Delete(const char *relName,
 			return rc;
 		}
 	}
+	if (rc = smm->CloseCompositeIndexes(composites, numComposites)){
+		if (!isRelation(*qPlan.root))
+			smm->DropTable(qPlan.root->output);
+		return rc;
+	}
 	// Finish Printer
 	printer.PrintFooter(cout);
 	// CLOSE END
@@ -579,6 +599,19 @@ RC QL_Manager::Update(const char *relName,
 				smm->DropTable(qPlan.root->output);
 			return rc;
 		}
+	}
+	// Get composite indexes keyed on the update attribute, if any
+	SM_CompositeIndex* composites;
+	int numComposites;
+	if (rc = OpenCompositeIndexes(relName, *qPlan.root, composites, numComposites)){
+		if (!isRelation(*qPlan.root))
+			smm->DropTable(qPlan.root->output);
+		return rc;
+	}
+	vector<bool> keyed(numComposites, false);
+	for (int k = 0; k < numComposites; ++k){
+		for (int j = 0; j < composites[k].indexcat.attrCount; ++j)
+			keyed[k] = keyed[k] || strcmp(composites[k].indexcat.attrNames[j], updAttr.attrName) == 0;
 	}
 	 // cerr << "Update D" << endl;
 	// Get right attrcat (if necessary)
@@ -638,6 +671,16 @@ RC QL_Manager::Update(const char *relName,
 					smm->DropTable(qPlan.root->output);
 				return rc;
 			}
+		}
+		for (int k = 0; k < numComposites; ++k){
+			if (!keyed[k])
+				continue;
+			if ((rc = composites[k].MakeKey(pData)) ||
+				(rc = composites[k].indexHandle.DeleteEntry(composites[k].key, rid))){
+				if (!isRelation(*qPlan.root))
+					smm->DropTable(qPlan.root->output);
+				return rc;
+			}
 		}
 		 // cerr << "Update H" << endl;
 		// Update record
@@ -656,6 +699,16 @@ RC QL_Manager::Update(const char *relName,
 					smm->DropTable(qPlan.root->output);
 				return rc;
 			}
+		}
+		for (int k = 0; k < numComposites; ++k){
+			if (!keyed[k])
+				continue;
+			if ((rc = composites[k].MakeKey(pData)) ||
+				(rc = composites[k].indexHandle.InsertEntry(composites[k].key, rid))){
+				if (!isRelation(*qPlan.root))
+					smm->DropTable(qPlan.root->output);
+				return rc;
+			}
 		}
 		 // cerr << "Update J" << endl;
 		// Update relation 
@@ -714,6 +767,11 @@ RC QL_Manager::Update(const char *relName,
 			return rc;
 		}
 	}
+	if (rc = smm->CloseCompositeIndexes(composites, numComposites)){
+		if (!isRelation(*qPlan.root))
+			smm->DropTable(qPlan.root->output);
+		return rc;
+	}
 	// Finish Printer
 	printer.PrintFooter(cout);
 	// CLOSE END
@@ -1327,6 +1385,17 @@ void QL_Manager::RecursivePrint(Node &node, int indent){
 bool QL_Manager::isRelation(const Node &node){
 	return node.numRids == 0;
 }
+// Opens relName's composite indexes, keys made from tuples of node's output
+RC QL_Manager::OpenCompositeIndexes(const char *relName, Node &node, SM_CompositeIndex* &indexes, int &numIndexes){
+	RC rc;
+	if (rc = smm->OpenCompositeIndexes(relName, indexes, numIndexes))
+		return rc;
+	for (int k = 0; k < numIndexes; ++k){
+		for (int j = 0; j < indexes[k].indexcat.attrCount; ++j)
+			indexes[k].offsets[j] = node.getAttrcat(relName, indexes[k].indexcat.attrNames[j]).offset;
+	}
+	return 0;
+}
 RC QL_Manager::DropOutput(Node &node){
 	RC rc;
 	if (!isRelation(node)){
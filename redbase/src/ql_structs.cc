@@ -111,6 +111,7 @@ Node::Node(){
 	rc = 0;
 	memset(execution, '\0', MAXNAME+1);
 	strcpy(execution, QL_FILE);
+	indexOnly = false;
 	cost = 0;
 	numTuples = 0;
 }
@@ -160,6 +161,8 @@ Node::Node(const Node& other){
 
 	rc = other.rc;
 	memcpy(execution, other.execution, MAXNAME+1);
+	composite = other.composite;
+	indexOnly = other.indexOnly;
 	cost = other.cost;
 	numTuples = other.numTuples;
 	tupleSize = other.tupleSize;
@@ -225,6 +228,8 @@ Node& Node::operator=(const Node& other){
 
 	rc = other.rc;
 	strcpy(execution, other.execution);
+	composite = other.composite;
+	indexOnly = other.indexOnly;
 	cost = other.cost;
 	numTuples = other.numTuples;
 	tupleSize = other.tupleSize;
@@ -241,6 +246,7 @@ RC Node::execute(){
 		rc = SelectionExecute();
 	else
 		return 0;
+	return rc;
 }
 void Node::printType(){
 	cout << type;
@@ -305,6 +311,14 @@ void Node::printType(){
 }
 void Node::printExecution(){
 	cout << execution;
+	if (strcmp(execution, QL_COMPOSITE) == 0){
+		cout << " (";
+		for (int i = 0; i < composite.attrCount; ++i)
+			cout << (i ? ", " : "") << composite.attrNames[i];
+		cout << ")";
+	}
+	if (indexOnly)
+		cout << ", Index Only";
 }
 Attrcat Node::getAttrcat(const char *relName, const char* attrName){
 	string str = makeNewAttrName(relName, attrName);
@@ -522,28 +536,65 @@ Selection::Selection(SM_Manager *smm, RM_Manager *rmm, IX_Manager *ixm, Node& le
 	}
 	// Order conditions
 	if (!EXT){
-	// Find a condition that an index scan can be performed upon
-		for (int i = 0; i < numConditions; ++i){
-			cerr << "Select start" << endl;
+	// Find a condition that an index scan can be performed upon; index entries
+	// point into the base relation, so only selections directly over it qualify.
+	// Equality is most selective, then ranges; not-equal needs two scans.
+	// Where the indexes can count the rows each condition selects, the fewest
+	// rows decide instead.
+		int best = -1;
+		int bestRank = 0;
+		int numBitmapConditions = 0;
+		vector<pair<int, int> > estimates; // condition, rows (-1 if unknown)
+		this->ixm = ixm;
+		for (int i = 0; left.numRids == 0 && i < numConditions; ++i){
 			pair<string, string> key = make_pair(conditions[i].lhsAttr.relName, conditions[i].lhsAttr.attrName);
-			cerr << "Select A" << endl;
 			// If is a value condition and attribute has an index...
-			if (!conditions[i].bRhsIsAttr && attrcats[key].indexNo != -1){
-				cerr << "Select B" << endl;
-				// Place condition first
-				if (i > 0){
-					cerr << "Select C" << endl;
-					Condition tmp(conditions[0]);
-					cerr << "Select D" << endl;
-					memcpy(conditions, conditions + i, sizeof(Condition));
-					cerr << "Select E" << endl;
-					memcpy(conditions + i, &tmp, sizeof(Condition));
-				}
-				cerr << "Select G" << endl;
-				strcpy(execution, QL_INDEX);
+			if (conditions[i].bRhsIsAttr || attrcats[key].indexNo == -1)
+				continue;
+			if (attrcats[key].indexType == BITMAP_INDEX)
+				++numBitmapConditions;
+			// A hash index only finds equal keys
+			if (attrcats[key].indexType == HASH_INDEX && conditions[i].op != EQ_OP)
+				continue;
+			int rank = (conditions[i].op == EQ_OP) ? 3 : (conditions[i].op == NE_OP) ? 1 : 2;
+			if (rank > bestRank){
+				best = i;
+				bestRank = rank;
+			}
+			estimates.push_back(make_pair(i, EstimateRows(conditions[i], attrcats[key])));
+		}
+		int bestRows = -1;
+		bool allEstimated = !estimates.empty();
+		for (int j = 0; j < estimates.size(); ++j)
+			allEstimated = allEstimated && estimates[j].second != -1;
+		for (int j = 0; j < estimates.size(); ++j){
+			int rows = estimates[j].second;
+			if (rows == 0 || (allEstimated && (bestRows == -1 || rows < bestRows))){
+				best = estimates[j].first;
+				bestRows = rows;
+			}
+			if (rows == 0)
 				break;
+		}
+		// A composite index wins if its key takes in more of the conditions
+		this->smm = smm;
+		int compositeRank = (left.numRids == 0) ? RankCompositeIndexes(left.relations) : 0;
+		// Two or more conditions on bitmap indexes are answered together, by
+		// combining their bitmaps before any record is read
+		if (numBitmapConditions >= 2)
+			strcpy(execution, QL_BITMAP);
+		else if (compositeRank > bestRank && bestRows != 0)
+			strcpy(execution, QL_COMPOSITE);
+		else if (best != -1){
+			// Place condition first
+			if (best > 0){
+				Condition tmp(conditions[0]);
+				memcpy(conditions, conditions + best, sizeof(Condition));
+				memcpy(conditions + best, &tmp, sizeof(Condition));
 			}
-			cerr << "Select end" << endl;
+			strcpy(execution, QL_INDEX);
+			if (bestRows != -1)
+				numTuples = bestRows;
 		}
 	}
 	else {
@@ -564,8 +615,281 @@ Selection::Selection(SM_Manager *smm, RM_Manager *rmm, IX_Manager *ixm, Node& le
 	SetRids();
 	SetOutAttrs();
 	Project(calcProj, numTotalPairs, pTotals);
+	indexOnly = CoveredByIndex();
 }
 Selection::~Selection(){}
+
+// Writes each scanned row that satisfies a selection's conditions to its output.
+// Rows are projected by the scan to the output tuple's layout (minus its rid
+// when reading a base relation), followed by any other condition attributes.
+class QL_SelectionConsumer : public RM_ScanConsumer {
+public:
+	QL_SelectionConsumer(Node &node, map<pair<string, string>, Attrcat> &rowAttrcats, bool prependRid, int outLen, char* outPData, RM_FileHandle &outFile):
+		node(node), rowAttrcats(rowAttrcats), prependRid(prependRid), outLen(outLen), outPData(outPData), outFile(outFile) {}
+	RC ConsumeRows(const char *rows, const RID *rids, int numRows, int rowSize){
+		RC rc;
+		for (int i = 0; i < numRows; ++i){
+			char* row = (char*)rows + i * rowSize;
+
+			// Check conditions
+			bool insert = true;
+			for (int k = 0; insert && k < node.numConditions; ++k)
+				insert = CheckSelectionCondition(row, node.conditions[k], rowAttrcats);
+			if (!insert)
+				continue;
+
+			// Write to output
+			char* outItr = outPData;
+			if (prependRid){
+				memcpy(outItr, rids + i, sizeof(RID));
+				outItr += sizeof(RID);
+			}
+			memcpy(outItr, row, outLen - (outItr - outPData));
+			RID tmp;
+			if (rc = outFile.InsertRec(outPData, tmp))
+				return rc;
+		}
+		return 0;
+	}
+private:
+	Node &node;
+	map<pair<string, string>, Attrcat> &rowAttrcats;
+	bool prependRid;
+	int outLen;
+	char* outPData;
+	RM_FileHandle &outFile;
+};
+
+// Adds an attribute to a scan projection, recording its offset within the row
+void AddToProjection(pair<string, string> key, map<pair<string, string>, Attrcat> &attrcats, map<pair<string, string>, Attrcat> &rowAttrcats, vector<int> &offsets, vector<int> &lengths, int &rowSize){
+	Attrcat attrcat = attrcats[key];
+	offsets.push_back(attrcat.offset);
+	lengths.push_back(attrcat.attrLen);
+	if (rowAttrcats.find(key) == rowAttrcats.end()){
+		attrcat.offset = rowSize;
+		rowAttrcats[key] = attrcat;
+	}
+	rowSize += attrcat.attrLen;
+}
+
+// Key range of one index scan; a NULL bound leaves that side open
+struct QL_IndexRange {
+	void* low;
+	bool lowInclusive;
+	void* high;
+	bool highInclusive;
+	QL_IndexRange(): low(NULL), lowInclusive(false), high(NULL), highInclusive(false) {}
+};
+
+// Compares two condition values of the same type: <0, 0, >0
+int CompareValues(AttrType attrType, void* one, void* two){
+	switch(attrType) {
+	case INT: {
+		int a, b;
+		memcpy(&a, one, sizeof(int));
+		memcpy(&b, two, sizeof(int));
+		return (a > b) - (a < b);
+	}
+	case FLOAT: {
+		float a, b;
+		memcpy(&a, one, sizeof(float));
+		memcpy(&b, two, sizeof(float));
+		return (a > b) - (a < b);
+	}
+	default:
+		return strcmp((char*)one, (char*)two);
+	}
+}
+
+// Narrows range by a value condition on the indexed attribute, returning
+// false if the condition cannot be expressed as a bound
+bool TightenIndexRange(QL_IndexRange &range, const Condition &cond, AttrType attrType){
+	void* v = cond.rhsValue.data;
+	bool lower = (cond.op == EQ_OP || cond.op == GT_OP || cond.op == GE_OP);
+	bool upper = (cond.op == EQ_OP || cond.op == LT_OP || cond.op == LE_OP);
+	if (!lower && !upper)
+		return false;
+	if (lower){
+		bool inclusive = (cond.op != GT_OP);
+		int cmp = range.low ? CompareValues(attrType, v, range.low) : 1;
+		if (cmp > 0 || (cmp == 0 && !inclusive)){
+			range.low = v;
+			range.lowInclusive = inclusive;
+		}
+	}
+	if (upper){
+		bool inclusive = (cond.op != LT_OP);
+		int cmp = range.high ? CompareValues(attrType, v, range.high) : -1;
+		if (cmp < 0 || (cmp == 0 && !inclusive)){
+			range.high = v;
+			range.highInclusive = inclusive;
+		}
+	}
+	return true;
+}
+
+// Estimates the rows a value condition on an indexed attribute selects from
+// the index's counts, or -1 if counting would take a scan.  Without counts,
+// a B+tree's smallest and largest keys still show a range holding none.
+int Node::EstimateRows(const Condition &cond, const Attrcat &attrcat){
+	IX_IndexHandle index;
+	if (ixm->OpenIndex(attrcat.relName, attrcat.indexNo, index))
+		return -1;
+	QL_IndexRange range;
+	bool notEqual = (cond.op == NE_OP);
+	if (notEqual){
+		range.low = range.high = cond.rhsValue.data;
+		range.lowInclusive = range.highInclusive = true;
+	}
+	else
+		TightenIndexRange(range, cond, attrcat.attrType);
+
+	int numRows = -1;
+	int numRids, numKeys, totalRids;
+	if (index.FastCounts()){
+		if (!index.CountEntries(range.low, range.lowInclusive, range.high, range.highInclusive, numRids, numKeys))
+			numRows = numRids;
+		if (notEqual && numRows != -1)
+			numRows = index.CountEntries(NULL, false, NULL, false, totalRids, numKeys) ? -1 : totalRids - numRids;
+	}
+	else if (attrcat.indexType == BTREE_INDEX && !notEqual){
+		char minKey[MAXSTRINGLEN + 1], maxKey[MAXSTRINGLEN + 1];
+		memset(minKey, '\0', MAXSTRINGLEN + 1);
+		memset(maxKey, '\0', MAXSTRINGLEN + 1);
+		RC minRC = index.GetMinKey(minKey);
+		if (minRC == IX_EOF)
+			numRows = 0;
+		else if (minRC == OK_RC && index.GetMaxKey(maxKey) == OK_RC){
+			int lowCmp = range.low ? CompareValues(attrcat.attrType, range.low, maxKey) : -1;
+			int highCmp = range.high ? CompareValues(attrcat.attrType, range.high, minKey) : 1;
+			if (lowCmp > 0 || (lowCmp == 0 && !range.lowInclusive) ||
+				highCmp < 0 || (highCmp == 0 && !range.highInclusive))
+				numRows = 0;
+		}
+	}
+	ixm->CloseIndex(index);
+	return numRows;
+}
+
+// Finds the value condition on relName.attrName with op, -1 if none
+static int FindValueCondition(int numConditions, Condition *conditions, const char *relName, const char *attrName, CompOp op){
+	for (int k = 0; k < numConditions; ++k){
+		if (!conditions[k].bRhsIsAttr && conditions[k].op == op &&
+			strcmp(conditions[k].lhsAttr.relName, relName) == 0 && strcmp(conditions[k].lhsAttr.attrName, attrName) == 0)
+			return k;
+	}
+	return -1;
+}
+
+// Counts the leading key attributes of a composite index with an equality
+// condition, and whether the attribute after them has a bound
+static int CompositePrefix(const Indexcat &index, int numConditions, Condition *conditions, bool &bounded){
+	int numEqual = 0;
+	while (numEqual < index.attrCount &&
+		FindValueCondition(numConditions, conditions, index.relName, index.attrNames[numEqual], EQ_OP) != -1)
+		++numEqual;
+	bounded = false;
+	CompOp bounds[4] = {LT_OP, LE_OP, GT_OP, GE_OP};
+	for (int i = 0; numEqual < index.attrCount && i < 4; ++i)
+		bounded = bounded || FindValueCondition(numConditions, conditions, index.relName, index.attrNames[numEqual], bounds[i]) != -1;
+	return numEqual;
+}
+
+// Picks the composite index on relName whose key the conditions use most,
+// ranked as single attribute indexes are: 3 per leading attribute under
+// equality, 2 for a bound on the next.  Returns 0 if none is usable.
+int Node::RankCompositeIndexes(const char *relName){
+	RM_Record record;
+	char* pData;
+	if (smm->GetRelcatRecord(relName, record) || record.GetData(pData))
+		return 0;
+	Relcat relcat(pData);
+	if (relcat.indexCount == 0)
+		return 0;
+	Indexcat* indexes = new Indexcat[relcat.indexCount];
+	int numIndexes;
+	if (smm->GetIndexcats(relName, indexes, numIndexes))
+		numIndexes = 0;
+
+	int bestRank = 0;
+	for (int i = 0; i < numIndexes; ++i){
+		bool bounded;
+		int numEqual = CompositePrefix(indexes[i], numConditions, conditions, bounded);
+		int rank = 3 * numEqual + (bounded ? 2 : 0);
+		if (rank > bestRank){
+			bestRank = rank;
+			composite = indexes[i];
+		}
+	}
+	delete [] indexes;
+	return bestRank;
+}
+
+// True if every attribute an index scan's selection outputs or checks is in
+// the scanned index's key, so its rows can be made from the keys alone
+bool Node::CoveredByIndex(){
+	vector<pair<string, string> > keyAttrs;
+	if (strcmp(execution, QL_COMPOSITE) == 0){
+		for (int i = 0; i < composite.attrCount; ++i)
+			keyAttrs.push_back(make_pair(string(composite.relName), string(composite.attrNames[i])));
+	}
+	else if (strcmp(execution, QL_INDEX) == 0)
+		keyAttrs.push_back(make_pair(string(conditions[0].lhsAttr.relName), string(conditions[0].lhsAttr.attrName)));
+	else
+		return false;
+
+	for (int i = 0; i < numOutAttrs; ++i)
+		if (find(keyAttrs.begin(), keyAttrs.end(), getRelAttrNames(outAttrs[i].attrName)) == keyAttrs.end())
+			return false;
+	for (int i = 0; i < numConditions; ++i){
+		if (find(keyAttrs.begin(), keyAttrs.end(), make_pair(string(conditions[i].lhsAttr.relName), string(conditions[i].lhsAttr.attrName))) == keyAttrs.end())
+			return false;
+		if (conditions[i].bRhsIsAttr && find(keyAttrs.begin(), keyAttrs.end(), make_pair(string(conditions[i].rhsAttr.relName), string(conditions[i].rhsAttr.attrName))) == keyAttrs.end())
+			return false;
+	}
+	return true;
+}
+
+// Makes the key range of a composite index scan: the values of equality
+// conditions on the leading key attributes, then the tightest bounds on the
+// next.  An end left open takes the lowest or highest key with the leading
+// values; an exclusive bound is encoded past every key with its value.
+static RC CompositeIndexRange(const IX_IndexHandle &index, const Indexcat &composite, int numConditions, Condition *conditions,
+	vector<bool> &covered, QL_IndexRange &range, char* lowKey, char* highKey){
+	RC rc;
+	bool bounded;
+	int numEqual = CompositePrefix(composite, numConditions, conditions, bounded);
+	void* values[MAXINDEXATTRS];
+	for (int j = 0; j < numEqual; ++j){
+		int k = FindValueCondition(numConditions, conditions, composite.relName, composite.attrNames[j], EQ_OP);
+		values[j] = conditions[k].rhsValue.data;
+		covered[k] = true;
+	}
+	QL_IndexRange bounds;
+	if (bounded){
+		for (int k = 0; k < numConditions; ++k){
+			if (conditions[k].bRhsIsAttr || strcmp(conditions[k].lhsAttr.relName, composite.relName) != 0 ||
+				strcmp(conditions[k].lhsAttr.attrName, composite.attrNames[numEqual]) != 0)
+				continue;
+			covered[k] = TightenIndexRange(bounds, conditions[k], index.ixIndexHeader.keyAttrTypes[numEqual]);
+		}
+	}
+
+	range.lowInclusive = bounds.low ? bounds.lowInclusive : true;
+	if (bounds.low)
+		values[numEqual] = bounds.low;
+	if (rc = index.EncodeKey(values, numEqual + (bounds.low ? 1 : 0), !range.lowInclusive, lowKey))
+		return rc;
+	range.highInclusive = bounds.high ? bounds.highInclusive : true;
+	if (bounds.high)
+		values[numEqual] = bounds.high;
+	if (rc = index.EncodeKey(values, numEqual + (bounds.high ? 1 : 0), range.highInclusive, highKey))
+		return rc;
+	range.low = lowKey;
+	range.high = highKey;
+	return 0;
+}
+
 RC Node::SelectionExecute(){
 	 // cerr << "select execute" << endl;
 	if (rc = CreateTmpOutput())
@@ -592,76 +916,221 @@ RC Node::SelectionExecute(){
 	}
 	// cerr << "selection execute A" << endl;
 	// No index scan
-	if (strcmp(execution, QL_FILE) == 0 || (strcmp(execution, QL_INDEX) == 0 && !EXT)){ // TODO
-		RM_FileScan scan;
-		if (rc = scan.OpenScan(file, INT, 4, 0, NO_OP, NULL))
+	if (strcmp(execution, QL_FILE) == 0){
+		// Push the first value condition down into the scan workers
+		RM_ParallelScan scan;
+		int k = 0;
+		while (k < numConditions && conditions[k].bRhsIsAttr)
+			++k;
+		if (k < numConditions){
+			Attrcat attrcat = attrcats[pair<string, string>(conditions[k].lhsAttr.relName, conditions[k].lhsAttr.attrName)];
+			rc = scan.OpenScan(file, attrcat.attrType, attrcat.attrLen, attrcat.offset, conditions[k].op, conditions[k].rhsValue.data, smm->scanWorkers);
+		}
+		else
+			rc = scan.OpenScan(file, INT, 4, 0, NO_OP, NULL, smm->scanWorkers);
+		if (rc)
 			return rc;
 
-		RM_Record record;
-		while( OK_RC == (rc = scan.GetNextRec(record))){
-			char* pData;
-			if (rc = record.GetData(pData))
-				return rc;
-
-			// Check rest of conditions
-			bool insert = true;
-			for (int k = 0; insert && k < numConditions; ++k)
-				insert = CheckSelectionCondition(pData, conditions[k], attrcats);
-			if (insert){
-				if (rc = WriteToOutput(child, otherChild, numOutAttrs, outAttrs, attrcats, attrcats, record, record, outPData, outFile))
-					return rc;
-			}
+		// Project the scan to the output attributes and condition attributes
+		map<pair<string, string>, Attrcat> rowAttrcats;
+		vector<int> offsets, lengths;
+		int rowSize = 0;
+		if (child->numRids > 0){
+			offsets.push_back(0);
+			lengths.push_back(child->numRids * sizeof(RID));
+			rowSize = child->numRids * sizeof(RID);
 		}
-		if (rc != RM_EOF)
+		for (int i = 0; i < numOutAttrs; ++i)
+			AddToProjection(getRelAttrNames(outAttrs[i].attrName), attrcats, rowAttrcats, offsets, lengths, rowSize);
+		for (int i = 0; i < numConditions; ++i){
+			pair<string, string> key(conditions[i].lhsAttr.relName, conditions[i].lhsAttr.attrName);
+			if (rowAttrcats.find(key) == rowAttrcats.end())
+				AddToProjection(key, attrcats, rowAttrcats, offsets, lengths, rowSize);
+			if (!conditions[i].bRhsIsAttr)
+				continue;
+			pair<string, string> rightKey(conditions[i].rhsAttr.relName, conditions[i].rhsAttr.attrName);
+			if (rowAttrcats.find(rightKey) == rowAttrcats.end())
+				AddToProjection(rightKey, attrcats, rowAttrcats, offsets, lengths, rowSize);
+		}
+		if (rc = scan.SetProjection(offsets.size(), &offsets[0], &lengths[0]))
+			return rc;
+
+		QL_SelectionConsumer consumer(*this, rowAttrcats, child->numRids == 0, len, outPData, outFile);
+		if (rc = scan.Scan(consumer))
 			return rc;
 		if (rc = scan.CloseScan())
 			return rc;
 	}
-	// Use index scan (for value conditions only, with an index on lhs attribute)
-	else if (strcmp(execution, QL_INDEX) == 0) {
-		cerr << "  Sel-Ex A" << endl;
-		pair<string, string> key(conditions[0].lhsAttr.relName, conditions[0].lhsAttr.attrName);
+	// Use index scan (for value conditions only, with an index on lhs
+	// attribute, or a composite index on attributes leading with them)
+	else if (strcmp(execution, QL_INDEX) == 0 || strcmp(execution, QL_COMPOSITE) == 0) {
 		IX_IndexHandle index;
-		if (rc = ixm->OpenIndex(attrcats[key].relName, attrcats[key].indexNo, index))
-			return rc;
 		IX_IndexScan indexScan;
-		// Check if operation is Not Equal (which is not implemented in ix scan)
-		CompOp op = conditions[0].op;
-		if (conditions[0].op == NE_OP){
-			op = LT_OP;
+		vector<QL_IndexRange> ranges(1);
+		vector<bool> covered(numConditions, false);
+		char lowKey[MAXSTRINGLEN], highKey[MAXSTRINGLEN];
+		if (strcmp(execution, QL_COMPOSITE) == 0){
+			if (rc = ixm->OpenIndex(composite.relName, composite.indexNo, index))
+				return rc;
+			if (rc = CompositeIndexRange(index, composite, numConditions, conditions, covered, ranges[0], lowKey, highKey))
+				return rc;
 		}
-		cerr << "  Sel-Ex B" << endl;
-		for (int i = 0; i < 1 || (conditions[0].op == NE_OP && i < 2); ++i){
-			if (rc = indexScan.OpenScan(index, op, conditions[0].rhsValue.data))
+		else {
+			pair<string, string> key(conditions[0].lhsAttr.relName, conditions[0].lhsAttr.attrName);
+			if (rc = ixm->OpenIndex(attrcats[key].relName, attrcats[key].indexNo, index))
+				return rc;
+			// Fold every bound on the indexed attribute into one key range, so
+			// the scan starts at the lower bound and stops past the upper one.
+			// Not equal (which is not implemented in ix scan) is two ranges, and
+			// a hash index probes the one key its equality condition names.
+			AttrType attrType = attrcats[key].attrType;
+			if (conditions[0].op == NE_OP){
+				ranges.resize(2);
+				ranges[0].high = ranges[1].low = conditions[0].rhsValue.data;
+				covered[0] = true;
+			}
+			else if (attrcats[key].indexType == HASH_INDEX)
+				covered[0] = TightenIndexRange(ranges[0], conditions[0], attrType);
+			else {
+				for (int k = 0; k < numConditions; ++k){
+					if (conditions[k].bRhsIsAttr || key != make_pair(string(conditions[k].lhsAttr.relName), string(conditions[k].lhsAttr.attrName)))
+						continue;
+					covered[k] = TightenIndexRange(ranges[0], conditions[k], attrType);
+				}
+			}
+		}
+		// An index only scan rebuilds each row's key attributes from its index
+		// key, at their offsets in the relation, and never reads the records
+		char* key = new char[index.ixIndexHeader.attrLength];
+		char* row = new char[child->tupleSize];
+		memset(row, '\0', child->tupleSize);
+		void* keyValues[MAXINDEXATTRS];
+		if (strcmp(execution, QL_COMPOSITE) == 0)
+			for (int j = 0; j < composite.attrCount; ++j)
+				keyValues[j] = row + attrcats[make_pair(string(composite.relName), string(composite.attrNames[j]))].offset;
+		else
+			keyValues[0] = row + attrcats[make_pair(string(conditions[0].lhsAttr.relName), string(conditions[0].lhsAttr.attrName))].offset;
+
+		// Index entries are fetched in batches, each batch's records read a page at a time
+		RID* rids = new RID[QL_FETCH_BATCH];
+		RM_Record* records = new RM_Record[QL_FETCH_BATCH];
+		for (int i = 0; i < ranges.size(); ++i){
+			if (rc = indexScan.OpenScan(index, ranges[i].low, ranges[i].lowInclusive, ranges[i].high, ranges[i].highInclusive))
 				return rc;
-			cerr << "  Sel-Ex C" << endl;
 			RID rid;
-			while(OK_RC == (rc = indexScan.GetNextEntry(rid))){
-				cerr << "  Sel-Ex D" << endl;
-				RM_Record record;
-				if (rc = file.GetRec(rid, record))
+			bool done = false;
+			while (indexOnly && OK_RC == (rc = indexScan.GetNextEntry(rid, key))){
+				if (strcmp(execution, QL_COMPOSITE) == 0){
+					if (rc = index.DecodeKey(key, keyValues))
+						return rc;
+				}
+				else
+					memcpy(keyValues[0], key, index.ixIndexHeader.attrLength);
+				// Check rest of conditions
+				bool insert = true;
+				for (int k = 0; insert && k < numConditions; ++k)
+					insert = covered[k] || CheckSelectionCondition(row, conditions[k], attrcats);
+				if (!insert)
+					continue;
+				// Write to output
+				memcpy(outPData, &rid, sizeof(RID));
+				for (int j = 0; j < numOutAttrs; ++j)
+					memcpy(outPData + outAttrs[j].offset, row + attrcats[getRelAttrNames(outAttrs[j].attrName)].offset, outAttrs[j].attrLen);
+				RID tmp;
+				if (rc = outFile.InsertRec(outPData, tmp))
+					return rc;
+			}
+			if (indexOnly){
+				if (rc != IX_EOF)
 					return rc;
+				done = true;
+			}
+			while (!done){
+				// Collect a batch of rids
+				int n = 0;
+				if (rc = indexScan.GetNextEntries(rids, QL_FETCH_BATCH, n)){
+					if (rc != IX_EOF)
+						return rc;
+					done = true;
+				}
+				if (rc = file.GetRecs(rids, n, records, true))
+					return rc;
+
+				for (int j = 0; j < n; ++j){
+					char* pData;
+					if (rc = records[j].GetData(pData))
+						return rc;
+					// Check rest of conditions
+					bool insert = true;
+					for (int k = 0; insert && k < numConditions; ++k)
+						insert = covered[k] || CheckSelectionCondition(pData, conditions[k], attrcats);
+					if (insert){
+						if (rc = WriteToOutput(child, otherChild, numOutAttrs, outAttrs, attrcats, attrcats, records[j], records[j], outPData, outFile))
+							return rc;
+					}
+				}
+			}
+			if (rc = indexScan.CloseScan())
+				return rc;
+		}
+		delete [] rids;
+		delete [] records;
+		delete [] key;
+		delete [] row;
+		if (rc = ixm->CloseIndex(index))
+			return rc;
+	}
+	// And the bitmaps of every value condition on a bitmap index, then read
+	// just the records left, in rid order
+	else if (strcmp(execution, QL_BITMAP) == 0) {
+		IX_Bitmap bitmap;
+		vector<bool> covered(numConditions, false);
+		bool first = true;
+		for (int k = 0; k < numConditions; ++k){
+			pair<string, string> key(conditions[k].lhsAttr.relName, conditions[k].lhsAttr.attrName);
+			if (conditions[k].bRhsIsAttr || attrcats[key].indexNo == -1 || attrcats[key].indexType != BITMAP_INDEX)
+				continue;
+			IX_IndexHandle index;
+			IX_Bitmap one;
+			if (rc = ixm->OpenIndex(attrcats[key].relName, attrcats[key].indexNo, index))
+				return rc;
+			if (rc = index.GetBitmap(conditions[k].op, conditions[k].rhsValue.data, one))
+				return rc;
+			if (rc = ixm->CloseIndex(index))
+				return rc;
+			if (first)
+				bitmap = one;
+			else
+				bitmap.And(one);
+			first = false;
+			covered[k] = true;
+		}
+
+		RID* rids;
+		int numRids;
+		if (rc = bitmap.GetRids(rids, numRids))
+			return rc;
+		RM_Record* records = new RM_Record[QL_FETCH_BATCH];
+		for (int start = 0; start < numRids; start += QL_FETCH_BATCH){
+			int n = min(QL_FETCH_BATCH, numRids - start);
+			if (rc = file.GetRecs(rids + start, n, records, true))
+				return rc;
+			for (int j = 0; j < n; ++j){
 				char* pData;
-				if (rc = record.GetData(pData))
+				if (rc = records[j].GetData(pData))
 					return rc;
-				cerr << "  Sel-Ex E" << endl;
 				// Check rest of conditions
 				bool insert = true;
-				for (int k = 1; insert && k < numConditions; ++k)
-					insert = CheckSelectionCondition(pData, conditions[k], attrcats);
-				cerr << "  Sel-Ex F" << endl;
+				for (int k = 0; insert && k < numConditions; ++k)
+					insert = covered[k] || CheckSelectionCondition(pData, conditions[k], attrcats);
 				if (insert){
-					if (rc = WriteToOutput(child, otherChild, numOutAttrs, outAttrs, attrcats, attrcats, record, record, outPData, outFile))
+					if (rc = WriteToOutput(child, otherChild, numOutAttrs, outAttrs, attrcats, attrcats, records[j], records[j], outPData, outFile))
 						return rc;
 				}
 			}
-			if (rc != IX_EOF)
-				return rc;
-			if (rc = indexScan.CloseScan())
-				return rc;
-
-			op = GT_OP;
 		}
+		delete [] rids;
+		delete [] records;
 	}
 	// Attribute conditions with indexes on both attributes
 	else if (strcmp(execution, QL_INDEXES) == 0)
@@ -684,6 +1153,41 @@ RC Node::SelectionExecute(){
 }
 
 // Both selection and join conditions
+// Counts file's records, stopping once there are more than maxRows
+static RC CountRows(RM_FileHandle &file, int maxRows, int &numRows)
+{
+	RC rc;
+	RM_FileScan scan;
+	RM_Record record;
+	if (rc = scan.OpenScan(file, INT, 4, 0, NO_OP, NULL))
+		return rc;
+	numRows = 0;
+	while (numRows <= maxRows && OK_RC == (rc = scan.GetNextRec(record)))
+		++numRows;
+	if (rc != OK_RC && rc != RM_EOF)
+		return rc;
+	return scan.CloseScan();
+}
+
+// True unless node is known to have more than QL_RADIX_MAX_ROWS rows.  A
+// base relation is counted; a derived node's rows are estimated, if at
+// all, and counted again when its output is built.
+bool Node::FitsRadixIndex(Node &node)
+{
+	if (node.numTuples > 0)
+		return node.numTuples <= QL_RADIX_MAX_ROWS;
+	if (node.child != NULL)
+		return true;
+	RM_FileHandle file;
+	int numRows;
+	if (rmm->OpenFile(node.output, file))
+		return false;
+	RC rc = CountRows(file, QL_RADIX_MAX_ROWS, numRows);
+	if (rmm->CloseFile(file) || rc)
+		return false;
+	return numRows <= QL_RADIX_MAX_ROWS;
+}
+
 Join::Join(SM_Manager *smm, RM_Manager *rmm, IX_Manager *ixm, Node& left, Node& right, int numConds, Condition *conds, bool calcProj, int numTotalPairs, RelAttrCount *pTotals){
 	 // cerr << "join A" << endl;
 	// set parent for both children
@@ -782,6 +1286,49 @@ Join::Join(SM_Manager *smm, RM_Manager *rmm, IX_Manager *ixm, Node& left, Node&
 	//	// TODO: set cost, numTuples
 	//}
 
+	// A join condition other than not-equal is looked up in a transient
+	// radix index, built on one small child's output and probed with the
+	// other's.  Joins of larger children keep the nested loop, which needs
+	// no memory beyond a record of each.
+	this->rmm = rmm;
+	map<pair<string, string>, Attrcat> attrcats;
+	for (int i = 0; i < left.numOutAttrs; ++i)
+		attrcats[getRelAttrNames(left.outAttrs[i].attrName)] = left.outAttrs[i];
+	map<pair<string, string>, Attrcat> otherAttrcats;
+	for (int i = 0; i < right.numOutAttrs; ++i)
+		otherAttrcats[getRelAttrNames(right.outAttrs[i].attrName)] = right.outAttrs[i];
+	for (int i = 0; i < numConditions; ++i){
+		if (!isJoinCondition(conditions[i]) || conditions[i].op == NE_OP || conditions[i].op == NO_OP)
+			continue;
+		pair<string, string> lhsKey(conditions[i].lhsAttr.relName, conditions[i].lhsAttr.attrName);
+		Attrcat lhs = GetAttrcat(conditions[i].lhsAttr, attrcats, otherAttrcats);
+		Attrcat rhs = GetAttrcat(conditions[i].rhsAttr, attrcats, otherAttrcats);
+		bool lhsLeft = (attrcats.find(lhsKey) != attrcats.end());
+
+		// Index the longer attribute, so no probe value is cut short to a
+		// key's length, and otherwise the right child if it is small enough
+		Attrcat leftAttr = lhsLeft ? lhs : rhs;
+		Attrcat rightAttr = lhsLeft ? rhs : lhs;
+		bool indexLeft = leftAttr.attrLen > rightAttr.attrLen;
+		if (!FitsRadixIndex(indexLeft ? left : right)){
+			if (leftAttr.attrLen != rightAttr.attrLen || !FitsRadixIndex(left))
+				continue;
+			indexLeft = true;
+		}
+
+		// Indexed attribute first, then the condition first
+		Condition cond(conditions[i]);
+		if (indexLeft != lhsLeft){
+			cond.lhsAttr = conditions[i].rhsAttr;
+			cond.rhsAttr = conditions[i].lhsAttr;
+			cond.op = FlipOp(conditions[i].op);
+		}
+		conditions[i] = conditions[0];
+		conditions[0] = cond;
+		strcpy(execution, QL_RADIX);
+		break;
+	}
+
 	 // cerr << "JOIN CREATION HERE" << endl;
 	this->smm = smm;
 	this->rmm = rmm;
@@ -830,6 +1377,17 @@ RC Node::JoinExecute(){
 		otherAttrcats[key] = otherChild->outAttrs[i];
 	}
 
+	// A child indexed by a transient radix index may prove too large once
+	// built; it is then joined by the nested loop instead
+	if (strcmp(execution, QL_RADIX) == 0){
+		bool indexLeft = (attrcats.find(pair<string, string>(conditions[0].lhsAttr.relName, conditions[0].lhsAttr.attrName)) != attrcats.end());
+		int numRows;
+		if (rc = CountRows(indexLeft ? file : otherFile, QL_RADIX_MAX_ROWS, numRows))
+			return rc;
+		if (numRows > QL_RADIX_MAX_ROWS)
+			strcpy(execution, QL_FILE);
+	}
+
 	// No index scan
 	if (strcmp(execution, QL_FILE) == 0 || (strcmp(execution, QL_INDEX) == 0 && !EXT)) //TODO
 	{
@@ -892,6 +1450,10 @@ RC Node::JoinExecute(){
 		if (rc)
 			return rc;
 
+		// Index entries are fetched in batches, each batch's records read a page at a time
+		RID* rids = new RID[QL_FETCH_BATCH];
+		RM_Record* indexRecords = new RM_Record[QL_FETCH_BATCH];
+
 		// Iterate over files
 		RM_Record fileRecord;
 		while(OK_RC == (rc = fileScan.GetNextRec(fileRecord))){
@@ -913,49 +1475,151 @@ RC Node::JoinExecute(){
 				if (rc = indexScan.OpenScan(index, op, value))
 					return rc;
 
-				RID rid;
-				while (OK_RC == (rc = indexScan.GetNextEntry(rid))){
-					RM_Record indexRecord;
+				bool done = false;
+				while (!done){
+					// Collect a batch of rids
+					int n = 0;
+					if (rc = indexScan.GetNextEntries(rids, QL_FETCH_BATCH, n)){
+						if (rc != IX_EOF)
+							return rc;
+						done = true;
+					}
 					if (swap)
-						rc = otherFile.GetRec(rid,indexRecord);
+						rc = otherFile.GetRecs(rids, n, indexRecords, true);
 					else 
-						rc = file.GetRec(rid, indexRecord);
+						rc = file.GetRecs(rids, n, indexRecords, true);
 					if (rc)
 						return rc;
 
+					for (int j = 0; j < n; ++j){
+						char* indexData;
+						if (rc = indexRecords[j].GetData(indexData))
+							return rc;
+
+						// Check rest of conditions
+						bool insert = true;
+						for (int k = 1; insert && k < numConditions; ++k){
+							if (swap)
+								insert = CheckJoinCondition(fileData, indexData, conditions[k], attrcats, otherAttrcats);
+							else
+								insert = CheckJoinCondition(indexData, fileData, conditions[k], attrcats, otherAttrcats);
+						}
+						if (insert){
+							if (swap)
+								rc = WriteToOutput(child, otherChild, numOutAttrs, outAttrs, attrcats, otherAttrcats, fileRecord, indexRecords[j], outPData, outFile);
+							else
+								rc = WriteToOutput(child, otherChild, numOutAttrs, outAttrs, attrcats, otherAttrcats, indexRecords[j], fileRecord, outPData, outFile);
+							if (rc)
+								return rc;
+						}
+					}
+				}
+				if (rc = indexScan.CloseScan())
+					return rc;
+
+				op = GT_OP;
+			}
+		}
+		if (rc != RM_EOF)
+			return rc;
+		if (rc = fileScan.CloseScan())
+			return rc;
+		delete [] rids;
+		delete [] indexRecords;
+	}
+	// Transient radix index on the lhsAttr of the first condition, probed
+	// with each record of the other child
+	else if (strcmp(execution, QL_RADIX) == 0)
+	{
+		Attrcat left = GetAttrcat(conditions[0].lhsAttr, attrcats, otherAttrcats);
+		Attrcat right = GetAttrcat(conditions[0].rhsAttr, attrcats, otherAttrcats);
+		bool indexLeft = (attrcats.find(pair<string, string>(conditions[0].lhsAttr.relName, conditions[0].lhsAttr.attrName)) != attrcats.end());
+		RM_FileHandle &indexFile = indexLeft ? file : otherFile;
+		RM_FileHandle &probeFile = indexLeft ? otherFile : file;
+
+		// Build the index
+		IX_RadixIndex index;
+		if (rc = index.Init(left.attrType, left.attrLen))
+			return rc;
+		RM_FileScan indexScan;
+		if (rc = indexScan.OpenScan(indexFile, INT, 4, 0, NO_OP, NULL))
+			return rc;
+		RM_Record indexRecord;
+		while (OK_RC == (rc = indexScan.GetNextRec(indexRecord))){
+			char* indexData;
+			RID rid;
+			if ((rc = indexRecord.GetData(indexData)) ||
+				(rc = indexRecord.GetRid(rid)) ||
+				(rc = index.InsertEntry(indexData + left.offset, rid)))
+				return rc;
+		}
+		if (rc != RM_EOF)
+			return rc;
+		if (rc = indexScan.CloseScan())
+			return rc;
+
+		// Probe it, fetching matches in batches a page at a time
+		RM_Record* indexRecords = new RM_Record[QL_FETCH_BATCH];
+		char* value = new char[left.attrLen];
+		RM_FileScan probeScan;
+		if (rc = probeScan.OpenScan(probeFile, INT, 4, 0, NO_OP, NULL))
+			return rc;
+		RM_Record probeRecord;
+		while (OK_RC == (rc = probeScan.GetNextRec(probeRecord))){
+			char* probeData;
+			if (rc = probeRecord.GetData(probeData))
+				return rc;
+			memset(value, '\0', left.attrLen);
+			memcpy(value, probeData + right.offset, min(left.attrLen, right.attrLen));
+
+			const RID* matches;
+			RID* range = NULL;
+			int numMatches;
+			if (conditions[0].op == EQ_OP)
+				rc = index.GetRids(value, matches, numMatches);
+			else {
+				rc = index.GetRange(conditions[0].op, value, range, numMatches);
+				matches = range;
+			}
+			if (rc)
+				return rc;
+
+			for (int start = 0; start < numMatches; start += QL_FETCH_BATCH){
+				int n = min(QL_FETCH_BATCH, numMatches - start);
+				if (rc = indexFile.GetRecs(matches + start, n, indexRecords, true))
+					return rc;
+
+				for (int j = 0; j < n; ++j){
 					char* indexData;
-					if (rc = indexRecord.GetData(indexData))
+					if (rc = indexRecords[j].GetData(indexData))
 						return rc;
 
 					// Check rest of conditions
 					bool insert = true;
 					for (int k = 1; insert && k < numConditions; ++k){
-						if (swap)
-							insert = CheckJoinCondition(fileData, indexData, conditions[k], attrcats, otherAttrcats);
+						if (indexLeft)
+							insert = CheckJoinCondition(indexData, probeData, conditions[k], attrcats, otherAttrcats);
 						else
-							insert = CheckJoinCondition(indexData, fileData, conditions[k], attrcats, otherAttrcats);
+							insert = CheckJoinCondition(probeData, indexData, conditions[k], attrcats, otherAttrcats);
 					}
 					if (insert){
-						if (swap)
-							rc = WriteToOutput(child, otherChild, numOutAttrs, outAttrs, attrcats, otherAttrcats, fileRecord, indexRecord, outPData, outFile);
+						if (indexLeft)
+							rc = WriteToOutput(child, otherChild, numOutAttrs, outAttrs, attrcats, otherAttrcats, indexRecords[j], probeRecord, outPData, outFile);
 						else
-							rc = WriteToOutput(child, otherChild, numOutAttrs, outAttrs, attrcats, otherAttrcats, indexRecord, fileRecord, outPData, outFile);
+							rc = WriteToOutput(child, otherChild, numOutAttrs, outAttrs, attrcats, otherAttrcats, probeRecord, indexRecords[j], outPData, outFile);
 						if (rc)
 							return rc;
 					}
 				}
-				if (rc != IX_EOF)
-					return rc;
-				if (rc = indexScan.CloseScan())
-					return rc;
-
-				op = GT_OP;
 			}
+			delete [] range;
 		}
 		if (rc != RM_EOF)
 			return rc;
-		if (rc = fileScan.CloseScan())
+		if (rc = probeScan.CloseScan())
 			return rc;
+		delete [] value;
+		delete [] indexRecords;
 	}
 	// Index scan of both attributes (must be A join B)
 	else if (strcmp(execution, QL_INDEXES) == 0) {
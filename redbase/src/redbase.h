@@ -16,6 +16,10 @@
                                         // string-type attribute
 #define MAXATTRS      40                // maximum number of attributes
                                         // in a relation
+#define MAXINDEXATTRS 4                 // maximum number of attributes
+                                        // in a composite index key
+#define MAXDUPBUCKETS 8                 // buckets in an index's key
+                                        // duplicate histogram
 
 #define YY_SKIP_YYWRAP 1
 #define yywrap() 1
@@ -63,6 +67,15 @@ enum AttrType {
     STRING
 };
 
+//
+// Index access methods
+//
+enum IndexType {
+    BTREE_INDEX,                                // ordered, any comparison
+    HASH_INDEX,                                 // equality only
+    BITMAP_INDEX                                // few distinct keys, rid bitmaps
+};
+
 //
 // Comparison operators
 //
@@ -106,6 +119,8 @@ void PrintError(RC rc);
 // Global structures
 extern const char* MYRELCAT;
 extern const char* MYATTRCAT;
+extern const char* MYINDEXCAT;
+extern const char* MYSTATCAT;
 //#define RELCAT "relcat"
 //#define ATTRCAT "attrcat"
 
@@ -129,12 +144,46 @@ struct Attrcat {
 	AttrType attrType;
 	int attrLen;
 	int indexNo;
+	IndexType indexType;
+	int encoded;          // 1 if the attribute is dictionary encoded
 
 	Attrcat();
 	Attrcat(char* pData);
-	Attrcat(const char* relName, const char * attrName, int offset, AttrType attrType, int attrLen, int indexNo);
+	Attrcat(const char* relName, const char * attrName, int offset, AttrType attrType, int attrLen, int indexNo, IndexType indexType = BTREE_INDEX);
 	Attrcat& operator=(char* pData);
 	Attrcat& operator=(const Attrcat& other);
 };
 
+// Change dbcreate.cc with
+// One per composite index, naming its key attributes in order
+struct Indexcat {
+	char relName[MAXNAME+1];
+	int indexNo;
+	int attrCount;
+	char attrNames[MAXINDEXATTRS][MAXNAME+1];
+
+	Indexcat();
+	Indexcat(char* pData);
+	Indexcat(const char* relName, int indexNo, int attrCount, const char * const attrNames[]);
+};
+
+// Change dbcreate.cc with
+// One per index, its statistics as of the last create index, reindex or
+// analyze.  duplicates[b] counts the keys with 2^b to 2^(b+1)-1 rids, the
+// last bucket any more
+struct Statcat {
+	char relName[MAXNAME+1];
+	int indexNo;
+	int height;
+	int leafPages;
+	int fillPercent;
+	int numRids;
+	int numKeys;
+	int clustering;
+	int duplicates[MAXDUPBUCKETS];
+
+	Statcat();
+	Statcat(char* pData);
+};
+
 #endif
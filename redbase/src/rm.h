@@ -22,12 +22,15 @@
 #include "rm_rid.h"
 #include "pf.h"
 
+class RM_Dictionary;
+
 //
 // RM_Record: RM Record interface
 //
 class RM_Record {
 	friend class RM_FileHandle;
 	friend class RM_FileScan;
+	friend class RM_ParallelScan;
 	public:
 		RM_Record ();
 		~RM_Record();
@@ -52,16 +55,25 @@ class RM_Record {
 #define RM_PAGE_LIST_END  -1           // end of list of free pages
 #define RM_PAGE_FULL      -2           // no free space in page
 #define RM_BIT_START	  sizeof(int)  //bit slots page offset
+#define RM_MORSEL_PAGES   16           // pages handed to a scan worker at a time
+#define RM_SCAN_BATCH     64           // records delivered to a scan consumer at a time
+#define RM_DICT_SPLIT     -2           // range partly overlaps an encoded attribute
+#define RM_MAX_ENCODED    MAXATTRS     // dictionary-encoded attributes per file
 const int RM_FILE_HDR_SIZE = PF_PAGE_SIZE;
 
 struct RM_FileHeader {
-	size_t recordSize;      // in bytes
+	size_t recordSize;      // in bytes, as stored
 	size_t maxSlot;
 	size_t maxPage;	        // CHANGES
 	int firstFreeSpace;     // page num, CHANGES
 	size_t pageHeaderSize;  // in bytes
+	size_t logicalSize;     // in bytes, as seen by callers
+	int numEncoded;         // dictionary-encoded attributes, by logical offset
+	int encOffsets[RM_MAX_ENCODED];
+	int encLengths[RM_MAX_ENCODED];
 
-	RM_FileHeader(): recordSize(0), maxSlot(0), maxPage(0), firstFreeSpace(RM_PAGE_LIST_END), pageHeaderSize(0){}
+	RM_FileHeader(): recordSize(0), maxSlot(0), maxPage(0), firstFreeSpace(RM_PAGE_LIST_END), pageHeaderSize(0),
+	                 logicalSize(0), numEncoded(0){}
 };
 struct RM_PageHeader {
 	int nextFreeSpace;      // page num
@@ -74,6 +86,7 @@ struct RM_PageHeader {
 class RM_FileHandle {
 	friend class RM_Manager;
 	friend class RM_FileScan;
+	friend class RM_ParallelScan;
 	public:
 		RM_FileHandle ();
 		~RM_FileHandle();
@@ -83,6 +96,12 @@ class RM_FileHandle {
 		// Given a RID, return the record
 		RC GetRec     (const RID &rid, RM_Record &rec) const;
 
+		// Given n RIDs, return their records.  RIDs are grouped by page so
+		// each page is pinned once, in ascending page order.  If inPageOrder,
+		// recs are returned sorted by RID; otherwise recs[i] is rids[i]'s.
+		RC GetRecs    (const RID *rids, int n, RM_Record *recs,
+		               bool inPageOrder = false) const;
+
 		RC InsertRec  (const char *pData, RID &rid);       // Insert a new record
 
 		RC DeleteRec  (const RID &rid);                    // Delete a record
@@ -92,15 +111,43 @@ class RM_FileHandle {
 		// from the buffer pool to disk.  Default value forces all pages.
 		RC ForcePages (PageNum pageNum = ALL_PAGES);
 
+		// Moves up to maxMoves records from the last pages of the file into
+		// free slots on earlier pages.  Successive calls continue where the
+		// last one stopped.  The old and new RIDs of each moved record are
+		// written to oldRids and newRids.  numMoves is 0 once the file is
+		// fully compacted, trailing empty pages are disposed of, and the free
+		// space list is rebuilt.
+		RC Compact    (int maxMoves, RID *oldRids, RID *newRids, int &numMoves);
+
+		// True if the attribute at attrOffset is dictionary encoded
+		bool IsEncoded(int attrOffset) const;
+
 private:
 	bool open;
 	bool modified;
 	PF_FileHandle pfFileHandle;
 	RM_FileHeader rmFileHeader;
+	PageNum compactHigh;    // Compact's high cursor, 0 between runs
+	RM_Dictionary *dicts;   // one per encoded attribute, shared by copies
+	int *dictRefs;          // handles sharing dicts; the last one deletes them
+
+	void ReleaseDictionaries();                                       // Drop this handle's share of dicts
+
+	// Dictionary encoding.  Callers see logical records, with strings;
+	// pages hold physical records, with an int code per encoded attribute.
+	RC EncodeRecord(const char* logical, char* physical);             // May add to dictionaries
+	void DecodeRecord(const char* physical, char* logical) const;
+	int EncodedAttr(int offset, int length) const;                    // Index, -1 if not encoded, RM_DICT_SPLIT if overlaps one
+	int PhysicalOffset(int offset) const;                             // Offset of a logical attribute in a physical record
+	const char* DecodeValue(int i, const char* pCode) const;         // String for the code at pCode
+	int LookupCode(int i, const char* value) const;                   // Code for value, RM_DICT_NOCODE if absent
 
 	bool GetSlotBitValue(char* pData, const SlotNum slotNum) const;   // Read a specific record's bit value in page header
 	void SetSlotBitValue(char* pData, const SlotNum slotNum, bool b); // Write a specific record's bit value in page header
 	char* GetRecordPtr(char* pData, const SlotNum slotNum) const;     // Gets a pointer to a specific record's start location
+	bool IsPageEmpty(char* pData) const;                              // True if no slot bits are set
+	bool IsPageFull(char* pData) const;                               // True if all slot bits are set
+	RC RebuildFreeSpaceList();                                        // Relinks all non-full pages in ascending order
 };
 
 //
@@ -129,9 +176,77 @@ private:
 	const RM_FileHandle* rmFileHandle;
 	AttrType attrType;
 	int attrLength;
-	int attrOffset;
+	int attrOffset;     // in the physical record
+	CompOp compOp;
+	void* value;
+	int decodeAttr;     // encoded attribute to decode before comparing, or -1
+	int valueCode;      // value's code, when EQ/NE compare codes
+};
+
+//
+// RM_ScanConsumer: receives batches of matching records from an
+// RM_ParallelScan.  Calls are serialized, so implementations need no
+// locking of their own.  A non-zero return code stops the scan.
+//
+class RM_ScanConsumer {
+public:
+    virtual ~RM_ScanConsumer() {}
+
+    // Whole records, when the scan has no projection
+    virtual RC Consume(RM_Record *recs, int numRecs);
+
+    // Projected rows, packed rowSize bytes apart, when the scan has one
+    virtual RC ConsumeRows(const char *rows, const RID *rids, int numRows, int rowSize);
+};
+
+//
+// RM_ParallelScan: condition-based scan of records in the file.  Pages
+// [1, maxPage] are split into morsels handed out to a pool of worker
+// threads, which evaluate the condition and pass batches of matching
+// records to a consumer.  With one worker, records arrive in file order.
+//
+class RM_ParallelScan {
+public:
+    RM_ParallelScan  ();
+    ~RM_ParallelScan ();
+
+    RC OpenScan  (const RM_FileHandle &fileHandle,
+                  AttrType   attrType,
+                  int        attrLength,
+                  int        attrOffset,
+                  CompOp     compOp,
+                  void       *value,
+                  int        numWorkers = 1,
+                  int        morselPages = RM_MORSEL_PAGES); // Initialize a parallel scan
+    RC SetProjection(int numProjs,                        // Deliver only these byte
+                  const int *offsets,                     //   ranges of each record,
+                  const int *lengths);                    //   packed into rows
+    RC Scan      (RM_ScanConsumer &consumer);             // Deliver all matching records
+    RC CloseScan ();                                      // Close the scan
+
+private:
+	bool open;
+
+	const RM_FileHandle* rmFileHandle;
+	AttrType attrType;
+	int attrLength;
+	int attrOffset;     // in the physical record
 	CompOp compOp;
 	void* value;
+	int decodeAttr;     // encoded attribute to decode before comparing, or -1
+	int valueCode;      // value's code, when EQ/NE compare codes
+	int numWorkers;
+	int morselPages;
+
+	int numProjs;       // 0 if records are delivered whole
+	int* projOffsets;
+	int* projLengths;
+	int rowSize;        // sum of projLengths
+
+	static void* Worker(void* state);                 // Worker thread body
+	static RC Deliver(void* state, RM_Record* batch,  // Hand a batch to the consumer
+	                  const char* rows, const RID* rids, int numRecs);
+	bool SatisfiesCondition(const char* pRecord) const; // Evaluate pushed-down condition
 };
 
 //
@@ -142,7 +257,10 @@ public:
     RM_Manager    (PF_Manager &pfm);
     ~RM_Manager   ();
 
-    RC CreateFile (const char *fileName, int recordSize);
+    RC CreateFile (const char *fileName, int recordSize,
+                   int numEncoded = 0,                    // Store these string
+                   const int *encOffsets = NULL,          //   attributes as
+                   const int *encLengths = NULL);         //   dictionary codes
     RC DestroyFile(const char *fileName);
     RC OpenFile   (const char *fileName, RM_FileHandle &fileHandle);
 
@@ -151,6 +269,7 @@ private:
 	PF_Manager* pfm;
 
 	size_t CalculateMaxSlots(int recordSize);  //Calculate max number of records that will fit in one page
+	RC ReadFileHeader(const char *fileName, RM_FileHeader &header);
 };
 
 //
@@ -165,7 +284,8 @@ void RM_PrintError(RC rc);
 #define RM_SCANNOTOPEN			(START_RM_WARN + 5)
 #define RM_INVALIDSCANCOMBO		(START_RM_WARN + 6)
 #define RM_SCANOPEN				(START_RM_WARN + 7)
-#define RM_LASTWARN		RM_SCANOPEN
+#define RM_NOCONSUMER			(START_RM_WARN + 8)
+#define RM_LASTWARN		RM_NOCONSUMER
 
 #define RM_RECORDSIZE           (START_RM_ERR - 0)
 #define RM_FILENAMELEN          (START_RM_ERR - 1) 
@@ -174,6 +294,9 @@ void RM_PrintError(RC rc);
 #define RM_MEMVIOLATION			(START_RM_ERR - 4)
 #define RM_INVALIDENUM			(START_RM_ERR - 5)
 #define RM_NUMLEN			(START_RM_ERR - 6)
-#define RM_LASTERROR	RM_NUMLEN
+#define RM_BATCHSIZE			(START_RM_ERR - 7)
+#define RM_THREAD				(START_RM_ERR - 8)
+#define RM_ENCODING				(START_RM_ERR - 9)
+#define RM_LASTERROR	RM_ENCODING
 
 #endif
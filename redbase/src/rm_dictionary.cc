@@ -0,0 +1,208 @@
+#include <cstdio>
+#include <iostream>
+#include <cstring>
+#include <sstream>
+#include "rm_dictionary.h"
+
+using namespace std;
+
+RM_Dictionary::RM_Dictionary (): valueLength(0), perPage(0), numCodes(0) {}
+
+RM_Dictionary::~RM_Dictionary()
+{
+	// Assume will always be closed before deleted.
+}
+
+// Creates an empty dictionary side file
+RC RM_Dictionary::Create(PF_Manager &pfm, const char *fileName, int valueLength)
+{
+	RC rc = pfm.CreateFile(fileName);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+
+	PF_FileHandle fileHandle;
+	rc = pfm.OpenFile(fileName, fileHandle);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+
+	// Write header page: number of codes, value length
+	PF_PageHandle pageHandle;
+	rc = fileHandle.AllocatePage(pageHandle);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	char *pData;
+	pageHandle.GetData(pData);
+	int tmp = 0;
+	memcpy(pData, &tmp, sizeof(int));
+	memcpy(pData + sizeof(int), &valueLength, sizeof(int));
+
+	// Clean up.
+	if ((rc = fileHandle.MarkDirty(0)) ||
+		(rc = fileHandle.UnpinPage(0)) ||
+		(rc = pfm.CloseFile(fileHandle))){
+		PrintError(rc);
+		return rc;
+	}
+
+	return OK_RC;
+}
+
+// Opens the side file and reads every value into memory
+RC RM_Dictionary::Open(PF_Manager &pfm, const char *fileName)
+{
+	RC rc = pfm.OpenFile(fileName, pfFileHandle);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+
+	// Read header page
+	PF_PageHandle pageHandle;
+	rc = pfFileHandle.GetThisPage(0, pageHandle);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	char *pData;
+	pageHandle.GetData(pData);
+	memcpy(&numCodes, pData, sizeof(int));
+	memcpy(&valueLength, pData + sizeof(int), sizeof(int));
+	if (rc = pfFileHandle.UnpinPage(0)){
+		PrintError(rc);
+		return rc;
+	}
+	perPage = PF_PAGE_SIZE / valueLength;
+
+	// Read values, one page at a time
+	values.assign(numCodes * valueLength, '\0');
+	codes.clear();
+	for (int code = 0; code < numCodes; code += perPage){
+		PageNum pageNum = 1 + code / perPage;
+		if (rc = pfFileHandle.GetThisPage(pageNum, pageHandle)){
+			PrintError(rc);
+			return rc;
+		}
+		pageHandle.GetData(pData);
+		int n = (numCodes - code < perPage) ? numCodes - code : perPage;
+		memcpy(&values[code * valueLength], pData, n * valueLength);
+		if (rc = pfFileHandle.UnpinPage(pageNum)){
+			PrintError(rc);
+			return rc;
+		}
+		for (int i = code; i < code + n; ++i)
+			codes[Key(Decode(i))] = i;
+	}
+
+	return OK_RC;
+}
+
+RC RM_Dictionary::Close(PF_Manager &pfm)
+{
+	RC rc = pfm.CloseFile(pfFileHandle);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	values.clear();
+	codes.clear();
+	numCodes = 0;
+	return OK_RC;
+}
+
+RC RM_Dictionary::ForcePages()
+{
+	RC rc = pfFileHandle.ForcePages();
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	return OK_RC;
+}
+
+// Returns value's code, appending value to the dictionary if it is new
+RC RM_Dictionary::Encode(const char *value, int &code)
+{
+	string key = Key(value);
+	map<string, int>::const_iterator it = codes.find(key);
+	if (it != codes.end()){
+		code = it->second;
+		return OK_RC;
+	}
+
+	// Get page for new code, allocating one when the last is full
+	code = numCodes;
+	PageNum pageNum = 1 + code / perPage;
+	PF_PageHandle pageHandle;
+	RC rc;
+	if (code % perPage == 0)
+		rc = pfFileHandle.AllocatePage(pageHandle);
+	else
+		rc = pfFileHandle.GetThisPage(pageNum, pageHandle);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	char *pData;
+	pageHandle.GetData(pData);
+
+	// Write value, null padded
+	char *ptr = pData + (code % perPage) * valueLength;
+	memset(ptr, '\0', valueLength);
+	memcpy(ptr, key.data(), key.size());
+	if ((rc = pfFileHandle.MarkDirty(pageNum)) ||
+		(rc = pfFileHandle.UnpinPage(pageNum))){
+		PrintError(rc);
+		return rc;
+	}
+
+	// Update header page
+	if (rc = pfFileHandle.GetThisPage(0, pageHandle)){
+		PrintError(rc);
+		return rc;
+	}
+	pageHandle.GetData(pData);
+	int tmp = numCodes + 1;
+	memcpy(pData, &tmp, sizeof(int));
+	if ((rc = pfFileHandle.MarkDirty(0)) ||
+		(rc = pfFileHandle.UnpinPage(0))){
+		PrintError(rc);
+		return rc;
+	}
+
+	// Update in-memory copy
+	values.resize((numCodes + 1) * valueLength, '\0');
+	memcpy(&values[code * valueLength], key.data(), key.size());
+	codes[key] = code;
+	++numCodes;
+
+	return OK_RC;
+}
+
+// Returns value's code without adding it
+int RM_Dictionary::Lookup(const char *value) const
+{
+	map<string, int>::const_iterator it = codes.find(Key(value));
+	return (it == codes.end()) ? RM_DICT_NOCODE : it->second;
+}
+
+// Strings compare up to their first null, so that is the dictionary key
+string RM_Dictionary::Key(const char *value) const
+{
+	int len = 0;
+	while (len < valueLength && value[len])
+		++len;
+	return string(value, len);
+}
+
+string RM_DictionaryFileName(const char *fileName, int i)
+{
+	stringstream ss;
+	ss << fileName << ".dict" << i;
+	return ss.str();
+}
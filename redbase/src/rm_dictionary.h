@@ -0,0 +1,53 @@
+//
+// rm_dictionary.h
+//
+//   RM_Dictionary: string dictionary for a dictionary-encoded attribute.
+//   Records store an int code in place of the string; the strings live
+//   in a side PF file, one per encoded attribute, in code order.
+//
+
+#ifndef RM_DICTIONARY_H
+#define RM_DICTIONARY_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include "rm.h"
+
+#define RM_DICT_NOCODE -1  // code of a value not in the dictionary
+
+//
+// Side file layout: page 0 holds the number of codes and the value
+// length; page 1 onward hold values packed valueLength bytes apart,
+// code c at page 1 + c / perPage, position c % perPage.
+//
+class RM_Dictionary {
+public:
+    RM_Dictionary ();
+    ~RM_Dictionary();
+
+    static RC Create(PF_Manager &pfm, const char *fileName, int valueLength);
+    RC Open       (PF_Manager &pfm, const char *fileName);   // Load all values
+    RC Close      (PF_Manager &pfm);
+    RC ForcePages ();
+
+    RC Encode     (const char *value, int &code);  // Adds value if new
+    int Lookup    (const char *value) const;       // RM_DICT_NOCODE if absent
+    const char* Decode(int code) const             // Padded to valueLength
+      { return &values[code * valueLength]; }
+
+private:
+    PF_FileHandle pfFileHandle;
+    int valueLength;
+    int perPage;                  // values per data page
+    int numCodes;
+    std::vector<char> values;     // numCodes values, valueLength bytes apart
+    std::map<std::string, int> codes;
+
+    std::string Key(const char *value) const;      // value up to its null
+};
+
+// Name of the side file holding fileName's i-th dictionary
+std::string RM_DictionaryFileName(const char *fileName, int i);
+
+#endif
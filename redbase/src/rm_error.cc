@@ -15,6 +15,7 @@ static char *RM_WarnMsg[] = {
   (char*)"scan not yet opened",
   (char*)"invalid scan parameters; either value is null and compOp is not NO_OP, or value is not null and compOp is NO_OP.",
   (char*)"tried to re-open an already opened scan",
+  (char*)"scan consumer does not accept records in this form (whole or projected)",
 };
 
 static char *RM_ErrorMsg[] = {
@@ -25,6 +26,9 @@ static char *RM_ErrorMsg[] = {
   (char*)"record index access invalid, either negative or will exceed record size",
   (char*)"invalid input given, not one of the listed enumerations",
   (char*)"invalid length for given attribute type; should be 4 for ints and floats",
+  (char*)"batch size invalid; must be greater than zero",
+  (char*)"could not start scan worker thread",
+  (char*)"invalid dictionary encoding; encoded attributes must be non-overlapping strings longer than a code",
 };
 
 void RM_PrintError(RC rc)
@@ -3,32 +3,64 @@
 #include <cstring>
 #include <cerrno>
 #include <string>
+#include <vector>
+#include <algorithm>
 #include "rm.h"
+#include "rm_dictionary.h"
 
 using namespace std;
 
-RM_FileHandle::RM_FileHandle (): open(false), modified(false), pfFileHandle(PF_FileHandle()) {}
+// Orders indexes into a RID array by page, then slot
+struct RIDIndexLess {
+	const RID *rids;
+	RIDIndexLess(const RID *rids): rids(rids) {}
+	bool operator()(int i, int j) const {
+		if (rids[i].pageNum != rids[j].pageNum)
+			return rids[i].pageNum < rids[j].pageNum;
+		return rids[i].slotNum < rids[j].slotNum;
+	}
+};
+
+RM_FileHandle::RM_FileHandle (): open(false), modified(false), pfFileHandle(PF_FileHandle()), compactHigh(0), dicts(NULL), dictRefs(NULL) {}
 
 RM_FileHandle::~RM_FileHandle()
 {
 	// Assume will always be closed before deleted.
+	ReleaseDictionaries();
 }
 
-RM_FileHandle::RM_FileHandle(const RM_FileHandle &other): open(false), modified(false), pfFileHandle(PF_FileHandle())
+RM_FileHandle::RM_FileHandle(const RM_FileHandle &other): open(false), modified(false), pfFileHandle(PF_FileHandle()), compactHigh(0), dicts(NULL), dictRefs(NULL)
 {
 	*this = other;
 }
+// Copies refer to the same open file, so they share its dictionaries
 RM_FileHandle& RM_FileHandle::operator= (const RM_FileHandle &other)
 {
 	if (this != &other){
+		ReleaseDictionaries();
 		open = other.open;
 		pfFileHandle = other.pfFileHandle;
 		modified = other.modified;
 		rmFileHeader = other.rmFileHeader;
+		compactHigh = other.compactHigh;
+		dicts = other.dicts;
+		dictRefs = other.dictRefs;
+		if (dictRefs)
+			++*dictRefs;
 	}
 	return *this;
 }
 
+void RM_FileHandle::ReleaseDictionaries()
+{
+	if (dictRefs && --*dictRefs == 0){
+		delete [] dicts;
+		delete dictRefs;
+	}
+	dicts = NULL;
+	dictRefs = NULL;
+}
+
 // Given a RID, return the record
 RC RM_FileHandle::GetRec     (const RID &rid, RM_Record &rec) const
 {
@@ -85,11 +117,11 @@ RC RM_FileHandle::GetRec     (const RID &rid, RM_Record &rec) const
 	char* ptr = GetRecordPtr(pData, slotNum);
 
 	// Copy info to record
-	rec.length = rmFileHeader.recordSize;
+	rec.length = rmFileHeader.logicalSize;
 	rec.rid = rid;
 	delete [] rec.recordCopy; // just in case
 	rec.recordCopy = new char[rec.length];
-	memcpy(rec.recordCopy, ptr, rec.length);
+	DecodeRecord(ptr, rec.recordCopy);
 
 	// Clean up.
 	pData = NULL;
@@ -103,6 +135,96 @@ RC RM_FileHandle::GetRec     (const RID &rid, RM_Record &rec) const
 }
 
 
+// Given n RIDs, return their records, pinning each page once
+RC RM_FileHandle::GetRecs    (const RID *rids, int n, RM_Record *recs, bool inPageOrder) const
+{
+	// Check input
+	if (!rids || !recs){
+		PrintError(RM_INPUTNULL);
+		return RM_INPUTNULL;
+	}
+	if (n < 0){
+		PrintError(RM_BATCHSIZE);
+		return RM_BATCHSIZE;
+	}
+	// End check input
+
+	// Check if file has been opened yet
+	if (!open){
+		PrintError(RM_FILENOTOPEN);
+		return RM_FILENOTOPEN;
+	}
+
+	// Check RIDs
+	for (int i = 0; i < n; ++i){
+		if (rids[i].pageNum > (PageNum)rmFileHeader.maxPage || rids[i].pageNum < 1 ||
+			rids[i].slotNum > (SlotNum)rmFileHeader.maxSlot || rids[i].slotNum < 0){
+			PrintError(RM_RECORD_DNE);
+			return RM_RECORD_DNE;
+		}
+	}
+	// End check RIDs
+
+	// Sort by page, so pages are read in file order and pinned once
+	vector<int> order(n);
+	for (int i = 0; i < n; ++i)
+		order[i] = i;
+	sort(order.begin(), order.end(), RIDIndexLess(rids));
+
+	RC rc;
+	int k = 0;
+	while (k < n){
+		PageNum pageNum = rids[order[k]].pageNum;
+
+		// Get page handle
+		PF_PageHandle pfPageHandle = PF_PageHandle();
+		rc = pfFileHandle.GetThisPage(pageNum, pfPageHandle);
+		if (rc != OK_RC){
+			PrintError(rc);
+			return rc;
+		}
+
+		// Get page data
+		char *pData;
+		rc = pfPageHandle.GetData(pData);
+		if (rc != OK_RC){
+			pfFileHandle.UnpinPage(pageNum);
+			PrintError(rc);
+			return rc;
+		}
+
+		// Copy every requested record on this page
+		for (; k < n && rids[order[k]].pageNum == pageNum; ++k){
+			const RID &rid = rids[order[k]];
+
+			// Check if record exists
+			if (!GetSlotBitValue(pData, rid.slotNum)){
+				pfFileHandle.UnpinPage(pageNum);
+				PrintError(RM_RECORD_DNE);
+				return RM_RECORD_DNE;
+			}
+
+			// Copy info to record
+			RM_Record &rec = recs[inPageOrder ? k : order[k]];
+			rec.length = rmFileHeader.logicalSize;
+			rec.rid = rid;
+			delete [] rec.recordCopy;
+			rec.recordCopy = new char[rec.length];
+			DecodeRecord(GetRecordPtr(pData, rid.slotNum), rec.recordCopy);
+		}
+
+		// Clean up.
+		pData = NULL;
+		rc = pfFileHandle.UnpinPage(pageNum);
+		if (rc != OK_RC){
+			PrintError(rc);
+			return rc;
+		}
+	}
+
+	return OK_RC;
+}
+
 RC RM_FileHandle::InsertRec  (const char *inData, RID &rid)       // Insert a new record
 {
 	// Check input
@@ -118,6 +240,16 @@ RC RM_FileHandle::InsertRec  (const char *inData, RID &rid)       // Insert a ne
 		return RM_FILENOTOPEN;
 	}
 
+	// Encode strings before any page is changed
+	vector<char> physical;
+	if (rmFileHeader.numEncoded > 0){
+		physical.resize(rmFileHeader.recordSize);
+		RC rc = EncodeRecord(inData, &physical[0]);
+		if (rc != OK_RC)
+			return rc;
+		inData = &physical[0];
+	}
+
 	// If no pages with free space exist...
 	if (rmFileHeader.firstFreeSpace == RM_PAGE_LIST_END){
 		// Allocate new page
@@ -386,6 +518,16 @@ RC RM_FileHandle::UpdateRec  (const RM_Record &rec)              // Update a rec
 		return RM_FILENOTOPEN;
 	}
 
+	// Encode strings before the page is changed
+	vector<char> physical;
+	if (rmFileHeader.numEncoded > 0){
+		physical.resize(rmFileHeader.recordSize);
+		rc = EncodeRecord(rData, &physical[0]);
+		if (rc != OK_RC)
+			return rc;
+		rData = &physical[0];
+	}
+
 	// Get page handle
 	PF_PageHandle pfPageHandle = PF_PageHandle();
 	rc = pfFileHandle.GetThisPage(pageNum, pfPageHandle);
@@ -491,6 +633,15 @@ RC RM_FileHandle::ForcePages (PageNum pageNum)
 		}
 	}
 
+	// Force dictionaries
+	if (pageNum == ALL_PAGES){
+		for (int i = 0; i < rmFileHeader.numEncoded; ++i){
+			RC rc = dicts[i].ForcePages();
+			if (rc != OK_RC)
+				return rc;
+		}
+	}
+
 	// Force pages
 	RC rc = pfFileHandle.ForcePages(pageNum);
 	if (rc != OK_RC){
@@ -501,6 +652,200 @@ RC RM_FileHandle::ForcePages (PageNum pageNum)
 	return OK_RC;
 }
 
+// Moves up to maxMoves records from the last pages of the file into
+// free slots on earlier pages.  A compaction run spans calls: the high
+// cursor is kept in the handle, and the low cursor is the head of the
+// free space list, which is sorted at the start of the run and popped as
+// pages fill.  Once the cursors meet, trailing empty pages are disposed of
+// and the free space list is rebuilt.
+RC RM_FileHandle::Compact    (int maxMoves, RID *oldRids, RID *newRids, int &numMoves)
+{
+	// Check input
+	if (!oldRids || !newRids){
+		PrintError(RM_INPUTNULL);
+		return RM_INPUTNULL;
+	}
+	if (maxMoves <= 0){
+		PrintError(RM_BATCHSIZE);
+		return RM_BATCHSIZE;
+	}
+	// End check input
+
+	// Check if file is open
+	if (!open){
+		PrintError(RM_FILENOTOPEN);
+		return RM_FILENOTOPEN;
+	}
+
+	numMoves = 0;
+	RC rc;
+
+	// Start a new run
+	if (compactHigh == 0){
+		if (rc = RebuildFreeSpaceList())
+			return rc;
+		compactHigh = rmFileHeader.maxPage;
+	}
+	if (compactHigh > rmFileHeader.maxPage)
+		compactHigh = rmFileHeader.maxPage;
+
+	// Low cursor takes free pages from the front of the list, high cursor
+	// walks backward looking for records.  Both pages stay pinned while moving.
+	PageNum lowPage = RM_PAGE_LIST_END, highPage = compactHigh;
+	SlotNum lowSlot = 0, highSlot = rmFileHeader.maxSlot;
+	char *lowData = NULL, *highData = NULL;
+	PF_PageHandle lowHandle, highHandle;
+	bool done = false;
+
+	while (numMoves < maxMoves){
+		// Get low page data
+		if (!lowData){
+			lowPage = rmFileHeader.firstFreeSpace;
+			if (lowPage == RM_PAGE_LIST_END || lowPage >= highPage){
+				done = true;
+				break;
+			}
+			if (rc = pfFileHandle.GetThisPage(lowPage, lowHandle)){
+				if (highData) pfFileHandle.UnpinPage(highPage);
+				PrintError(rc);
+				return rc;
+			}
+			lowHandle.GetData(lowData);
+			lowSlot = 0;
+		}
+		// Get high page data
+		if (!highData){
+			if (rc = pfFileHandle.GetThisPage(highPage, highHandle)){
+				pfFileHandle.UnpinPage(lowPage);
+				PrintError(rc);
+				return rc;
+			}
+			highHandle.GetData(highData);
+		}
+
+		// Find next free slot on low page.  A full page leaves the list.
+		while (lowSlot <= rmFileHeader.maxSlot && GetSlotBitValue(lowData, lowSlot))
+			++lowSlot;
+		if (lowSlot > rmFileHeader.maxSlot){
+			int i = RM_PAGE_FULL;
+			memcpy(&rmFileHeader.firstFreeSpace, lowData, sizeof(int));
+			memcpy(lowData, &i, sizeof(int));
+			modified = true;
+			lowData = NULL;
+			if ((rc = pfFileHandle.MarkDirty(lowPage)) ||
+				(rc = pfFileHandle.UnpinPage(lowPage))){
+				if (highData) pfFileHandle.UnpinPage(highPage);
+				PrintError(rc);
+				return rc;
+			}
+			continue;
+		}
+
+		// Find next record on high page
+		while (highSlot >= 0 && !GetSlotBitValue(highData, highSlot))
+			--highSlot;
+		if (highSlot < 0){
+			highData = NULL;
+			if (rc = pfFileHandle.UnpinPage(highPage)){
+				pfFileHandle.UnpinPage(lowPage);
+				PrintError(rc);
+				return rc;
+			}
+			--highPage;
+			highSlot = rmFileHeader.maxSlot;
+			// Low and high may now share a page
+			if (highPage == lowPage){
+				lowData = NULL;
+				if (rc = pfFileHandle.UnpinPage(lowPage)){
+					PrintError(rc);
+					return rc;
+				}
+			}
+			continue;
+		}
+
+		// Move record
+		memcpy(GetRecordPtr(lowData, lowSlot), GetRecordPtr(highData, highSlot), rmFileHeader.recordSize);
+		SetSlotBitValue(lowData, lowSlot, true);
+		SetSlotBitValue(highData, highSlot, false);
+		oldRids[numMoves] = RID(highPage, highSlot);
+		newRids[numMoves] = RID(lowPage, lowSlot);
+		++numMoves;
+
+		// Mark pages as dirty.
+		if ((rc = pfFileHandle.MarkDirty(lowPage)) ||
+			(rc = pfFileHandle.MarkDirty(highPage))){
+			pfFileHandle.UnpinPage(lowPage);
+			pfFileHandle.UnpinPage(highPage);
+			PrintError(rc);
+			return rc;
+		}
+	}
+
+	// Clean up.  A low page filled by the last move leaves the list now,
+	// so inserts between calls never see a full page at its head.
+	if (lowData && IsPageFull(lowData)){
+		int i = RM_PAGE_FULL;
+		memcpy(&rmFileHeader.firstFreeSpace, lowData, sizeof(int));
+		memcpy(lowData, &i, sizeof(int));
+		modified = true;
+		if (rc = pfFileHandle.MarkDirty(lowPage)){
+			pfFileHandle.UnpinPage(lowPage);
+			if (highData) pfFileHandle.UnpinPage(highPage);
+			PrintError(rc);
+			return rc;
+		}
+	}
+	if (lowData && (rc = pfFileHandle.UnpinPage(lowPage))){
+		if (highData) pfFileHandle.UnpinPage(highPage);
+		PrintError(rc);
+		return rc;
+	}
+	if (highData && (rc = pfFileHandle.UnpinPage(highPage))){
+		PrintError(rc);
+		return rc;
+	}
+	compactHigh = highPage;
+	if (!done)
+		return OK_RC;
+
+	// Run is over.  Dispose of trailing empty pages.  Disposing from the end
+	// keeps PF's free page list ordered, so later allocations reuse
+	// maxPage + 1 first.
+	compactHigh = 0;
+	while (rmFileHeader.maxPage > 0){
+		PageNum pageNum = rmFileHeader.maxPage;
+		PF_PageHandle pfPageHandle;
+		if (rc = pfFileHandle.GetThisPage(pageNum, pfPageHandle)){
+			PrintError(rc);
+			return rc;
+		}
+		char *pData;
+		pfPageHandle.GetData(pData);
+		bool empty = IsPageEmpty(pData);
+		if (rc = pfFileHandle.UnpinPage(pageNum)){
+			PrintError(rc);
+			return rc;
+		}
+		if (!empty)
+			break;
+
+		if (rc = pfFileHandle.DisposePage(pageNum)){
+			PrintError(rc);
+			return rc;
+		}
+		modified = true;
+		rmFileHeader.maxPage -= 1;
+	}
+
+	// Drained pages were left out of the list during the run, and disposed
+	// pages may still be in it, so relink it.
+	if (rc = RebuildFreeSpaceList())
+		return rc;
+
+	return OK_RC;
+}
+
 // Read a specific record's bit value in page header
 bool RM_FileHandle::GetSlotBitValue(char* pData, const SlotNum slotNum) const
 {
@@ -523,3 +868,158 @@ char* RM_FileHandle::GetRecordPtr(char* pData, const SlotNum slotNum) const
 {
 	return pData + rmFileHeader.pageHeaderSize + slotNum * rmFileHeader.recordSize;
 }
+
+// True if no slot bits are set in a page
+bool RM_FileHandle::IsPageEmpty(char* pData) const
+{
+	for (SlotNum slotNum = 0; slotNum <= rmFileHeader.maxSlot; ++slotNum){
+		if (GetSlotBitValue(pData, slotNum))
+			return false;
+	}
+	return true;
+}
+
+// True if all slot bits are set in a page
+bool RM_FileHandle::IsPageFull(char* pData) const
+{
+	for (SlotNum slotNum = 0; slotNum <= rmFileHeader.maxSlot; ++slotNum){
+		if (!GetSlotBitValue(pData, slotNum))
+			return false;
+	}
+	return true;
+}
+
+// Relinks all non-full pages into the free space list, lowest page first,
+// so that inserts fill the front of the file.
+RC RM_FileHandle::RebuildFreeSpaceList()
+{
+	RC rc;
+	int next = RM_PAGE_LIST_END;
+
+	for (PageNum pageNum = rmFileHeader.maxPage; pageNum >= 1; --pageNum){
+		// Get page data
+		PF_PageHandle pfPageHandle;
+		if (rc = pfFileHandle.GetThisPage(pageNum, pfPageHandle)){
+			PrintError(rc);
+			return rc;
+		}
+		char *pData;
+		pfPageHandle.GetData(pData);
+
+		// Link page, dirtying it only if its link changes
+		int i = RM_PAGE_FULL, old;
+		if (!IsPageFull(pData)){
+			i = next;
+			next = pageNum;
+		}
+		memcpy(&old, pData, sizeof(int));
+		if (i != old){
+			memcpy(pData, &i, sizeof(int));
+			if (rc = pfFileHandle.MarkDirty(pageNum)){
+				pfFileHandle.UnpinPage(pageNum);
+				PrintError(rc);
+				return rc;
+			}
+		}
+
+		// Clean up.
+		if (rc = pfFileHandle.UnpinPage(pageNum)){
+			PrintError(rc);
+			return rc;
+		}
+	}
+
+	// Modify file header
+	if (rmFileHeader.firstFreeSpace != next){
+		modified = true;
+		rmFileHeader.firstFreeSpace = next;
+	}
+
+	return OK_RC;
+}
+
+// True if the attribute at attrOffset is dictionary encoded
+bool RM_FileHandle::IsEncoded(int attrOffset) const
+{
+	for (int i = 0; i < rmFileHeader.numEncoded; ++i){
+		if (rmFileHeader.encOffsets[i] == attrOffset)
+			return true;
+	}
+	return false;
+}
+
+// Converts a logical record to its stored form, replacing each encoded
+// string by its code and adding new strings to their dictionaries
+RC RM_FileHandle::EncodeRecord(const char* logical, char* physical)
+{
+	int from = 0;
+	for (int i = 0; i < rmFileHeader.numEncoded; ++i){
+		int offset = rmFileHeader.encOffsets[i];
+		memcpy(physical, logical + from, offset - from);
+		physical += offset - from;
+
+		int code;
+		RC rc = dicts[i].Encode(logical + offset, code);
+		if (rc != OK_RC)
+			return rc;
+		memcpy(physical, &code, sizeof(int));
+		physical += sizeof(int);
+		from = offset + rmFileHeader.encLengths[i];
+	}
+	memcpy(physical, logical + from, rmFileHeader.logicalSize - from);
+	return OK_RC;
+}
+
+// Converts a stored record back to its logical form
+void RM_FileHandle::DecodeRecord(const char* physical, char* logical) const
+{
+	int from = 0;
+	for (int i = 0; i < rmFileHeader.numEncoded; ++i){
+		int offset = rmFileHeader.encOffsets[i];
+		memcpy(logical + from, physical, offset - from);
+		physical += offset - from;
+
+		memcpy(logical + offset, DecodeValue(i, physical), rmFileHeader.encLengths[i]);
+		physical += sizeof(int);
+		from = offset + rmFileHeader.encLengths[i];
+	}
+	memcpy(logical + from, physical, rmFileHeader.logicalSize - from);
+}
+
+// Index of the encoded attribute at exactly [offset, offset + length),
+// -1 if the range touches none, RM_DICT_SPLIT if it covers part of one
+int RM_FileHandle::EncodedAttr(int offset, int length) const
+{
+	for (int i = 0; i < rmFileHeader.numEncoded; ++i){
+		int encOffset = rmFileHeader.encOffsets[i];
+		int encLength = rmFileHeader.encLengths[i];
+		if (offset == encOffset && length == encLength)
+			return i;
+		if (offset < encOffset + encLength && encOffset < offset + length)
+			return RM_DICT_SPLIT;
+	}
+	return -1;
+}
+
+// Offset of a logical attribute in a physical record
+int RM_FileHandle::PhysicalOffset(int offset) const
+{
+	int physical = offset;
+	for (int i = 0; i < rmFileHeader.numEncoded && rmFileHeader.encOffsets[i] < offset; ++i)
+		physical -= rmFileHeader.encLengths[i] - sizeof(int);
+	return physical;
+}
+
+// String for the code stored at pCode
+const char* RM_FileHandle::DecodeValue(int i, const char* pCode) const
+{
+	int code;
+	memcpy(&code, pCode, sizeof(int));
+	return dicts[i].Decode(code);
+}
+
+// Code for value in the i-th dictionary, RM_DICT_NOCODE if absent
+int RM_FileHandle::LookupCode(int i, const char* value) const
+{
+	return dicts[i].Lookup(value);
+}
@@ -58,7 +58,16 @@ RC RM_FileScan::OpenScan  (const RM_FileHandle &fileHandle,
 	}
 	// Check all memory accesses is within the bounds of the intended record
 	if (attrOffset < 0 || 
-		attrOffset + attrLength > fileHandle.rmFileHeader.recordSize){
+		attrOffset + attrLength > fileHandle.rmFileHeader.logicalSize){
+		PrintError(RM_MEMVIOLATION);
+		return RM_MEMVIOLATION;
+	}
+	// Check attribute is not part of an encoded attribute.  Without a
+	// condition the attribute is never read, so any offset will do.
+	int encAttr = -1;
+	if (compOp != NO_OP)
+		encAttr = fileHandle.EncodedAttr(attrOffset, attrLength);
+	if (encAttr == RM_DICT_SPLIT){
 		PrintError(RM_MEMVIOLATION);
 		return RM_MEMVIOLATION;
 	}
@@ -68,9 +77,23 @@ RC RM_FileScan::OpenScan  (const RM_FileHandle &fileHandle,
 	rmFileHandle = &fileHandle;
 	this->attrType = attrType;
 	this->attrLength = attrLength;
-	this->attrOffset = attrOffset;
+	this->attrOffset = compOp == NO_OP ? attrOffset : fileHandle.PhysicalOffset(attrOffset);
 	this->compOp = compOp;
 	this->value = value;
+	decodeAttr = -1;
+
+	// On an encoded attribute, equality compares codes; other
+	// conditions compare the decoded string
+	if (encAttr >= 0 && value){
+		if (compOp == EQ_OP || compOp == NE_OP){
+			valueCode = fileHandle.LookupCode(encAttr, (char*)value);
+			this->attrType = INT;
+			this->attrLength = sizeof(int);
+			this->value = &valueCode;
+		}
+		else
+			decodeAttr = encAttr;
+	}
 	
 	// Setup scan params
 	open = true;
@@ -129,8 +152,10 @@ RC RM_FileScan::GetNextRec(RM_Record &rec)               // Get next matching re
 			}
 
 			// Read in attribute, covert attribute and value to correct type
-			char* ptr = rmFileHandle->GetRecordPtr(pData, slotNum);
+			const char* ptr = rmFileHandle->GetRecordPtr(pData, slotNum);
 			ptr += attrOffset;
+			if (decodeAttr >= 0)
+				ptr = rmFileHandle->DecodeValue(decodeAttr, ptr);
 
 			int a_i, v_i;
 			float a_f, v_f;
@@ -288,9 +313,9 @@ RC RM_FileScan::GetNextRec(RM_Record &rec)               // Get next matching re
 	rec.rid.slotNum = slotNum;
 	if (rec.recordCopy)
 		delete [] rec.recordCopy;
-	int length = rmFileHandle->rmFileHeader.recordSize;
-	rec.recordCopy = new char[length];
-	memcpy(rec.recordCopy, rmFileHandle->GetRecordPtr(pData, slotNum), length);
+	rec.length = rmFileHandle->rmFileHeader.logicalSize;
+	rec.recordCopy = new char[rec.length];
+	rmFileHandle->DecodeRecord(rmFileHandle->GetRecordPtr(pData, slotNum), rec.recordCopy);
 
 	// Clean up.
 	pData = NULL;
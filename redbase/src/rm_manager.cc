@@ -2,17 +2,43 @@
 #include <iostream>
 #include <math.h>
 #include <cstring>
+#include <string>
 #include "rm.h"
+#include "rm_dictionary.h"
 
 using namespace std;
 
+// Parses a header page, as written by RM_Manager::CreateFile
+static void ReadHeaderPage(const char *pData, RM_FileHeader &header)
+{
+	const char* ptr = pData;
+	memcpy(&header.recordSize, ptr, sizeof(size_t));
+	ptr += sizeof(size_t);
+	memcpy(&header.maxSlot, ptr, sizeof(size_t));
+	ptr += sizeof(size_t);
+	memcpy(&header.maxPage, ptr, sizeof(size_t));
+	ptr += sizeof(size_t);
+	memcpy(&header.firstFreeSpace, ptr, sizeof(int));
+	ptr += sizeof(int);
+	memcpy(&header.pageHeaderSize, ptr, sizeof(size_t));
+	ptr += sizeof(size_t);
+	memcpy(&header.logicalSize, ptr, sizeof(size_t));
+	ptr += sizeof(size_t);
+	memcpy(&header.numEncoded, ptr, sizeof(int));
+	ptr += sizeof(int);
+	memcpy(header.encOffsets, ptr, sizeof(header.encOffsets));
+	ptr += sizeof(header.encOffsets);
+	memcpy(header.encLengths, ptr, sizeof(header.encLengths));
+}
+
 RM_Manager::RM_Manager    (PF_Manager &pfm): pfm(&pfm){}
 RM_Manager::~RM_Manager   ()
 {
 	pfm = NULL;
 }
 
-RC RM_Manager::CreateFile (const char *fileName, int recordSize)
+RC RM_Manager::CreateFile (const char *fileName, int recordSize,
+                           int numEncoded, const int *encOffsets, const int *encLengths)
 {
 	// Check input parameters
 	if (fileName == NULL){
@@ -25,8 +51,35 @@ RC RM_Manager::CreateFile (const char *fileName, int recordSize)
 		PrintError(RM_FILENAMELEN);
 		return RM_FILENAMELEN;
 	}
+	// Check encoded attributes are strings within the record, longer than
+	// a code, and do not overlap.  They are kept sorted by offset.
+	if (numEncoded < 0 || numEncoded > RM_MAX_ENCODED ||
+		(numEncoded > 0 && (!encOffsets || !encLengths))){
+		PrintError(RM_ENCODING);
+		return RM_ENCODING;
+	}
+	int offsets[RM_MAX_ENCODED], lengths[RM_MAX_ENCODED];
+	for (int i = 0; i < numEncoded; ++i){
+		int j = i;
+		for (; j > 0 && offsets[j-1] > encOffsets[i]; --j){
+			offsets[j] = offsets[j-1];
+			lengths[j] = lengths[j-1];
+		}
+		offsets[j] = encOffsets[i];
+		lengths[j] = encLengths[i];
+	}
+	int physicalSize = recordSize;
+	for (int i = 0; i < numEncoded; ++i){
+		if (offsets[i] < 0 || lengths[i] <= (int)sizeof(int) || lengths[i] > MAXSTRINGLEN ||
+			offsets[i] + lengths[i] > recordSize ||
+			(i > 0 && offsets[i-1] + lengths[i-1] > offsets[i])){
+			PrintError(RM_ENCODING);
+			return RM_ENCODING;
+		}
+		physicalSize -= lengths[i] - sizeof(int);
+	}
 	// Check record size is feasible, accounting for available space and page header size, and greater than zero
-	if (recordSize > PF_PAGE_SIZE-sizeof(int)-sizeof(char) || recordSize <= 0){
+	if (physicalSize > PF_PAGE_SIZE-sizeof(int)-sizeof(char) || recordSize <= 0){
 		PrintError(RM_RECORDSIZE);
 		return RM_RECORDSIZE;
 	}
@@ -64,10 +117,10 @@ RC RM_Manager::CreateFile (const char *fileName, int recordSize)
 
 	// Write info to header page
 	char* ptr = pData;
-	size_t tmp = recordSize;
+	size_t tmp = physicalSize;
 	memcpy(ptr, &tmp, sizeof(size_t)); // recordSize
 	ptr += sizeof(size_t);
-	tmp = CalculateMaxSlots(recordSize) - 1; // 0-indexing
+	tmp = CalculateMaxSlots(physicalSize) - 1; // 0-indexing
 	memcpy(ptr, &tmp, sizeof(size_t)); // maxSlot
 	ptr += sizeof(size_t);
 	tmp = 0;
@@ -76,8 +129,18 @@ RC RM_Manager::CreateFile (const char *fileName, int recordSize)
 	int tmp2 = RM_PAGE_LIST_END;
 	memcpy(ptr, &tmp2, sizeof(int)); // firstFreeSpace
 	ptr += sizeof(int);
-	tmp = sizeof(int) + ceil(CalculateMaxSlots(recordSize) / 8.0);
+	tmp = sizeof(int) + ceil(CalculateMaxSlots(physicalSize) / 8.0);
 	memcpy(ptr, &tmp, sizeof(size_t)); // pageHeaderSize
+	ptr += sizeof(size_t);
+	tmp = recordSize;
+	memcpy(ptr, &tmp, sizeof(size_t)); // logicalSize
+	ptr += sizeof(size_t);
+	memcpy(ptr, &numEncoded, sizeof(int)); // numEncoded
+	ptr += sizeof(int);
+	memset(ptr, 0, 2 * RM_MAX_ENCODED * sizeof(int));
+	memcpy(ptr, offsets, numEncoded * sizeof(int)); // encOffsets
+	ptr += RM_MAX_ENCODED * sizeof(int);
+	memcpy(ptr, lengths, numEncoded * sizeof(int)); // encLengths
 	// End write info to header page.
 
 	// Mark header page as dirty.
@@ -103,6 +166,13 @@ RC RM_Manager::CreateFile (const char *fileName, int recordSize)
 		return rc;
 	}
 
+	// Create a side file per encoded attribute for its dictionary
+	for (int i = 0; i < numEncoded; ++i){
+		rc = RM_Dictionary::Create(*pfm, RM_DictionaryFileName(fileName, i).c_str(), lengths[i]);
+		if (rc != OK_RC)
+			return rc;
+	}
+
 	return OK_RC;
 }
 
@@ -121,13 +191,28 @@ RC RM_Manager::DestroyFile(const char *fileName)
 	}
 	// End check input parameters.
 
+	// Find dictionary side files
+	RM_FileHeader header;
+	RC rc = ReadFileHeader(fileName, header);
+	if (rc != OK_RC)
+		return rc;
+
 	// Delete file
-	RC rc = pfm->DestroyFile(fileName);
+	rc = pfm->DestroyFile(fileName);
 	if (rc != OK_RC){
 		PrintError(rc);
 		return rc;
 	}
 
+	// Delete dictionaries
+	for (int i = 0; i < header.numEncoded; ++i){
+		rc = pfm->DestroyFile(RM_DictionaryFileName(fileName, i).c_str());
+		if (rc != OK_RC){
+			PrintError(rc);
+			return rc;
+		}
+	}
+
 	return OK_RC;
 }
 
@@ -157,6 +242,7 @@ RC RM_Manager::OpenFile   (const char *fileName, RM_FileHandle &fileHandle)
 	// Initialize state
 	fileHandle.open = true;
 	fileHandle.modified = false;
+	fileHandle.compactHigh = 0;
 
 	// Get header page handle
 	PF_PageHandle pfPageHandle = PF_PageHandle();
@@ -176,27 +262,28 @@ RC RM_Manager::OpenFile   (const char *fileName, RM_FileHandle &fileHandle)
 	}
 
 	// Copy over header data
-	char* ptr = pData;
-	memcpy(&fileHandle.rmFileHeader.recordSize, ptr, sizeof(size_t));
-	ptr += sizeof(size_t);
-	memcpy(&fileHandle.rmFileHeader.maxSlot, ptr, sizeof(size_t));
-	ptr += sizeof(size_t);
-	memcpy(&fileHandle.rmFileHeader.maxPage, ptr, sizeof(size_t));
-	ptr += sizeof(size_t);
-	memcpy(&fileHandle.rmFileHeader.firstFreeSpace, ptr, sizeof(int));
-	ptr += sizeof(int);
-	memcpy(&fileHandle.rmFileHeader.pageHeaderSize, ptr, sizeof(size_t));
-
+	ReadHeaderPage(pData, fileHandle.rmFileHeader);
 	
 	// Clean up
 	pData = NULL;
-	ptr = NULL;
 	rc = fileHandle.pfFileHandle.UnpinPage(0);
 	if (rc != OK_RC){
 		PrintError(rc);
 		return rc;
 	}
 
+	// Load dictionaries
+	fileHandle.ReleaseDictionaries();
+	if (fileHandle.rmFileHeader.numEncoded > 0){
+		fileHandle.dicts = new RM_Dictionary[fileHandle.rmFileHeader.numEncoded];
+		fileHandle.dictRefs = new int(1);
+		for (int i = 0; i < fileHandle.rmFileHeader.numEncoded; ++i){
+			rc = fileHandle.dicts[i].Open(*pfm, RM_DictionaryFileName(fileName, i).c_str());
+			if (rc != OK_RC)
+				return rc;
+		}
+	}
+
 	return OK_RC;
 }
 
@@ -215,6 +302,14 @@ RC RM_Manager::CloseFile  (RM_FileHandle &fileHandle)
 	}
 	fileHandle.open = false;
 
+	// Close dictionaries, which copies of the handle share
+	for (int i = 0; i < fileHandle.rmFileHeader.numEncoded; ++i){
+		rc = fileHandle.dicts[i].Close(*pfm);
+		if (rc != OK_RC)
+			return rc;
+	}
+	fileHandle.ReleaseDictionaries();
+
 	return OK_RC;
 }
 
@@ -223,3 +318,33 @@ RC RM_Manager::CloseFile  (RM_FileHandle &fileHandle)
 size_t RM_Manager::CalculateMaxSlots(int recordSize){
 	return floor((PF_PAGE_SIZE - sizeof(int)) / (recordSize + 1/8.0));
 }
+
+// Reads a closed file's header
+RC RM_Manager::ReadFileHeader(const char *fileName, RM_FileHeader &header)
+{
+	PF_FileHandle fileHandle;
+	RC rc = pfm->OpenFile(fileName, fileHandle);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+
+	PF_PageHandle pageHandle;
+	rc = fileHandle.GetThisPage(0, pageHandle);
+	if (rc != OK_RC){
+		PrintError(rc);
+		return rc;
+	}
+	char *pData;
+	pageHandle.GetData(pData);
+	ReadHeaderPage(pData, header);
+
+	// Clean up.
+	if ((rc = fileHandle.UnpinPage(0)) ||
+		(rc = pfm->CloseFile(fileHandle))){
+		PrintError(rc);
+		return rc;
+	}
+
+	return OK_RC;
+}
@@ -0,0 +1,441 @@
+#include <cstdio>
+#include <iostream>
+#include <cstring>
+#include <pthread.h>
+#include "rm.h"
+
+using namespace std;
+
+// State shared by the workers of one RM_ParallelScan::Scan call
+struct RM_ScanState {
+	const RM_ParallelScan* scan;
+	RM_ScanConsumer* consumer;
+	PageNum nextPage;    // first page of the next unclaimed morsel
+	PageNum maxPage;     // last page to scan, fixed when the scan starts
+	RC rc;               // first error hit by any worker
+
+	pthread_mutex_t morselMutex;   // guards nextPage and rc
+	pthread_mutex_t consumerMutex; // serializes consumer calls
+};
+
+// Default consumers reject the form they were not written for
+RC RM_ScanConsumer::Consume(RM_Record *recs, int numRecs)
+{
+	return RM_NOCONSUMER;
+}
+RC RM_ScanConsumer::ConsumeRows(const char *rows, const RID *rids, int numRows, int rowSize)
+{
+	return RM_NOCONSUMER;
+}
+
+RM_ParallelScan::RM_ParallelScan  (): open(false), rmFileHandle(NULL),
+	numProjs(0), projOffsets(NULL), projLengths(NULL), rowSize(0)
+{
+}
+RM_ParallelScan::~RM_ParallelScan ()
+{
+	rmFileHandle = NULL;
+	delete [] projOffsets;
+	delete [] projLengths;
+}
+
+RC RM_ParallelScan::OpenScan  (const RM_FileHandle &fileHandle,
+					   		   AttrType   attrType,
+							   int        attrLength,
+							   int        attrOffset,
+							   CompOp     compOp,
+							   void       *value,
+							   int        numWorkers,
+							   int        morselPages) // Initialize a parallel scan
+{
+	if (open){
+		PrintError(RM_SCANOPEN);
+		return RM_SCANOPEN;
+	}
+
+	// Check input
+	// Check attribute type is one of the three allowed
+	if (attrType != INT && attrType != FLOAT && attrType != STRING){
+		PrintError(RM_INVALIDENUM);
+		return RM_INVALIDENUM;
+	}
+	// Check compare operation is one of the seven allowed
+	if (compOp != NO_OP && compOp != EQ_OP && compOp !=NE_OP &&
+		compOp !=LT_OP && compOp !=GT_OP && compOp !=LE_OP &&
+		compOp !=GE_OP){
+		PrintError(RM_INVALIDENUM);
+		return RM_INVALIDENUM;
+	}
+	// Check for invalid value/compOp combinations
+	if ((compOp == NO_OP && value) || (compOp != NO_OP && !value)){
+		PrintError(RM_INVALIDSCANCOMBO);
+		return RM_INVALIDSCANCOMBO;
+	}
+	// Check string attribute length is greater than 0 and less than 255 bytes
+	if (attrType == STRING && (attrLength > MAXSTRINGLEN || attrLength < 1)){
+		PrintError(RM_STRLEN);
+		return RM_STRLEN;
+	}
+	// Check int or float attribute length is exactly 4 bytes
+	if (attrType != STRING && attrLength != 4){
+		PrintError(RM_NUMLEN);
+		return RM_NUMLEN;
+	}
+	// Check all memory accesses is within the bounds of the intended record
+	if (attrOffset < 0 ||
+		attrOffset + attrLength > fileHandle.rmFileHeader.logicalSize){
+		PrintError(RM_MEMVIOLATION);
+		return RM_MEMVIOLATION;
+	}
+	// Check attribute is not part of an encoded attribute.  Without a
+	// condition the attribute is never read, so any offset will do.
+	int encAttr = -1;
+	if (compOp != NO_OP)
+		encAttr = fileHandle.EncodedAttr(attrOffset, attrLength);
+	if (encAttr == RM_DICT_SPLIT){
+		PrintError(RM_MEMVIOLATION);
+		return RM_MEMVIOLATION;
+	}
+	// Check worker and morsel counts
+	if (numWorkers < 1 || morselPages < 1){
+		PrintError(RM_BATCHSIZE);
+		return RM_BATCHSIZE;
+	}
+	// End check input
+
+	// Check if file is open
+	if (!fileHandle.open){
+		PrintError(RM_FILENOTOPEN);
+		return RM_FILENOTOPEN;
+	}
+
+	// Copy over info
+	rmFileHandle = &fileHandle;
+	this->attrType = attrType;
+	this->attrLength = attrLength;
+	this->attrOffset = compOp == NO_OP ? attrOffset : fileHandle.PhysicalOffset(attrOffset);
+	this->compOp = compOp;
+	this->value = value;
+	this->numWorkers = numWorkers;
+	this->morselPages = morselPages;
+	decodeAttr = -1;
+
+	// On an encoded attribute, equality compares codes; other
+	// conditions compare the decoded string
+	if (encAttr >= 0 && value){
+		if (compOp == EQ_OP || compOp == NE_OP){
+			valueCode = fileHandle.LookupCode(encAttr, (char*)value);
+			this->attrType = INT;
+			this->attrLength = sizeof(int);
+			this->value = &valueCode;
+		}
+		else
+			decodeAttr = encAttr;
+	}
+
+	open = true;
+	return OK_RC;
+}
+
+// Restricts delivered rows to the given byte ranges of each record
+RC RM_ParallelScan::SetProjection(int numProjs, const int *offsets, const int *lengths)
+{
+	// Check if scan is open
+	if (!open){
+		PrintError(RM_SCANNOTOPEN);
+		return RM_SCANNOTOPEN;
+	}
+
+	// Check input
+	if (numProjs > 0 && (!offsets || !lengths)){
+		PrintError(RM_INPUTNULL);
+		return RM_INPUTNULL;
+	}
+	// Check all memory accesses are within the bounds of the record
+	for (int i = 0; i < numProjs; ++i){
+		if (offsets[i] < 0 || lengths[i] < 1 ||
+			offsets[i] + lengths[i] > rmFileHandle->rmFileHeader.logicalSize){
+			PrintError(RM_MEMVIOLATION);
+			return RM_MEMVIOLATION;
+		}
+	}
+	// End check input
+
+	// Copy over info
+	delete [] projOffsets;
+	delete [] projLengths;
+	projOffsets = projLengths = NULL;
+	this->numProjs = (numProjs > 0) ? numProjs : 0;
+	rowSize = 0;
+	if (this->numProjs > 0){
+		projOffsets = new int[numProjs];
+		projLengths = new int[numProjs];
+		memcpy(projOffsets, offsets, numProjs * sizeof(int));
+		memcpy(projLengths, lengths, numProjs * sizeof(int));
+		for (int i = 0; i < numProjs; ++i)
+			rowSize += lengths[i];
+	}
+
+	return OK_RC;
+}
+
+RC RM_ParallelScan::Scan (RM_ScanConsumer &consumer)    // Deliver all matching records
+{
+	// Check if scan is open
+	if (!open){
+		PrintError(RM_SCANNOTOPEN);
+		return RM_SCANNOTOPEN;
+	}
+
+	// Setup shared state
+	RM_ScanState state;
+	state.scan = this;
+	state.consumer = &consumer;
+	state.nextPage = 1;  // Skip header page
+	state.maxPage = rmFileHandle->rmFileHeader.maxPage;
+	state.rc = OK_RC;
+	pthread_mutex_init(&state.morselMutex, NULL);
+	pthread_mutex_init(&state.consumerMutex, NULL);
+
+	// A single worker runs in the calling thread
+	if (numWorkers == 1){
+		Worker(&state);
+	}
+	else {
+		pthread_t* threads = new pthread_t[numWorkers];
+		int started = 0;
+		for (; started < numWorkers; ++started){
+			if (pthread_create(&threads[started], NULL, Worker, &state) != 0){
+				pthread_mutex_lock(&state.morselMutex);
+				if (state.rc == OK_RC)
+					state.rc = RM_THREAD;
+				pthread_mutex_unlock(&state.morselMutex);
+				break;
+			}
+		}
+		for (int i = 0; i < started; ++i)
+			pthread_join(threads[i], NULL);
+		delete [] threads;
+	}
+
+	// Clean up.
+	pthread_mutex_destroy(&state.morselMutex);
+	pthread_mutex_destroy(&state.consumerMutex);
+
+	if (state.rc != OK_RC){
+		PrintError(state.rc);
+		return state.rc;
+	}
+	return OK_RC;
+}
+
+RC RM_ParallelScan::CloseScan ()                        // Close the scan
+{
+	open = false;
+	rmFileHandle = NULL;
+	delete [] projOffsets;
+	delete [] projLengths;
+	projOffsets = projLengths = NULL;
+	numProjs = 0;
+	rowSize = 0;
+	return OK_RC;
+}
+
+// Worker thread body.  Claims morsels until none remain, copying each page
+// out of the buffer pool so the pin is held only briefly.
+void* RM_ParallelScan::Worker(void* arg)
+{
+	RM_ScanState* state = (RM_ScanState*)arg;
+	const RM_ParallelScan* scan = state->scan;
+	const RM_FileHandle* fileHandle = scan->rmFileHandle;
+	const size_t recordSize = fileHandle->rmFileHeader.logicalSize;
+	const SlotNum maxSlot = fileHandle->rmFileHeader.maxSlot;
+
+	char* page = new char[PF_PAGE_SIZE];
+	// Decoded record, when the file has encoded attributes
+	char* logical = NULL;
+	if (fileHandle->rmFileHeader.numEncoded > 0)
+		logical = new char[recordSize];
+	// Batch of whole records, or of projected rows
+	RM_Record* batch = NULL;
+	char* rows = NULL;
+	RID* rids = NULL;
+	if (scan->numProjs == 0)
+		batch = new RM_Record[RM_SCAN_BATCH];
+	else {
+		rows = new char[RM_SCAN_BATCH * scan->rowSize];
+		rids = new RID[RM_SCAN_BATCH];
+	}
+	int numRecs = 0;
+	RC rc = OK_RC;
+
+	while (rc == OK_RC){
+		// Claim next morsel
+		pthread_mutex_lock(&state->morselMutex);
+		PageNum first = state->nextPage;
+		state->nextPage += scan->morselPages;
+		bool stop = (state->rc != OK_RC);
+		pthread_mutex_unlock(&state->morselMutex);
+		if (stop || first > state->maxPage)
+			break;
+		PageNum last = first + scan->morselPages - 1;
+		if (last > state->maxPage)
+			last = state->maxPage;
+
+		for (PageNum pageNum = first; rc == OK_RC && pageNum <= last; ++pageNum){
+			// Copy page out of the buffer pool, which serializes calls
+			PF_PageHandle pfPageHandle;
+			char* pData;
+			if (OK_RC == (rc = fileHandle->pfFileHandle.GetThisPage(pageNum, pfPageHandle))){
+				pfPageHandle.GetData(pData);
+				memcpy(page, pData, PF_PAGE_SIZE);
+				rc = fileHandle->pfFileHandle.UnpinPage(pageNum);
+			}
+			if (rc != OK_RC)
+				break;
+
+			// Evaluate condition on each record
+			for (SlotNum slotNum = 0; slotNum <= maxSlot; ++slotNum){
+				if (!fileHandle->GetSlotBitValue(page, slotNum))
+					continue;
+				char* ptr = fileHandle->GetRecordPtr(page, slotNum);
+				if (!scan->SatisfiesCondition(ptr))
+					continue;
+				if (logical){
+					fileHandle->DecodeRecord(ptr, logical);
+					ptr = logical;
+				}
+
+				if (batch){
+					// Copy record into batch, reusing its buffer
+					RM_Record &rec = batch[numRecs];
+					if (!rec.recordCopy || rec.length != recordSize){
+						delete [] rec.recordCopy;
+						rec.recordCopy = new char[recordSize];
+						rec.length = recordSize;
+					}
+					memcpy(rec.recordCopy, ptr, recordSize);
+					rec.rid = RID(pageNum, slotNum);
+				}
+				else {
+					// Copy only the projected bytes into the row
+					char* row = rows + numRecs * scan->rowSize;
+					for (int i = 0; i < scan->numProjs; ++i){
+						memcpy(row, ptr + scan->projOffsets[i], scan->projLengths[i]);
+						row += scan->projLengths[i];
+					}
+					rids[numRecs] = RID(pageNum, slotNum);
+				}
+				++numRecs;
+
+				// Deliver full batch
+				if (numRecs == RM_SCAN_BATCH){
+					if (rc = Deliver(state, batch, rows, rids, numRecs))
+						break;
+					numRecs = 0;
+				}
+			}
+		}
+	}
+
+	// Deliver remaining records
+	if (rc == OK_RC && numRecs > 0)
+		rc = Deliver(state, batch, rows, rids, numRecs);
+
+	// Record error for other workers
+	if (rc != OK_RC){
+		pthread_mutex_lock(&state->morselMutex);
+		if (state->rc == OK_RC)
+			state->rc = rc;
+		pthread_mutex_unlock(&state->morselMutex);
+	}
+
+	// Clean up.
+	delete [] page;
+	delete [] logical;
+	delete [] batch;
+	delete [] rows;
+	delete [] rids;
+	return NULL;
+}
+
+// Hands a batch to the consumer, one worker at a time
+RC RM_ParallelScan::Deliver(void* arg, RM_Record* batch, const char* rows, const RID* rids, int numRecs)
+{
+	RM_ScanState* state = (RM_ScanState*)arg;
+	RC rc = OK_RC;
+
+	pthread_mutex_lock(&state->consumerMutex);
+	if (state->rc == OK_RC){
+		if (batch)
+			rc = state->consumer->Consume(batch, numRecs);
+		else
+			rc = state->consumer->ConsumeRows(rows, rids, numRecs, state->scan->rowSize);
+	}
+	pthread_mutex_unlock(&state->consumerMutex);
+	return rc;
+}
+
+// Evaluate pushed-down condition on a record
+bool RM_ParallelScan::SatisfiesCondition(const char* pRecord) const
+{
+	if (compOp == NO_OP)
+		return true;
+
+	// Compare attribute against value
+	const char* ptr = pRecord + attrOffset;
+	if (decodeAttr >= 0)
+		ptr = rmFileHandle->DecodeValue(decodeAttr, ptr);
+	int cmp = 0;
+	switch(attrType) {
+	case INT:
+	{
+		int a_i, v_i;
+		memcpy(&a_i, ptr, sizeof(int));
+		memcpy(&v_i, value, sizeof(int));
+		cmp = (a_i < v_i) ? -1 : (a_i > v_i);
+		break;
+	}
+	case FLOAT:
+	{
+		float a_f, v_f;
+		memcpy(&a_f, ptr, sizeof(float));
+		memcpy(&v_f, value, sizeof(float));
+		cmp = (a_f < v_f) ? -1 : (a_f > v_f);
+		break;
+	}
+	case STRING:
+	{
+		// Attribute ends at attrLength or its first null, value at its null
+		const unsigned char* a = (const unsigned char*)ptr;
+		const unsigned char* v = (const unsigned char*)value;
+		int i = 0;
+		while (i < attrLength && a[i] && a[i] == v[i])
+			++i;
+		bool aEnd = (i == attrLength || !a[i]);
+		if (aEnd)
+			cmp = v[i] ? -1 : 0;
+		else
+			cmp = (a[i] < v[i]) ? -1 : 1;
+		break;
+	}
+	}
+
+	// Check if record fulfills condition
+	switch(compOp) {
+	case EQ_OP:
+		return cmp == 0;
+	case LT_OP:
+		return cmp < 0;
+	case GT_OP:
+		return cmp > 0;
+	case LE_OP:
+		return cmp <= 0;
+	case GE_OP:
+		return cmp >= 0;
+	case NE_OP:
+		return cmp != 0;
+	default:
+		return true;
+	}
+}
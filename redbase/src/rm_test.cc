@@ -34,6 +34,9 @@ using namespace std;
 #define PROG_UNIT   50               // how frequently to give progress
                                       //   reports when adding lots of recs
 #define FEW_RECS   20                // number of records added in
+#define MANY_RECS  1000              // number of records added in Test3
+#define NUM_CODES  7                 // distinct strings in Test5
+#define NUM_FETCH  8                 // RIDs fetched at once in Test6
 
 //
 // Computes the offset of a field in a record (should be in <stddef.h>)
@@ -62,6 +65,11 @@ RM_Manager rmm(pfm);
 //
 RC Test1(void);
 RC Test2(void);
+RC Test3(void);
+RC Test4(void);
+RC Test5(void);
+RC Test6(void);
+RC Test7(void);
 
 void PrintError(RC rc);
 void LsFile(char *fileName);
@@ -82,11 +90,16 @@ RC GetNextRecScan(RM_FileScan &fs, RM_Record &rec);
 //
 // Array of pointers to the test functions
 //
-#define NUM_TESTS       2               // number of tests
+#define NUM_TESTS       7               // number of tests
 int (*tests[])() =                      // RC doesn't work on some compilers
 {
     Test1,
-    Test2
+    Test2,
+    Test3,
+    Test4,
+    Test5,
+    Test6,
+    Test7
 };
 
 //
@@ -497,3 +510,522 @@ RC Test2(void)
     printf("\ntest2 done ********************\n");
     return (0);
 }
+
+//
+// Test3 tests compacting a file after deleting most of its records.
+//
+RC Test3(void)
+{
+    RC            rc;
+    RM_FileHandle fh;
+    RM_FileScan   fs;
+    RM_Record     rec;
+    TestRec       *pRecBuf;
+    RID           rid, oldRids[PROG_UNIT], newRids[PROG_UNIT];
+    int           n, numMoves;
+
+    printf("test3 starting ****************\n");
+
+    if ((rc = CreateFile(FILENAME, sizeof(TestRec))) ||
+        (rc = OpenFile(FILENAME, fh)) ||
+        (rc = AddRecs(fh, MANY_RECS)))
+        return (rc);
+
+    // Delete all records but every fourth one
+    if ((rc = fs.OpenScan(fh, INT, sizeof(int), offsetof(TestRec, num),
+                          NO_OP, NULL, NO_HINT)))
+        return (rc);
+    while (!(rc = GetNextRecScan(fs, rec))) {
+        if ((rc = rec.GetData((char *&)pRecBuf)) ||
+            (rc = rec.GetRid(rid)))
+            return (rc);
+        if (pRecBuf->num % 4 != 0 && (rc = DeleteRec(fh, rid)))
+            return (rc);
+    }
+    if (rc != RM_EOF || (rc = fs.CloseScan()))
+        return (rc);
+
+    // Compact in batches
+    printf("\ncompacting file\n");
+    do {
+        if ((rc = fh.Compact(PROG_UNIT, oldRids, newRids, numMoves)))
+            return (rc);
+    } while (numMoves > 0);
+
+    // Make sure the remaining records survived, now packed in the front
+    if ((rc = fs.OpenScan(fh, INT, sizeof(int), offsetof(TestRec, num),
+                          NO_OP, NULL, NO_HINT)))
+        return (rc);
+    for (n = 0; !(rc = GetNextRecScan(fs, rec)); n++) {
+        if ((rc = rec.GetData((char *&)pRecBuf)))
+            return (rc);
+        if (pRecBuf->num % 4 != 0) {
+            printf("Test3: deleted record = [%s, %d, %f]\n",
+                   pRecBuf->str, pRecBuf->num, pRecBuf->r);
+            exit(1);
+        }
+    }
+    if (rc != RM_EOF || (rc = fs.CloseScan()))
+        return (rc);
+    if (n != MANY_RECS / 4) {
+        printf("%d records in file (supposed to be %d)\n", n, MANY_RECS / 4);
+        exit(1);
+    }
+
+    // Inserts should reuse the freed space
+    if ((rc = AddRecs(fh, FEW_RECS)) ||
+        (rc = CloseFile(FILENAME, fh)))
+        return (rc);
+
+    LsFile(FILENAME);
+
+    if ((rc = DestroyFile(FILENAME)))
+        return (rc);
+
+    printf("\ntest3 done ********************\n");
+    return (0);
+}
+
+//
+// CountConsumer
+//
+// Desc: mark records delivered by a parallel scan as found
+//
+class CountConsumer : public RM_ScanConsumer {
+public:
+    CountConsumer(char *found): found(found), n(0) {}
+    RC Consume(RM_Record *recs, int numRecs)
+    {
+        RC      rc;
+        TestRec *pRecBuf;
+
+        for (int i = 0; i < numRecs; i++, n++) {
+            if ((rc = recs[i].GetData((char *&)pRecBuf)))
+                return (rc);
+            found[pRecBuf->num] += 1;
+        }
+        return (0);
+    }
+
+    char *found;
+    int  n;
+};
+
+//
+// Test4 tests a parallel scan with a pushed-down condition.
+//
+RC Test4(void)
+{
+    RC              rc;
+    RM_FileHandle   fh;
+    RM_ParallelScan ps;
+    char            found[MANY_RECS];
+    int             value = MANY_RECS / 2;
+
+    printf("test4 starting ****************\n");
+
+    memset(found, 0, MANY_RECS);
+    CountConsumer consumer(found);
+
+    if ((rc = CreateFile(FILENAME, sizeof(TestRec))) ||
+        (rc = OpenFile(FILENAME, fh)) ||
+        (rc = AddRecs(fh, MANY_RECS)))
+        return (rc);
+
+    printf("\nscanning with 4 workers\n");
+    if ((rc = ps.OpenScan(fh, INT, sizeof(int), offsetof(TestRec, num),
+                          GE_OP, &value, 4, 2)) ||
+        (rc = ps.Scan(consumer)) ||
+        (rc = ps.CloseScan()))
+        return (rc);
+
+    // Every record >= value, and only those, should be found once
+    for (int i = 0; i < MANY_RECS; i++) {
+        if (found[i] != (i >= value ? 1 : 0)) {
+            printf("Test4: record %d found %d times\n", i, found[i]);
+            exit(1);
+        }
+    }
+    printf("%d records found\n", consumer.n);
+
+    if ((rc = CloseFile(FILENAME, fh)))
+        return (rc);
+
+    LsFile(FILENAME);
+
+    if ((rc = DestroyFile(FILENAME)))
+        return (rc);
+
+    printf("\ntest4 done ********************\n");
+    return (0);
+}
+
+
+//
+// Test5 tests a file with a dictionary-encoded string attribute.
+//
+RC Test5(void)
+{
+    RC              rc;
+    RM_FileHandle   fh;
+    RM_FileScan     fs;
+    RM_ParallelScan ps;
+    RM_Record       rec;
+    TestRec         recBuf;
+    TestRec         *pRecBuf;
+    RID             rid;
+    char            found[MANY_RECS];
+    int             encOffset = offsetof(TestRec, str);
+    int             encLength = STRLEN;
+    int             i, n;
+
+    printf("test5 starting ****************\n");
+
+    printf("\ncreating %s with str encoded\n", FILENAME);
+    if ((rc = rmm.CreateFile(FILENAME, sizeof(TestRec), 1, &encOffset, &encLength)) ||
+        (rc = OpenFile(FILENAME, fh)))
+        return (rc);
+
+    printf("\nadding %d records with %d distinct strings\n", MANY_RECS, NUM_CODES);
+    memset((void *)&recBuf, 0, sizeof(recBuf));
+    for (i = 0; i < MANY_RECS; i++) {
+        memset(recBuf.str, 0, STRLEN);
+        sprintf(recBuf.str, "a%d", i % NUM_CODES);
+        recBuf.num = i;
+        recBuf.r = (float)i;
+        if ((rc = InsertRec(fh, (char *)&recBuf, rid)))
+            return (rc);
+    }
+
+    // Dictionary must survive closing and reopening
+    if ((rc = CloseFile(FILENAME, fh)) ||
+        (rc = OpenFile(FILENAME, fh)))
+        return (rc);
+
+    // Equality compares codes
+    printf("\nscanning for str = a3\n");
+    if ((rc = fs.OpenScan(fh, STRING, STRLEN, encOffset, EQ_OP, (void *)"a3")))
+        return (rc);
+    for (n = 0; (rc = GetNextRecScan(fs, rec)) == 0; n++) {
+        if ((rc = rec.GetData((char *&)pRecBuf)))
+            return (rc);
+        if (strcmp(pRecBuf->str, "a3") || pRecBuf->num % NUM_CODES != 3) {
+            printf("Test5: wrong record %s, %d\n", pRecBuf->str, pRecBuf->num);
+            exit(1);
+        }
+    }
+    if (rc != RM_EOF || (rc = fs.CloseScan()))
+        return (rc);
+    if (n != (MANY_RECS + NUM_CODES - 4) / NUM_CODES) {
+        printf("Test5: %d records found for a3\n", n);
+        exit(1);
+    }
+
+    // A string not in the dictionary matches nothing
+    if ((rc = fs.OpenScan(fh, STRING, STRLEN, encOffset, EQ_OP, (void *)"b")))
+        return (rc);
+    if ((rc = GetNextRecScan(fs, rec)) != RM_EOF) {
+        printf("Test5: found record for absent string\n");
+        exit(1);
+    }
+    if ((rc = fs.CloseScan()))
+        return (rc);
+
+    // Updates may add codes
+    printf("\nupdating one record to a new string\n");
+    if ((rc = fs.OpenScan(fh, INT, sizeof(int), offsetof(TestRec, num), EQ_OP, &n)) ||
+        (rc = GetNextRecScan(fs, rec)) ||
+        (rc = fs.CloseScan()) ||
+        (rc = rec.GetData((char *&)pRecBuf)))
+        return (rc);
+    strcpy(pRecBuf->str, "new");
+    if ((rc = UpdateRec(fh, rec)) ||
+        (rc = rec.GetRid(rid)) ||
+        (rc = fh.GetRec(rid, rec)) ||
+        (rc = rec.GetData((char *&)pRecBuf)))
+        return (rc);
+    if (strcmp(pRecBuf->str, "new") || pRecBuf->num != n) {
+        printf("Test5: update lost, got %s, %d\n", pRecBuf->str, pRecBuf->num);
+        exit(1);
+    }
+
+    // Ranges compare decoded strings; a5 < "a6" and "new" > "a6"
+    printf("\nscanning for str >= a6 with 4 workers\n");
+    memset(found, 0, MANY_RECS);
+    CountConsumer consumer(found);
+    if ((rc = ps.OpenScan(fh, STRING, STRLEN, encOffset, GE_OP, (void *)"a6", 4, 2)) ||
+        (rc = ps.Scan(consumer)) ||
+        (rc = ps.CloseScan()))
+        return (rc);
+    for (i = 0; i < MANY_RECS; i++) {
+        if (found[i] != ((i % NUM_CODES == 6 || i == n) ? 1 : 0)) {
+            printf("Test5: record %d found %d times\n", i, found[i]);
+            exit(1);
+        }
+    }
+    printf("%d records found\n", consumer.n);
+
+    // Scans without a condition may name the encoded attribute's offset,
+    // as full scans name offset 0
+    printf("\nscanning all records by offset 0\n");
+    if ((rc = fs.OpenScan(fh, INT, sizeof(int), 0, NO_OP, NULL)))
+        return (rc);
+    for (n = 0; (rc = GetNextRecScan(fs, rec)) == 0; n++)
+        ;
+    if (rc != RM_EOF || (rc = fs.CloseScan()))
+        return (rc);
+    if (n != MANY_RECS) {
+        printf("Test5: %d records found by offset 0\n", n);
+        exit(1);
+    }
+    memset(found, 0, MANY_RECS);
+    CountConsumer all(found);
+    if ((rc = ps.OpenScan(fh, INT, sizeof(int), 0, NO_OP, NULL, 4, 2)) ||
+        (rc = ps.Scan(all)) ||
+        (rc = ps.CloseScan()))
+        return (rc);
+    for (i = 0; i < MANY_RECS; i++) {
+        if (found[i] != 1) {
+            printf("Test5: record %d found %d times by offset 0\n", i, found[i]);
+            exit(1);
+        }
+    }
+
+    // A copy of the handle shares its dictionaries, and outliving it
+    // leaves them usable until the file is closed
+    {
+        RM_FileHandle copy(fh);
+        if ((rc = copy.GetRec(rid, rec)) ||
+            (rc = rec.GetData((char *&)pRecBuf)))
+            return (rc);
+        if (strcmp(pRecBuf->str, "new")) {
+            printf("Test5: copied handle read %s\n", pRecBuf->str);
+            exit(1);
+        }
+    }
+    if ((rc = fh.GetRec(rid, rec)) ||
+        (rc = rec.GetData((char *&)pRecBuf)))
+        return (rc);
+    if (strcmp(pRecBuf->str, "new")) {
+        printf("Test5: handle read %s after its copy was destroyed\n", pRecBuf->str);
+        exit(1);
+    }
+
+    if ((rc = CloseFile(FILENAME, fh)))
+        return (rc);
+
+    LsFile(FILENAME);
+
+    if ((rc = DestroyFile(FILENAME)))
+        return (rc);
+
+    printf("\ntest5 done ********************\n");
+    return (0);
+}
+
+//
+// Test6 tests fetching a batch of records by RID.
+//
+RC Test6(void)
+{
+    RC            rc;
+    RM_FileHandle fh;
+    RM_Record     recs[NUM_FETCH];
+    TestRec       recBuf;
+    TestRec       *pRecBuf;
+    RID           rids[MANY_RECS], batch[NUM_FETCH], rid;
+    PageNum       pageNum, lastPage, recPage;
+    SlotNum       slotNum, lastSlot, recSlot;
+    // Unsorted, with duplicates, from the first and last pages
+    int           nums[NUM_FETCH] = { MANY_RECS - 1, 0, MANY_RECS / 2, 0,
+                                      42, MANY_RECS - 1, 1, MANY_RECS - 2 };
+    int           i;
+
+    printf("test6 starting ****************\n");
+
+    if ((rc = CreateFile(FILENAME, sizeof(TestRec))) ||
+        (rc = OpenFile(FILENAME, fh)))
+        return (rc);
+
+    printf("\nadding %d records\n", MANY_RECS);
+    memset((void *)&recBuf, 0, sizeof(recBuf));
+    for (i = 0; i < MANY_RECS; i++) {
+        sprintf(recBuf.str, "a%d", i);
+        recBuf.num = i;
+        recBuf.r = (float)i;
+        if ((rc = InsertRec(fh, (char *)&recBuf, rids[i])))
+            return (rc);
+    }
+    for (i = 0; i < NUM_FETCH; i++)
+        batch[i] = rids[nums[i]];
+    if ((rc = rids[0].GetPageNum(pageNum)) ||
+        (rc = rids[MANY_RECS - 1].GetPageNum(lastPage)))
+        return (rc);
+    if (pageNum == lastPage) {
+        printf("Test6: %d records fit on one page\n", MANY_RECS);
+        exit(1);
+    }
+
+    // recs[i] is batch[i]'s record
+    printf("\nfetching %d records in request order\n", NUM_FETCH);
+    if ((rc = fh.GetRecs(batch, NUM_FETCH, recs)))
+        return (rc);
+    for (i = 0; i < NUM_FETCH; i++) {
+        if ((rc = recs[i].GetData((char *&)pRecBuf)))
+            return (rc);
+        if (pRecBuf->num != nums[i]) {
+            printf("Test6: record %d is %d (supposed to be %d)\n",
+                   i, pRecBuf->num, nums[i]);
+            exit(1);
+        }
+    }
+
+    // recs are sorted by RID, and each is still its RID's record
+    printf("\nfetching %d records in page order\n", NUM_FETCH);
+    if ((rc = fh.GetRecs(batch, NUM_FETCH, recs, true)))
+        return (rc);
+    for (i = 0; i < NUM_FETCH; i++) {
+        if ((rc = recs[i].GetData((char *&)pRecBuf)) ||
+            (rc = recs[i].GetRid(rid)) ||
+            (rc = rid.GetPageNum(pageNum)) ||
+            (rc = rid.GetSlotNum(slotNum)))
+            return (rc);
+        if (i > 0 && (pageNum < lastPage ||
+                      (pageNum == lastPage && slotNum < lastSlot))) {
+            printf("Test6: record %d out of page order\n", i);
+            exit(1);
+        }
+        if ((rc = rids[pRecBuf->num].GetPageNum(recPage)) ||
+            (rc = rids[pRecBuf->num].GetSlotNum(recSlot)))
+            return (rc);
+        if (pageNum != recPage || slotNum != recSlot) {
+            printf("Test6: record %d has the wrong RID\n", pRecBuf->num);
+            exit(1);
+        }
+        lastPage = pageNum;
+        lastSlot = slotNum;
+    }
+
+    // A deleted record fails the whole batch
+    printf("\nfetching a batch with a deleted record\n");
+    if ((rc = DeleteRec(fh, rids[MANY_RECS / 2])))
+        return (rc);
+    if ((rc = fh.GetRecs(batch, NUM_FETCH, recs)) != RM_RECORD_DNE) {
+        printf("Test6: fetching a deleted record returned %d\n", rc);
+        exit(1);
+    }
+
+    // So does a RID past the end of the file
+    printf("\nfetching a batch with an invalid RID\n");
+    batch[2] = RID(lastPage + MANY_RECS, 0);
+    if ((rc = fh.GetRecs(batch, NUM_FETCH, recs)) != RM_RECORD_DNE) {
+        printf("Test6: fetching an invalid RID returned %d\n", rc);
+        exit(1);
+    }
+
+    if ((rc = CloseFile(FILENAME, fh)))
+        return (rc);
+
+    LsFile(FILENAME);
+
+    if ((rc = DestroyFile(FILENAME)))
+        return (rc);
+
+    printf("\ntest6 done ********************\n");
+    return (0);
+}
+
+//
+// RowConsumer
+//
+// Desc: check rows of (r, num) projected by a parallel scan against the
+//       records at their RIDs, and mark them as found
+//
+class RowConsumer : public RM_ScanConsumer {
+public:
+    RowConsumer(RM_FileHandle &fh, char *found): fh(fh), found(found), n(0) {}
+    RC ConsumeRows(const char *rows, const RID *rids, int numRows, int rowSize)
+    {
+        RC        rc;
+        RM_Record rec;
+        TestRec   *pRecBuf;
+        float     r;
+        int       num;
+
+        if (rowSize != sizeof(float) + sizeof(int)) {
+            printf("Test7: row size %d\n", rowSize);
+            exit(1);
+        }
+        for (int i = 0; i < numRows; i++, n++, rows += rowSize) {
+            memcpy(&r, rows, sizeof(float));
+            memcpy(&num, rows + sizeof(float), sizeof(int));
+            if ((rc = fh.GetRec(rids[i], rec)) ||
+                (rc = rec.GetData((char *&)pRecBuf)))
+                return (rc);
+            if (num != pRecBuf->num || r != pRecBuf->r || r != (float)num) {
+                printf("Test7: row [%f, %d] for record [%f, %d]\n",
+                       r, num, pRecBuf->r, pRecBuf->num);
+                exit(1);
+            }
+            found[num] += 1;
+        }
+        return (0);
+    }
+
+    RM_FileHandle &fh;
+    char *found;
+    int  n;
+};
+
+//
+// Test7 tests a parallel scan projecting attributes after the first.
+//
+RC Test7(void)
+{
+    RC              rc;
+    RM_FileHandle   fh;
+    RM_ParallelScan ps;
+    char            found[MANY_RECS];
+    int             value = MANY_RECS / 4;
+    // Out of record order, so each row is (r, num)
+    int             offsets[2] = { offsetof(TestRec, r), offsetof(TestRec, num) };
+    int             lengths[2] = { sizeof(float), sizeof(int) };
+
+    printf("test7 starting ****************\n");
+
+    memset(found, 0, MANY_RECS);
+    RowConsumer consumer(fh, found);
+
+    if ((rc = CreateFile(FILENAME, sizeof(TestRec))) ||
+        (rc = OpenFile(FILENAME, fh)) ||
+        (rc = AddRecs(fh, MANY_RECS)))
+        return (rc);
+
+    printf("\nscanning r and num with 4 workers\n");
+    if ((rc = ps.OpenScan(fh, INT, sizeof(int), offsetof(TestRec, num),
+                          GE_OP, &value, 4, 2)) ||
+        (rc = ps.SetProjection(2, offsets, lengths)) ||
+        (rc = ps.Scan(consumer)) ||
+        (rc = ps.CloseScan()))
+        return (rc);
+
+    // Every record >= value, and only those, should be found once
+    for (int i = 0; i < MANY_RECS; i++) {
+        if (found[i] != (i >= value ? 1 : 0)) {
+            printf("Test7: record %d found %d times\n", i, found[i]);
+            exit(1);
+        }
+    }
+    printf("%d rows found\n", consumer.n);
+
+    if ((rc = CloseFile(FILENAME, fh)))
+        return (rc);
+
+    LsFile(FILENAME);
+
+    if ((rc = DestroyFile(FILENAME)))
+        return (rc);
+
+    printf("\ntest7 done ********************\n");
+    return (0);
+}
@@ -102,6 +102,14 @@ static int get_id(char *s)
       return yylval.ival = RW_PRINT;
    if(!strcmp(string, "set"))
       return yylval.ival = RW_SET;
+   if(!strcmp(string, "vacuum"))
+      return yylval.ival = RW_VACUUM;
+   if(!strcmp(string, "reindex"))
+      return yylval.ival = RW_REINDEX;
+   if(!strcmp(string, "analyze"))
+      return yylval.ival = RW_ANALYZE;
+   if(!strcmp(string, "using"))
+      return yylval.ival = RW_USING;
 
    if(!strcmp(string, "and"))
       return yylval.ival = RW_AND;
@@ -16,6 +16,26 @@
 #include "ix.h"
 
 #define SM_INVALID -1
+#define SM_VACUUM_BATCH 64   // default records moved per vacuum batch
+#define SM_VACUUM_DELAY 0    // default pause between vacuum batches, in ms
+#define SM_SCAN_WORKERS 1    // default worker threads per relation scan
+#define SM_AUTO_ENCODE 0     // default for choosing dictionary encoding on Load
+#define SM_DICT_MAX 4096     // most distinct values Load will encode an attribute with
+#define SM_DICT_RATIO 10     // min loaded rows per distinct value to encode
+#define SM_INDEX_COUNTS 0    // default for giving new B+tree indexes entry counts
+//
+// SM_CompositeIndex: an open composite index, and where the tuples its
+// keys are made from hold each key attribute
+//
+struct SM_CompositeIndex {
+	Indexcat indexcat;
+	int offsets[MAXINDEXATTRS];
+	IX_IndexHandle indexHandle;
+	char key[MAXSTRINGLEN];     // last key made
+
+	RC MakeKey(char *pData);    // Encodes pData's key into key
+};
+
 //
 // SM_Manager: provides data management
 //
@@ -34,31 +54,69 @@ public:
                    int        attrCount,          //   number of attributes
                    AttrInfo   *attributes);       //   attribute data
     RC CreateIndex(const char *relName,           // create an index for
-                   const char *attrName);         //   relName.attrName
+                   const char *attrName,          //   relName.attrName,
+                   IndexType  indexType = BTREE_INDEX); // a B+tree, hash or bitmap
+    RC CreateIndex(const char *relName,           // create a composite index
+                   int        attrCount,          //   for relName on attrCount
+                   const char * const attrNames[], // attributes, in order;
+                   IndexType  indexType = BTREE_INDEX); // only B+trees for 2+
     RC DropTable  (const char *relName);          // destroy a relation
 
     RC DropIndex  (const char *relName,           // destroy index on
                    const char *attrName);         //   relName.attrName
+    RC DropIndex  (const char *relName,           // destroy composite index
+                   int        attrCount,          //   on relName's attributes
+                   const char * const attrNames[]);
     RC Load       (const char *relName,           // load relName from
                    const char *fileName);         //   fileName
     RC Help       ();                             // Print relations in db
     RC Help       (const char *relName);          // print schema of relName
+    RC HelpIndex  (const char *relName);          // print statistics of
+                                                  //   relName's indexes
 
     RC Print      (const char *relName);          // print relName contents
 
     RC Set        (const char *paramName,         // set parameter to
                    const char *value);            //   value
 
+    RC Vacuum     (const char *relName);          // compact relName's pages
+
+    RC Reindex    (const char *relName,           // rebuild index on
+                   const char *attrName);         //   relName.attrName
+    RC Reindex    (const char *relName,           // rebuild composite index
+                   int        attrCount,          //   on relName's attributes
+                   const char * const attrNames[]);
+
+    RC Analyze    (const char *relName);          // refresh statistics of
+                                                  //   relName's indexes
+
 private:
 	bool isCatalog(const char* relName);
 	RC CheckName(const char* relName);
 	RC GetRelcatRecord (const char* relName, RM_Record &record);
 	RC GetAttrcatRecord (const char* relName, const char *attrName, RM_Record &record);
 	RC GetAttrcats(const char* relName, Attrcat* attributes);
+	RC GetIndexcatRecord(const char* relName, int attrCount, const char * const attrNames[], RM_Record &record);
+	RC GetIndexcats(const char* relName, Indexcat* indexes, int &numIndexes); // room for relcat's indexCount
+	RC OpenCompositeIndexes(const char* relName, SM_CompositeIndex* &indexes, int &numIndexes); // caller deletes
+	RC CloseCompositeIndexes(SM_CompositeIndex* indexes, int numIndexes);
+	RC GetIntParam(const char *value, int &param);
+	RC UpdateStatcat(const char* relName, int indexNo, IX_IndexHandle &indexHandle);
+	RC DeleteStatcats(const char* relName, int indexNo); // every index of relName's if SM_INVALID
+	RC ChooseEncoding(const char *relName, const char *fileName, const Relcat &relcat,
+	                  const Attrcat *attributes, int attrCount, RM_FileHandle &fileHandle);
 	
 	IX_Manager* ixManager;
 	RM_Manager* rmManager;
-	RM_FileHandle relFile, attrFile;
+	RM_FileHandle relFile, attrFile, indexFile, statFile;
+
+	// System parameters, changed through Set
+	int vacuumBatch;  // records moved (and index entries updated) per batch
+	int vacuumDelay;  // pause between batches, in ms, to yield to queries
+	int scanWorkers;  // worker threads for Print, CreateIndex and QL file scans
+	int autoEncode;   // 1 if Load into an empty relation picks encoded attributes
+	int indexFill;    // percent of each node filled when an index is bulk loaded
+	int indexCounts;  // 1 if CreateIndex gives a B+tree entry counts
 };
 
 //
@@ -75,7 +133,8 @@ void SM_PrintError(RC rc);
 #define SM_DNE					(START_SM_WARN + 6)
 #define SM_FILENOTOPEN			(START_SM_WARN + 7)
 #define SM_INVALIDCATACTION		(START_SM_WARN + 8)
-#define SM_LASTWARN		SM_INVALIDCATACTION
+#define SM_INVALIDPARAM			(START_SM_WARN + 9)
+#define SM_LASTWARN		SM_INVALIDPARAM
 
 #define SM_CHDIR			 (START_SM_ERR - 0)
 #define SM_INVALIDATTRLEN	 (START_SM_ERR - 1)
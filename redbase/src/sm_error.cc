@@ -14,7 +14,8 @@ static char *SM_WarnMsg[] = {
   (char*)"relation or index already exists",
   (char*)"relation or index does not exist",
   (char*)"file did not successfully open",
-  (char*)"invalid action upon a catalog"
+  (char*)"invalid action upon a catalog",
+  (char*)"unknown parameter or invalid parameter value"
 };
 
 static char *SM_ErrorMsg[] = {
@@ -18,7 +18,77 @@
 using namespace std;
 bool sortAttrcats(const Attrcat &i, const Attrcat &j);
 
-SM_Manager::SM_Manager(IX_Manager &ixm, RM_Manager &rmm): ixManager(&ixm), rmManager(&rmm){}
+// Frees Load's bulk loaders; an unclosed loader discards its entries
+static void DeleteLoaders(vector<IX_BulkLoader*> &loaders){
+	for (int i = 0; i < loaders.size(); ++i){
+		delete loaders[i];
+		loaders[i] = NULL;
+	}
+}
+
+// Prints each scanned tuple
+class SM_PrintConsumer : public RM_ScanConsumer {
+public:
+	SM_PrintConsumer(Printer &printer): printer(printer) {}
+	RC Consume(RM_Record *recs, int numRecs){
+		RC rc;
+		char* pData;
+		for (int i = 0; i < numRecs; ++i){
+			if (rc = recs[i].GetData(pData))
+				return rc;
+			printer.Print(cout, pData);
+		}
+		return 0;
+	}
+private:
+	Printer &printer;
+};
+
+// Adds each scanned tuple's attribute (projected by the scan) to an index bulk load
+class SM_IndexConsumer : public RM_ScanConsumer {
+public:
+	SM_IndexConsumer(IX_BulkLoader &loader): loader(loader) {}
+	RC ConsumeRows(const char *rows, const RID *rids, int numRows, int rowSize){
+		RC rc;
+		for (int i = 0; i < numRows; ++i){
+			if (rc = loader.InsertEntry((void*)(rows + i * rowSize), rids[i]))
+				return rc;
+		}
+		return 0;
+	}
+private:
+	IX_BulkLoader &loader;
+};
+
+// Adds each scanned tuple's key (its key attributes, projected by the scan
+// in key order) to a composite index bulk load
+class SM_CompositeConsumer : public RM_ScanConsumer {
+public:
+	SM_CompositeConsumer(IX_BulkLoader &loader, SM_CompositeIndex &index): loader(loader), index(index) {}
+	RC ConsumeRows(const char *rows, const RID *rids, int numRows, int rowSize){
+		RC rc;
+		for (int i = 0; i < numRows; ++i){
+			if ((rc = index.MakeKey((char*)(rows + i * rowSize))) ||
+				(rc = loader.InsertEntry(index.key, rids[i])))
+				return rc;
+		}
+		return 0;
+	}
+private:
+	IX_BulkLoader &loader;
+	SM_CompositeIndex &index;
+};
+
+RC SM_CompositeIndex::MakeKey(char *pData){
+	void* values[MAXINDEXATTRS];
+	for (int i = 0; i < indexcat.attrCount; ++i)
+		values[i] = pData + offsets[i];
+	return indexHandle.EncodeKey(values, indexcat.attrCount, false, key);
+}
+
+SM_Manager::SM_Manager(IX_Manager &ixm, RM_Manager &rmm): ixManager(&ixm), rmManager(&rmm),
+	vacuumBatch(SM_VACUUM_BATCH), vacuumDelay(SM_VACUUM_DELAY), scanWorkers(SM_SCAN_WORKERS),
+	autoEncode(SM_AUTO_ENCODE), indexFill(IX_FILL_PERCENT), indexCounts(SM_INDEX_COUNTS){}
 
 SM_Manager::~SM_Manager()
 {
@@ -32,24 +102,32 @@ RC SM_Manager::OpenDb(const char *dbName)
     if (chdir(dbName) < 0)
         return SM_CHDIR;
 
-	// Open relcat and attrcat relations
+	// Open relcat, attrcat, indexcat and statcat relations
 	RC rc;
 	if (rc = rmManager->OpenFile(MYRELCAT, relFile))
 		return rc;
 	if (rc = rmManager->OpenFile(MYATTRCAT, attrFile))
 		return rc;
+	if (rc = rmManager->OpenFile(MYINDEXCAT, indexFile))
+		return rc;
+	if (rc = rmManager->OpenFile(MYSTATCAT, statFile))
+		return rc;
 
     return (0);
 }
 
 RC SM_Manager::CloseDb()
 {
-	// Close relcat and attrcat relations
+	// Close relcat, attrcat, indexcat and statcat relations
 	RC rc;
 	if (rc = rmManager->CloseFile(relFile))
 		return rc;
 	if (rc = rmManager->CloseFile(attrFile))
 		return rc;
+	if (rc = rmManager->CloseFile(indexFile))
+		return rc;
+	if (rc = rmManager->CloseFile(statFile))
+		return rc;
 
 	// Change currect working directory to up parent directory
 	if (chdir("..") < 0)
@@ -102,6 +180,11 @@ RC SM_Manager::CreateTable(const char *relName,
 			return SM_INVALIDATTRLEN;
 		if (attrInfo.attrType != STRING && attrInfo.attrLength != 4)
 			return SM_INVALIDATTRLEN;
+		// Check encoded attributes are strings longer than a code
+		if (attrInfo.encoded && attrInfo.attrType != STRING)
+			return SM_INVALIDENUM;
+		if (attrInfo.encoded && attrInfo.attrLength <= sizeof(int))
+			return SM_INVALIDATTRLEN;
 
 		// Check attribute name
 		if (rc = CheckName(attrInfo.attrName))
@@ -120,12 +203,20 @@ RC SM_Manager::CreateTable(const char *relName,
 	// Initialize
 	RID rid;
 	int offset = 0;
+	int numEncoded = 0;
+	int encOffsets[MAXATTRS], encLengths[MAXATTRS];
 
 	// Update attrcat
 	for (int i = 0; i < attrCount; i++){
 		Attrcat attrcat = Attrcat(relName, attributes[i].attrName, offset, attributes[i].attrType, attributes[i].attrLength, SM_INVALID);
+		attrcat.encoded = attributes[i].encoded ? 1 : 0;
 		if (rc = attrFile.InsertRec((char*)&attrcat, rid))
 			return rc;
+		if (attributes[i].encoded){
+			encOffsets[numEncoded] = offset;
+			encLengths[numEncoded] = attributes[i].attrLength;
+			++numEncoded;
+		}
 		offset += attributes[i].attrLength;
 	}
 
@@ -136,7 +227,7 @@ RC SM_Manager::CreateTable(const char *relName,
 		return rc;
 
 	// Create relation file
-	if (rc = rmManager->CreateFile(relName, tupleLen))
+	if (rc = rmManager->CreateFile(relName, tupleLen, numEncoded, encOffsets, encLengths))
 		return rc;
 
     return (0);
@@ -211,11 +302,36 @@ RC SM_Manager::DropTable(const char *relName)
 	if (rc = fileScan.CloseScan())
 		return rc;
 
+	// Delete composite indexes' indexcat entries and files
+	offset = (int)offsetof(struct Indexcat, relName);
+	if (rc = fileScan.OpenScan(indexFile, STRING, MAXNAME, offset, EQ_OP, relation))
+		return rc;
+	while ( OK_RC == (rc = fileScan.GetNextRec(record))){
+		if (rc = record.GetData(pData))
+			return rc;
+		Indexcat indexcat(pData);
+		if (rc = record.GetRid(rid))
+			return rc;
+		if (rc = indexFile.DeleteRec(rid))
+			return rc;
+		if (rc = ixManager->DestroyIndex(relName, indexcat.indexNo))
+			return rc;
+	}
+	if (rc != RM_EOF)
+		return rc;
+	if (rc = fileScan.CloseScan())
+		return rc;
+
+	// Delete every index's statistics
+	if (rc = DeleteStatcats(relName, SM_INVALID))
+		return rc;
+
     return (0);
 }
 
 RC SM_Manager::CreateIndex(const char *relName,
-                           const char *attrName)
+                           const char *attrName,
+                           IndexType  indexType)
 {
 	RC rc;
 
@@ -224,6 +340,8 @@ RC SM_Manager::CreateIndex(const char *relName,
 		return rc;
 	if (rc = CheckName(attrName))
 		return rc;
+	if (indexType != BTREE_INDEX && indexType != HASH_INDEX && indexType != BITMAP_INDEX)
+		return SM_INVALIDENUM;
 	// End check input.
 
 	RM_Record record;
@@ -246,6 +364,7 @@ RC SM_Manager::CreateIndex(const char *relName,
 
 	// Update attrcat
 	attrcat.indexNo = indexNo;
+	attrcat.indexType = indexType;
 	memcpy(pData, &attrcat, sizeof(Attrcat));
 	if (rc = attrFile.UpdateRec(record))
 		return rc;
@@ -265,47 +384,58 @@ RC SM_Manager::CreateIndex(const char *relName,
 		return rc;
 
 	// Create index
-	if (rc = ixManager->CreateIndex(relName, indexNo, attrcat.attrType, attrcat.attrLen))
+	if (rc = ixManager->CreateIndex(relName, indexNo, attrcat.attrType, attrcat.attrLen, indexType))
 		return rc;
 
 	// Prepare relation scan / index insertion
 	IX_IndexHandle indexHandle;
 	RM_FileHandle fileHandle;
-	RM_FileScan fileScan;
-	RID rid;
+	RM_ParallelScan fileScan;
 	// Open index
 	if (rc = ixManager->OpenIndex(relName, indexNo, indexHandle))
 		return rc;
 	// Open (relation if not a catalog) and scan
 	if (strcmp(relName, MYRELCAT) == 0){
-		if (rc = fileScan.OpenScan(relFile, INT, 4, 0, NO_OP, NULL))
+		if (rc = fileScan.OpenScan(relFile, INT, 4, 0, NO_OP, NULL, scanWorkers))
 		return rc;
 	}
 	else if (strcmp(relName, MYATTRCAT) == 0){
-		if (rc = fileScan.OpenScan(attrFile, INT, 4, 0, NO_OP, NULL))
+		if (rc = fileScan.OpenScan(attrFile, INT, 4, 0, NO_OP, NULL, scanWorkers))
+			return rc;
+	} 
+	else if (strcmp(relName, MYINDEXCAT) == 0){
+		if (rc = fileScan.OpenScan(indexFile, INT, 4, 0, NO_OP, NULL, scanWorkers))
+			return rc;
+	} 
+	else if (strcmp(relName, MYSTATCAT) == 0){
+		if (rc = fileScan.OpenScan(statFile, INT, 4, 0, NO_OP, NULL, scanWorkers))
 			return rc;
 	} 
 	else {
 		// Open relation
 		if (rc = rmManager->OpenFile(relName, fileHandle))
 			return rc;
-		if (rc = fileScan.OpenScan(fileHandle, INT, 4, 0, NO_OP, NULL))
+		if (rc = fileScan.OpenScan(fileHandle, INT, 4, 0, NO_OP, NULL, scanWorkers))
 			return rc;
 	}
 
-	// Insert each relation tuple into index
-	while ( OK_RC == (rc = fileScan.GetNextRec(record))){
-		if (rc = record.GetData(pData))
-			return rc;
-		void* attribute = pData + attrcat.offset;
-		if (rc = record.GetRid(rid))
-			return rc;
-		
-		if (rc = indexHandle.InsertEntry(attribute, rid))
-			return rc;
+	// A B+tree given entry counts is counted once loaded
+	if (indexCounts && indexType == BTREE_INDEX &&
+		(rc = ixManager->CreateEntryCounts(relName, indexNo, indexHandle)))
+		return rc;
+
+	// Bulk load each relation tuple into the new index, reading only the attribute
+	IX_BulkLoader loader(*ixManager);
+	if (rc = loader.OpenLoad(relName, indexNo, indexHandle, indexFill))
+		return rc;
+	SM_IndexConsumer consumer(loader);
+	if (rc = fileScan.SetProjection(1, &attrcat.offset, &attrcat.attrLen))
+		return rc;
+	if (rc = fileScan.Scan(consumer)){
+		loader.CloseLoad();
+		return rc;
 	}
-	// Check if error occurred while scanning
-	if (rc != RM_EOF)
+	if (rc = loader.CloseLoad())
 		return rc;
 
 	// Clean up
@@ -316,12 +446,160 @@ RC SM_Manager::CreateIndex(const char *relName,
 		if (rc = rmManager->CloseFile(fileHandle))
 			return rc;
 	}
+	if (rc = UpdateStatcat(relName, indexNo, indexHandle))
+		return rc;
 	if (rc = ixManager->CloseIndex(indexHandle))
 		return rc;
 
     return (0);
 }
 
+RC SM_Manager::CreateIndex(const char *relName,
+                           int        attrCount,
+                           const char * const attrNames[],
+                           IndexType  indexType)
+{
+	RC rc;
+
+	// A single attribute is an ordinary index
+	if (attrCount == 1 && attrNames)
+		return CreateIndex(relName, attrNames[0], indexType);
+
+	// Composite keys are matched by prefix, which a hash can't do
+	if (indexType != BTREE_INDEX)
+		return SM_INVALIDENUM;
+
+	// Check input
+	if (rc = CheckName(relName))
+		return rc;
+	if (isCatalog(relName))
+		return SM_INVALIDCATACTION;
+	if (!attrNames)
+		return SM_NULLINPUT;
+	if (attrCount < 1 || attrCount > MAXINDEXATTRS)
+		return SM_ATTRNUM;
+	for (int i = 0; i < attrCount; ++i){
+		if (rc = CheckName(attrNames[i]))
+			return rc;
+		for (int j = 0; j < i; ++j){
+			if (strcmp(attrNames[i], attrNames[j]) == 0)
+				return SM_EXISTS;
+		}
+	}
+	// End check input.
+
+	RM_Record record;
+	char* pData;
+
+	// Check relation and key attributes exist
+	if (rc = GetRelcatRecord(relName, record)){
+		if (rc == RM_EOF)
+			return SM_DNE;
+		return rc;
+	}
+	if (rc = record.GetData(pData))
+		return rc;
+	Relcat relcat(pData);
+	SM_CompositeIndex index;
+	AttrType attrTypes[MAXINDEXATTRS];
+	int attrLengths[MAXINDEXATTRS];
+	for (int i = 0; i < attrCount; ++i){
+		if (rc = GetAttrcatRecord(relName, attrNames[i], record)){
+			if (rc == RM_EOF)
+				return SM_DNE;
+			return rc;
+		}
+		if (rc = record.GetData(pData))
+			return rc;
+		Attrcat attrcat(pData);
+		index.offsets[i] = attrcat.offset;
+		attrTypes[i] = attrcat.attrType;
+		attrLengths[i] = attrcat.attrLen;
+	}
+
+	// Check there is not already an index on the attributes
+	rc = GetIndexcatRecord(relName, attrCount, attrNames, record);
+	if (rc == 0)
+		return SM_EXISTS;
+	if (rc != RM_EOF)
+		return rc;
+
+	// Index number is past every offset, so unique among the relation's
+	// single attribute indexes, and not taken by another composite index
+	Indexcat* indexes = new Indexcat[relcat.indexCount];
+	int numIndexes;
+	if (rc = GetIndexcats(relName, indexes, numIndexes)){
+		delete [] indexes;
+		return rc;
+	}
+	int indexNo = relcat.tupleLen;
+	for (int i = 0; i < numIndexes; ++i){
+		if (indexes[i].indexNo >= indexNo)
+			indexNo = indexes[i].indexNo + 1;
+	}
+	delete [] indexes;
+
+	// Create index
+	if (rc = ixManager->CreateIndex(relName, indexNo, attrCount, attrTypes, attrLengths))
+		return rc;
+
+	// Update indexcat
+	RID rid;
+	index.indexcat = Indexcat(relName, indexNo, attrCount, attrNames);
+	if (rc = indexFile.InsertRec((char*)&index.indexcat, rid))
+		return rc;
+
+	// Update relcat
+	if (rc = GetRelcatRecord(relName, record))
+		return rc;
+	if (rc = record.GetData(pData))
+		return rc;
+	relcat.indexCount += 1;
+	memcpy(pData, &relcat, sizeof(Relcat));
+	if (rc = relFile.UpdateRec(record))
+		return rc;
+
+	// Bulk load each relation tuple's key, reading only the key attributes
+	RM_FileHandle fileHandle;
+	RM_ParallelScan fileScan;
+	if (rc = ixManager->OpenIndex(relName, indexNo, index.indexHandle))
+		return rc;
+	if (rc = rmManager->OpenFile(relName, fileHandle))
+		return rc;
+	if (rc = fileScan.OpenScan(fileHandle, INT, 4, 0, NO_OP, NULL, scanWorkers))
+		return rc;
+	if (rc = fileScan.SetProjection(attrCount, index.offsets, attrLengths))
+		return rc;
+	// The projected row holds the key attributes back to back
+	int offset = 0;
+	for (int i = 0; i < attrCount; ++i){
+		index.offsets[i] = offset;
+		offset += attrLengths[i];
+	}
+	IX_BulkLoader loader(*ixManager);
+	if (rc = loader.OpenLoad(relName, indexNo, index.indexHandle, indexFill))
+		return rc;
+	SM_CompositeConsumer consumer(loader, index);
+	if (rc = fileScan.Scan(consumer)){
+		loader.CloseLoad();
+		return rc;
+	}
+	if (rc = loader.CloseLoad())
+		return rc;
+
+	// Clean up
+	if (rc = fileScan.CloseScan())
+		return rc;
+	if (rc = rmManager->CloseFile(fileHandle))
+		return rc;
+	if (rc = UpdateStatcat(relName, indexNo, index.indexHandle))
+		return rc;
+	if (rc = ixManager->CloseIndex(index.indexHandle))
+		return rc;
+
+    return (0);
+}
+
 RC SM_Manager::DropIndex(const char *relName,
                          const char *attrName)
 {
@@ -354,6 +632,7 @@ RC SM_Manager::DropIndex(const char *relName,
 
 	// Update attrcat
 	attrcat.indexNo = SM_INVALID;
+	attrcat.indexType = BTREE_INDEX;
 	memcpy(pData, &attrcat, sizeof(Attrcat));
 	if (rc = attrFile.UpdateRec(record))
 		return rc;
@@ -372,9 +651,73 @@ RC SM_Manager::DropIndex(const char *relName,
 	if (rc = relFile.UpdateRec(record))
 		return rc;
 
-	// Delete index
+	// Delete index and its statistics
 	if (rc = ixManager->DestroyIndex(relName, indexNo))
 		return rc;
+	if (rc = DeleteStatcats(relName, indexNo))
+		return rc;
+
+    return (0);
+}
+
+RC SM_Manager::DropIndex(const char *relName,
+                         int        attrCount,
+                         const char * const attrNames[])
+{
+	RC rc;
+
+	// A single attribute is an ordinary index
+	if (attrCount == 1 && attrNames)
+		return DropIndex(relName, attrNames[0]);
+
+	// Check input
+	if (rc = CheckName(relName))
+		return rc;
+	if (!attrNames)
+		return SM_NULLINPUT;
+	if (attrCount < 1 || attrCount > MAXINDEXATTRS)
+		return SM_ATTRNUM;
+	// End check input.
+
+	RM_Record record;
+	char* pData;
+	RID rid;
+
+	// Check there is an index on the attributes
+	if (rc = GetIndexcatRecord(relName, attrCount, attrNames, record)){
+		if (rc == RM_EOF)
+			return SM_DNE;
+		return rc;
+	}
+	if (rc = record.GetData(pData))
+		return rc;
+	Indexcat indexcat(pData);
+
+	// Update indexcat
+	if (rc = record.GetRid(rid))
+		return rc;
+	if (rc = indexFile.DeleteRec(rid))
+		return rc;
+
+	// Update relcat
+	if (rc = GetRelcatRecord(relName, record)){
+		if (rc == RM_EOF)
+			return SM_DNE;
+		return rc;
+	}
+	if (rc = record.GetData(pData))
+		return rc;
+	Relcat relcat(pData);
+	relcat.indexCount -= 1;
+	memcpy(pData, &relcat, sizeof(Relcat));
+	if (rc = relFile.UpdateRec(record))
+		return rc;
+
+	// Delete index and its statistics
+	if (rc = ixManager->DestroyIndex(relName, indexcat.indexNo))
+		return rc;
+	if (rc = DeleteStatcats(relName, indexcat.indexNo))
+		return rc;
 
     return (0);
 }
@@ -445,6 +788,12 @@ RC SM_Manager::Load(const char *relName,
 	if (rc = fileScan.CloseScan())
 		return rc;
 
+	// Open composite indexes
+	SM_CompositeIndex* composites;
+	int numComposites;
+	if (rc = OpenCompositeIndexes(relName, composites, numComposites))
+		return rc;
+
 	// Sort attributes by attrNo
 	sort(attributes.begin(), attributes.end(), sortAttrcats);
     //cerr << "C" << endl;
@@ -459,10 +808,37 @@ RC SM_Manager::Load(const char *relName,
 		return rc;
 	Relcat relcat(pData);
     //cerr << "D" << endl;
+	// Pick dictionary-encoded attributes from a sample of the file
+	if (autoEncode){
+		if (rc = ChooseEncoding(relName, fileName, relcat, &attributes[0], attributes.size(), fileHandle))
+			return rc;
+	}
+	// Bulk load each index that is still empty; the rest take inserts.
+	// Composite indexes' loaders follow the single attribute ones.
+	vector<IX_BulkLoader*> loaders(indexes.size() + numComposites, (IX_BulkLoader*)NULL);
+	for (int i = 0; i < loaders.size(); ++i){
+		loaders[i] = new IX_BulkLoader(*ixManager);
+		if (i < indexes.size())
+			rc = loaders[i]->OpenLoad(relName, indexes[i].first.indexNo, indexes[i].second, indexFill);
+		else {
+			SM_CompositeIndex &composite = composites[i - indexes.size()];
+			rc = loaders[i]->OpenLoad(relName, composite.indexcat.indexNo, composite.indexHandle, indexFill);
+		}
+		if (rc == IX_NOTEMPTY){
+			delete loaders[i];
+			loaders[i] = NULL;
+		}
+		else if (rc){
+			DeleteLoaders(loaders);
+			return rc;
+		}
+	}
 	// Open ASCII file
 	ifstream asciiFile(fileName);
-	if (!asciiFile.is_open())
+	if (!asciiFile.is_open()){
+		DeleteLoaders(loaders);
 		return SM_FILENOTOPEN;
+	}
 	// Read tuples from ASCII file
 	string line;
 	while (getline(asciiFile, line)){	
@@ -482,6 +858,7 @@ RC SM_Manager::Load(const char *relName,
 					ss >> tmp;
 					if (ss.fail() || ss.rdbuf()->in_avail() != 0){
 						delete [] pData;
+						DeleteLoaders(loaders);
 						//cerr << "INT: " << line << " token: " << token << endl;
 						return SM_INVALIDLOADFORMAT;
 					}
@@ -495,6 +872,7 @@ RC SM_Manager::Load(const char *relName,
 					ss >> tmp;
 					if (ss.fail() || ss.rdbuf()->in_avail() != 0){
 						delete [] pData;
+						DeleteLoaders(loaders);
 						//cerr << "FLOAT" << endl;
 						return SM_INVALIDLOADFORMAT;
 					}
@@ -505,6 +883,7 @@ RC SM_Manager::Load(const char *relName,
 				{
 					if (token.size() > attributes[i].attrLen){
 						delete [] pData;
+						DeleteLoaders(loaders);
 						//cerr << "STRING" << endl;
 						return  SM_INVALIDLOADFORMAT;
 					}
@@ -520,6 +899,7 @@ RC SM_Manager::Load(const char *relName,
 		RID rid;
 		if (rc = fileHandle.InsertRec(pData, rid)){
 			delete [] pData;
+			DeleteLoaders(loaders);
 			return rc;
 		} 
         //cerr << "G" << endl;
@@ -527,8 +907,27 @@ RC SM_Manager::Load(const char *relName,
 		for (int i = 0; i < indexes.size(); ++i){
 			pair<Attrcat, IX_IndexHandle> pair = indexes.at(i);
 			char* attribute = pData + pair.first.offset;
-			if (rc = indexes.at(i).second.InsertEntry(attribute, rid)){
+			if (loaders[i])
+				rc = loaders[i]->InsertEntry(attribute, rid);
+			else
+				rc = indexes.at(i).second.InsertEntry(attribute, rid);
+			if (rc){
 				delete [] pData;
+				DeleteLoaders(loaders);
+				return rc;
+			}
+		}
+		for (int i = 0; i < numComposites; ++i){
+			IX_BulkLoader* loader = loaders[indexes.size() + i];
+			if (!(rc = composites[i].MakeKey(pData))){
+				if (loader)
+					rc = loader->InsertEntry(composites[i].key, rid);
+				else
+					rc = composites[i].indexHandle.InsertEntry(composites[i].key, rid);
+			}
+			if (rc){
+				delete [] pData;
+				DeleteLoaders(loaders);
 				return rc;
 			}
 		}
@@ -539,6 +938,14 @@ RC SM_Manager::Load(const char *relName,
     //cerr << "H" << endl;
 	// Close ASCII file
 	asciiFile.close();
+	// Build bulk loaded indexes
+	for (int i = 0; i < loaders.size(); ++i){
+		if (loaders[i] && (rc = loaders[i]->CloseLoad())){
+			DeleteLoaders(loaders);
+			return rc;
+		}
+	}
+	DeleteLoaders(loaders);
 	// Close relation file
 	if (rc = rmManager->CloseFile(fileHandle))
 		return rc;
@@ -547,6 +954,8 @@ RC SM_Manager::Load(const char *relName,
 		if (rc = ixManager->CloseIndex(indexes.at(i).second))
 			return rc;
 	}
+	if (rc = CloseCompositeIndexes(composites, numComposites))
+		return rc;
 
     return (0);
 }
@@ -585,45 +994,52 @@ RC SM_Manager::Print(const char *relName)
 	printer.PrintHeader(cout);
 
 	// Initialize scan
-	RM_FileScan fileScan;
+	RM_ParallelScan fileScan;
 	RM_FileHandle fileHandle;
 	if (strcmp(relName, MYRELCAT) == 0){
-		if (rc = fileScan.OpenScan(relFile, INT, 4, 0, NO_OP, NULL)){
+		if (rc = fileScan.OpenScan(relFile, INT, 4, 0, NO_OP, NULL, scanWorkers)){
 			delete [] attributes;
 			delete [] dataAttrs;
 			return rc;
 		}
 	}
 	else if (strcmp(relName, MYATTRCAT) == 0){
-		if (rc = fileScan.OpenScan(attrFile, INT, 4, 0, NO_OP, NULL)){
+		if (rc = fileScan.OpenScan(attrFile, INT, 4, 0, NO_OP, NULL, scanWorkers)){
 			delete [] attributes;
 			delete [] dataAttrs;
 			return rc;
 		}
 	} 
-	else{
-		if (rc = rmManager->OpenFile(relName, fileHandle)){
+	else if (strcmp(relName, MYINDEXCAT) == 0){
+		if (rc = fileScan.OpenScan(indexFile, INT, 4, 0, NO_OP, NULL, scanWorkers)){
 			delete [] attributes;
 			delete [] dataAttrs;
 			return rc;
 		}
-		if (rc = fileScan.OpenScan(fileHandle, INT, 4, 0, NO_OP, NULL)){
+	} 
+	else if (strcmp(relName, MYSTATCAT) == 0){
+		if (rc = fileScan.OpenScan(statFile, INT, 4, 0, NO_OP, NULL, scanWorkers)){
 			delete [] attributes;
 			delete [] dataAttrs;
 			return rc;
 		}
-	}
-
-	// Scan and print tuples
-	while ( OK_RC == (rc = fileScan.GetNextRec(record))){
-		if (rc = record.GetData(pData)){
+	} 
+	else{
+		if (rc = rmManager->OpenFile(relName, fileHandle)){
+			delete [] attributes;
+			delete [] dataAttrs;
+			return rc;
+		}
+		if (rc = fileScan.OpenScan(fileHandle, INT, 4, 0, NO_OP, NULL, scanWorkers)){
 			delete [] attributes;
 			delete [] dataAttrs;
 			return rc;
 		}
-		printer.Print(cout, pData);
 	}
-	if (rc != RM_EOF){
+
+	// Scan and print tuples
+	SM_PrintConsumer consumer(printer);
+	if (rc = fileScan.Scan(consumer)){
 		delete [] attributes;
 		delete [] dataAttrs;
 		return rc;
@@ -650,38 +1066,377 @@ RC SM_Manager::Print(const char *relName)
 }
 
 RC SM_Manager::Set(const char *paramName, const char *value)
-{
-	// TODO: nothing for now
-    return (0);
-}
-
-RC SM_Manager::Help()
-{
-    //cout << "Help\n";
-	RC rc;
-	if (rc = Print(MYRELCAT))
-		return rc;
-    return (0);
-}
-
-RC SM_Manager::Help(const char *relName)
 {
 	RC rc;
 
 	// Check input
-	if (rc = CheckName(relName))
-		return rc;
-	// End check input
+	if (!paramName || !value)
+		return SM_NULLINPUT;
+	// End check input.
 
-	// Get attributes
-	RM_Record record;
-	char* pData;
-	if (rc = GetRelcatRecord(relName, record)){
-		if (rc == RM_EOF)
-			return SM_DNE;
-		return rc;
+	if (strcmp(paramName, "vacuumBatch") == 0){
+		if (rc = GetIntParam(value, vacuumBatch))
+			return rc;
+		if (vacuumBatch < 1){
+			vacuumBatch = SM_VACUUM_BATCH;
+			return SM_INVALIDPARAM;
+		}
 	}
-	if (rc = record.GetData(pData))
+	else if (strcmp(paramName, "vacuumDelay") == 0){
+		if (rc = GetIntParam(value, vacuumDelay))
+			return rc;
+		if (vacuumDelay < 0){
+			vacuumDelay = SM_VACUUM_DELAY;
+			return SM_INVALIDPARAM;
+		}
+	}
+	else if (strcmp(paramName, "scanWorkers") == 0){
+		if (rc = GetIntParam(value, scanWorkers))
+			return rc;
+		if (scanWorkers < 1){
+			scanWorkers = SM_SCAN_WORKERS;
+			return SM_INVALIDPARAM;
+		}
+	}
+	else if (strcmp(paramName, "autoEncode") == 0){
+		if (rc = GetIntParam(value, autoEncode))
+			return rc;
+		if (autoEncode != 0 && autoEncode != 1){
+			autoEncode = SM_AUTO_ENCODE;
+			return SM_INVALIDPARAM;
+		}
+	}
+	else if (strcmp(paramName, "indexFill") == 0){
+		if (rc = GetIntParam(value, indexFill))
+			return rc;
+		if (indexFill < 1 || indexFill > 100){
+			indexFill = IX_FILL_PERCENT;
+			return SM_INVALIDPARAM;
+		}
+	}
+	else if (strcmp(paramName, "indexCounts") == 0){
+		if (rc = GetIntParam(value, indexCounts))
+			return rc;
+		if (indexCounts != 0 && indexCounts != 1){
+			indexCounts = SM_INDEX_COUNTS;
+			return SM_INVALIDPARAM;
+		}
+	}
+	else if (strcmp(paramName, "indexMerge") == 0){
+		// Kept by IX, for indexes opened from now on
+		int indexMerge;
+		if (rc = GetIntParam(value, indexMerge))
+			return rc;
+		if (indexMerge < 0 || indexMerge > 50)
+			return SM_INVALIDPARAM;
+		if (rc = ixManager->SetMergePercent(indexMerge))
+			return rc;
+	}
+	else
+		return SM_INVALIDPARAM;
+
+    return (0);
+}
+
+RC SM_Manager::Vacuum(const char *relName)
+{
+	RM_FileHandle fileHandle;
+	vector<pair<Attrcat, IX_IndexHandle> > indexes;
+	RC rc;
+
+	// Check input
+	if (rc = CheckName(relName))
+		return rc;
+	if (isCatalog(relName))
+		return SM_INVALIDCATACTION;
+	// End check input.
+
+	// Check if relation exists
+	RM_Record record;
+	if (rc = GetRelcatRecord(relName, record)){
+		if (rc == RM_EOF)
+			return SM_DNE;
+		return rc;
+	}
+
+	// Open relation file
+	if (rc = rmManager->OpenFile(relName, fileHandle))
+		return rc;
+	// Open all index files
+	RM_FileScan fileScan;
+	int offset = (int)offsetof(struct Attrcat, relName);
+	char relation[MAXNAME + 1];
+	memset(relation, '\0', MAXNAME + 1);
+	memcpy(relation, relName, min(strlen(relName), MAXNAME));
+	if (rc = fileScan.OpenScan(attrFile, STRING, MAXNAME, offset, EQ_OP, relation))
+		return rc;
+	while ( OK_RC == (rc = fileScan.GetNextRec(record))){
+		char* pData;
+		if (rc = record.GetData(pData))
+			return rc;
+		Attrcat attrcat(pData);
+
+		if (attrcat.indexNo != SM_INVALID){
+			IX_IndexHandle indexHandle;
+			if (rc = ixManager->OpenIndex(relName, attrcat.indexNo, indexHandle))
+				return rc;
+			indexes.push_back(make_pair(attrcat, indexHandle));
+		}
+	}
+	// Check if error occurred
+	if (rc != RM_EOF)
+		return rc;
+	// Clean up
+	if (rc = fileScan.CloseScan())
+		return rc;
+
+	SM_CompositeIndex* composites;
+	int numComposites;
+	if (rc = OpenCompositeIndexes(relName, composites, numComposites))
+		return rc;
+
+	// Compact one batch at a time.  Each batch's index updates and pages
+	// are flushed before the next; a batch only dirties the pages it moved
+	// records between, so flushing stays proportional to the batch.  The
+	// batch size and pause between batches bound how long vacuum holds the
+	// buffer pool from queries.
+	RID* oldRids = new RID[vacuumBatch];
+	RID* newRids = new RID[vacuumBatch];
+	int numMoves;
+	do {
+		if (rc = fileHandle.Compact(vacuumBatch, oldRids, newRids, numMoves))
+			break;
+
+		// Point index entries at moved records
+		for (int i = 0; rc == OK_RC && i < numMoves; ++i){
+			char* pData;
+			if ((rc = fileHandle.GetRec(newRids[i], record)) ||
+				(rc = record.GetData(pData)))
+				break;
+			for (int j = 0; j < indexes.size(); ++j){
+				char* attribute = pData + indexes.at(j).first.offset;
+				if ((rc = indexes.at(j).second.DeleteEntry(attribute, oldRids[i])) ||
+					(rc = indexes.at(j).second.InsertEntry(attribute, newRids[i])))
+					break;
+			}
+			for (int j = 0; rc == OK_RC && j < numComposites; ++j){
+				if ((rc = composites[j].MakeKey(pData)) ||
+					(rc = composites[j].indexHandle.DeleteEntry(composites[j].key, oldRids[i])) ||
+					(rc = composites[j].indexHandle.InsertEntry(composites[j].key, newRids[i])))
+					break;
+			}
+		}
+		if (rc)
+			break;
+
+		// Flush batch
+		if (rc = fileHandle.ForcePages())
+			break;
+		for (int j = 0; rc == OK_RC && j < indexes.size(); ++j)
+			rc = indexes.at(j).second.ForcePages();
+		for (int j = 0; rc == OK_RC && j < numComposites; ++j)
+			rc = composites[j].indexHandle.ForcePages();
+		if (rc)
+			break;
+
+		// Throttle
+		if (numMoves > 0 && vacuumDelay > 0)
+			usleep(vacuumDelay * 1000);
+	} while (numMoves > 0);
+	delete [] oldRids;
+	delete [] newRids;
+	if (rc){
+		CloseCompositeIndexes(composites, numComposites);
+		return rc;
+	}
+
+	// Close relation file
+	if (rc = rmManager->CloseFile(fileHandle))
+		return rc;
+	// Close index files
+	for (int i = 0; i < indexes.size(); ++i){
+		if (rc = ixManager->CloseIndex(indexes.at(i).second))
+			return rc;
+	}
+	if (rc = CloseCompositeIndexes(composites, numComposites))
+		return rc;
+
+    return (0);
+}
+
+RC SM_Manager::Reindex(const char *relName,
+                       const char *attrName)
+{
+	RC rc;
+
+	// Check input
+	if (rc = CheckName(relName))
+		return rc;
+	if (rc = CheckName(attrName))
+		return rc;
+	// End check input.
+
+	RM_Record record;
+	char* pData;
+
+	// Check there is an index on the attribute
+	if (rc = GetAttrcatRecord(relName, attrName, record)){
+		if (rc == RM_EOF)
+			return SM_DNE;
+		return rc;
+	}
+	if (rc = record.GetData(pData))
+		return rc;
+	Attrcat attrcat(pData);
+	if (attrcat.indexNo == SM_INVALID)
+		return SM_DNE;
+
+	// Bulk load a compact copy at indexFill, which replaces the index once
+	// built; until then the old file serves queries
+	IX_IndexHandle indexHandle;
+	if (rc = ixManager->OpenIndex(relName, attrcat.indexNo, indexHandle))
+		return rc;
+	if (rc = ixManager->RebuildIndex(relName, attrcat.indexNo, indexHandle, indexFill))
+		return rc;
+	if (rc = UpdateStatcat(relName, attrcat.indexNo, indexHandle))
+		return rc;
+	if (rc = ixManager->CloseIndex(indexHandle))
+		return rc;
+
+    return (0);
+}
+
+RC SM_Manager::Reindex(const char *relName,
+                       int        attrCount,
+                       const char * const attrNames[])
+{
+	RC rc;
+
+	// A single attribute is an ordinary index
+	if (attrCount == 1 && attrNames)
+		return Reindex(relName, attrNames[0]);
+
+	// Check input
+	if (rc = CheckName(relName))
+		return rc;
+	if (!attrNames)
+		return SM_NULLINPUT;
+	if (attrCount < 1 || attrCount > MAXINDEXATTRS)
+		return SM_ATTRNUM;
+	// End check input.
+
+	RM_Record record;
+	char* pData;
+
+	// Check there is an index on the attributes
+	if (rc = GetIndexcatRecord(relName, attrCount, attrNames, record)){
+		if (rc == RM_EOF)
+			return SM_DNE;
+		return rc;
+	}
+	if (rc = record.GetData(pData))
+		return rc;
+	Indexcat indexcat(pData);
+
+	// Rebuilt as a single attribute index is
+	IX_IndexHandle indexHandle;
+	if (rc = ixManager->OpenIndex(relName, indexcat.indexNo, indexHandle))
+		return rc;
+	if (rc = ixManager->RebuildIndex(relName, indexcat.indexNo, indexHandle, indexFill))
+		return rc;
+	if (rc = UpdateStatcat(relName, indexcat.indexNo, indexHandle))
+		return rc;
+	if (rc = ixManager->CloseIndex(indexHandle))
+		return rc;
+
+    return (0);
+}
+
+RC SM_Manager::Analyze(const char *relName)
+{
+	RC rc;
+
+	// Check input
+	if (rc = CheckName(relName))
+		return rc;
+	// End check input.
+
+	RM_Record record;
+	char* pData;
+	if (rc = GetRelcatRecord(relName, record)){
+		if (rc == RM_EOF)
+			return SM_DNE;
+		return rc;
+	}
+	if (rc = record.GetData(pData))
+		return rc;
+	Relcat relcat(pData);
+
+	// Find the relation's single attribute and composite indexes
+	vector<int> indexNos;
+	Attrcat* attributes = new Attrcat[relcat.attrCount];
+	if (rc = GetAttrcats(relName, attributes)){
+		delete [] attributes;
+		return rc;
+	}
+	for (int i = 0; i < relcat.attrCount; ++i){
+		if (attributes[i].indexNo != SM_INVALID)
+			indexNos.push_back(attributes[i].indexNo);
+	}
+	delete [] attributes;
+	Indexcat* indexes = new Indexcat[relcat.indexCount];
+	int numIndexes;
+	if (rc = GetIndexcats(relName, indexes, numIndexes)){
+		delete [] indexes;
+		return rc;
+	}
+	for (int i = 0; i < numIndexes; ++i)
+		indexNos.push_back(indexes[i].indexNo);
+	delete [] indexes;
+
+	// Replace each index's statistics
+	for (int i = 0; i < indexNos.size(); ++i){
+		IX_IndexHandle indexHandle;
+		if (rc = ixManager->OpenIndex(relName, indexNos[i], indexHandle))
+			return rc;
+		if (rc = UpdateStatcat(relName, indexNos[i], indexHandle)){
+			ixManager->CloseIndex(indexHandle);
+			return rc;
+		}
+		if (rc = ixManager->CloseIndex(indexHandle))
+			return rc;
+	}
+
+    return (0);
+}
+
+RC SM_Manager::Help()
+{
+    //cout << "Help\n";
+	RC rc;
+	if (rc = Print(MYRELCAT))
+		return rc;
+    return (0);
+}
+
+RC SM_Manager::Help(const char *relName)
+{
+	RC rc;
+
+	// Check input
+	if (rc = CheckName(relName))
+		return rc;
+	// End check input
+
+	// Get attributes
+	RM_Record record;
+	char* pData;
+	if (rc = GetRelcatRecord(relName, record)){
+		if (rc == RM_EOF)
+			return SM_DNE;
+		return rc;
+	}
+	if (rc = record.GetData(pData))
 		return rc;
 	Relcat relcat(pData);
 	Attrcat* attributes = new Attrcat[relcat.attrCount];
@@ -691,7 +1446,7 @@ RC SM_Manager::Help(const char *relName)
 	}
 
 	// Make dataAttrs based on Attrcat
-	const int attrCount = 6;
+	const int attrCount = 8;
 	DataAttrInfo* dataAttrs = new DataAttrInfo[attrCount]; 
 	dataAttrs[0] = DataAttrInfo(MYATTRCAT, "relName", offsetof(struct Attrcat, relName), STRING, sizeof(Attrcat::relName), SM_INVALID);
 	dataAttrs[1] = DataAttrInfo(MYATTRCAT, "attrName", offsetof(struct Attrcat, attrName), STRING, sizeof(Attrcat::attrName), SM_INVALID);
@@ -699,6 +1454,8 @@ RC SM_Manager::Help(const char *relName)
 	dataAttrs[3] = DataAttrInfo(MYATTRCAT, "attrType", offsetof(struct Attrcat, attrType), INT, sizeof(Attrcat::attrType), SM_INVALID);
 	dataAttrs[4] = DataAttrInfo(MYATTRCAT, "attrLen", offsetof(struct Attrcat, attrLen),INT, sizeof(Attrcat::attrLen), SM_INVALID);
 	dataAttrs[5] = DataAttrInfo(MYATTRCAT, "indexNo", offsetof(struct Attrcat, indexNo), INT, sizeof(Attrcat::indexNo), SM_INVALID);
+	dataAttrs[6] = DataAttrInfo(MYATTRCAT, "indexType", offsetof(struct Attrcat, indexType), INT, sizeof(Attrcat::indexType), SM_INVALID);
+	dataAttrs[7] = DataAttrInfo(MYATTRCAT, "encoded", offsetof(struct Attrcat, encoded), INT, sizeof(Attrcat::encoded), SM_INVALID);
 
 	// Initialize printer
 	Printer printer(dataAttrs, attrCount);
@@ -712,9 +1469,97 @@ RC SM_Manager::Help(const char *relName)
 	// Finish printer
 	printer.PrintFooter(cout);
 
+	// Print composite indexes, if any
+	Indexcat* indexes = new Indexcat[relcat.indexCount];
+	int numIndexes;
+	if (rc = GetIndexcats(relName, indexes, numIndexes)){
+		delete [] attributes;
+		delete [] dataAttrs;
+		delete [] indexes;
+		return rc;
+	}
+	if (numIndexes > 0){
+		vector<DataAttrInfo> indexAttrs;
+		indexAttrs.push_back(DataAttrInfo(MYINDEXCAT, "indexNo", offsetof(struct Indexcat, indexNo), INT, sizeof(Indexcat::indexNo), SM_INVALID));
+		indexAttrs.push_back(DataAttrInfo(MYINDEXCAT, "attrCount", offsetof(struct Indexcat, attrCount), INT, sizeof(Indexcat::attrCount), SM_INVALID));
+		for (int i = 0; i < MAXINDEXATTRS; ++i){
+			stringstream name;
+			name << "attrName" << i + 1;
+			indexAttrs.push_back(DataAttrInfo(MYINDEXCAT, name.str().c_str(), offsetof(struct Indexcat, attrNames) + i * (MAXNAME + 1), STRING, MAXNAME + 1, SM_INVALID));
+		}
+		Printer indexPrinter(&indexAttrs[0], indexAttrs.size());
+		indexPrinter.PrintHeader(cout);
+		for (int i = 0; i < numIndexes; ++i)
+			indexPrinter.Print(cout, (char*)(indexes + i));
+		indexPrinter.PrintFooter(cout);
+	}
+
 	// Clean up
 	delete [] attributes;
 	delete [] dataAttrs;
+	delete [] indexes;
+    return (0);
+}
+
+RC SM_Manager::HelpIndex(const char *relName)
+{
+	RC rc;
+
+	// Check input
+	if (rc = CheckName(relName))
+		return rc;
+	// End check input
+
+	// Check relation exists
+	RM_Record record;
+	char* pData;
+	if (rc = GetRelcatRecord(relName, record)){
+		if (rc == RM_EOF)
+			return SM_DNE;
+		return rc;
+	}
+
+	// Initialize printer with statcat's attributes
+	if (rc = GetRelcatRecord(MYSTATCAT, record))
+		return rc;
+	if (rc = record.GetData(pData))
+		return rc;
+	Relcat relcat(pData);
+	Attrcat* attributes = new Attrcat[relcat.attrCount];
+	if (rc = GetAttrcats(MYSTATCAT, attributes)){
+		delete [] attributes;
+		return rc;
+	}
+	DataAttrInfo* dataAttrs = new DataAttrInfo[relcat.attrCount];
+	for (int i = 0; i < relcat.attrCount; ++i)
+		dataAttrs[i] = DataAttrInfo(attributes[i]);
+	delete [] attributes;
+	Printer printer(dataAttrs, relcat.attrCount);
+	printer.PrintHeader(cout);
+
+	// Print the relation's statcat records
+	RM_FileScan fileScan;
+	char relation[MAXNAME + 1];
+	memset(relation, '\0', MAXNAME + 1);
+	memcpy(relation, relName, min(strlen(relName), MAXNAME));
+	int offset = (int)offsetof(struct Statcat, relName);
+	if (rc = fileScan.OpenScan(statFile, STRING, MAXNAME, offset, EQ_OP, relation)){
+		delete [] dataAttrs;
+		return rc;
+	}
+	while ( OK_RC == (rc = fileScan.GetNextRec(record))){
+		if (rc = record.GetData(pData))
+			break;
+		printer.Print(cout, pData);
+	}
+	delete [] dataAttrs;
+	if (rc != RM_EOF)
+		return rc;
+	if (rc = fileScan.CloseScan())
+		return rc;
+
+	// Finish printer
+	printer.PrintFooter(cout);
     return (0);
 }
 
@@ -723,7 +1568,8 @@ bool sortAttrcats(const Attrcat &i, const Attrcat &j){
 	return i.offset < j.offset;
 }
 bool SM_Manager::isCatalog(const char* relName){
-	return (strcmp(relName, MYRELCAT) == 0 || strcmp(relName, MYATTRCAT) == 0);
+	return (strcmp(relName, MYRELCAT) == 0 || strcmp(relName, MYATTRCAT) == 0 ||
+		strcmp(relName, MYINDEXCAT) == 0 || strcmp(relName, MYSTATCAT) == 0);
 }
 RC SM_Manager::CheckName(const char* name){
 	if (!name)
@@ -735,6 +1581,15 @@ RC SM_Manager::CheckName(const char* name){
 	}
 	return 0;
 }
+RC SM_Manager::GetIntParam(const char *value, int &param){
+	int tmp;
+	istringstream ss(value);
+	ss >> tmp;
+	if (ss.fail() || ss.rdbuf()->in_avail() != 0)
+		return SM_INVALIDPARAM;
+	param = tmp;
+	return 0;
+}
 RC SM_Manager::GetRelcatRecord(const char* relName, RM_Record &record){
 	char relation[MAXNAME + 1];
 	memset(relation, '\0', MAXNAME + 1);
@@ -821,4 +1676,276 @@ RC SM_Manager::GetAttrcats(const char* relName, Attrcat* attributes){
 
 	return 0;
 }
+RC SM_Manager::GetIndexcatRecord(const char* relName, int attrCount, const char * const attrNames[], RM_Record &record){
+	char relation[MAXNAME + 1];
+	memset(relation, '\0', MAXNAME + 1);
+	memcpy(relation, relName, min(strlen(relName), MAXNAME));
+	RM_FileScan fileScan;
+	RC rc;
+	char* pData;
+	int offset = (int)offsetof(struct Indexcat, relName);
+
+	// Scan for the relation's composite index on exactly these attributes
+	if (rc = fileScan.OpenScan(indexFile, STRING, MAXNAME, offset, EQ_OP, relation))
+		return rc;
+	while ( OK_RC == (rc = fileScan.GetNextRec(record))){
+		if (rc = record.GetData(pData))
+			return rc;
+		Indexcat indexcat(pData);
+		bool same = (indexcat.attrCount == attrCount);
+		for (int i = 0; same && i < attrCount; ++i)
+			same = (strcmp(indexcat.attrNames[i], attrNames[i]) == 0);
+		if (same){
+			// Clean up.
+			if (rc = fileScan.CloseScan())
+				return rc;
+			return 0;
+		}
+	}
+	fileScan.CloseScan();
+	return rc;
+}
+RC SM_Manager::GetIndexcats(const char* relName, Indexcat* indexes, int &numIndexes){
+	RM_FileScan fileScan;
+	RM_Record record;
+	char* pData;
+	RC rc;
 
+	// Open scan
+	char relation[MAXNAME + 1];
+	memset(relation, '\0', MAXNAME + 1);
+	memcpy(relation, relName, min(strlen(relName), MAXNAME));
+	int offset = (int)offsetof(struct Indexcat, relName);
+	if (rc = fileScan.OpenScan(indexFile, STRING, MAXNAME, offset, EQ_OP, relation))
+		return rc;
+
+	// Copy each composite index
+	numIndexes = 0;
+	while ( OK_RC == (rc = fileScan.GetNextRec(record))){
+		if (rc = record.GetData(pData))
+			return rc;
+		memcpy(indexes + numIndexes, pData, sizeof(Indexcat));
+		numIndexes += 1;
+	}
+	// Check if error occurred while scanning indexcat file
+	if (rc != RM_EOF)
+		return rc;
+
+	// Clean up
+	if (rc = fileScan.CloseScan())
+		return rc;
+
+	return 0;
+}
+// Opens relName's composite indexes, their offsets those of the relation's tuples
+RC SM_Manager::OpenCompositeIndexes(const char* relName, SM_CompositeIndex* &indexes, int &numIndexes){
+	RM_Record record;
+	char* pData;
+	RC rc;
+
+	indexes = NULL;
+	numIndexes = 0;
+	if (rc = GetRelcatRecord(relName, record))
+		return rc;
+	if (rc = record.GetData(pData))
+		return rc;
+	Relcat relcat(pData);
+	if (relcat.indexCount == 0)
+		return 0;
+
+	Indexcat* indexcats = new Indexcat[relcat.indexCount];
+	if (rc = GetIndexcats(relName, indexcats, numIndexes)){
+		delete [] indexcats;
+		return rc;
+	}
+	indexes = new SM_CompositeIndex[numIndexes];
+	for (int i = 0; i < numIndexes; ++i){
+		indexes[i].indexcat = indexcats[i];
+		for (int j = 0; j < indexcats[i].attrCount; ++j){
+			if ((rc = GetAttrcatRecord(relName, indexcats[i].attrNames[j], record)) ||
+				(rc = record.GetData(pData)))
+				break;
+			indexes[i].offsets[j] = Attrcat(pData).offset;
+		}
+		if (rc || (rc = ixManager->OpenIndex(relName, indexcats[i].indexNo, indexes[i].indexHandle))){
+			CloseCompositeIndexes(indexes, i);
+			delete [] indexcats;
+			indexes = NULL;
+			numIndexes = 0;
+			return rc;
+		}
+	}
+	delete [] indexcats;
+	return 0;
+}
+// Closes and deletes indexes
+RC SM_Manager::CloseCompositeIndexes(SM_CompositeIndex* indexes, int numIndexes){
+	RC rc = 0;
+	for (int i = 0; i < numIndexes; ++i){
+		RC rc2 = ixManager->CloseIndex(indexes[i].indexHandle);
+		if (rc == 0)
+			rc = rc2;
+	}
+	delete [] indexes;
+	return rc;
+}
+// Replaces indexNo's statcat record with indexHandle's statistics
+RC SM_Manager::UpdateStatcat(const char* relName, int indexNo, IX_IndexHandle &indexHandle){
+	RC rc;
+	IX_IndexStats stats;
+	if (rc = indexHandle.GetStats(stats))
+		return rc;
+	if (rc = DeleteStatcats(relName, indexNo))
+		return rc;
+
+	Statcat statcat;
+	memcpy(statcat.relName, relName, min(strlen(relName), MAXNAME));
+	statcat.indexNo = indexNo;
+	statcat.height = stats.height;
+	statcat.leafPages = stats.leafPages;
+	statcat.fillPercent = stats.fillPercent;
+	statcat.numRids = stats.numRids;
+	statcat.numKeys = stats.numKeys;
+	statcat.clustering = stats.clustering;
+	memcpy(statcat.duplicates, stats.duplicates, sizeof(statcat.duplicates));
+	RID rid;
+	if (rc = statFile.InsertRec((char*)&statcat, rid))
+		return rc;
+	return 0;
+}
+RC SM_Manager::DeleteStatcats(const char* relName, int indexNo){
+	RM_FileScan fileScan;
+	RM_Record record;
+	char* pData;
+	RID rid;
+	RC rc;
+
+	// Open scan
+	char relation[MAXNAME + 1];
+	memset(relation, '\0', MAXNAME + 1);
+	memcpy(relation, relName, min(strlen(relName), MAXNAME));
+	int offset = (int)offsetof(struct Statcat, relName);
+	if (rc = fileScan.OpenScan(statFile, STRING, MAXNAME, offset, EQ_OP, relation))
+		return rc;
+
+	// Delete the index's record, or all of them
+	while ( OK_RC == (rc = fileScan.GetNextRec(record))){
+		if (rc = record.GetData(pData))
+			return rc;
+		Statcat statcat(pData);
+		if (indexNo != SM_INVALID && statcat.indexNo != indexNo)
+			continue;
+		if (rc = record.GetRid(rid))
+			return rc;
+		if (rc = statFile.DeleteRec(rid))
+			return rc;
+	}
+	// Check if error occurred while scanning statcat file
+	if (rc != RM_EOF)
+		return rc;
+
+	// Clean up
+	if (rc = fileScan.CloseScan())
+		return rc;
+
+	return 0;
+}
+
+
+// Before loading into an empty relation, reads the whole ASCII file and
+// re-creates the relation file with low-cardinality string attributes
+// dictionary encoded, recording them in attrcat.  Attributes already
+// encoded stay encoded.
+RC SM_Manager::ChooseEncoding(const char *relName, const char *fileName, const Relcat &relcat,
+                              const Attrcat *attributes, int attrCount, RM_FileHandle &fileHandle)
+{
+	RC rc;
+
+	// Only an empty relation can change layout
+	RM_FileScan fileScan;
+	RM_Record record;
+	if (rc = fileScan.OpenScan(fileHandle, INT, sizeof(int), 0, NO_OP, NULL))
+		return rc;
+	rc = fileScan.GetNextRec(record);
+	if (rc == OK_RC)
+		return fileScan.CloseScan();
+	if (rc != RM_EOF)
+		return rc;
+	if (rc = fileScan.CloseScan())
+		return rc;
+
+	// Count distinct values of each candidate attribute over every line,
+	// dropping an attribute once it has more than SM_DICT_MAX
+	vector<bool> candidate(attrCount);
+	int numCandidates = 0;
+	for (int i = 0; i < attrCount; ++i){
+		candidate[i] = !fileHandle.IsEncoded(attributes[i].offset) &&
+			attributes[i].attrType == STRING && attributes[i].attrLen > sizeof(int);
+		numCandidates += candidate[i];
+	}
+	if (numCandidates == 0)
+		return OK_RC;
+	vector<set<string> > distinct(attrCount);
+	ifstream asciiFile(fileName);
+	if (!asciiFile.is_open())
+		return SM_FILENOTOPEN;
+	string line;
+	int numRows = 0;
+	while (numCandidates > 0 && getline(asciiFile, line)){
+		++numRows;
+		stringstream ss(line);
+		string token;
+		for (int i = 0; i < attrCount && getline(ss, token, ','); ++i){
+			if (!candidate[i])
+				continue;
+			distinct[i].insert(token);
+			if (distinct[i].size() > SM_DICT_MAX){
+				candidate[i] = false;
+				distinct[i].clear();
+				--numCandidates;
+			}
+		}
+	}
+	asciiFile.close();
+
+	// Encode attributes averaging SM_DICT_RATIO or more rows per value
+	int numEncoded = 0;
+	int encOffsets[MAXATTRS], encLengths[MAXATTRS];
+	vector<int> newlyEncoded;
+	for (int i = 0; i < attrCount; ++i){
+		bool encoded = fileHandle.IsEncoded(attributes[i].offset);
+		if (candidate[i] && numRows > 0 && distinct[i].size() * SM_DICT_RATIO <= numRows){
+			encoded = true;
+			newlyEncoded.push_back(i);
+		}
+		if (encoded){
+			encOffsets[numEncoded] = attributes[i].offset;
+			encLengths[numEncoded] = attributes[i].attrLen;
+			++numEncoded;
+		}
+	}
+	if (newlyEncoded.empty())
+		return OK_RC;
+
+	// Re-create relation file
+	if ((rc = rmManager->CloseFile(fileHandle)) ||
+		(rc = rmManager->DestroyFile(relName)) ||
+		(rc = rmManager->CreateFile(relName, relcat.tupleLen, numEncoded, encOffsets, encLengths)) ||
+		(rc = rmManager->OpenFile(relName, fileHandle)))
+		return rc;
+
+	// Update attrcat
+	for (int i = 0; i < newlyEncoded.size(); ++i){
+		char* pData;
+		if ((rc = GetAttrcatRecord(relName, attributes[newlyEncoded[i]].attrName, record)) ||
+			(rc = record.GetData(pData)))
+			return rc;
+		Attrcat attrcat(pData);
+		attrcat.encoded = 1;
+		memcpy(pData, &attrcat, sizeof(Attrcat));
+		if (rc = attrFile.UpdateRec(record))
+			return rc;
+	}
+
+	return OK_RC;
+}
@@ -0,0 +1,17 @@
+#include <string>
+#include <cstring>
+#include <stdio.h>
+#include "redbase.h"
+
+using namespace std;
+
+const char* MYSTATCAT = "statcat";
+
+Statcat::Statcat(){
+	memset(this, '\0', sizeof(Statcat));
+	indexNo = -1;
+}
+
+Statcat::Statcat(char* pData){
+	memcpy(this, pData, sizeof(Statcat));
+}